@@ -0,0 +1,1744 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../simple_array.h"
+#include "../simple_bigint.h"
+#include "../simple_concurrent_hashtable.h"
+#include "../simple_error.h"
+#include "../simple_hashtable.h"
+#include "../simple_heap.h"
+#include "../simple_int_hashtable.h"
+#include "../simple_mapped_hashtable.h"
+#include "../simple_object.h"
+#include "../simple_profile.h"
+#include "../simple_serial.h"
+#include "../simple_sink.h"
+#include "../simple_string.h"
+#include "../simple_test.h"
+#include "../type.h"
+
+#include <assert.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#define BENCH_COUNT(array) (sizeof array / sizeof *array)
+
+static const size_t bench_bigint_sizes[] = {4, 16, 64, 256, 1024, 4096};
+static const size_t bench_array_sizes[] = {1 << 12, 1 << 20, 1 << 24};
+// the largest size only runs with --large, it needs gigabytes of memory
+static const size_t bench_hashtable_sizes[] = {10, 1000, 100000, 1000000,
+    10000000};
+static size_t bench_hashtable_size_count = BENCH_COUNT(bench_hashtable_sizes)
+    - 1;
+
+static void bench_shuffle(
+    void *elements,
+    size_t count,
+    size_t element_size
+) {
+    char *bytes = elements, swap[16];
+    uint64_t state = 88172645463325252ULL;
+    for (size_t j = count - 1; j > 0; j--) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        size_t k = (size_t)(state % (j + 1));
+        memcpy(swap, bytes + j * element_size, element_size);
+        memcpy(bytes + j * element_size, bytes + k * element_size,
+            element_size);
+        memcpy(bytes + k * element_size, swap, element_size);
+    }
+}
+
+// names nodes after the input size they measure
+static struct simple_test_item *bench_create_size_node(
+    struct simple_test_item *parent,
+    const char *prefix,
+    size_t size
+) {
+    char name[32];
+    snprintf(name, sizeof name, "%s%zu", prefix, size);
+    return simple_test_create_node(parent, name);
+}
+
+struct bench_bigint_pair {
+    struct simple_bigint *lhs, *rhs;
+    enum simple_bigint_mul_algorithm algorithm;
+};
+
+static struct bench_bigint_pair bench_bigint_pairs[
+    BENCH_COUNT(bench_bigint_sizes)][4];
+
+static struct simple_bigint *bench_random_bigint(
+    size_t limb_count,
+    uint64_t *state
+) {
+    uint64_t *limbs = calloc(limb_count, sizeof *limbs);
+    for (size_t i = 0; i < limb_count; i++) {
+        *state ^= *state << 13;
+        *state ^= *state >> 7;
+        *state ^= *state << 17;
+        limbs[i] = *state;
+    }
+    struct simple_bigint *bigint;
+    bigint = simple_bigint_new_limbs(limbs, limb_count, false);
+    free(limbs);
+    return bigint;
+}
+
+static struct simple_error *bench_bigint_mul(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_bigint_pair *pair = context;
+    for (size_t i = 0; i < iterations; i++) {
+        simple_bigint_destroy(simple_bigint_mul_with(pair->lhs, pair->rhs,
+            pair->algorithm));
+    }
+    return NULL;
+}
+
+// one division by ten per digit, the baseline for the chunked conversion
+static struct simple_error *bench_naive_to_decimal(
+    const struct simple_bigint *bigint,
+    char **result
+) {
+    size_t capacity = simple_bigint_limb_count(bigint) * 20 + 2;
+    char *buff = calloc(capacity, sizeof *buff);
+    size_t length = 0;
+    struct simple_error *error = NULL;
+
+    struct simple_bigint *value = simple_bigint_copy(bigint);
+    do {
+        struct simple_bigint *quotient;
+        uint64_t digit;
+        error = simple_bigint_div_small(value, 10, &quotient, &digit);
+        simple_error_check(error);
+        buff[length++] = (char)('0' + digit);
+        simple_bigint_destroy(value);
+        value = quotient;
+    } while (simple_bigint_limb_count(value));
+
+    for (size_t i = 0; i < length / 2; i++) {
+        char swap = buff[i];
+        buff[i] = buff[length - 1 - i];
+        buff[length - 1 - i] = swap;
+    }
+
+    cleanup:
+    simple_bigint_destroy(value);
+    *result = buff;
+    return error;
+}
+
+static struct simple_error *bench_bigint_naive_decimal(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_bigint_pair *pair = context;
+    struct simple_error *error = NULL;
+    char *decimal;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = bench_naive_to_decimal(pair->lhs, &decimal);
+        free(decimal);
+    }
+    return error;
+}
+
+static struct simple_error *bench_bigint_decimal(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_bigint_pair *pair = context;
+    for (size_t i = 0; i < iterations; i++) {
+        free(simple_bigint_to_decimal(pair->lhs));
+    }
+    return NULL;
+}
+
+static void bench_bigint(
+    struct simple_test_item *root
+) {
+    static const char *names[] = {"mul_auto", "mul_schoolbook",
+        "mul_karatsuba", "mul_toom3"};
+
+    struct simple_test_item *bigint = simple_test_create_node(root, "bigint");
+    uint64_t state = 88172645463325252ULL;
+
+    for (size_t i = 0; i < BENCH_COUNT(bench_bigint_sizes); i++) {
+        struct simple_test_item *size;
+        size = bench_create_size_node(bigint, "limbs_",
+            bench_bigint_sizes[i]);
+
+        struct simple_bigint *lhs, *rhs;
+        lhs = bench_random_bigint(bench_bigint_sizes[i], &state);
+        rhs = bench_random_bigint(bench_bigint_sizes[i], &state);
+
+        for (size_t j = 0; j < 4; j++) {
+            bench_bigint_pairs[i][j] = (struct bench_bigint_pair) {
+                .lhs = lhs,
+                .rhs = rhs,
+                .algorithm = (enum simple_bigint_mul_algorithm)j
+            };
+            simple_test_create_bench(size, names[j], bench_bigint_mul,
+                bench_bigint_pairs[i] + j, 1);
+        }
+
+        simple_test_create_bench(size, "naive_decimal",
+            bench_bigint_naive_decimal, bench_bigint_pairs[i], 1);
+        simple_test_create_bench(size, "decimal", bench_bigint_decimal,
+            bench_bigint_pairs[i], 1);
+    }
+}
+
+static void bench_bigint_release(
+    void
+) {
+    for (size_t i = 0; i < BENCH_COUNT(bench_bigint_sizes); i++) {
+        simple_bigint_destroy(bench_bigint_pairs[i][0].lhs);
+        simple_bigint_destroy(bench_bigint_pairs[i][0].rhs);
+    }
+}
+
+struct bench_array_pair {
+    struct simple_array *lhs, *rhs;
+    enum simple_array_isa isa;
+};
+
+static struct bench_array_pair bench_array_pairs[
+    BENCH_COUNT(bench_array_sizes)][SIMPLE_ARRAY_ISA_AVX512 + 1];
+
+static struct simple_error *bench_array_sum(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_array_pair *pair = context;
+    union simple_array_value sum;
+    struct simple_error *error = NULL;
+
+    simple_array_set_isa(pair->isa);
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = simple_array_sum(pair->lhs, &sum);
+    }
+    return error;
+}
+
+static struct simple_error *bench_array_add(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_array_pair *pair = context;
+    struct simple_array *result;
+    struct simple_error *error = NULL;
+
+    simple_array_set_isa(pair->isa);
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = simple_array_arithmetic(pair->lhs, pair->rhs,
+            SIMPLE_ARRAY_ADD, &result);
+        if (!error) {
+            simple_array_destroy(result);
+        }
+    }
+    return error;
+}
+
+static struct simple_error *bench_array_filter(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_array_pair *pair = context;
+    struct simple_error *error = NULL;
+
+    simple_array_set_isa(pair->isa);
+    for (size_t i = 0; !error && i < iterations; i++) {
+        struct simple_array *mask = NULL, *result = NULL;
+        error = simple_array_compare(pair->lhs, SIMPLE_ARRAY_LT,
+            (union simple_array_value) {.integer = 500}, &mask);
+        if (!error) {
+            error = simple_array_filter(pair->lhs, mask, &result);
+        }
+        simple_array_destroy(mask);
+        simple_array_destroy(result);
+    }
+    return error;
+}
+
+// one operation is one element, for every isa the cpu supports
+static void bench_array(
+    struct simple_test_item *root
+) {
+    struct simple_test_item *array = simple_test_create_node(root, "array");
+    enum simple_array_isa best = simple_array_get_isa();
+
+    for (size_t i = 0; i < BENCH_COUNT(bench_array_sizes); i++) {
+        struct simple_test_item *size;
+        size = bench_create_size_node(array, "elements_",
+            bench_array_sizes[i]);
+
+        struct simple_array *lhs, *rhs;
+        lhs = simple_array_new(SIMPLE_ARRAY_INT32, bench_array_sizes[i]);
+        rhs = simple_array_new(SIMPLE_ARRAY_INT32, bench_array_sizes[i]);
+        simple_array_resize(lhs, bench_array_sizes[i]);
+        simple_array_resize(rhs, bench_array_sizes[i]);
+
+        int32_t *data = simple_array_data(lhs);
+        for (size_t j = 0; j < bench_array_sizes[i]; j++) {
+            data[j] = (int32_t)((j * 7919) % 1000);
+        }
+
+        for (int isa = SIMPLE_ARRAY_ISA_GENERIC; isa <= (int)best; isa++) {
+            struct bench_array_pair *pair = bench_array_pairs[i] + isa;
+            *pair = (struct bench_array_pair) {
+                .lhs = lhs,
+                .rhs = rhs,
+                .isa = (enum simple_array_isa)isa
+            };
+
+            // dots separate the levels of full test names
+            char name[32];
+            snprintf(name, sizeof name, "%s",
+                simple_array_isa_get_name(pair->isa));
+            for (char *dot = strchr(name, '.'); dot; dot = strchr(dot, '.')) {
+                *dot = '_';
+            }
+            struct simple_test_item *node = simple_test_create_node(size,
+                name);
+            simple_test_create_bench(node, "sum", bench_array_sum, pair,
+                bench_array_sizes[i]);
+            simple_test_create_bench(node, "add", bench_array_add, pair,
+                bench_array_sizes[i]);
+            simple_test_create_bench(node, "filter", bench_array_filter,
+                pair, bench_array_sizes[i]);
+        }
+    }
+}
+
+static void bench_array_release(
+    void
+) {
+    for (size_t i = 0; i < BENCH_COUNT(bench_array_sizes); i++) {
+        simple_array_destroy(bench_array_pairs[i][0].lhs);
+        simple_array_destroy(bench_array_pairs[i][0].rhs);
+    }
+    simple_array_set_isa(SIMPLE_ARRAY_ISA_AVX512);
+}
+
+struct bench_hashtable_lookup {
+    const struct type *type;
+    const struct object **keys;
+    size_t count;
+    struct simple_hashtable *table;
+    struct object **results;
+};
+
+static struct bench_hashtable_lookup bench_hashtable_lookups[
+    BENCH_COUNT(bench_hashtable_sizes)];
+
+// find at one size with the table reserved for 1, 2 and 4 times the entries
+#define BENCH_HASHTABLE_LOAD_ENTRIES 100000
+static struct bench_hashtable_lookup bench_hashtable_loads[3];
+
+static struct simple_error *bench_hashtable_insert(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_hashtable_lookup *lookup = context;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        struct simple_hashtable *table;
+        table = simple_hashtable_new(lookup->type, lookup->type);
+        for (size_t j = 0; !error && j < lookup->count; j++) {
+            error = simple_hashtable_insert(table, lookup->keys[j],
+                lookup->keys[j]);
+        }
+        simple_hashtable_destroy(table);
+    }
+    return error;
+}
+
+static struct simple_error *bench_hashtable_insert_many(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_hashtable_lookup *lookup = context;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        struct simple_hashtable *table;
+        table = simple_hashtable_new(lookup->type, lookup->type);
+        error = simple_hashtable_insert_many(table, lookup->keys,
+            lookup->keys, lookup->count);
+        simple_hashtable_destroy(table);
+    }
+    return error;
+}
+
+static struct simple_error *bench_hashtable_find(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_hashtable_lookup *lookup = context;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        for (size_t j = 0; !error && j < lookup->count; j++) {
+            error = simple_hashtable_find(lookup->table, lookup->keys[j],
+                lookup->results + j);
+        }
+    }
+    return error;
+}
+
+static struct simple_error *bench_hashtable_find_many(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_hashtable_lookup *lookup = context;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = simple_hashtable_find_many(lookup->table, lookup->keys,
+            lookup->count, lookup->results);
+    }
+    return error;
+}
+
+// Erasing needs a filled table, so every key is inserted again right
+// after it was erased. Subtract insert to get the cost of erase alone.
+static struct simple_error *bench_hashtable_erase_insert(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_hashtable_lookup *lookup = context;
+    struct simple_error *error = NULL;
+    bool erased;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        for (size_t j = 0; !error && j < lookup->count; j++) {
+            error = simple_hashtable_erase(lookup->table, lookup->keys[j],
+                &erased);
+            if (!error) {
+                error = simple_hashtable_insert(lookup->table,
+                    lookup->keys[j], lookup->keys[j]);
+            }
+        }
+    }
+    return error;
+}
+
+// keys are looked up in a shuffled order so batches cannot ride on the
+// order entries were allocated in
+static struct simple_error *bench_hashtable_setup(
+    struct bench_hashtable_lookup *lookup,
+    const struct type *int_type,
+    size_t count,
+    size_t capacity
+) {
+    struct simple_error *error = NULL;
+    struct object **keys = calloc(count, sizeof *keys);
+    for (size_t j = 0; !error && j < count; j++) {
+        error = object_new_int((int)j, keys + j);
+    }
+    bench_shuffle(keys, count, sizeof *keys);
+
+    *lookup = (struct bench_hashtable_lookup) {
+        .type = int_type,
+        .keys = (const struct object **)keys,
+        .count = count,
+        .table = simple_hashtable_new_with_capacity(int_type, int_type,
+            capacity),
+        .results = calloc(count, sizeof *lookup->results)
+    };
+    simple_error_check(error);
+
+    error = simple_hashtable_insert_many(lookup->table, lookup->keys,
+        lookup->keys, count);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *bench_hashtable(
+    struct simple_test_item *root
+) {
+    struct simple_test_item *hashtable, *load;
+    struct type *int_type;
+    struct simple_error *error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    hashtable = simple_test_create_node(root, "hashtable");
+    for (size_t i = 0; i < bench_hashtable_size_count; i++) {
+        size_t count = bench_hashtable_sizes[i];
+        struct bench_hashtable_lookup *lookup = bench_hashtable_lookups + i;
+        error = bench_hashtable_setup(lookup, int_type, count, 0);
+        simple_error_check(error);
+
+        struct simple_test_item *size;
+        size = bench_create_size_node(hashtable, "entries_", count);
+        simple_test_create_bench(size, "insert", bench_hashtable_insert,
+            lookup, count);
+        simple_test_create_bench(size, "insert_many",
+            bench_hashtable_insert_many, lookup, count);
+        simple_test_create_bench(size, "find", bench_hashtable_find, lookup,
+            count);
+        simple_test_create_bench(size, "find_many", bench_hashtable_find_many,
+            lookup, count);
+        simple_test_create_bench(size, "erase_insert",
+            bench_hashtable_erase_insert, lookup, count);
+    }
+
+    load = simple_test_create_node(hashtable, "load");
+    for (size_t i = 0; i < BENCH_COUNT(bench_hashtable_loads); i++) {
+        struct bench_hashtable_lookup *lookup = bench_hashtable_loads + i;
+        error = bench_hashtable_setup(lookup, int_type,
+            BENCH_HASHTABLE_LOAD_ENTRIES, BENCH_HASHTABLE_LOAD_ENTRIES << i);
+        simple_error_check(error);
+
+        struct simple_test_item *capacity;
+        capacity = bench_create_size_node(load, "capacity_x", (size_t)1 << i);
+        simple_test_create_bench(capacity, "find", bench_hashtable_find,
+            lookup, BENCH_HASHTABLE_LOAD_ENTRIES);
+    }
+
+    cleanup:
+    return error;
+}
+
+static void bench_hashtable_release(
+    void
+) {
+    for (size_t i = 0; i < BENCH_COUNT(bench_hashtable_sizes); i++) {
+        simple_hashtable_destroy(bench_hashtable_lookups[i].table);
+        free(bench_hashtable_lookups[i].results);
+        free(bench_hashtable_lookups[i].keys);
+    }
+    for (size_t i = 0; i < BENCH_COUNT(bench_hashtable_loads); i++) {
+        simple_hashtable_destroy(bench_hashtable_loads[i].table);
+        free(bench_hashtable_loads[i].results);
+        free(bench_hashtable_loads[i].keys);
+    }
+}
+
+struct bench_int_hashtable {
+    const struct type *type;
+    int64_t *keys;
+    const struct object *value;
+    size_t count;
+    struct simple_int_hashtable *table;
+};
+
+static struct bench_int_hashtable bench_int_hashtables[
+    BENCH_COUNT(bench_hashtable_sizes)];
+
+static struct simple_error *bench_int_hashtable_insert(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_int_hashtable *bench = context;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        struct simple_int_hashtable *table;
+        table = simple_int_hashtable_new(bench->type);
+        for (size_t j = 0; !error && j < bench->count; j++) {
+            error = simple_int_hashtable_insert(table, bench->keys[j],
+                bench->value);
+        }
+        simple_int_hashtable_destroy(table);
+    }
+    return error;
+}
+
+static struct simple_error *bench_int_hashtable_find(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_int_hashtable *bench = context;
+    struct simple_error *error = NULL;
+    struct object *found;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        for (size_t j = 0; !error && j < bench->count; j++) {
+            error = simple_int_hashtable_find(bench->table, bench->keys[j],
+                &found);
+            object_refcount_decrease(found);
+        }
+    }
+    return error;
+}
+
+// same shuffled keys as bench_hashtable, but unboxed
+static struct simple_error *bench_int_hashtable(
+    struct simple_test_item *root
+) {
+    struct simple_test_item *int_hashtable;
+    struct type *int_type;
+    struct object *value = NULL;
+    struct simple_error *error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    error = object_new_int(1, &value);
+    simple_error_check(error);
+
+    int_hashtable = simple_test_create_node(root, "int_hashtable");
+    for (size_t i = 0; i < bench_hashtable_size_count; i++) {
+        size_t count = bench_hashtable_sizes[i];
+        int64_t *keys = calloc(count, sizeof *keys);
+        for (size_t j = 0; j < count; j++) {
+            keys[j] = (int64_t)j;
+        }
+        bench_shuffle(keys, count, sizeof *keys);
+
+        struct bench_int_hashtable *bench = bench_int_hashtables + i;
+        *bench = (struct bench_int_hashtable) {
+            .type = int_type,
+            .keys = keys,
+            .value = value,
+            .count = count,
+            .table = simple_int_hashtable_new_with_capacity(int_type, count)
+        };
+        for (size_t j = 0; !error && j < count; j++) {
+            error = simple_int_hashtable_insert(bench->table, keys[j],
+                value);
+        }
+        simple_error_check(error);
+
+        struct simple_test_item *size;
+        size = bench_create_size_node(int_hashtable, "entries_", count);
+        simple_test_create_bench(size, "insert", bench_int_hashtable_insert,
+            bench, count);
+        simple_test_create_bench(size, "find", bench_int_hashtable_find,
+            bench, count);
+    }
+
+    cleanup:
+    return error;
+}
+
+static void bench_int_hashtable_release(
+    void
+) {
+    for (size_t i = 0; i < BENCH_COUNT(bench_hashtable_sizes); i++) {
+        simple_int_hashtable_destroy(bench_int_hashtables[i].table);
+        free(bench_int_hashtables[i].keys);
+    }
+}
+
+#define BENCH_CONCURRENT_KEYS 100000
+#define BENCH_CONCURRENT_MAX_THREADS 64
+
+static const unsigned bench_concurrent_read_percents[] = {100, 90, 50};
+
+struct bench_concurrent_shared {
+    struct simple_concurrent_hashtable *table;
+    struct simple_hashtable *locked_table;
+    pthread_mutex_t lock;
+    struct object **keys;
+};
+
+struct bench_concurrent_run {
+    struct bench_concurrent_shared *shared;
+    unsigned read_percent;
+    size_t thread_count;
+    bool locked;
+};
+
+struct bench_concurrent_thread {
+    const struct bench_concurrent_run *run;
+    uint64_t seed;
+    size_t iterations;
+    struct simple_error *error;
+};
+
+static struct bench_concurrent_shared bench_concurrent_shared;
+static struct bench_concurrent_run *bench_concurrent_runs;
+
+static void *bench_concurrent_worker(
+    void *pointer
+) {
+    struct bench_concurrent_thread *thread = pointer;
+    const struct bench_concurrent_run *run = thread->run;
+    struct bench_concurrent_shared *shared = run->shared;
+    uint64_t state = thread->seed;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < thread->iterations; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        const struct object *key = shared->keys[state % BENCH_CONCURRENT_KEYS];
+        bool read = (state >> 32) % 100 < run->read_percent;
+
+        if (run->locked) {
+            pthread_mutex_lock(&shared->lock);
+            if (read) {
+                struct object *found;
+                error = simple_hashtable_find(shared->locked_table, key,
+                    &found);
+                object_refcount_decrease(found);
+            } else {
+                error = simple_hashtable_insert(shared->locked_table, key,
+                    key);
+            }
+            pthread_mutex_unlock(&shared->lock);
+        } else if (read) {
+            const struct object *found;
+            error = simple_concurrent_hashtable_find(shared->table, key,
+                &found);
+        } else {
+            error = simple_concurrent_hashtable_insert(shared->table, key,
+                key);
+        }
+    }
+
+    thread->error = error;
+    return NULL;
+}
+
+// Every thread performs iterations operations, so one iteration is one
+// operation per thread and ops/s is the throughput over all of them.
+static struct simple_error *bench_concurrent_hashtable_run(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_concurrent_run *run = context;
+    pthread_t threads[BENCH_CONCURRENT_MAX_THREADS];
+    struct bench_concurrent_thread contexts[BENCH_CONCURRENT_MAX_THREADS];
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; i < run->thread_count; i++) {
+        contexts[i] = (struct bench_concurrent_thread) {
+            .run = run,
+            .seed = 0x9E3779B97F4A7C15ULL * (i + 1),
+            .iterations = iterations,
+            .error = NULL
+        };
+        pthread_create(threads + i, NULL, bench_concurrent_worker,
+            contexts + i);
+    }
+    for (size_t i = 0; i < run->thread_count; i++) {
+        pthread_join(threads[i], NULL);
+        if (error) {
+            simple_error_destroy(contexts[i].error);
+        } else {
+            error = contexts[i].error;
+        }
+    }
+    return error;
+}
+
+// compares against simple_hashtable behind one global mutex
+static struct simple_error *bench_concurrent_hashtable(
+    struct simple_test_item *root
+) {
+    struct bench_concurrent_shared *shared = &bench_concurrent_shared;
+    struct simple_test_item *concurrent;
+    struct type *int_type;
+    struct simple_error *error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    shared->keys = calloc(BENCH_CONCURRENT_KEYS, sizeof *shared->keys);
+    shared->table = simple_concurrent_hashtable_new(int_type, int_type);
+    shared->locked_table = simple_hashtable_new(int_type, int_type);
+    pthread_mutex_init(&shared->lock, NULL);
+
+    for (size_t i = 0; !error && i < BENCH_CONCURRENT_KEYS; i++) {
+        error = object_new_int((int)i, shared->keys + i);
+    }
+    simple_error_check(error);
+
+    error = simple_hashtable_insert_many(shared->locked_table,
+        (const struct object **)shared->keys,
+        (const struct object **)shared->keys, BENCH_CONCURRENT_KEYS);
+    simple_error_check(error);
+
+    for (size_t i = 0; !error && i < BENCH_CONCURRENT_KEYS; i++) {
+        error = simple_concurrent_hashtable_insert(shared->table,
+            shared->keys[i], shared->keys[i]);
+    }
+    simple_error_check(error);
+
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = cpu_count > 1 ? (size_t)cpu_count : 1;
+    if (max_threads > BENCH_CONCURRENT_MAX_THREADS) {
+        max_threads = BENCH_CONCURRENT_MAX_THREADS;
+    }
+
+    // two runs for every read ratio and power of two thread count
+    size_t run_count = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        run_count += 2 * BENCH_COUNT(bench_concurrent_read_percents);
+    }
+    bench_concurrent_runs = calloc(run_count, sizeof *bench_concurrent_runs);
+
+    concurrent = simple_test_create_node(root, "concurrent_hashtable");
+    struct bench_concurrent_run *run = bench_concurrent_runs;
+    for (size_t i = 0; i < BENCH_COUNT(bench_concurrent_read_percents);
+            i++) {
+        struct simple_test_item *reads;
+        reads = bench_create_size_node(concurrent, "reads_",
+            bench_concurrent_read_percents[i]);
+
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            struct simple_test_item *node;
+            node = bench_create_size_node(reads, "threads_", threads);
+
+            for (int locked = 0; locked < 2; locked++) {
+                *run = (struct bench_concurrent_run) {
+                    .shared = shared,
+                    .read_percent = bench_concurrent_read_percents[i],
+                    .thread_count = threads,
+                    .locked = locked
+                };
+                simple_test_create_bench(node, locked ? "global_lock" :
+                    "concurrent", bench_concurrent_hashtable_run, run,
+                    threads);
+                run++;
+            }
+        }
+    }
+
+    cleanup:
+    return error;
+}
+
+static void bench_concurrent_hashtable_release(
+    void
+) {
+    struct bench_concurrent_shared *shared = &bench_concurrent_shared;
+
+    if (!shared->keys) {
+        return;
+    }
+    pthread_mutex_destroy(&shared->lock);
+    simple_concurrent_hashtable_destroy(shared->table);
+    simple_hashtable_destroy(shared->locked_table);
+    free(shared->keys);
+    free(bench_concurrent_runs);
+}
+
+static const size_t bench_string_lengths[] = {8, 64, 1024};
+
+// results are stored here so the compiler cannot drop the measured calls
+static volatile size_t bench_sink;
+
+struct bench_string {
+    char *cstring;
+    struct simple_string *string, *copy;
+};
+
+static struct bench_string bench_strings[BENCH_COUNT(bench_string_lengths)];
+
+static struct simple_error *bench_string_new(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_string *bench = context;
+    for (size_t i = 0; i < iterations; i++) {
+        simple_string_destroy(simple_string_new(bench->cstring));
+    }
+    return NULL;
+}
+
+static struct simple_error *bench_string_copy(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_string *bench = context;
+    for (size_t i = 0; i < iterations; i++) {
+        simple_string_destroy(simple_string_copy(bench->string));
+    }
+    return NULL;
+}
+
+static struct simple_error *bench_string_hash(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_string *bench = context;
+    size_t hash = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        hash += simple_string_hash(bench->string);
+    }
+    bench_sink = hash;
+    return NULL;
+}
+
+// compares against an equal copy, so every character is looked at
+static struct simple_error *bench_string_equals(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_string *bench = context;
+    size_t equal = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        equal += simple_string_equals(bench->string, bench->copy);
+    }
+    bench_sink = equal;
+    return NULL;
+}
+
+static void bench_string(
+    struct simple_test_item *root
+) {
+    struct simple_test_item *string = simple_test_create_node(root, "string");
+
+    for (size_t i = 0; i < BENCH_COUNT(bench_string_lengths); i++) {
+        struct bench_string *bench = bench_strings + i;
+        bench->cstring = calloc(bench_string_lengths[i] + 1, 1);
+        for (size_t j = 0; j < bench_string_lengths[i]; j++) {
+            bench->cstring[j] = (char)('a' + j % 26);
+        }
+        bench->string = simple_string_new(bench->cstring);
+        bench->copy = simple_string_new(bench->cstring);
+
+        struct simple_test_item *length;
+        length = bench_create_size_node(string, "length_",
+            bench_string_lengths[i]);
+        simple_test_create_bench(length, "new", bench_string_new, bench, 1);
+        simple_test_create_bench(length, "copy", bench_string_copy, bench, 1);
+        simple_test_create_bench(length, "hash", bench_string_hash, bench, 1);
+        simple_test_create_bench(length, "equals", bench_string_equals,
+            bench, 1);
+    }
+}
+
+static void bench_string_release(
+    void
+) {
+    for (size_t i = 0; i < BENCH_COUNT(bench_string_lengths); i++) {
+        simple_string_destroy(bench_strings[i].string);
+        simple_string_destroy(bench_strings[i].copy);
+        free(bench_strings[i].cstring);
+    }
+}
+
+// an int and a string object, each with an equal second object
+struct bench_object {
+    struct object *value, *other;
+};
+
+static struct bench_object bench_objects[2];
+
+static struct simple_error *bench_object_new_int(
+    void *context,
+    size_t iterations
+) {
+    struct simple_error *error = NULL;
+    struct object *o;
+
+    (void)context;
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = object_new_int((int)i, &o);
+        object_refcount_decrease(o);
+    }
+    return error;
+}
+
+static struct simple_error *bench_object_new_string(
+    void *context,
+    size_t iterations
+) {
+    struct simple_error *error = NULL;
+    struct object *o;
+
+    (void)context;
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = object_new_string(&o, "%s", "benchmark");
+        object_refcount_decrease(o);
+    }
+    return error;
+}
+
+static struct simple_error *bench_object_copy(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_object *bench = context;
+    struct simple_error *error = NULL;
+    struct object *copy;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = object_copy(bench->value, &copy);
+        object_refcount_decrease(copy);
+    }
+    return error;
+}
+
+static struct simple_error *bench_object_equals(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_object *bench = context;
+    struct simple_error *error = NULL;
+    bool equals;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = object_equals(bench->value, bench->other, &equals);
+    }
+    return error;
+}
+
+static struct simple_error *bench_object(
+    struct simple_test_item *root
+) {
+    struct simple_test_item *object, *kind;
+    struct simple_error *error;
+
+    error = object_new_int(42, &bench_objects[0].value);
+    simple_error_check(error);
+
+    error = object_new_int(42, &bench_objects[0].other);
+    simple_error_check(error);
+
+    error = object_new_string(&bench_objects[1].value, "%s", "benchmark");
+    simple_error_check(error);
+
+    error = object_new_string(&bench_objects[1].other, "%s", "benchmark");
+    simple_error_check(error);
+
+    object = simple_test_create_node(root, "object");
+    kind = simple_test_create_node(object, "int");
+    simple_test_create_bench(kind, "new", bench_object_new_int, NULL, 1);
+    simple_test_create_bench(kind, "copy", bench_object_copy,
+        bench_objects, 1);
+    simple_test_create_bench(kind, "equals", bench_object_equals,
+        bench_objects, 1);
+
+    kind = simple_test_create_node(object, "string");
+    simple_test_create_bench(kind, "new", bench_object_new_string, NULL, 1);
+    simple_test_create_bench(kind, "copy", bench_object_copy,
+        bench_objects + 1, 1);
+    simple_test_create_bench(kind, "equals", bench_object_equals,
+        bench_objects + 1, 1);
+
+    cleanup:
+    return error;
+}
+
+// what int_print does per value, through a sink and through stdio
+static FILE *bench_output_file;
+static struct simple_sink *bench_output_sink;
+
+static struct simple_error *bench_output_write_sink(
+    void *context,
+    size_t iterations
+) {
+    struct simple_sink *sink = context;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = simple_sink_write_int(sink, (int64_t)(i * 7919));
+        if (!error) {
+            error = simple_sink_write(sink, "\n", 1);
+        }
+    }
+    return error;
+}
+
+static struct simple_error *bench_output_write_stdio(
+    void *context,
+    size_t iterations
+) {
+    FILE *file = context;
+
+    for (size_t i = 0; i < iterations; i++) {
+        fprintf(file, "%d\n", (int)(i * 7919));
+    }
+    return NULL;
+}
+
+static void bench_output(
+    struct simple_test_item *root
+) {
+    bench_output_file = fopen("/dev/null", "w");
+    if (!bench_output_file) {
+        return;
+    }
+    bench_output_sink = simple_sink_new(fileno(bench_output_file));
+
+    struct simple_test_item *output = simple_test_create_node(root, "output");
+    simple_test_create_bench(output, "int_sink", bench_output_write_sink,
+        bench_output_sink, 1);
+    simple_test_create_bench(output, "int_stdio", bench_output_write_stdio,
+        bench_output_file, 1);
+}
+
+static void bench_output_release(
+    void
+) {
+    if (bench_output_file) {
+        struct simple_error *error = simple_sink_flush(bench_output_sink);
+        simple_error_destroy(error);
+        simple_sink_destroy(bench_output_sink);
+        fclose(bench_output_file);
+    }
+}
+
+// a dict of string keys and int values, encoded in the binary format and
+// as naive text with one tab separated key and value per line
+#define BENCH_SERIAL_ENTRIES 10000
+
+struct bench_serial {
+    struct object *dict;
+    FILE *file;
+    uint64_t *binary;
+    size_t binary_size;
+    char *text;
+    size_t text_size;
+    struct type *string_type, *int_type;
+};
+
+static struct bench_serial bench_serial_data;
+
+static struct simple_error *bench_serial_encode(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_serial *bench = context;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        rewind(bench->file);
+        struct simple_serial_writer *writer;
+        writer = simple_serial_writer_new(bench->file);
+        error = simple_serial_write(writer, bench->dict);
+        simple_serial_writer_destroy(writer);
+    }
+    return error;
+}
+
+static struct simple_error *bench_serial_decode(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_serial *bench = context;
+    struct simple_error *error = NULL;
+    struct simple_serial_reader *reader;
+    struct object *dict;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = simple_serial_reader_new(bench->binary, bench->binary_size,
+            &reader);
+        if (!error) {
+            error = simple_serial_read(reader, &dict);
+            object_refcount_decrease(dict);
+            simple_serial_reader_destroy(reader);
+        }
+    }
+    return error;
+}
+
+static struct simple_error *bench_serial_write_text(
+    const struct bench_serial *bench,
+    FILE *file
+) {
+    struct simple_error *error = NULL;
+    struct simple_hashtable *table;
+    struct simple_hashtable_iterator iterator;
+    const struct object *key, *value;
+    struct simple_string *string;
+    int number;
+
+    error = object_get_dict(bench->dict, &table);
+    simple_error_check(error);
+
+    simple_hashtable_iterator_init(&iterator, table);
+    while (simple_hashtable_iterator_next(&iterator, &key, &value)) {
+        error = object_get_string(key, &string);
+        simple_error_check(error);
+        error = object_get_int(value, &number);
+        simple_error_check(error);
+        fprintf(file, "%s\t%d\n", simple_string_get(string), number);
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *bench_serial_encode_text(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_serial *bench = context;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        rewind(bench->file);
+        error = bench_serial_write_text(bench, bench->file);
+    }
+    return error;
+}
+
+static struct simple_error *bench_serial_decode_text(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_serial *bench = context;
+    struct simple_error *error = NULL;
+    struct object *key = NULL, *value = NULL, *dict;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        struct simple_hashtable *table = simple_hashtable_new_with_capacity(
+            bench->string_type, bench->int_type, BENCH_SERIAL_ENTRIES);
+        const char *line = bench->text, *end = bench->text + bench->text_size;
+
+        while (line < end) {
+            const char *tab = strchr(line, '\t');
+            char *next;
+            error = object_new_string(&key, "%.*s", (int)(tab - line), line);
+            simple_error_check(error);
+            error = object_new_int((int)strtol(tab + 1, &next, 10), &value);
+            simple_error_check(error);
+            error = simple_hashtable_insert(table, key, value);
+            simple_error_check(error);
+            object_refcount_decrease(key);
+            object_refcount_decrease(value);
+            key = value = NULL;
+            line = next + 1;
+        }
+
+        error = object_new_dict(table, &dict);
+        simple_error_check(error);
+        object_refcount_decrease(dict);
+    }
+
+    cleanup:
+    object_refcount_decrease(key);
+    object_refcount_decrease(value);
+    return error;
+}
+
+static struct simple_error *bench_serial(
+    struct simple_test_item *root
+) {
+    struct bench_serial *bench = &bench_serial_data;
+    struct object *key = NULL, *value = NULL;
+    struct simple_serial_writer *writer;
+    char *binary = NULL;
+    FILE *file;
+
+    struct simple_error *error = type_registry_get_type("string",
+        &bench->string_type);
+    simple_error_check(error);
+    error = type_registry_get_type("int", &bench->int_type);
+    simple_error_check(error);
+
+    struct simple_hashtable *table = simple_hashtable_new_with_capacity(
+        bench->string_type, bench->int_type, BENCH_SERIAL_ENTRIES);
+    for (int i = 0; i < BENCH_SERIAL_ENTRIES; i++) {
+        error = object_new_string(&key, "reference/key/%08d", i * 7919);
+        simple_error_check(error);
+        error = object_new_int(i, &value);
+        simple_error_check(error);
+        error = simple_hashtable_insert(table, key, value);
+        simple_error_check(error);
+        object_refcount_decrease(key);
+        object_refcount_decrease(value);
+        key = value = NULL;
+    }
+    error = object_new_dict(table, &bench->dict);
+    simple_error_check(error);
+
+    // the binary form is copied to 8 byte aligned memory, as a map would be
+    file = open_memstream(&binary, &bench->binary_size);
+    writer = simple_serial_writer_new(file);
+    error = simple_serial_write(writer, bench->dict);
+    simple_serial_writer_destroy(writer);
+    fclose(file);
+    simple_error_check(error);
+    bench->binary = calloc(bench->binary_size / sizeof *bench->binary + 1,
+        sizeof *bench->binary);
+    memcpy(bench->binary, binary, bench->binary_size);
+
+    file = open_memstream(&bench->text, &bench->text_size);
+    error = bench_serial_write_text(bench, file);
+    fclose(file);
+    simple_error_check(error);
+
+    bench->file = tmpfile();
+    if (!bench->file) {
+        error = simple_error_new("%s", "Cannot create a temporary file.");
+        simple_error_check(error);
+    }
+
+    struct simple_test_item *serial = simple_test_create_node(root, "serial");
+    struct simple_test_item *format;
+    format = simple_test_create_node(serial, "binary");
+    simple_test_create_bench(format, "encode", bench_serial_encode, bench,
+        BENCH_SERIAL_ENTRIES);
+    simple_test_create_bench(format, "decode", bench_serial_decode, bench,
+        BENCH_SERIAL_ENTRIES);
+    format = simple_test_create_node(serial, "text");
+    simple_test_create_bench(format, "encode", bench_serial_encode_text,
+        bench, BENCH_SERIAL_ENTRIES);
+    simple_test_create_bench(format, "decode", bench_serial_decode_text,
+        bench, BENCH_SERIAL_ENTRIES);
+
+    cleanup:
+    object_refcount_decrease(key);
+    object_refcount_decrease(value);
+    free(binary);
+    return error;
+}
+
+static void bench_serial_release(
+    void
+) {
+    struct bench_serial *bench = &bench_serial_data;
+    if (bench->file) {
+        fclose(bench->file);
+    }
+    free(bench->binary);
+    free(bench->text);
+}
+
+// a reference table of string keys and int values, built at startup the
+// usual way and mapped from a file written once
+#define BENCH_MAPPED_ENTRIES 100000
+
+struct bench_mapped {
+    struct type *string_type, *int_type;
+    const struct object **keys, **values;
+    struct simple_hashtable *source;
+    struct simple_mapped_hashtable *table;
+    char path[32];
+};
+
+static struct bench_mapped bench_mapped_data;
+
+static struct simple_error *bench_mapped_build(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_mapped *bench = context;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        struct simple_hashtable *table = simple_hashtable_new(
+            bench->string_type, bench->int_type);
+        error = simple_hashtable_insert_many(table, bench->keys,
+            bench->values, BENCH_MAPPED_ENTRIES);
+        simple_hashtable_destroy(table);
+    }
+    return error;
+}
+
+static struct simple_error *bench_mapped_open(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_mapped *bench = context;
+    struct simple_error *error = NULL;
+    struct simple_mapped_hashtable *table;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = simple_mapped_hashtable_open(bench->path, &table);
+        if (!error) {
+            simple_mapped_hashtable_destroy(table);
+        }
+    }
+    return error;
+}
+
+static struct simple_error *bench_mapped_find(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_mapped *bench = context;
+    struct simple_error *error = NULL;
+    struct object *found;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        for (size_t j = 0; !error && j < BENCH_MAPPED_ENTRIES; j++) {
+            error = simple_mapped_hashtable_find(bench->table,
+                bench->keys[j], &found);
+            object_refcount_decrease(found);
+        }
+    }
+    return error;
+}
+
+static struct simple_error *bench_mapped_find_hashtable(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_mapped *bench = context;
+    struct simple_error *error = NULL;
+    struct object *found;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        for (size_t j = 0; !error && j < BENCH_MAPPED_ENTRIES; j++) {
+            error = simple_hashtable_find(bench->source, bench->keys[j],
+                &found);
+            object_refcount_decrease(found);
+        }
+    }
+    return error;
+}
+
+static struct simple_error *bench_mapped(
+    struct simple_test_item *root
+) {
+    struct bench_mapped *bench = &bench_mapped_data;
+    struct object **keys, **values;
+    FILE *file = NULL;
+
+    struct simple_error *error = type_registry_get_type("string",
+        &bench->string_type);
+    simple_error_check(error);
+    error = type_registry_get_type("int", &bench->int_type);
+    simple_error_check(error);
+
+    keys = calloc(BENCH_MAPPED_ENTRIES, sizeof *keys);
+    values = calloc(BENCH_MAPPED_ENTRIES, sizeof *values);
+    bench->keys = (const struct object **)keys;
+    bench->values = (const struct object **)values;
+    for (int i = 0; !error && i < BENCH_MAPPED_ENTRIES; i++) {
+        error = object_new_string(keys + i, "reference/key/%08d", i);
+        if (!error) {
+            error = object_new_int(i, values + i);
+        }
+    }
+    simple_error_check(error);
+
+    bench->source = simple_hashtable_new(bench->string_type,
+        bench->int_type);
+    error = simple_hashtable_insert_many(bench->source, bench->keys,
+        bench->values, BENCH_MAPPED_ENTRIES);
+    simple_error_check(error);
+    bench_shuffle(keys, BENCH_MAPPED_ENTRIES, sizeof *keys);
+
+    strcpy(bench->path, "/tmp/bench_mapped_XXXXXX");
+    file = fdopen(mkstemp(bench->path), "wb");
+    if (!file) {
+        error = simple_error_new("%s", "Cannot create a temporary file.");
+        simple_error_check(error);
+    }
+    error = simple_mapped_hashtable_write(bench->source, file);
+    simple_error_check(error);
+    error = simple_mapped_hashtable_open(bench->path, &bench->table);
+    simple_error_check(error);
+
+    struct simple_test_item *mapped, *size;
+    mapped = simple_test_create_node(root, "mapped_hashtable");
+    size = bench_create_size_node(mapped, "entries_", BENCH_MAPPED_ENTRIES);
+    simple_test_create_bench(size, "build", bench_mapped_build, bench, 1);
+    simple_test_create_bench(size, "open", bench_mapped_open, bench, 1);
+    simple_test_create_bench(size, "find", bench_mapped_find, bench,
+        BENCH_MAPPED_ENTRIES);
+    simple_test_create_bench(size, "find_hashtable",
+        bench_mapped_find_hashtable, bench, BENCH_MAPPED_ENTRIES);
+
+    cleanup:
+    if (file) {
+        fclose(file);
+    }
+    return error;
+}
+
+static void bench_mapped_release(
+    void
+) {
+    struct bench_mapped *bench = &bench_mapped_data;
+    simple_mapped_hashtable_destroy(bench->table);
+    simple_hashtable_destroy(bench->source);
+    free(bench->keys);
+    free(bench->values);
+    if (bench->path[0]) {
+        unlink(bench->path);
+    }
+}
+
+struct bench_dispatch {
+    struct object *target, *argument;
+    const char *method;
+};
+
+static struct bench_dispatch bench_dispatches[3];
+
+static struct simple_error *bench_dispatch_call(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_dispatch *bench = context;
+    struct simple_error *error = NULL;
+    struct object *result;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = object_call_method(bench->target, bench->method,
+            bench->argument, &result);
+    }
+    return error;
+}
+
+// the same assignment without looking up a member function
+static struct simple_error *bench_dispatch_direct(
+    void *context,
+    size_t iterations
+) {
+    const struct bench_dispatch *bench = context;
+    struct simple_error *error = NULL;
+    int value;
+
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = object_get_int(bench->argument, &value);
+        if (!error) {
+            error = object_set_int(bench->target, value);
+        }
+    }
+    return error;
+}
+
+static struct simple_error *bench_dispatch(
+    struct simple_test_item *root
+) {
+    struct simple_test_item *dispatch;
+    struct object *target, *argument;
+    struct simple_error *error;
+
+    error = object_new_int(0, &target);
+    simple_error_check(error);
+
+    error = object_new_int(7, &argument);
+    simple_error_check(error);
+
+    bench_dispatches[0] = (struct bench_dispatch) {target, NULL, "_init"};
+    bench_dispatches[1] = (struct bench_dispatch) {target, argument,
+        "_assign"};
+    bench_dispatches[2] = (struct bench_dispatch) {target, argument, NULL};
+
+    dispatch = simple_test_create_node(root, "dispatch");
+    simple_test_create_bench(dispatch, "int_init", bench_dispatch_call,
+        bench_dispatches, 1);
+    simple_test_create_bench(dispatch, "int_assign", bench_dispatch_call,
+        bench_dispatches + 1, 1);
+    simple_test_create_bench(dispatch, "int_assign_direct",
+        bench_dispatch_direct, bench_dispatches + 2, 1);
+
+    cleanup:
+    return error;
+}
+
+// Objects and types of replaced registries are never freed, which keeps
+// the objects of the other benchmarks valid. Registered last all the same,
+// so nothing created afterwards mixes types of different registries.
+static struct simple_error *bench_type_registry_new(
+    void *context,
+    size_t iterations
+) {
+    struct simple_error *error = NULL;
+
+    (void)context;
+    for (size_t i = 0; !error && i < iterations; i++) {
+        error = type_registry_destroy();
+        if (!error) {
+            error = type_registry_new();
+        }
+    }
+    return error;
+}
+
+// release functions of the benches set up so far, a bench is pushed
+// before its setup runs so one failing halfway is released as well
+static void (*bench_releases[16])(void);
+static size_t bench_release_count = 0;
+
+static void bench_push_release(
+    void (*release)(void)
+) {
+    assert(bench_release_count < BENCH_COUNT(bench_releases));
+    bench_releases[bench_release_count++] = release;
+}
+
+// usage: bench_simple [--large] [--perf] [--json path] [--save path]
+//     [--baseline path] [--threshold percent] [--profile path]
+//     [--heap path]
+// Results go to bench_simple.json by default, --perf adds hardware
+// counters. --save writes a baseline, --baseline compares against one, or
+// several saved ones concatenated, and exits with 2 when a benchmark
+// regressed by more than threshold percent, 5 by default. Errors exit with
+// 1. --profile samples member functions over the whole run and writes
+// folded stacks, --heap writes a heap snapshot at the end.
+int main(
+    int argc,
+    char **argv
+) {
+    const char *json_path = "bench_simple.json";
+    const char *save_path = NULL, *baseline_path = NULL;
+    const char *profile_path = NULL, *heap_path = NULL;
+    double threshold = 5;
+    size_t regressions = 0;
+    bool failed = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--large") == 0) {
+            bench_hashtable_size_count = BENCH_COUNT(bench_hashtable_sizes);
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            simple_test_set_perf_counters(true);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--heap") == 0 && i + 1 < argc) {
+            heap_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--large] [--perf] [--json path] "
+                "[--save path] [--baseline path] [--threshold percent] "
+                "[--profile path] [--heap path]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    simple_test_init();
+
+    struct simple_error *error = type_registry_new();
+    if (error) {
+        simple_error_show(error, stderr);
+        simple_error_destroy(error);
+        return 1;
+    }
+
+    FILE *json = fopen(json_path, "w");
+    if (!json) {
+        fprintf(stderr, "Cannot open '%s' for writing.\n", json_path);
+    }
+    simple_test_set_json_output(json);
+
+    // loaded before saving, so both may name the same file
+    FILE *baseline = NULL, *save = NULL;
+    if (baseline_path) {
+        baseline = fopen(baseline_path, "r");
+        if (!baseline) {
+            error = simple_error_new("Cannot open baseline '%s'.",
+                baseline_path);
+            simple_error_check(error);
+        }
+        error = simple_test_load_baseline(baseline, threshold / 100);
+        simple_error_check(error);
+    }
+    if (save_path) {
+        save = fopen(save_path, "w");
+        if (!save) {
+            error = simple_error_new("Cannot open '%s' for writing.",
+                save_path);
+            simple_error_check(error);
+        }
+        simple_test_set_baseline_output(save);
+    }
+
+    struct simple_test_item *root = simple_test_get_root();
+    bench_push_release(bench_bigint_release);
+    bench_bigint(root);
+    bench_push_release(bench_array_release);
+    bench_array(root);
+    bench_push_release(bench_hashtable_release);
+    error = bench_hashtable(root);
+    simple_error_check(error);
+
+    bench_push_release(bench_int_hashtable_release);
+    error = bench_int_hashtable(root);
+    simple_error_check(error);
+
+    bench_push_release(bench_concurrent_hashtable_release);
+    error = bench_concurrent_hashtable(root);
+    simple_error_check(error);
+
+    bench_push_release(bench_string_release);
+    bench_string(root);
+    error = bench_object(root);
+    simple_error_check(error);
+
+    bench_push_release(bench_output_release);
+    bench_output(root);
+
+    bench_push_release(bench_serial_release);
+    error = bench_serial(root);
+    simple_error_check(error);
+
+    bench_push_release(bench_mapped_release);
+    error = bench_mapped(root);
+    simple_error_check(error);
+    error = bench_dispatch(root);
+    simple_error_check(error);
+
+    struct simple_test_item *registry_node;
+    registry_node = simple_test_create_node(root, "type_registry");
+    simple_test_create_bench(registry_node, "new", bench_type_registry_new,
+        NULL, 1);
+
+    if (profile_path) {
+        error = simple_profile_start(0, 0);
+        simple_error_check(error);
+    }
+
+    simple_test_run();
+    regressions = simple_test_get_regression_count();
+
+    if (profile_path) {
+        simple_profile_stop();
+        FILE *profile = fopen(profile_path, "w");
+        if (!profile) {
+            error = simple_error_new("Cannot open '%s' for writing.",
+                profile_path);
+            simple_error_check(error);
+        }
+        simple_profile_write_folded(profile);
+        fclose(profile);
+    }
+
+    if (heap_path) {
+        FILE *heap = fopen(heap_path, "wb");
+        if (!heap) {
+            error = simple_error_new("Cannot open '%s' for writing.",
+                heap_path);
+            simple_error_check(error);
+        }
+        error = simple_heap_write_snapshot(heap);
+        fclose(heap);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    if (error) {
+        simple_error_show(error, stderr);
+        simple_error_destroy(error);
+        failed = true;
+    }
+
+    simple_test_destroy();
+    while (bench_release_count) {
+        bench_releases[--bench_release_count]();
+    }
+    if (json) {
+        fclose(json);
+    }
+    if (baseline) {
+        fclose(baseline);
+    }
+    if (save) {
+        fclose(save);
+    }
+
+    error = type_registry_destroy();
+    if (error) {
+        simple_error_show(error, stderr);
+        simple_error_destroy(error);
+        failed = true;
+    }
+    if (failed) {
+        return 1;
+    }
+    return regressions ? 2 : 0;
+}
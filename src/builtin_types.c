@@ -3,17 +3,49 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <assert.h>
+#include <limits.h>
+#include <malloc.h>
 
+#include "simple_array.h"
+#include "simple_bigint.h"
+#include "simple_btree.h"
 #include "simple_error.h"
+#include "simple_hamt.h"
+#include "simple_hashtable.h"
+#include "simple_list.h"
 #include "simple_object.h"
+#include "simple_sink.h"
+#include "simple_string.h"
+#include "simple_trace.h"
 #include "type.h"
 
+// The _print member functions write to the sink passed as argument, or to
+// the stdout sink without one. An uninitialized sink writes to stdout too.
+static struct simple_error *print_get_sink(
+    const struct object *args,
+    struct simple_sink **result
+) {
+    struct simple_error *error = NULL;
+    *result = NULL;
+
+    if (args) {
+        error = object_get_sink(args, result);
+        simple_error_check(error);
+    }
+    if (!*result) {
+        *result = simple_sink_get_stdout();
+    }
+
+    cleanup:
+    return error;
+}
+
 static struct simple_error *int_assign(
     struct object *o,
     const struct object *args,
     struct object **result
 ) {
-    printf("int assign was called!\n");
+    simple_trace_begin("int_assign");
 
     int value;
     struct simple_error *error;
@@ -27,6 +59,7 @@ static struct simple_error *int_assign(
     *result = o;
     
     cleanup:
+    simple_trace_end("int_assign");
     return error;
 }
 
@@ -35,7 +68,7 @@ static struct simple_error *int_init(
     const struct object *args,
     struct object **result
 ) {
-    printf("int init was called!\n");
+    simple_trace_begin("int_init");
 
     struct simple_error *error;
     if (args) {
@@ -47,6 +80,7 @@ static struct simple_error *int_init(
     }
 
     cleanup:
+    simple_trace_end("int_init");
     return error;
 }
 
@@ -55,57 +89,2111 @@ static struct simple_error *int_print(
     const struct object *args,
     struct object **result
 ) {
-    (void)args;
-
-    printf("int init was called!\n");
+    simple_trace_begin("int_print");
 
     int value;
+    struct simple_sink *sink;
     struct simple_error *error = object_get_int(o, &value);
     simple_error_check(error);
 
-    printf("%d\n", value);
+    error = print_get_sink(args, &sink);
+    simple_error_check(error);
+
+    error = simple_sink_write_int(sink, value);
+    simple_error_check(error);
+
+    error = simple_sink_write(sink, "\n", 1);
+    simple_error_check(error);
 
     *result = NULL;
     
     cleanup:
+    simple_trace_end("int_print");
     return error;
 }
 
-struct simple_error *register_builtin_types(
-    void
+// accepts int, bigint and decimal string arguments
+static struct simple_error *bigint_from_object(
+    const struct object *o,
+    struct simple_bigint **result
+) {
+    struct simple_error *error = NULL;
+
+    switch (object_get_kind(o)) {
+        case OBJECT_INTEGER: {
+            int value;
+            error = object_get_int(o, &value);
+            simple_error_check(error);
+            *result = simple_bigint_new(value);
+            break;
+        }
+        case OBJECT_BIGINT: {
+            const struct simple_bigint *value;
+            error = object_get_bigint(o, &value);
+            simple_error_check(error);
+            *result = simple_bigint_copy(value);
+            break;
+        }
+        case OBJECT_STRING: {
+            struct simple_string *value;
+            error = object_get_string((struct object *)o, &value);
+            simple_error_check(error);
+            error = simple_bigint_parse(simple_string_get(value), result);
+            simple_error_check(error);
+            break;
+        }
+        case OBJECT_FUNCTION:
+        case OBJECT_TYPE:
+        case OBJECT_ARRAY:
+        case OBJECT_LIST:
+        case OBJECT_DICT:
+        case OBJECT_FROZEN_DICT:
+        case OBJECT_SORTED_DICT:
+        case OBJECT_SINK:
+            error = simple_error_new("Cannot convert %s to bigint.",
+                object_kind_get_name(object_get_kind(o)));
+            simple_error_check(error);
+    }
+
+    cleanup:
+    if (error) {
+        *result = NULL;
+    }
+    return error;
+}
+
+static struct simple_error *bigint_assign(
+    struct object *o,
+    const struct object *args,
+    struct object **result
 ) {
+    struct simple_bigint *value = NULL;
+    struct simple_error *error;
+
+    error = bigint_from_object(args, &value);
+    simple_error_check(error);
+
+    error = object_set_bigint(o, value);
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
 
+static struct simple_error *bigint_init(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
     struct simple_error *error;
-    struct type *int_type, *func_type;
-    struct object *function = NULL;
-    
-    
-    error = type_registry_create_type("int", &int_type);
+    if (args) {
+        error = bigint_assign(o, args, result);
+        simple_error_check(error);
+    } else {
+        error = object_set_bigint(o, simple_bigint_new(0));
+        simple_error_check(error);
+        *result = o;
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *bigint_binary_operation(
+    struct object *o,
+    const struct object *args,
+    struct object **result,
+    struct simple_bigint *(*operation)(
+        const struct simple_bigint *lhs,
+        const struct simple_bigint *rhs
+    )
+) {
+    const struct simple_bigint *lhs;
+    struct simple_bigint *rhs = NULL;
+    struct simple_error *error;
+
+    *result = NULL;
+
+    error = object_get_bigint(o, &lhs);
     simple_error_check(error);
 
-    error = object_new_function(int_init, &function);
+    error = bigint_from_object(args, &rhs);
     simple_error_check(error);
 
-    error = type_set_attribute(int_type, "_init", function);
+    error = object_new_bigint(operation(lhs, rhs), result);
     simple_error_check(error);
 
-    error = object_new_function(int_assign, &function);
+    cleanup:
+    simple_bigint_destroy(rhs);
+    return error;
+}
+
+static struct simple_error *bigint_add(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return bigint_binary_operation(o, args, result, simple_bigint_add);
+}
+
+static struct simple_error *bigint_sub(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return bigint_binary_operation(o, args, result, simple_bigint_sub);
+}
+
+static struct simple_error *bigint_mul(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return bigint_binary_operation(o, args, result, simple_bigint_mul);
+}
+
+static struct simple_error *bigint_print(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    const struct simple_bigint *value;
+    struct simple_sink *sink;
+    char *decimal = NULL;
+    struct simple_error *error = object_get_bigint(o, &value);
     simple_error_check(error);
 
-    error = type_set_attribute(int_type, "_assign", function);
+    error = print_get_sink(args, &sink);
     simple_error_check(error);
 
-    error = object_new_function(int_print, &function);
+    decimal = simple_bigint_to_decimal(value);
+    error = simple_sink_write_string(sink, decimal);
     simple_error_check(error);
 
-    error = type_set_attribute(int_type, "_print", function);
+    error = simple_sink_write(sink, "\n", 1);
     simple_error_check(error);
 
-    error = type_registry_create_type("func", &func_type);
+    *result = NULL;
+
+    cleanup:
+    free(decimal);
+    return error;
+}
+
+static struct simple_error *object_from_int64(
+    int64_t value,
+    struct object **result
+) {
+    if (value >= INT_MIN && value <= INT_MAX) {
+        return object_new_int((int)value, result);
+    }
+    return object_new_bigint(simple_bigint_new(value), result);
+}
+
+static struct simple_error *int64_from_object(
+    const struct object *o,
+    int64_t *result
+) {
+    struct simple_error *error = NULL;
+    *result = 0;
+
+    if (object_get_kind(o) == OBJECT_BIGINT) {
+        const struct simple_bigint *value;
+        error = object_get_bigint(o, &value);
+        simple_error_check(error);
+
+        if (!simple_bigint_get_int64(value, result)) {
+            error = simple_error_new("%s", "Bigint does not fit in 64 bits.");
+            simple_error_check(error);
+        }
+    } else {
+        int value;
+        error = object_get_int(o, &value);
+        simple_error_check(error);
+        *result = value;
+    }
+
+    cleanup:
+    return error;
+}
+
+// there is no float object, float64 values travel as arrays of length one
+static struct simple_error *array_value_to_object(
+    enum simple_array_element element,
+    union simple_array_value value,
+    struct object **result
+) {
+    if (element == SIMPLE_ARRAY_FLOAT64) {
+        struct simple_array *scalar = simple_array_new(element, 1);
+        simple_array_append(scalar, value);
+        return object_new_array(scalar, result);
+    }
+    return object_from_int64(value.integer, result);
+}
+
+static struct simple_error *array_value_from_object(
+    enum simple_array_element element,
+    const struct object *o,
+    union simple_array_value *result
+) {
+    struct simple_error *error = NULL;
+
+    if (object_get_kind(o) == OBJECT_ARRAY) {
+        struct simple_array *array;
+        error = object_get_array(o, &array);
+        simple_error_check(error);
+
+        if (simple_array_length(array) != 1) {
+            error = simple_error_new("Expected array of length 1, got %zu.",
+                simple_array_length(array));
+            simple_error_check(error);
+        }
+
+        error = simple_array_get(array, 0, result);
+        simple_error_check(error);
+
+        if (simple_array_get_element(array) == SIMPLE_ARRAY_FLOAT64 &&
+                element != SIMPLE_ARRAY_FLOAT64) {
+            result->integer = (int64_t)result->real;
+        } else if (simple_array_get_element(array) != SIMPLE_ARRAY_FLOAT64 &&
+                element == SIMPLE_ARRAY_FLOAT64) {
+            result->real = (double)result->integer;
+        }
+    } else {
+        int64_t value;
+        error = int64_from_object(o, &value);
+        simple_error_check(error);
+
+        if (element == SIMPLE_ARRAY_FLOAT64) {
+            result->real = (double)value;
+        } else {
+            result->integer = value;
+        }
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *array_init(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_error *error;
+    enum simple_array_element element = SIMPLE_ARRAY_INT64;
+
+    if (args) {
+        struct simple_string *name;
+        error = object_get_string((struct object *)args, &name);
+        simple_error_check(error);
+
+        error = simple_array_element_from_name(simple_string_get(name),
+            &element);
+        simple_error_check(error);
+    }
+
+    error = object_set_array(o, simple_array_new(element, 0));
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *array_append(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_array *array;
+    union simple_array_value value;
+    struct simple_error *error;
+
+    error = object_get_array(o, &array);
+    simple_error_check(error);
+
+    error = array_value_from_object(simple_array_get_element(array), args,
+        &value);
+    simple_error_check(error);
+
+    simple_array_append(array, value);
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *array_len(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+
+    struct simple_array *array;
+    struct simple_error *error = object_get_array(o, &array);
+    simple_error_check(error);
+
+    error = object_from_int64((int64_t)simple_array_length(array), result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *array_get(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_array *array;
+    union simple_array_value value;
+    int64_t index;
+    struct simple_error *error;
+
+    error = object_get_array(o, &array);
+    simple_error_check(error);
+
+    error = int64_from_object(args, &index);
+    simple_error_check(error);
+
+    if (index < 0) {
+        index += (int64_t)simple_array_length(array);
+    }
+
+    error = simple_array_get(array, (size_t)index, &value);
+    simple_error_check(error);
+
+    error = array_value_to_object(simple_array_get_element(array), value,
+        result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *array_reduction(
+    struct object *o,
+    struct object **result,
+    struct simple_error *(*reduce)(
+        const struct simple_array *array,
+        union simple_array_value *result
+    )
+) {
+    struct simple_array *array;
+    union simple_array_value value;
+    struct simple_error *error;
+
+    error = object_get_array(o, &array);
+    simple_error_check(error);
+
+    error = reduce(array, &value);
+    simple_error_check(error);
+
+    // a mask sums to a count
+    enum simple_array_element element = simple_array_get_element(array);
+    error = array_value_to_object(element, value, result);
     simple_error_check(error);
 
     cleanup:
-        object_refcount_decrease(function);
+    return error;
+}
+
+static struct simple_error *array_sum(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return array_reduction(o, result, simple_array_sum);
+}
+
+static struct simple_error *array_min(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return array_reduction(o, result, simple_array_min);
+}
+
+static struct simple_error *array_max(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return array_reduction(o, result, simple_array_max);
+}
+
+static struct simple_error *array_arithmetic(
+    struct object *o,
+    const struct object *args,
+    struct object **result,
+    enum simple_array_operation operation
+) {
+    struct simple_array *lhs, *rhs, *array;
+    struct simple_error *error;
+
+    *result = NULL;
+
+    error = object_get_array(o, &lhs);
+    simple_error_check(error);
+
+    error = object_get_array(args, &rhs);
+    simple_error_check(error);
+
+    error = simple_array_arithmetic(lhs, rhs, operation, &array);
+    simple_error_check(error);
 
+    error = object_new_array(array, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *array_add(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return array_arithmetic(o, args, result, SIMPLE_ARRAY_ADD);
+}
+
+static struct simple_error *array_sub(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return array_arithmetic(o, args, result, SIMPLE_ARRAY_SUB);
+}
+
+static struct simple_error *array_mul(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return array_arithmetic(o, args, result, SIMPLE_ARRAY_MUL);
+}
+
+static struct simple_error *array_compare(
+    struct object *o,
+    const struct object *args,
+    struct object **result,
+    enum simple_array_comparison comparison
+) {
+    struct simple_array *array, *mask;
+    union simple_array_value scalar;
+    struct simple_error *error;
+
+    *result = NULL;
+
+    error = object_get_array(o, &array);
+    simple_error_check(error);
+
+    error = array_value_from_object(simple_array_get_element(array), args,
+        &scalar);
+    simple_error_check(error);
+
+    error = simple_array_compare(array, comparison, scalar, &mask);
+    simple_error_check(error);
+
+    error = object_new_array(mask, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *array_lt(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return array_compare(o, args, result, SIMPLE_ARRAY_LT);
+}
+
+static struct simple_error *array_le(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return array_compare(o, args, result, SIMPLE_ARRAY_LE);
+}
+
+static struct simple_error *array_gt(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return array_compare(o, args, result, SIMPLE_ARRAY_GT);
+}
+
+static struct simple_error *array_ge(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return array_compare(o, args, result, SIMPLE_ARRAY_GE);
+}
+
+static struct simple_error *array_eq(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return array_compare(o, args, result, SIMPLE_ARRAY_EQ);
+}
+
+static struct simple_error *array_ne(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return array_compare(o, args, result, SIMPLE_ARRAY_NE);
+}
+
+static struct simple_error *array_filter(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_array *array, *mask, *filtered;
+    struct simple_error *error;
+
+    *result = NULL;
+
+    error = object_get_array(o, &array);
+    simple_error_check(error);
+
+    error = object_get_array(args, &mask);
+    simple_error_check(error);
+
+    error = simple_array_filter(array, mask, &filtered);
+    simple_error_check(error);
+
+    error = object_new_array(filtered, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *array_print(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_array *array;
+    struct simple_sink *sink;
+    struct simple_error *error = object_get_array(o, &array);
+    simple_error_check(error);
+
+    error = print_get_sink(args, &sink);
+    simple_error_check(error);
+
+    enum simple_array_element element = simple_array_get_element(array);
+    error = simple_sink_write(sink, "[", 1);
+    simple_error_check(error);
+
+    for (size_t i = 0; i < simple_array_length(array); i++) {
+        union simple_array_value value;
+        error = simple_array_get(array, i, &value);
+        simple_error_check(error);
+
+        if (i) {
+            error = simple_sink_write(sink, ", ", 2);
+            simple_error_check(error);
+        }
+        if (element == SIMPLE_ARRAY_FLOAT64) {
+            error = simple_sink_write_double(sink, value.real);
+        } else {
+            error = simple_sink_write_int(sink, value.integer);
+        }
+        simple_error_check(error);
+    }
+
+    error = simple_sink_write(sink, "]\n", 2);
+    simple_error_check(error);
+
+    *result = NULL;
+
+    cleanup:
+    return error;
+}
+
+// a negative index counts from the back, like in most scripting languages
+static struct simple_error *list_index_from_object(
+    const struct simple_list *list,
+    const struct object *o,
+    size_t *result
+) {
+    int64_t index;
+    struct simple_error *error = int64_from_object(o, &index);
+    simple_error_check(error);
+
+    if (index < 0) {
+        index += (int64_t)simple_list_size(list);
+    }
+    *result = index < 0 ? SIZE_MAX : (size_t)index;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *list_init(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_error *error;
+    struct simple_list *list = NULL;
+
+    if (!args) {
+        list = simple_list_new(0);
+    } else if (object_get_kind(args) == OBJECT_LIST) {
+        struct simple_list *other;
+        error = object_get_list(args, &other);
+        simple_error_check(error);
+        list = simple_list_copy(other);
+    } else {
+        // an int argument is a capacity hint
+        int64_t capacity;
+        error = int64_from_object(args, &capacity);
+        simple_error_check(error);
+        list = simple_list_new(capacity > 0 ? (size_t)capacity : 0);
+    }
+
+    error = object_set_list(o, list);
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *list_append(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_list *list;
+    struct simple_error *error = object_get_list(o, &list);
+    simple_error_check(error);
+
+    simple_list_append(list, (struct object *)args);
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *list_extend(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_list *list, *other;
+    struct simple_error *error;
+
+    error = object_get_list(o, &list);
+    simple_error_check(error);
+
+    error = object_get_list(args, &other);
+    simple_error_check(error);
+
+    simple_list_extend(list, other);
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *list_get(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_list *list;
+    size_t index;
+    struct simple_error *error;
+
+    error = object_get_list(o, &list);
+    simple_error_check(error);
+
+    error = list_index_from_object(list, args, &index);
+    simple_error_check(error);
+
+    error = simple_list_get(list, index, result);
+    simple_error_check(error);
+
+    object_refcount_increase(*result);
+
+    cleanup:
+    return error;
+}
+
+// args is a list holding the index and the new element
+static struct simple_error *list_set(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_list *list, *pair;
+    struct object *index_object, *element;
+    size_t index;
+    struct simple_error *error;
+
+    error = object_get_list(o, &list);
+    simple_error_check(error);
+
+    error = object_get_list(args, &pair);
+    simple_error_check(error);
+
+    error = simple_list_get(pair, 0, &index_object);
+    simple_error_check(error);
+
+    error = simple_list_get(pair, 1, &element);
+    simple_error_check(error);
+
+    error = list_index_from_object(list, index_object, &index);
+    simple_error_check(error);
+
+    error = simple_list_set(list, index, element);
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *list_pop(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+
+    struct simple_list *list;
+    struct simple_error *error = object_get_list(o, &list);
+    simple_error_check(error);
+
+    error = simple_list_pop(list, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *list_len(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+
+    struct simple_list *list;
+    struct simple_error *error = object_get_list(o, &list);
+    simple_error_check(error);
+
+    error = object_from_int64((int64_t)simple_list_size(list), result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *list_reserve(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_list *list;
+    int64_t capacity;
+    struct simple_error *error;
+
+    error = object_get_list(o, &list);
+    simple_error_check(error);
+
+    error = int64_from_object(args, &capacity);
+    simple_error_check(error);
+
+    if (capacity > 0) {
+        simple_list_reserve(list, (size_t)capacity);
+    }
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *list_shrink_to_fit(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+
+    struct simple_list *list;
+    struct simple_error *error = object_get_list(o, &list);
+    simple_error_check(error);
+
+    simple_list_shrink_to_fit(list);
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+// dicts map any hashable object to any object
+static struct simple_error *dict_table_new(
+    size_t capacity,
+    struct simple_hashtable **result
+) {
+    struct type *any_type;
+    struct simple_error *error;
+
+    error = type_registry_get_type("object", &any_type);
+    simple_error_check(error);
+
+    *result = simple_hashtable_new_with_capacity(any_type, any_type,
+        capacity);
+
+    cleanup:
+    if (error) {
+        *result = NULL;
+    }
+    return error;
+}
+
+// pairs are passed as lists holding the key and the value
+static struct simple_error *dict_pair_from_object(
+    const struct object *o,
+    struct object **key,
+    struct object **value
+) {
+    struct simple_list *pair;
+    struct simple_error *error;
+
+    error = object_get_list(o, &pair);
+    simple_error_check(error);
+
+    if (simple_list_size(pair) != 2) {
+        error = simple_error_new("Expected a [key, value] pair, got a list "
+            "of size %zu.", simple_list_size(pair));
+        simple_error_check(error);
+    }
+
+    error = simple_list_get(pair, 0, key);
+    simple_error_check(error);
+
+    error = simple_list_get(pair, 1, value);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *dict_load_entry(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    return simple_hashtable_insert(context, key, value);
+}
+
+// bulk load from a dict or a list of pairs, the table is sized once up front
+static struct simple_error *dict_load(
+    struct simple_hashtable *table,
+    const struct object *args
+) {
+    struct simple_error *error;
+    const struct object **keys = NULL, **values = NULL;
+
+    if (object_get_kind(args) == OBJECT_DICT) {
+        struct simple_hashtable *other;
+        error = object_get_dict(args, &other);
+        simple_error_check(error);
+
+        simple_hashtable_reserve(table, simple_hashtable_size(table) +
+            simple_hashtable_size(other));
+        error = simple_hashtable_foreach(other, dict_load_entry, table);
+        simple_error_check(error);
+    } else {
+        struct simple_list *pairs;
+        error = object_get_list(args, &pairs);
+        simple_error_check(error);
+
+        size_t count = simple_list_size(pairs);
+        keys = calloc(count, sizeof *keys);
+        values = calloc(count, sizeof *values);
+
+        for (size_t i = 0; i < count; i++) {
+            struct object *pair, *key, *value;
+            error = simple_list_get(pairs, i, &pair);
+            simple_error_check(error);
+
+            error = dict_pair_from_object(pair, &key, &value);
+            simple_error_check(error);
+
+            keys[i] = key;
+            values[i] = value;
+        }
+
+        error = simple_hashtable_insert_many(table, keys, values, count);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    free(keys);
+    free(values);
+    return error;
+}
+
+static struct simple_error *dict_init(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_error *error;
+    struct simple_hashtable *table = NULL;
+
+    if (!args) {
+        error = dict_table_new(0, &table);
+        simple_error_check(error);
+    } else if (object_get_kind(args) == OBJECT_INTEGER ||
+            object_get_kind(args) == OBJECT_BIGINT) {
+        // an int argument is a capacity hint
+        int64_t capacity;
+        error = int64_from_object(args, &capacity);
+        simple_error_check(error);
+
+        error = dict_table_new(capacity > 0 ? (size_t)capacity : 0, &table);
+        simple_error_check(error);
+    } else {
+        error = dict_table_new(0, &table);
+        simple_error_check(error);
+
+        error = dict_load(table, args);
+        simple_error_check(error);
+    }
+
+    error = object_set_dict(o, table);
+    table = NULL;
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    simple_hashtable_destroy(table);
+    return error;
+}
+
+static struct simple_error *dict_get(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_hashtable *table;
+    struct simple_error *error;
+
+    error = object_get_dict(o, &table);
+    simple_error_check(error);
+
+    error = simple_hashtable_find(table, args, result);
+    simple_error_check(error);
+
+    if (!*result) {
+        error = simple_error_new("%s", "Key not found in dict.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+// args is a list holding the key and the value
+static struct simple_error *dict_set(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_hashtable *table;
+    struct object *key, *value;
+    struct simple_error *error;
+
+    error = object_get_dict(o, &table);
+    simple_error_check(error);
+
+    error = dict_pair_from_object(args, &key, &value);
+    simple_error_check(error);
+
+    error = simple_hashtable_insert(table, key, value);
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *dict_del(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_hashtable *table;
+    bool erased;
+    struct simple_error *error;
+
+    error = object_get_dict(o, &table);
+    simple_error_check(error);
+
+    error = simple_hashtable_erase(table, args, &erased);
+    simple_error_check(error);
+
+    if (!erased) {
+        error = simple_error_new("%s", "Key not found in dict.");
+        simple_error_check(error);
+    }
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *dict_len(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+
+    struct simple_hashtable *table;
+    struct simple_error *error = object_get_dict(o, &table);
+    simple_error_check(error);
+
+    error = object_from_int64((int64_t)simple_hashtable_size(table), result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *dict_reserve(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_hashtable *table;
+    int64_t count;
+    struct simple_error *error;
+
+    error = object_get_dict(o, &table);
+    simple_error_check(error);
+
+    error = int64_from_object(args, &count);
+    simple_error_check(error);
+
+    if (count > 0) {
+        simple_hashtable_reserve(table, (size_t)count);
+    }
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *dict_update(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_hashtable *table;
+    struct simple_error *error;
+
+    error = object_get_dict(o, &table);
+    simple_error_check(error);
+
+    error = dict_load(table, args);
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+enum dict_view {
+    DICT_KEYS,
+    DICT_VALUES,
+    DICT_ITEMS
+};
+
+struct dict_view_state {
+    enum dict_view view;
+    struct simple_list *list;
+};
+
+// keys are copied, mutating one in place would corrupt the table
+static struct simple_error *dict_view_entry(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    struct dict_view_state *state = context;
+    struct object *key_copy = NULL, *item = NULL;
+    struct simple_error *error = NULL;
+
+    if (state->view != DICT_VALUES) {
+        error = object_copy(key, &key_copy);
+        simple_error_check(error);
+    }
+
+    switch (state->view) {
+        case DICT_KEYS:
+            simple_list_append(state->list, key_copy);
+            break;
+        case DICT_VALUES:
+            simple_list_append(state->list, (struct object *)value);
+            break;
+        case DICT_ITEMS: {
+            struct simple_list *pair = simple_list_new(2);
+            simple_list_append(pair, key_copy);
+            simple_list_append(pair, (struct object *)value);
+            error = object_new_list(pair, &item);
+            simple_error_check(error);
+            simple_list_append(state->list, item);
+            break;
+        }
+    }
+
+    cleanup:
+    object_refcount_decrease(key_copy);
+    object_refcount_decrease(item);
+    return error;
+}
+
+static struct simple_error *dict_make_view(
+    struct object *o,
+    enum dict_view view,
+    struct object **result
+) {
+    struct simple_hashtable *table;
+    struct simple_error *error;
+
+    error = object_get_dict(o, &table);
+    simple_error_check(error);
+
+    struct dict_view_state state = {
+        .view = view,
+        .list = simple_list_new(simple_hashtable_size(table))
+    };
+
+    error = simple_hashtable_foreach(table, dict_view_entry, &state);
+    if (error) {
+        simple_list_destroy(state.list);
+    }
+    simple_error_check(error);
+
+    error = object_new_list(state.list, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *dict_keys(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return dict_make_view(o, DICT_KEYS, result);
+}
+
+static struct simple_error *dict_values(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return dict_make_view(o, DICT_VALUES, result);
+}
+
+static struct simple_error *dict_items(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return dict_make_view(o, DICT_ITEMS, result);
+}
+
+// frozen dicts map any hashable object to any object, like dicts
+static struct simple_error *frozen_dict_map_new(
+    struct simple_hamt **result
+) {
+    struct type *any_type;
+    struct simple_error *error;
+
+    error = type_registry_get_type("object", &any_type);
+    simple_error_check(error);
+
+    *result = simple_hamt_new(any_type, any_type);
+
+    cleanup:
+    if (error) {
+        *result = NULL;
+    }
+    return error;
+}
+
+// context points at the map being built, which is replaced by a new one
+static struct simple_error *frozen_dict_load_entry(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    struct simple_hamt **map = context, *updated;
+    struct simple_error *error;
+
+    error = simple_hamt_insert(*map, key, value, &updated);
+    simple_error_check(error);
+
+    simple_hamt_release(*map);
+    *map = updated;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *frozen_dict_init(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_error *error = NULL;
+    struct simple_hamt *map = NULL;
+
+    if (args && object_get_kind(args) == OBJECT_FROZEN_DICT) {
+        // frozen dicts never change, sharing is as good as copying
+        const struct simple_hamt *other;
+        error = object_get_frozen_dict(args, &other);
+        simple_error_check(error);
+
+        map = simple_hamt_share(other);
+    } else {
+        error = frozen_dict_map_new(&map);
+        simple_error_check(error);
+    }
+
+    if (args && object_get_kind(args) == OBJECT_DICT) {
+        struct simple_hashtable *table;
+        error = object_get_dict(args, &table);
+        simple_error_check(error);
+
+        error = simple_hashtable_foreach(table, frozen_dict_load_entry, &map);
+        simple_error_check(error);
+    } else if (args && object_get_kind(args) != OBJECT_FROZEN_DICT) {
+        struct simple_list *pairs;
+        error = object_get_list(args, &pairs);
+        simple_error_check(error);
+
+        for (size_t i = 0; i < simple_list_size(pairs); i++) {
+            struct object *pair, *key, *value;
+            error = simple_list_get(pairs, i, &pair);
+            simple_error_check(error);
+
+            error = dict_pair_from_object(pair, &key, &value);
+            simple_error_check(error);
+
+            error = frozen_dict_load_entry(key, value, &map);
+            simple_error_check(error);
+        }
+    }
+
+    error = object_set_frozen_dict(o, map);
+    map = NULL;
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    simple_hamt_release(map);
+    return error;
+}
+
+static struct simple_error *frozen_dict_get(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    const struct simple_hamt *map;
+    const struct object *value;
+    struct simple_error *error;
+
+    *result = NULL;
+
+    error = object_get_frozen_dict(o, &map);
+    simple_error_check(error);
+
+    error = simple_hamt_find(map, args, &value);
+    simple_error_check(error);
+
+    if (!value) {
+        error = simple_error_new("%s", "Key not found in frozen_dict.");
+        simple_error_check(error);
+    }
+
+    *result = (struct object *)value;
+    object_refcount_increase(*result);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *frozen_dict_len(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+
+    const struct simple_hamt *map;
+    struct simple_error *error = object_get_frozen_dict(o, &map);
+    simple_error_check(error);
+
+    error = object_from_int64((int64_t)simple_hamt_size(map), result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+// args is a list holding the key and the value, o is left alone
+static struct simple_error *frozen_dict_with(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    const struct simple_hamt *map;
+    struct simple_hamt *updated;
+    struct object *key, *value;
+    struct simple_error *error;
+
+    error = object_get_frozen_dict(o, &map);
+    simple_error_check(error);
+
+    error = dict_pair_from_object(args, &key, &value);
+    simple_error_check(error);
+
+    error = simple_hamt_insert(map, key, value, &updated);
+    simple_error_check(error);
+
+    error = object_new_frozen_dict(updated, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+// a key that is not there is fine, the result then equals o
+static struct simple_error *frozen_dict_without(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    const struct simple_hamt *map;
+    struct simple_hamt *updated;
+    bool erased;
+    struct simple_error *error;
+
+    error = object_get_frozen_dict(o, &map);
+    simple_error_check(error);
+
+    error = simple_hamt_erase(map, args, &updated, &erased);
+    simple_error_check(error);
+
+    error = object_new_frozen_dict(updated, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *frozen_dict_make_view(
+    struct object *o,
+    enum dict_view view,
+    struct object **result
+) {
+    const struct simple_hamt *map;
+    struct simple_error *error;
+
+    error = object_get_frozen_dict(o, &map);
+    simple_error_check(error);
+
+    struct dict_view_state state = {
+        .view = view,
+        .list = simple_list_new(simple_hamt_size(map))
+    };
+
+    error = simple_hamt_foreach(map, dict_view_entry, &state);
+    if (error) {
+        simple_list_destroy(state.list);
+    }
+    simple_error_check(error);
+
+    error = object_new_list(state.list, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *frozen_dict_keys(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return frozen_dict_make_view(o, DICT_KEYS, result);
+}
+
+static struct simple_error *frozen_dict_values(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return frozen_dict_make_view(o, DICT_VALUES, result);
+}
+
+static struct simple_error *frozen_dict_items(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return frozen_dict_make_view(o, DICT_ITEMS, result);
+}
+
+// sorted dicts map any orderable object to any object
+static struct simple_error *sorted_dict_tree_new(
+    struct simple_btree **result
+) {
+    struct type *any_type;
+    struct simple_error *error;
+
+    error = type_registry_get_type("object", &any_type);
+    simple_error_check(error);
+
+    *result = simple_btree_new(any_type, any_type);
+
+    cleanup:
+    if (error) {
+        *result = NULL;
+    }
+    return error;
+}
+
+static struct simple_error *sorted_dict_load_entry(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    return simple_btree_insert(context, key, value);
+}
+
+static struct simple_error *sorted_dict_init(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_error *error = NULL;
+    struct simple_btree *tree = NULL;
+
+    if (args && object_get_kind(args) == OBJECT_SORTED_DICT) {
+        struct simple_btree *other;
+        error = object_get_sorted_dict(args, &other);
+        simple_error_check(error);
+
+        error = simple_btree_copy(other, &tree);
+        simple_error_check(error);
+    } else {
+        error = sorted_dict_tree_new(&tree);
+        simple_error_check(error);
+    }
+
+    if (args && object_get_kind(args) == OBJECT_DICT) {
+        struct simple_hashtable *table;
+        error = object_get_dict(args, &table);
+        simple_error_check(error);
+
+        error = simple_hashtable_foreach(table, sorted_dict_load_entry, tree);
+        simple_error_check(error);
+    } else if (args && object_get_kind(args) != OBJECT_SORTED_DICT) {
+        struct simple_list *pairs;
+        error = object_get_list(args, &pairs);
+        simple_error_check(error);
+
+        for (size_t i = 0; i < simple_list_size(pairs); i++) {
+            struct object *pair, *key, *value;
+            error = simple_list_get(pairs, i, &pair);
+            simple_error_check(error);
+
+            error = dict_pair_from_object(pair, &key, &value);
+            simple_error_check(error);
+
+            error = simple_btree_insert(tree, key, value);
+            simple_error_check(error);
+        }
+    }
+
+    error = object_set_sorted_dict(o, tree);
+    tree = NULL;
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    simple_btree_destroy(tree);
+    return error;
+}
+
+static struct simple_error *sorted_dict_get(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_btree *tree;
+    struct simple_error *error;
+
+    error = object_get_sorted_dict(o, &tree);
+    simple_error_check(error);
+
+    error = simple_btree_find(tree, args, result);
+    simple_error_check(error);
+
+    if (!*result) {
+        error = simple_error_new("%s", "Key not found in sorted_dict.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+// args is a list holding the key and the value
+static struct simple_error *sorted_dict_set(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_btree *tree;
+    struct object *key, *value;
+    struct simple_error *error;
+
+    error = object_get_sorted_dict(o, &tree);
+    simple_error_check(error);
+
+    error = dict_pair_from_object(args, &key, &value);
+    simple_error_check(error);
+
+    error = simple_btree_insert(tree, key, value);
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *sorted_dict_del(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_btree *tree;
+    bool erased;
+    struct simple_error *error;
+
+    error = object_get_sorted_dict(o, &tree);
+    simple_error_check(error);
+
+    error = simple_btree_erase(tree, args, &erased);
+    simple_error_check(error);
+
+    if (!erased) {
+        error = simple_error_new("%s", "Key not found in sorted_dict.");
+        simple_error_check(error);
+    }
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *sorted_dict_len(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+
+    struct simple_btree *tree;
+    struct simple_error *error = object_get_sorted_dict(o, &tree);
+    simple_error_check(error);
+
+    error = object_from_int64((int64_t)simple_btree_size(tree), result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+// entries in [low, high) in key order, a NULL bound is open
+static struct simple_error *sorted_dict_make_view(
+    struct object *o,
+    enum dict_view view,
+    const struct object *low,
+    const struct object *high,
+    struct object **result
+) {
+    struct simple_btree *tree;
+    struct simple_error *error;
+
+    error = object_get_sorted_dict(o, &tree);
+    simple_error_check(error);
+
+    struct dict_view_state state = {
+        .view = view,
+        .list = simple_list_new(low || high ? 0 : simple_btree_size(tree))
+    };
+
+    error = simple_btree_range(tree, low, high, dict_view_entry, &state);
+    if (error) {
+        simple_list_destroy(state.list);
+    }
+    simple_error_check(error);
+
+    error = object_new_list(state.list, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *sorted_dict_keys(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return sorted_dict_make_view(o, DICT_KEYS, NULL, NULL, result);
+}
+
+static struct simple_error *sorted_dict_values(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return sorted_dict_make_view(o, DICT_VALUES, NULL, NULL, result);
+}
+
+static struct simple_error *sorted_dict_items(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+    return sorted_dict_make_view(o, DICT_ITEMS, NULL, NULL, result);
+}
+
+// args is a list [low, high], the items with low <= key < high are returned
+static struct simple_error *sorted_dict_range(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct object *low, *high;
+    struct simple_error *error;
+
+    error = dict_pair_from_object(args, &low, &high);
+    simple_error_check(error);
+
+    error = sorted_dict_make_view(o, DICT_ITEMS, low, high, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+// Like _range, a list holding the [key, value] pair at the bound if any.
+static struct simple_error *sorted_dict_bound(
+    struct object *o,
+    const struct object *args,
+    bool upper,
+    struct object **result
+) {
+    struct simple_btree *tree;
+    struct simple_btree_cursor cursor;
+    const struct object *key, *value;
+    struct simple_error *error;
+
+    error = object_get_sorted_dict(o, &tree);
+    simple_error_check(error);
+
+    if (upper) {
+        error = simple_btree_upper_bound(tree, args, &cursor);
+    } else {
+        error = simple_btree_lower_bound(tree, args, &cursor);
+    }
+    simple_error_check(error);
+
+    struct dict_view_state state = {
+        .view = DICT_ITEMS,
+        .list = simple_list_new(1)
+    };
+
+    if (simple_btree_cursor_next(&cursor, &key, &value)) {
+        error = dict_view_entry(key, value, &state);
+        if (error) {
+            simple_list_destroy(state.list);
+        }
+        simple_error_check(error);
+    }
+
+    error = object_new_list(state.list, result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *sorted_dict_lower_bound(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return sorted_dict_bound(o, args, false, result);
+}
+
+static struct simple_error *sorted_dict_upper_bound(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    return sorted_dict_bound(o, args, true, result);
+}
+
+// Without arguments the sink writes to stdout, otherwise to the fd given.
+static struct simple_error *sink_init(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_error *error = NULL;
+    struct simple_sink *sink = simple_sink_get_stdout();
+    int fd;
+
+    if (args) {
+        error = object_get_int(args, &fd);
+        simple_error_check(error);
+        sink = simple_sink_new(fd);
+    }
+
+    error = object_set_sink(o, sink);
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *sink_write(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_sink *sink;
+    struct simple_error *error = print_get_sink(o, &sink);
+    simple_error_check(error);
+
+    enum object_kind kind = object_get_kind(args);
+    if (kind == OBJECT_INTEGER) {
+        int value;
+        error = object_get_int(args, &value);
+        simple_error_check(error);
+        error = simple_sink_write_int(sink, value);
+        simple_error_check(error);
+    } else if (kind == OBJECT_STRING) {
+        struct simple_string *value;
+        error = object_get_string((struct object *)args, &value);
+        simple_error_check(error);
+        error = simple_sink_write_string(sink, simple_string_get(value));
+        simple_error_check(error);
+    } else {
+        error = simple_error_new("Cannot write %s to a sink.",
+            object_kind_get_name(kind));
+        simple_error_check(error);
+    }
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *sink_flush(
+    struct object *o,
+    const struct object *args,
+    struct object **result
+) {
+    (void)args;
+
+    struct simple_sink *sink;
+    struct simple_error *error = print_get_sink(o, &sink);
+    simple_error_check(error);
+
+    error = simple_sink_flush(sink);
+    simple_error_check(error);
+
+    *result = o;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *register_member_function(
+    struct type *type,
+    const char *name,
+    memberfunc_t func
+) {
+    struct simple_error *error;
+    struct object *function = NULL;
+
+    error = object_new_function(func, &function);
+    simple_error_check(error);
+
+    error = type_set_attribute(type, name, function);
+    simple_error_check(error);
+
+    cleanup:
+    object_refcount_decrease(function);
+    return error;
+}
+
+struct simple_error *register_builtin_types(
+    void
+) {
+
+    struct simple_error *error;
+    struct type *int_type, *bigint_type, *array_type, *list_type;
+    struct type *dict_type, *frozen_dict_type, *sorted_dict_type, *func_type;
+    struct type *sink_type;
+
+    error = type_registry_create_type("int", &int_type);
+    simple_error_check(error);
+
+    error = register_member_function(int_type, "_init", int_init);
+    simple_error_check(error);
+
+    error = register_member_function(int_type, "_assign", int_assign);
+    simple_error_check(error);
+
+    error = register_member_function(int_type, "_print", int_print);
+    simple_error_check(error);
+
+    error = type_registry_create_type("bigint", &bigint_type);
+    simple_error_check(error);
+
+    error = register_member_function(bigint_type, "_init", bigint_init);
+    simple_error_check(error);
+
+    error = register_member_function(bigint_type, "_assign", bigint_assign);
+    simple_error_check(error);
+
+    error = register_member_function(bigint_type, "_add", bigint_add);
+    simple_error_check(error);
+
+    error = register_member_function(bigint_type, "_sub", bigint_sub);
+    simple_error_check(error);
+
+    error = register_member_function(bigint_type, "_mul", bigint_mul);
+    simple_error_check(error);
+
+    error = register_member_function(bigint_type, "_print", bigint_print);
+    simple_error_check(error);
+
+    error = type_registry_create_type("array", &array_type);
+    simple_error_check(error);
+
+    static const struct {
+        const char *name;
+        memberfunc_t func;
+    } array_members[] = {
+        {"_init", array_init},
+        {"_append", array_append},
+        {"_len", array_len},
+        {"_get", array_get},
+        {"_sum", array_sum},
+        {"_min", array_min},
+        {"_max", array_max},
+        {"_add", array_add},
+        {"_sub", array_sub},
+        {"_mul", array_mul},
+        {"_lt", array_lt},
+        {"_le", array_le},
+        {"_gt", array_gt},
+        {"_ge", array_ge},
+        {"_eq", array_eq},
+        {"_ne", array_ne},
+        {"_filter", array_filter},
+        {"_print", array_print}
+    };
+
+    for (size_t i = 0; i < sizeof array_members / sizeof *array_members;
+            i++) {
+        error = register_member_function(array_type, array_members[i].name,
+            array_members[i].func);
+        simple_error_check(error);
+    }
+
+    error = type_registry_create_type("list", &list_type);
+    simple_error_check(error);
+
+    static const struct {
+        const char *name;
+        memberfunc_t func;
+    } list_members[] = {
+        {"_init", list_init},
+        {"_append", list_append},
+        {"_extend", list_extend},
+        {"_get", list_get},
+        {"_set", list_set},
+        {"_pop", list_pop},
+        {"_len", list_len},
+        {"_reserve", list_reserve},
+        {"_shrink_to_fit", list_shrink_to_fit}
+    };
+
+    for (size_t i = 0; i < sizeof list_members / sizeof *list_members; i++) {
+        error = register_member_function(list_type, list_members[i].name,
+            list_members[i].func);
+        simple_error_check(error);
+    }
+
+    error = type_registry_create_type("dict", &dict_type);
+    simple_error_check(error);
+
+    static const struct {
+        const char *name;
+        memberfunc_t func;
+    } dict_members[] = {
+        {"_init", dict_init},
+        {"_get", dict_get},
+        {"_set", dict_set},
+        {"_del", dict_del},
+        {"_len", dict_len},
+        {"_reserve", dict_reserve},
+        {"_update", dict_update},
+        {"_keys", dict_keys},
+        {"_values", dict_values},
+        {"_items", dict_items}
+    };
+
+    for (size_t i = 0; i < sizeof dict_members / sizeof *dict_members; i++) {
+        error = register_member_function(dict_type, dict_members[i].name,
+            dict_members[i].func);
+        simple_error_check(error);
+    }
+
+    error = type_registry_create_type("frozen_dict", &frozen_dict_type);
+    simple_error_check(error);
+
+    static const struct {
+        const char *name;
+        memberfunc_t func;
+    } frozen_dict_members[] = {
+        {"_init", frozen_dict_init},
+        {"_get", frozen_dict_get},
+        {"_len", frozen_dict_len},
+        {"_with", frozen_dict_with},
+        {"_without", frozen_dict_without},
+        {"_keys", frozen_dict_keys},
+        {"_values", frozen_dict_values},
+        {"_items", frozen_dict_items}
+    };
+
+    for (size_t i = 0;
+            i < sizeof frozen_dict_members / sizeof *frozen_dict_members;
+            i++) {
+        error = register_member_function(frozen_dict_type,
+            frozen_dict_members[i].name, frozen_dict_members[i].func);
+        simple_error_check(error);
+    }
+
+    error = type_registry_create_type("sorted_dict", &sorted_dict_type);
+    simple_error_check(error);
+
+    static const struct {
+        const char *name;
+        memberfunc_t func;
+    } sorted_dict_members[] = {
+        {"_init", sorted_dict_init},
+        {"_get", sorted_dict_get},
+        {"_set", sorted_dict_set},
+        {"_del", sorted_dict_del},
+        {"_len", sorted_dict_len},
+        {"_keys", sorted_dict_keys},
+        {"_values", sorted_dict_values},
+        {"_items", sorted_dict_items},
+        {"_range", sorted_dict_range},
+        {"_lower_bound", sorted_dict_lower_bound},
+        {"_upper_bound", sorted_dict_upper_bound}
+    };
+
+    for (size_t i = 0;
+            i < sizeof sorted_dict_members / sizeof *sorted_dict_members;
+            i++) {
+        error = register_member_function(sorted_dict_type,
+            sorted_dict_members[i].name, sorted_dict_members[i].func);
+        simple_error_check(error);
+    }
+
+    error = type_registry_create_type("sink", &sink_type);
+    simple_error_check(error);
+
+    static const struct {
+        const char *name;
+        memberfunc_t func;
+    } sink_members[] = {
+        {"_init", sink_init},
+        {"_write", sink_write},
+        {"_flush", sink_flush}
+    };
+
+    for (size_t i = 0; i < sizeof sink_members / sizeof *sink_members; i++) {
+        error = register_member_function(sink_type, sink_members[i].name,
+            sink_members[i].func);
+        simple_error_check(error);
+    }
+
+    error = type_registry_create_type("func", &func_type);
+    simple_error_check(error);
+
+    cleanup:
     return error;
 }
@@ -0,0 +1,55 @@
+#include "../simple_error.h"
+#include "../simple_heap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Reads a heap snapshot, see simple_heap.h, and reports the retained size
+// per type and the objects retaining the most.
+int main(
+    int argc,
+    char **argv
+) {
+    const char *path = NULL;
+    size_t top = 20;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "usage: %s [--top count] snapshot\n", argv[0]);
+        return 1;
+    }
+
+    struct simple_error *error = NULL;
+    struct simple_heap_snapshot *snapshot = NULL;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        error = simple_error_new("Cannot open heap snapshot '%s'.", path);
+        simple_error_check(error);
+    }
+
+    error = simple_heap_read_snapshot(file, &snapshot);
+    simple_error_check(error);
+    simple_heap_write_report(snapshot, stdout, top);
+
+    cleanup:
+    if (file) {
+        fclose(file);
+    }
+    simple_heap_snapshot_destroy(snapshot);
+    if (error) {
+        simple_error_show(error, stderr);
+        simple_error_destroy(error);
+        return 1;
+    }
+    return 0;
+}
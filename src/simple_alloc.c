@@ -0,0 +1,191 @@
+#include "simple_alloc.h"
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Only compiled in for instrumented builds, so one lock is good enough.
+// Sites are few, they are found by a linear scan over pointer keys.
+
+struct simple_alloc_site {
+    const char *filename;
+    size_t line;
+    const char *function;
+    const char *kind;
+    size_t allocations;
+    size_t bytes;
+};
+
+struct simple_alloc_type {
+    const char *name;
+    long live;
+    size_t created;
+};
+
+static pthread_mutex_t simple_alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct simple_alloc_site *simple_alloc_sites;
+static size_t simple_alloc_site_count, simple_alloc_site_capacity;
+static struct simple_alloc_type *simple_alloc_types;
+static size_t simple_alloc_type_count, simple_alloc_type_capacity;
+
+// grows array to hold one more element of size element_size
+static void *simple_alloc_reserve(
+    void *array,
+    size_t count,
+    size_t *capacity,
+    size_t element_size
+) {
+    if (count < *capacity) {
+        return array;
+    }
+    *capacity = *capacity ? *capacity * 2 : 32;
+    return realloc(array, *capacity * element_size);
+}
+
+void simple_alloc_record_site(
+    const char *filename,
+    size_t line,
+    const char *function,
+    const char *kind,
+    size_t bytes
+) {
+    pthread_mutex_lock(&simple_alloc_lock);
+
+    struct simple_alloc_site *site = NULL;
+    for (size_t i = 0; i < simple_alloc_site_count; i++) {
+        if (simple_alloc_sites[i].line == line &&
+                simple_alloc_sites[i].filename == filename &&
+                simple_alloc_sites[i].kind == kind) {
+            site = simple_alloc_sites + i;
+            break;
+        }
+    }
+
+    if (!site) {
+        simple_alloc_sites = simple_alloc_reserve(simple_alloc_sites,
+            simple_alloc_site_count, &simple_alloc_site_capacity,
+            sizeof *simple_alloc_sites);
+        site = simple_alloc_sites + simple_alloc_site_count++;
+        *site = (struct simple_alloc_site) {
+            .filename = filename,
+            .line = line,
+            .function = function,
+            .kind = kind,
+            .allocations = 0,
+            .bytes = 0
+        };
+    }
+
+    site->allocations++;
+    site->bytes += bytes;
+    pthread_mutex_unlock(&simple_alloc_lock);
+}
+
+void simple_alloc_live_update(
+    const char *type_name,
+    long delta
+) {
+    pthread_mutex_lock(&simple_alloc_lock);
+
+    struct simple_alloc_type *type = NULL;
+    for (size_t i = 0; i < simple_alloc_type_count; i++) {
+        if (simple_alloc_types[i].name == type_name) {
+            type = simple_alloc_types + i;
+            break;
+        }
+    }
+
+    if (!type) {
+        simple_alloc_types = simple_alloc_reserve(simple_alloc_types,
+            simple_alloc_type_count, &simple_alloc_type_capacity,
+            sizeof *simple_alloc_types);
+        type = simple_alloc_types + simple_alloc_type_count++;
+        *type = (struct simple_alloc_type) {
+            .name = type_name,
+            .live = 0,
+            .created = 0
+        };
+    }
+
+    type->live += delta;
+    if (delta > 0) {
+        type->created += (size_t)delta;
+    }
+    pthread_mutex_unlock(&simple_alloc_lock);
+}
+
+bool simple_alloc_enabled(
+    void
+) {
+#ifdef SIMPLE_ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void simple_alloc_get_totals(
+    struct simple_alloc_totals *result
+) {
+    *result = (struct simple_alloc_totals) {0, 0};
+
+    pthread_mutex_lock(&simple_alloc_lock);
+    for (size_t i = 0; i < simple_alloc_site_count; i++) {
+        result->allocations += simple_alloc_sites[i].allocations;
+        result->bytes += simple_alloc_sites[i].bytes;
+    }
+    pthread_mutex_unlock(&simple_alloc_lock);
+}
+
+static int simple_alloc_compare_sites(
+    const void *lhs,
+    const void *rhs
+) {
+    const struct simple_alloc_site *l = lhs, *r = rhs;
+    return (l->bytes < r->bytes) - (l->bytes > r->bytes);
+}
+
+void simple_alloc_census(
+    FILE *file
+) {
+    if (!simple_alloc_enabled()) {
+        fprintf(file, "%s\n", "Allocation tracking is not compiled in, "
+            "build with SIMPLE_ALLOC_TRACKING.");
+        return;
+    }
+
+    pthread_mutex_lock(&simple_alloc_lock);
+    qsort(simple_alloc_sites, simple_alloc_site_count,
+        sizeof *simple_alloc_sites, simple_alloc_compare_sites);
+
+    fprintf(file, "%12s %14s  %-16s %s\n", "allocations", "bytes", "kind",
+        "site");
+    for (size_t i = 0; i < simple_alloc_site_count; i++) {
+        const struct simple_alloc_site *site = simple_alloc_sites + i;
+        if (site->allocations) {
+            fprintf(file, "%12zu %14zu  %-16s %s:%zu %s()\n",
+                site->allocations, site->bytes, site->kind, site->filename,
+                site->line, site->function);
+        }
+    }
+
+    fprintf(file, "%12s %14s  %s\n", "live", "created", "type");
+    for (size_t i = 0; i < simple_alloc_type_count; i++) {
+        const struct simple_alloc_type *type = simple_alloc_types + i;
+        fprintf(file, "%12ld %14zu  %s\n", type->live, type->created,
+            type->name);
+    }
+    pthread_mutex_unlock(&simple_alloc_lock);
+}
+
+void simple_alloc_reset(
+    void
+) {
+    pthread_mutex_lock(&simple_alloc_lock);
+    for (size_t i = 0; i < simple_alloc_site_count; i++) {
+        simple_alloc_sites[i].allocations = 0;
+        simple_alloc_sites[i].bytes = 0;
+    }
+    pthread_mutex_unlock(&simple_alloc_lock);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Allocation accounting. Counts allocations and bytes by call site and
+// kind, and live objects by type. Recording is compiled in only with
+// SIMPLE_ALLOC_TRACKING defined (cmake -DSIMPLE_ALLOC_TRACKING=ON), without
+// it the macros below cost nothing and the census stays empty.
+
+#ifdef SIMPLE_ALLOC_TRACKING
+#define simple_alloc_record(kind, bytes) \
+    simple_alloc_record_site(__FILE__, __LINE__, __FUNCTION__, kind, bytes)
+#define simple_alloc_record_at(filename, line, function, kind, bytes) \
+    simple_alloc_record_site(filename, line, function, kind, bytes)
+#else
+#define simple_alloc_record(kind, bytes) ((void)(kind), (void)(bytes))
+#define simple_alloc_record_at(filename, line, function, kind, bytes) \
+    ((void)(filename), (void)(line), (void)(function), (void)(kind), \
+    (void)(bytes))
+#endif
+
+struct simple_alloc_totals {
+    size_t allocations;
+    size_t bytes;
+};
+
+// kind must outlive the census, in practice it is a string literal
+void simple_alloc_record_site(
+    const char *filename,
+    size_t line,
+    const char *function,
+    const char *kind,
+    size_t bytes
+);
+
+// Adds delta to the live objects of the type named type_name, which must
+// outlive the census.
+void simple_alloc_live_update(
+    const char *type_name,
+    long delta
+);
+
+bool simple_alloc_enabled(
+    void
+);
+
+// Totals over all call sites since the last reset.
+void simple_alloc_get_totals(
+    struct simple_alloc_totals *result
+);
+
+// Writes the call sites by bytes allocated, then the live objects by type.
+void simple_alloc_census(
+    FILE *file
+);
+
+// Clears the call site counts, live objects are kept.
+void simple_alloc_reset(
+    void
+);
@@ -0,0 +1,765 @@
+#include "simple_array.h"
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_error.h"
+
+#define SIMPLE_ARRAY_ALIGNMENT 64
+
+struct simple_array {
+    enum simple_array_element element;
+    size_t length, capacity;
+    void *data;
+};
+
+struct simple_array_kernels {
+    int64_t (*sum_int32)(const int32_t *values, size_t length);
+    int64_t (*sum_int64)(const int64_t *values, size_t length);
+    double (*sum_float64)(const double *values, size_t length);
+    int64_t (*sum_mask)(const uint8_t *values, size_t length);
+    void (*minmax_int32)(const int32_t *values, size_t length,
+        int32_t *min, int32_t *max);
+    void (*minmax_int64)(const int64_t *values, size_t length,
+        int64_t *min, int64_t *max);
+    void (*minmax_float64)(const double *values, size_t length,
+        double *min, double *max);
+    void (*arithmetic_int32)(const int32_t *lhs, const int32_t *rhs,
+        int32_t *result, size_t length, enum simple_array_operation operation);
+    void (*arithmetic_int64)(const int64_t *lhs, const int64_t *rhs,
+        int64_t *result, size_t length, enum simple_array_operation operation);
+    void (*arithmetic_float64)(const double *lhs, const double *rhs,
+        double *result, size_t length, enum simple_array_operation operation);
+    void (*compare_int32)(const int32_t *values, size_t length,
+        int32_t scalar, enum simple_array_comparison comparison,
+        uint8_t *mask);
+    void (*compare_int64)(const int64_t *values, size_t length,
+        int64_t scalar, enum simple_array_comparison comparison,
+        uint8_t *mask);
+    void (*compare_float64)(const double *values, size_t length,
+        double scalar, enum simple_array_comparison comparison,
+        uint8_t *mask);
+};
+
+// The kernels are written once with vector extensions and instantiated per
+// instruction set, the target attribute lets the compiler emit the wider
+// instructions in those copies only. Tails are padded into a full vector so
+// every element sees the same arithmetic.
+
+#define SIMPLE_ARRAY_SELECT(mask, lhs, rhs, vector, mask_vector) \
+    ((vector)(((mask_vector)(lhs) & (mask)) | ((mask_vector)(rhs) & ~(mask))))
+
+// loads narrow chunks so the widened accumulator is one register wide
+#define SIMPLE_ARRAY_DEFINE_SUM(isa, target, width, name, T, ACC) \
+target \
+static ACC simple_array_sum_##name##_##isa( \
+    const T *values, \
+    size_t length \
+) { \
+    typedef ACC wide_vector __attribute__((vector_size(width))); \
+    typedef T vector __attribute__((vector_size( \
+        width / sizeof(ACC) * sizeof(T)))); \
+    const size_t lanes = width / sizeof(ACC); \
+    wide_vector total = {0}; \
+    size_t i = 0; \
+    for (; i + lanes <= length; i += lanes) { \
+        vector chunk; \
+        memcpy(&chunk, values + i, sizeof chunk); \
+        total += __builtin_convertvector(chunk, wide_vector); \
+    } \
+    ACC result = 0; \
+    for (size_t lane = 0; lane < lanes; lane++) { \
+        result += total[lane]; \
+    } \
+    for (; i < length; i++) { \
+        result += (ACC)values[i]; \
+    } \
+    return result; \
+}
+
+#define SIMPLE_ARRAY_ELEMENTWISE(operator) \
+    for (; i + lanes <= length; i += lanes) { \
+        vector a, b; \
+        memcpy(&a, lhs + i, sizeof a); \
+        memcpy(&b, rhs + i, sizeof b); \
+        a = a operator b; \
+        memcpy(result + i, &a, sizeof a); \
+    } \
+    if (i < length) { \
+        vector a = {0}, b = {0}; \
+        memcpy(&a, lhs + i, (length - i) * sizeof *lhs); \
+        memcpy(&b, rhs + i, (length - i) * sizeof *rhs); \
+        a = a operator b; \
+        memcpy(result + i, &a, (length - i) * sizeof *result); \
+    }
+
+#define SIMPLE_ARRAY_COMPARE(operator) \
+    for (; i + lanes <= length; i += lanes) { \
+        vector chunk; \
+        memcpy(&chunk, values + i, sizeof chunk); \
+        mask_vector hit = chunk operator splat; \
+        byte_vector bytes = __builtin_convertvector(hit, byte_vector) & 1; \
+        memcpy(mask + i, &bytes, sizeof bytes); \
+    } \
+    if (i < length) { \
+        vector chunk = {0}; \
+        memcpy(&chunk, values + i, (length - i) * sizeof *values); \
+        mask_vector hit = chunk operator splat; \
+        byte_vector bytes = __builtin_convertvector(hit, byte_vector) & 1; \
+        memcpy(mask + i, &bytes, length - i); \
+    }
+
+#define SIMPLE_ARRAY_DEFINE_KERNELS(isa, target, width, name, T, IT) \
+target \
+static void simple_array_minmax_##name##_##isa( \
+    const T *values, \
+    size_t length, \
+    T *min, \
+    T *max \
+) { \
+    typedef T vector __attribute__((vector_size(width))); \
+    typedef IT mask_vector __attribute__((vector_size(width))); \
+    const size_t lanes = width / sizeof(T); \
+    vector low = (vector){0} + values[0], high = low; \
+    size_t i = 0; \
+    for (; i + lanes <= length; i += lanes) { \
+        vector chunk; \
+        memcpy(&chunk, values + i, sizeof chunk); \
+        mask_vector less = chunk < low, greater = chunk > high; \
+        low = SIMPLE_ARRAY_SELECT(less, chunk, low, vector, mask_vector); \
+        high = SIMPLE_ARRAY_SELECT(greater, chunk, high, vector, \
+            mask_vector); \
+    } \
+    *min = values[0]; \
+    *max = values[0]; \
+    for (size_t lane = 0; lane < lanes; lane++) { \
+        *min = low[lane] < *min ? low[lane] : *min; \
+        *max = high[lane] > *max ? high[lane] : *max; \
+    } \
+    for (; i < length; i++) { \
+        *min = values[i] < *min ? values[i] : *min; \
+        *max = values[i] > *max ? values[i] : *max; \
+    } \
+} \
+\
+target \
+static void simple_array_arithmetic_##name##_##isa( \
+    const T *lhs, \
+    const T *rhs, \
+    T *result, \
+    size_t length, \
+    enum simple_array_operation operation \
+) { \
+    typedef T vector __attribute__((vector_size(width))); \
+    const size_t lanes = width / sizeof(T); \
+    size_t i = 0; \
+    switch (operation) { \
+        case SIMPLE_ARRAY_ADD: \
+            SIMPLE_ARRAY_ELEMENTWISE(+) \
+            break; \
+        case SIMPLE_ARRAY_SUB: \
+            SIMPLE_ARRAY_ELEMENTWISE(-) \
+            break; \
+        case SIMPLE_ARRAY_MUL: \
+            SIMPLE_ARRAY_ELEMENTWISE(*) \
+            break; \
+    } \
+} \
+\
+target \
+static void simple_array_compare_##name##_##isa( \
+    const T *values, \
+    size_t length, \
+    T scalar, \
+    enum simple_array_comparison comparison, \
+    uint8_t *mask \
+) { \
+    typedef T vector __attribute__((vector_size(width))); \
+    typedef IT mask_vector __attribute__((vector_size(width))); \
+    typedef uint8_t byte_vector __attribute__((vector_size( \
+        width / sizeof(T)))); \
+    const size_t lanes = width / sizeof(T); \
+    const vector splat = (vector){0} + scalar; \
+    size_t i = 0; \
+    switch (comparison) { \
+        case SIMPLE_ARRAY_LT: \
+            SIMPLE_ARRAY_COMPARE(<) \
+            break; \
+        case SIMPLE_ARRAY_LE: \
+            SIMPLE_ARRAY_COMPARE(<=) \
+            break; \
+        case SIMPLE_ARRAY_GT: \
+            SIMPLE_ARRAY_COMPARE(>) \
+            break; \
+        case SIMPLE_ARRAY_GE: \
+            SIMPLE_ARRAY_COMPARE(>=) \
+            break; \
+        case SIMPLE_ARRAY_EQ: \
+            SIMPLE_ARRAY_COMPARE(==) \
+            break; \
+        case SIMPLE_ARRAY_NE: \
+            SIMPLE_ARRAY_COMPARE(!=) \
+            break; \
+    } \
+}
+
+#define SIMPLE_ARRAY_DEFINE_ISA(isa, target, width) \
+    SIMPLE_ARRAY_DEFINE_SUM(isa, target, width, int32, int32_t, int64_t) \
+    SIMPLE_ARRAY_DEFINE_SUM(isa, target, width, int64, int64_t, int64_t) \
+    SIMPLE_ARRAY_DEFINE_SUM(isa, target, width, float64, double, double) \
+    SIMPLE_ARRAY_DEFINE_SUM(isa, target, width, mask, uint8_t, int64_t) \
+    SIMPLE_ARRAY_DEFINE_KERNELS(isa, target, width, int32, int32_t, int32_t) \
+    SIMPLE_ARRAY_DEFINE_KERNELS(isa, target, width, int64, int64_t, int64_t) \
+    SIMPLE_ARRAY_DEFINE_KERNELS(isa, target, width, float64, double, \
+        int64_t) \
+    static const struct simple_array_kernels simple_array_kernels_##isa = { \
+        .sum_int32 = simple_array_sum_int32_##isa, \
+        .sum_int64 = simple_array_sum_int64_##isa, \
+        .sum_float64 = simple_array_sum_float64_##isa, \
+        .sum_mask = simple_array_sum_mask_##isa, \
+        .minmax_int32 = simple_array_minmax_int32_##isa, \
+        .minmax_int64 = simple_array_minmax_int64_##isa, \
+        .minmax_float64 = simple_array_minmax_float64_##isa, \
+        .arithmetic_int32 = simple_array_arithmetic_int32_##isa, \
+        .arithmetic_int64 = simple_array_arithmetic_int64_##isa, \
+        .arithmetic_float64 = simple_array_arithmetic_float64_##isa, \
+        .compare_int32 = simple_array_compare_int32_##isa, \
+        .compare_int64 = simple_array_compare_int64_##isa, \
+        .compare_float64 = simple_array_compare_float64_##isa \
+    };
+
+SIMPLE_ARRAY_DEFINE_ISA(generic, , 16)
+
+#if defined(__x86_64__)
+SIMPLE_ARRAY_DEFINE_ISA(sse42, __attribute__((target("sse4.2"))), 16)
+SIMPLE_ARRAY_DEFINE_ISA(avx2, __attribute__((target("avx2"))), 32)
+SIMPLE_ARRAY_DEFINE_ISA(avx512,
+    __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl"))), 64)
+#endif
+
+static bool simple_array_isa_detected;
+static enum simple_array_isa simple_array_detected_isa, simple_array_isa;
+
+static void simple_array_detect_isa(
+    void
+) {
+    if (simple_array_isa_detected) {
+        return;
+    }
+
+    enum simple_array_isa isa = SIMPLE_ARRAY_ISA_GENERIC;
+
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+            __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512dq") &&
+            __builtin_cpu_supports("avx512vl")) {
+        isa = SIMPLE_ARRAY_ISA_AVX512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        isa = SIMPLE_ARRAY_ISA_AVX2;
+    } else if (__builtin_cpu_supports("sse4.2")) {
+        isa = SIMPLE_ARRAY_ISA_SSE42;
+    }
+#endif
+
+    simple_array_detected_isa = isa;
+    simple_array_isa = isa;
+    simple_array_isa_detected = true;
+}
+
+static const struct simple_array_kernels *simple_array_get_kernels(
+    void
+) {
+    simple_array_detect_isa();
+
+#if defined(__x86_64__)
+    switch (simple_array_isa) {
+        case SIMPLE_ARRAY_ISA_GENERIC:
+            break;
+        case SIMPLE_ARRAY_ISA_SSE42:
+            return &simple_array_kernels_sse42;
+        case SIMPLE_ARRAY_ISA_AVX2:
+            return &simple_array_kernels_avx2;
+        case SIMPLE_ARRAY_ISA_AVX512:
+            return &simple_array_kernels_avx512;
+    }
+#endif
+
+    return &simple_array_kernels_generic;
+}
+
+enum simple_array_isa simple_array_get_isa(
+    void
+) {
+    simple_array_detect_isa();
+    return simple_array_detected_isa;
+}
+
+const char *simple_array_isa_get_name(
+    enum simple_array_isa isa
+) {
+    switch (isa) {
+        case SIMPLE_ARRAY_ISA_GENERIC:
+            return "generic";
+        case SIMPLE_ARRAY_ISA_SSE42:
+            return "sse4.2";
+        case SIMPLE_ARRAY_ISA_AVX2:
+            return "avx2";
+        case SIMPLE_ARRAY_ISA_AVX512:
+            return "avx512";
+    }
+}
+
+void simple_array_set_isa(
+    enum simple_array_isa isa
+) {
+    simple_array_detect_isa();
+    if (isa > simple_array_detected_isa) {
+        isa = simple_array_detected_isa;
+    }
+    simple_array_isa = isa;
+}
+
+const char *simple_array_element_get_name(
+    enum simple_array_element element
+) {
+    switch (element) {
+        case SIMPLE_ARRAY_INT32:
+            return "int32";
+        case SIMPLE_ARRAY_INT64:
+            return "int64";
+        case SIMPLE_ARRAY_FLOAT64:
+            return "float64";
+        case SIMPLE_ARRAY_MASK:
+            return "mask";
+    }
+}
+
+struct simple_error *simple_array_element_from_name(
+    const char *name,
+    enum simple_array_element *result
+) {
+    if (strcmp(name, "int32") == 0) {
+        *result = SIMPLE_ARRAY_INT32;
+    } else if (strcmp(name, "int64") == 0) {
+        *result = SIMPLE_ARRAY_INT64;
+    } else if (strcmp(name, "float64") == 0) {
+        *result = SIMPLE_ARRAY_FLOAT64;
+    } else if (strcmp(name, "mask") == 0) {
+        *result = SIMPLE_ARRAY_MASK;
+    } else {
+        *result = SIMPLE_ARRAY_INT64;
+        return simple_error_new("Unknown array element type '%s'.", name);
+    }
+    return NULL;
+}
+
+static size_t simple_array_element_size(
+    enum simple_array_element element
+) {
+    switch (element) {
+        case SIMPLE_ARRAY_INT32:
+            return sizeof(int32_t);
+        case SIMPLE_ARRAY_INT64:
+            return sizeof(int64_t);
+        case SIMPLE_ARRAY_FLOAT64:
+            return sizeof(double);
+        case SIMPLE_ARRAY_MASK:
+            return sizeof(uint8_t);
+    }
+}
+
+static void *simple_array_allocate(
+    size_t bytes
+) {
+    // aligned_alloc() wants a multiple of the alignment
+    bytes = (bytes / SIMPLE_ARRAY_ALIGNMENT + 1) * SIMPLE_ARRAY_ALIGNMENT;
+    void *data = aligned_alloc(SIMPLE_ARRAY_ALIGNMENT, bytes);
+    memset(data, 0, bytes);
+    return data;
+}
+
+static void simple_array_reserve(
+    struct simple_array *array,
+    size_t capacity
+) {
+    if (capacity <= array->capacity) {
+        return;
+    }
+
+    size_t element_size = simple_array_element_size(array->element);
+    void *data = simple_array_allocate(capacity * element_size);
+    memcpy(data, array->data, array->length * element_size);
+    free(array->data);
+
+    array->data = data;
+    array->capacity = capacity;
+}
+
+struct simple_array *simple_array_new(
+    enum simple_array_element element,
+    size_t capacity
+) {
+    struct simple_array *array = calloc(1, sizeof *array);
+    *array = (struct simple_array) {
+        .element = element,
+        .length = 0,
+        .capacity = capacity,
+        .data = simple_array_allocate(capacity *
+            simple_array_element_size(element))
+    };
+    return array;
+}
+
+struct simple_array *simple_array_copy(
+    const struct simple_array *array
+) {
+    struct simple_array *copy;
+    copy = simple_array_new(array->element, array->length);
+    memcpy(copy->data, array->data,
+        array->length * simple_array_element_size(array->element));
+    copy->length = array->length;
+    return copy;
+}
+
+void simple_array_destroy(
+    struct simple_array *array
+) {
+    if (!array) {
+        return;
+    }
+    free(array->data);
+    free(array);
+}
+
+enum simple_array_element simple_array_get_element(
+    const struct simple_array *array
+) {
+    return array->element;
+}
+
+size_t simple_array_length(
+    const struct simple_array *array
+) {
+    return array->length;
+}
+
+void *simple_array_data(
+    struct simple_array *array
+) {
+    return array->data;
+}
+
+void simple_array_resize(
+    struct simple_array *array,
+    size_t length
+) {
+    size_t element_size = simple_array_element_size(array->element);
+    simple_array_reserve(array, length);
+    if (length > array->length) {
+        memset((char *)array->data + array->length * element_size, 0,
+            (length - array->length) * element_size);
+    }
+    array->length = length;
+}
+
+void simple_array_append(
+    struct simple_array *array,
+    union simple_array_value value
+) {
+    if (array->length == array->capacity) {
+        simple_array_reserve(array, array->capacity ? 2 * array->capacity :
+            8);
+    }
+
+    size_t index = array->length++;
+    switch (array->element) {
+        case SIMPLE_ARRAY_INT32:
+            ((int32_t *)array->data)[index] = (int32_t)value.integer;
+            break;
+        case SIMPLE_ARRAY_INT64:
+            ((int64_t *)array->data)[index] = value.integer;
+            break;
+        case SIMPLE_ARRAY_FLOAT64:
+            ((double *)array->data)[index] = value.real;
+            break;
+        case SIMPLE_ARRAY_MASK:
+            ((uint8_t *)array->data)[index] = value.integer != 0;
+            break;
+    }
+}
+
+struct simple_error *simple_array_get(
+    const struct simple_array *array,
+    size_t index,
+    union simple_array_value *result
+) {
+    if (index >= array->length) {
+        result->integer = 0;
+        return simple_error_new("Index %zu out of range for array of "
+            "length %zu.", index, array->length);
+    }
+
+    switch (array->element) {
+        case SIMPLE_ARRAY_INT32:
+            result->integer = ((const int32_t *)array->data)[index];
+            break;
+        case SIMPLE_ARRAY_INT64:
+            result->integer = ((const int64_t *)array->data)[index];
+            break;
+        case SIMPLE_ARRAY_FLOAT64:
+            result->real = ((const double *)array->data)[index];
+            break;
+        case SIMPLE_ARRAY_MASK:
+            result->integer = ((const uint8_t *)array->data)[index];
+            break;
+    }
+    return NULL;
+}
+
+bool simple_array_equals(
+    const struct simple_array *lhs,
+    const struct simple_array *rhs
+) {
+    if (lhs->element != rhs->element || lhs->length != rhs->length) {
+        return false;
+    }
+
+    if (lhs->element == SIMPLE_ARRAY_FLOAT64) {
+        // memcmp() would treat 0.0 and -0.0 as different
+        const double *lhs_data = lhs->data, *rhs_data = rhs->data;
+        for (size_t i = 0; i < lhs->length; i++) {
+            if (lhs_data[i] != rhs_data[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    return memcmp(lhs->data, rhs->data,
+        lhs->length * simple_array_element_size(lhs->element)) == 0;
+}
+
+struct simple_error *simple_array_sum(
+    const struct simple_array *array,
+    union simple_array_value *result
+) {
+    const struct simple_array_kernels *kernels = simple_array_get_kernels();
+
+    switch (array->element) {
+        case SIMPLE_ARRAY_INT32:
+            result->integer = kernels->sum_int32(array->data, array->length);
+            break;
+        case SIMPLE_ARRAY_INT64:
+            result->integer = kernels->sum_int64(array->data, array->length);
+            break;
+        case SIMPLE_ARRAY_FLOAT64:
+            result->real = kernels->sum_float64(array->data, array->length);
+            break;
+        case SIMPLE_ARRAY_MASK:
+            result->integer = kernels->sum_mask(array->data, array->length);
+            break;
+    }
+    return NULL;
+}
+
+static struct simple_error *simple_array_minmax(
+    const struct simple_array *array,
+    union simple_array_value *min,
+    union simple_array_value *max
+) {
+    const struct simple_array_kernels *kernels = simple_array_get_kernels();
+
+    if (!array->length || array->element == SIMPLE_ARRAY_MASK) {
+        min->integer = 0;
+        max->integer = 0;
+        return simple_error_new("Cannot take min or max of %s array of "
+            "length %zu.", simple_array_element_get_name(array->element),
+            array->length);
+    }
+
+    switch (array->element) {
+        case SIMPLE_ARRAY_INT32: {
+            int32_t low, high;
+            kernels->minmax_int32(array->data, array->length, &low, &high);
+            min->integer = low;
+            max->integer = high;
+            break;
+        }
+        case SIMPLE_ARRAY_INT64:
+            kernels->minmax_int64(array->data, array->length, &min->integer,
+                &max->integer);
+            break;
+        case SIMPLE_ARRAY_FLOAT64:
+            kernels->minmax_float64(array->data, array->length, &min->real,
+                &max->real);
+            break;
+        case SIMPLE_ARRAY_MASK:
+            break;
+    }
+    return NULL;
+}
+
+struct simple_error *simple_array_min(
+    const struct simple_array *array,
+    union simple_array_value *result
+) {
+    union simple_array_value max;
+    return simple_array_minmax(array, result, &max);
+}
+
+struct simple_error *simple_array_max(
+    const struct simple_array *array,
+    union simple_array_value *result
+) {
+    union simple_array_value min;
+    return simple_array_minmax(array, &min, result);
+}
+
+struct simple_error *simple_array_arithmetic(
+    const struct simple_array *lhs,
+    const struct simple_array *rhs,
+    enum simple_array_operation operation,
+    struct simple_array **result
+) {
+    const struct simple_array_kernels *kernels = simple_array_get_kernels();
+
+    if (lhs->element != rhs->element || lhs->length != rhs->length ||
+            lhs->element == SIMPLE_ARRAY_MASK) {
+        *result = NULL;
+        return simple_error_new("Cannot combine %s array of length %zu with "
+            "%s array of length %zu.",
+            simple_array_element_get_name(lhs->element), lhs->length,
+            simple_array_element_get_name(rhs->element), rhs->length);
+    }
+
+    struct simple_array *array = simple_array_new(lhs->element, lhs->length);
+    array->length = lhs->length;
+
+    switch (lhs->element) {
+        case SIMPLE_ARRAY_INT32:
+            kernels->arithmetic_int32(lhs->data, rhs->data, array->data,
+                array->length, operation);
+            break;
+        case SIMPLE_ARRAY_INT64:
+            kernels->arithmetic_int64(lhs->data, rhs->data, array->data,
+                array->length, operation);
+            break;
+        case SIMPLE_ARRAY_FLOAT64:
+            kernels->arithmetic_float64(lhs->data, rhs->data, array->data,
+                array->length, operation);
+            break;
+        case SIMPLE_ARRAY_MASK:
+            break;
+    }
+
+    *result = array;
+    return NULL;
+}
+
+struct simple_error *simple_array_compare(
+    const struct simple_array *array,
+    enum simple_array_comparison comparison,
+    union simple_array_value scalar,
+    struct simple_array **result
+) {
+    const struct simple_array_kernels *kernels = simple_array_get_kernels();
+    struct simple_array *mask;
+
+    if (array->element == SIMPLE_ARRAY_MASK) {
+        *result = NULL;
+        return simple_error_new("%s", "Cannot compare a mask array.");
+    }
+
+    if (array->element == SIMPLE_ARRAY_INT32 &&
+            (scalar.integer < INT32_MIN || scalar.integer > INT32_MAX)) {
+        *result = NULL;
+        return simple_error_new("Scalar %lld does not fit an int32 array.",
+            (long long)scalar.integer);
+    }
+
+    mask = simple_array_new(SIMPLE_ARRAY_MASK, array->length);
+    mask->length = array->length;
+
+    switch (array->element) {
+        case SIMPLE_ARRAY_INT32:
+            kernels->compare_int32(array->data, array->length,
+                (int32_t)scalar.integer, comparison, mask->data);
+            break;
+        case SIMPLE_ARRAY_INT64:
+            kernels->compare_int64(array->data, array->length,
+                scalar.integer, comparison, mask->data);
+            break;
+        case SIMPLE_ARRAY_FLOAT64:
+            kernels->compare_float64(array->data, array->length,
+                scalar.real, comparison, mask->data);
+            break;
+        case SIMPLE_ARRAY_MASK:
+            break;
+    }
+
+    *result = mask;
+    return NULL;
+}
+
+// branchless: every element is stored, the cursor only moves on a hit
+#define SIMPLE_ARRAY_FILTER(T) \
+    { \
+        const T *values = array->data; \
+        T *selected = filtered->data; \
+        for (size_t i = 0; i < array->length; i++) { \
+            selected[count] = values[i]; \
+            count += flags[i]; \
+        } \
+    }
+
+struct simple_error *simple_array_filter(
+    const struct simple_array *array,
+    const struct simple_array *mask,
+    struct simple_array **result
+) {
+    if (mask->element != SIMPLE_ARRAY_MASK ||
+            mask->length != array->length) {
+        *result = NULL;
+        return simple_error_new("Cannot filter array of length %zu with %s "
+            "array of length %zu.", array->length,
+            simple_array_element_get_name(mask->element), mask->length);
+    }
+
+    union simple_array_value selected_count;
+    struct simple_error *error = simple_array_sum(mask, &selected_count);
+    simple_error_check(error);
+
+    const uint8_t *flags = mask->data;
+    size_t count = 0;
+
+    // one spare slot for the store past the last hit
+    struct simple_array *filtered = simple_array_new(array->element,
+        (size_t)selected_count.integer + 1);
+
+    switch (array->element) {
+        case SIMPLE_ARRAY_INT32:
+            SIMPLE_ARRAY_FILTER(int32_t)
+            break;
+        case SIMPLE_ARRAY_INT64:
+            SIMPLE_ARRAY_FILTER(int64_t)
+            break;
+        case SIMPLE_ARRAY_FLOAT64:
+            SIMPLE_ARRAY_FILTER(double)
+            break;
+        case SIMPLE_ARRAY_MASK:
+            SIMPLE_ARRAY_FILTER(uint8_t)
+            break;
+    }
+
+    filtered->length = count;
+    *result = filtered;
+
+    cleanup:
+    if (error) {
+        *result = NULL;
+    }
+    return error;
+}
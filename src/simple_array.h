@@ -0,0 +1,153 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct simple_error;
+struct simple_array;
+
+enum simple_array_element {
+    SIMPLE_ARRAY_INT32,
+    SIMPLE_ARRAY_INT64,
+    SIMPLE_ARRAY_FLOAT64,
+    SIMPLE_ARRAY_MASK
+};
+
+enum simple_array_operation {
+    SIMPLE_ARRAY_ADD,
+    SIMPLE_ARRAY_SUB,
+    SIMPLE_ARRAY_MUL
+};
+
+enum simple_array_comparison {
+    SIMPLE_ARRAY_LT,
+    SIMPLE_ARRAY_LE,
+    SIMPLE_ARRAY_GT,
+    SIMPLE_ARRAY_GE,
+    SIMPLE_ARRAY_EQ,
+    SIMPLE_ARRAY_NE
+};
+
+// GENERIC is portable vector code, SSE2 on x86-64
+enum simple_array_isa {
+    SIMPLE_ARRAY_ISA_GENERIC,
+    SIMPLE_ARRAY_ISA_SSE42,
+    SIMPLE_ARRAY_ISA_AVX2,
+    SIMPLE_ARRAY_ISA_AVX512
+};
+
+// integer elements and masks use integer, float64 elements use real
+union simple_array_value {
+    int64_t integer;
+    double real;
+};
+
+const char *simple_array_element_get_name(
+    enum simple_array_element element
+);
+
+struct simple_error *simple_array_element_from_name(
+    const char *name,
+    enum simple_array_element *result
+) __attribute__((warn_unused_result));
+
+// Best instruction set supported by this cpu, detected once.
+enum simple_array_isa simple_array_get_isa(
+    void
+);
+
+const char *simple_array_isa_get_name(
+    enum simple_array_isa isa
+);
+
+// Restricts kernels to isa, or less if the cpu lacks it. Meant for
+// benchmarks and tests comparing kernels.
+void simple_array_set_isa(
+    enum simple_array_isa isa
+);
+
+struct simple_array *simple_array_new(
+    enum simple_array_element element,
+    size_t capacity
+) __attribute__((warn_unused_result));
+
+struct simple_array *simple_array_copy(
+    const struct simple_array *array
+) __attribute__((warn_unused_result));
+
+void simple_array_destroy(
+    struct simple_array *array
+);
+
+enum simple_array_element simple_array_get_element(
+    const struct simple_array *array
+);
+
+size_t simple_array_length(
+    const struct simple_array *array
+);
+
+// Contiguous, 64 byte aligned element storage for bulk loading.
+void *simple_array_data(
+    struct simple_array *array
+);
+
+// Grows or shrinks to length, new elements are zero.
+void simple_array_resize(
+    struct simple_array *array,
+    size_t length
+);
+
+void simple_array_append(
+    struct simple_array *array,
+    union simple_array_value value
+);
+
+struct simple_error *simple_array_get(
+    const struct simple_array *array,
+    size_t index,
+    union simple_array_value *result
+) __attribute__((warn_unused_result));
+
+bool simple_array_equals(
+    const struct simple_array *lhs,
+    const struct simple_array *rhs
+);
+
+// int32 sums are widened to int64, summing a mask counts the set entries.
+struct simple_error *simple_array_sum(
+    const struct simple_array *array,
+    union simple_array_value *result
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_array_min(
+    const struct simple_array *array,
+    union simple_array_value *result
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_array_max(
+    const struct simple_array *array,
+    union simple_array_value *result
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_array_arithmetic(
+    const struct simple_array *lhs,
+    const struct simple_array *rhs,
+    enum simple_array_operation operation,
+    struct simple_array **result
+) __attribute__((warn_unused_result));
+
+// Builds a mask with a 1 for every element where element <op> scalar.
+struct simple_error *simple_array_compare(
+    const struct simple_array *array,
+    enum simple_array_comparison comparison,
+    union simple_array_value scalar,
+    struct simple_array **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_array_filter(
+    const struct simple_array *array,
+    const struct simple_array *mask,
+    struct simple_array **result
+) __attribute__((warn_unused_result));
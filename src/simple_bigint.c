@@ -0,0 +1,768 @@
+#include "simple_bigint.h"
+
+#include <malloc.h>
+#include <string.h>
+
+#include "simple_error.h"
+#include "simple_hash.h"
+
+// operand sizes in limbs below which the simpler algorithm wins
+#define SIMPLE_BIGINT_KARATSUBA_THRESHOLD 48
+#define SIMPLE_BIGINT_TOOM3_THRESHOLD 160
+
+// 10^19 is the largest power of ten that fits in one limb
+#define SIMPLE_BIGINT_DECIMAL_BASE 10000000000000000000ULL
+#define SIMPLE_BIGINT_DECIMAL_DIGITS 19
+
+typedef unsigned __int128 simple_bigint_wide;
+
+struct simple_bigint {
+    uint64_t *limbs;
+    size_t length;
+    bool negative;
+};
+
+static size_t mag_normalize(
+    const uint64_t *limbs,
+    size_t length
+) {
+    while (length > 0 && limbs[length - 1] == 0) {
+        length--;
+    }
+    return length;
+}
+
+static int mag_compare(
+    const uint64_t *lhs,
+    size_t lhs_length,
+    const uint64_t *rhs,
+    size_t rhs_length
+) {
+    lhs_length = mag_normalize(lhs, lhs_length);
+    rhs_length = mag_normalize(rhs, rhs_length);
+    if (lhs_length != rhs_length) {
+        return lhs_length < rhs_length ? -1 : 1;
+    }
+    for (size_t i = lhs_length; i > 0; i--) {
+        if (lhs[i - 1] != rhs[i - 1]) {
+            return lhs[i - 1] < rhs[i - 1] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// result must hold max(lhs_length, rhs_length) + 1 limbs
+static void mag_add(
+    uint64_t *result,
+    const uint64_t *lhs,
+    size_t lhs_length,
+    const uint64_t *rhs,
+    size_t rhs_length
+) {
+    if (lhs_length < rhs_length) {
+        const uint64_t *swap = lhs;
+        lhs = rhs;
+        rhs = swap;
+        size_t swap_length = lhs_length;
+        lhs_length = rhs_length;
+        rhs_length = swap_length;
+    }
+
+    uint64_t carry = 0;
+    size_t i;
+    for (i = 0; i < rhs_length; i++) {
+        uint64_t sum = lhs[i] + carry;
+        carry = sum < carry;
+        sum += rhs[i];
+        carry += sum < rhs[i];
+        result[i] = sum;
+    }
+    for (; i < lhs_length; i++) {
+        uint64_t sum = lhs[i] + carry;
+        carry = sum < carry;
+        result[i] = sum;
+    }
+    result[lhs_length] = carry;
+}
+
+// requires lhs >= rhs and rhs_length <= lhs_length, result may alias lhs
+static void mag_sub(
+    uint64_t *result,
+    const uint64_t *lhs,
+    size_t lhs_length,
+    const uint64_t *rhs,
+    size_t rhs_length
+) {
+    uint64_t borrow = 0;
+    size_t i;
+    for (i = 0; i < rhs_length; i++) {
+        uint64_t value = lhs[i];
+        uint64_t difference = value - rhs[i];
+        uint64_t next_borrow = (value < rhs[i]) | (difference < borrow);
+        result[i] = difference - borrow;
+        borrow = next_borrow;
+    }
+    for (; i < lhs_length; i++) {
+        uint64_t value = lhs[i];
+        result[i] = value - borrow;
+        borrow = value < borrow;
+    }
+}
+
+// adds value into result in place, the sum must fit in result_length limbs
+static void mag_add_into(
+    uint64_t *result,
+    size_t result_length,
+    const uint64_t *value,
+    size_t value_length
+) {
+    value_length = mag_normalize(value, value_length);
+
+    uint64_t carry = 0;
+    size_t i;
+    for (i = 0; i < value_length; i++) {
+        uint64_t sum = result[i] + carry;
+        carry = sum < carry;
+        sum += value[i];
+        carry += sum < value[i];
+        result[i] = sum;
+    }
+    for (; carry && i < result_length; i++) {
+        result[i]++;
+        carry = result[i] == 0;
+    }
+}
+
+// returns the remainder, quotient may alias value
+static uint64_t mag_div_small(
+    uint64_t *quotient,
+    const uint64_t *value,
+    size_t length,
+    uint64_t divisor
+) {
+    simple_bigint_wide remainder = 0;
+    for (size_t i = length; i > 0; i--) {
+        simple_bigint_wide current = (remainder << 64) | value[i - 1];
+        quotient[i - 1] = (uint64_t)(current / divisor);
+        remainder = current % divisor;
+    }
+    return (uint64_t)remainder;
+}
+
+// limbs = limbs * factor + addend, limbs must have room for one more limb
+static void mag_mul_small_add(
+    uint64_t *limbs,
+    size_t *length,
+    uint64_t factor,
+    uint64_t addend
+) {
+    simple_bigint_wide carry = addend;
+    for (size_t i = 0; i < *length; i++) {
+        simple_bigint_wide product = (simple_bigint_wide)limbs[i] * factor +
+            carry;
+        limbs[i] = (uint64_t)product;
+        carry = product >> 64;
+    }
+    if (carry) {
+        limbs[*length] = (uint64_t)carry;
+        (*length)++;
+    }
+}
+
+// result must hold lhs_length + rhs_length limbs
+static void mag_mul_schoolbook(
+    uint64_t *result,
+    const uint64_t *lhs,
+    size_t lhs_length,
+    const uint64_t *rhs,
+    size_t rhs_length
+) {
+    memset(result, 0, (lhs_length + rhs_length) * sizeof *result);
+    for (size_t i = 0; i < lhs_length; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < rhs_length; j++) {
+            simple_bigint_wide product = (simple_bigint_wide)lhs[i] * rhs[j] +
+                result[i + j] + carry;
+            result[i + j] = (uint64_t)product;
+            carry = (uint64_t)(product >> 64);
+        }
+        result[i + rhs_length] = carry;
+    }
+}
+
+static void mag_mul(
+    uint64_t *result,
+    const uint64_t *lhs,
+    size_t lhs_length,
+    const uint64_t *rhs,
+    size_t rhs_length,
+    enum simple_bigint_mul_algorithm algorithm
+);
+
+static void mag_mul_karatsuba(
+    uint64_t *result,
+    const uint64_t *lhs,
+    size_t lhs_length,
+    const uint64_t *rhs,
+    size_t rhs_length
+) {
+    if (rhs_length < 2) {
+        mag_mul_schoolbook(result, lhs, lhs_length, rhs, rhs_length);
+        return;
+    }
+
+    size_t half = (lhs_length + 1) / 2;
+    size_t result_length = lhs_length + rhs_length;
+
+    if (rhs_length <= half) {
+        // rhs has no high half, only split lhs
+        size_t high_length = lhs_length - half + rhs_length;
+        uint64_t *high = calloc(high_length, sizeof *high);
+
+        mag_mul(result, lhs, half, rhs, rhs_length, SIMPLE_BIGINT_MUL_AUTO);
+        memset(result + half + rhs_length, 0,
+            (lhs_length - half) * sizeof *result);
+        mag_mul(high, lhs + half, lhs_length - half, rhs, rhs_length,
+            SIMPLE_BIGINT_MUL_AUTO);
+        mag_add_into(result + half, result_length - half, high, high_length);
+
+        free(high);
+        return;
+    }
+
+    size_t lhs_high_length = lhs_length - half;
+    size_t rhs_high_length = rhs_length - half;
+
+    // z0 goes in the low 2 * half limbs and z2 right above it
+    mag_mul(result, lhs, half, rhs, half, SIMPLE_BIGINT_MUL_AUTO);
+    mag_mul(result + 2 * half, lhs + half, lhs_high_length, rhs + half,
+        rhs_high_length, SIMPLE_BIGINT_MUL_AUTO);
+
+    uint64_t *lhs_sum = calloc(half + 1, sizeof *lhs_sum);
+    uint64_t *rhs_sum = calloc(half + 1, sizeof *rhs_sum);
+    uint64_t *middle = calloc(2 * half + 2, sizeof *middle);
+
+    mag_add(lhs_sum, lhs, half, lhs + half, lhs_high_length);
+    mag_add(rhs_sum, rhs, half, rhs + half, rhs_high_length);
+    mag_mul(middle, lhs_sum, half + 1, rhs_sum, half + 1,
+        SIMPLE_BIGINT_MUL_AUTO);
+
+    // z1 = (l0 + l1)(r0 + r1) - z0 - z2
+    mag_sub(middle, middle, 2 * half + 2, result, 2 * half);
+    mag_sub(middle, middle, 2 * half + 2, result + 2 * half,
+        lhs_high_length + rhs_high_length);
+    mag_add_into(result + half, result_length - half, middle, 2 * half + 2);
+
+    free(lhs_sum);
+    free(rhs_sum);
+    free(middle);
+}
+
+static struct simple_bigint *simple_bigint_alloc(
+    size_t length
+) {
+    struct simple_bigint *bigint = calloc(1, sizeof *bigint);
+    *bigint = (struct simple_bigint) {
+        .limbs = calloc(length ? length : 1, sizeof *bigint->limbs),
+        .length = length,
+        .negative = false
+    };
+    return bigint;
+}
+
+static void simple_bigint_normalize(
+    struct simple_bigint *bigint
+) {
+    bigint->length = mag_normalize(bigint->limbs, bigint->length);
+    if (!bigint->length) {
+        bigint->negative = false;
+    }
+}
+
+static struct simple_bigint *simple_bigint_add_signed(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs,
+    bool negate_rhs
+) {
+    bool rhs_negative = rhs->negative != negate_rhs;
+    struct simple_bigint *result;
+
+    if (lhs->negative == rhs_negative) {
+        size_t length = lhs->length > rhs->length ? lhs->length : rhs->length;
+        result = simple_bigint_alloc(length + 1);
+        mag_add(result->limbs, lhs->limbs, lhs->length, rhs->limbs,
+            rhs->length);
+        result->negative = lhs->negative;
+    } else if (mag_compare(lhs->limbs, lhs->length, rhs->limbs,
+            rhs->length) >= 0) {
+        result = simple_bigint_alloc(lhs->length);
+        mag_sub(result->limbs, lhs->limbs, lhs->length, rhs->limbs,
+            rhs->length);
+        result->negative = lhs->negative;
+    } else {
+        result = simple_bigint_alloc(rhs->length);
+        mag_sub(result->limbs, rhs->limbs, rhs->length, lhs->limbs,
+            lhs->length);
+        result->negative = rhs_negative;
+    }
+
+    simple_bigint_normalize(result);
+    return result;
+}
+
+// divides in place, only valid when divisor is known to divide value
+static void simple_bigint_div_exact(
+    struct simple_bigint *value,
+    uint64_t divisor
+) {
+    (void)mag_div_small(value->limbs, value->limbs, value->length, divisor);
+    simple_bigint_normalize(value);
+}
+
+static void simple_bigint_toom3_split(
+    const uint64_t *limbs,
+    size_t length,
+    size_t part_length,
+    struct simple_bigint *parts[3]
+) {
+    for (size_t i = 0; i < 3; i++) {
+        size_t offset = i * part_length;
+        size_t count = 0;
+        if (offset < length) {
+            count = length - offset;
+            count = count < part_length ? count : part_length;
+        }
+        parts[i] = simple_bigint_new_limbs(limbs + offset, count, false);
+    }
+}
+
+// evaluates the polynomial at 0, 1, -1, -2 and infinity
+static void simple_bigint_toom3_evaluate(
+    struct simple_bigint *const parts[3],
+    struct simple_bigint *points[5]
+) {
+    struct simple_bigint *even = simple_bigint_add(parts[0], parts[2]);
+
+    points[0] = simple_bigint_copy(parts[0]);
+    points[1] = simple_bigint_add(even, parts[1]);
+    points[2] = simple_bigint_sub(even, parts[1]);
+
+    struct simple_bigint *shifted = simple_bigint_add(points[2], parts[2]);
+    struct simple_bigint *doubled = simple_bigint_add(shifted, shifted);
+    points[3] = simple_bigint_sub(doubled, parts[0]);
+    points[4] = simple_bigint_copy(parts[2]);
+
+    simple_bigint_destroy(even);
+    simple_bigint_destroy(shifted);
+    simple_bigint_destroy(doubled);
+}
+
+static void mag_mul_toom3(
+    uint64_t *result,
+    const uint64_t *lhs,
+    size_t lhs_length,
+    const uint64_t *rhs,
+    size_t rhs_length
+) {
+    size_t part_length = (lhs_length + 2) / 3;
+
+    if (rhs_length <= part_length || part_length < 2) {
+        // too unbalanced for three way splitting to pay off
+        mag_mul_karatsuba(result, lhs, lhs_length, rhs, rhs_length);
+        return;
+    }
+
+    struct simple_bigint *lhs_parts[3], *rhs_parts[3];
+    struct simple_bigint *lhs_points[5], *rhs_points[5], *values[5];
+
+    simple_bigint_toom3_split(lhs, lhs_length, part_length, lhs_parts);
+    simple_bigint_toom3_split(rhs, rhs_length, part_length, rhs_parts);
+    simple_bigint_toom3_evaluate(lhs_parts, lhs_points);
+    simple_bigint_toom3_evaluate(rhs_parts, rhs_points);
+
+    for (size_t i = 0; i < 5; i++) {
+        values[i] = simple_bigint_mul(lhs_points[i], rhs_points[i]);
+    }
+
+    // interpolation sequence by Bodrato
+    struct simple_bigint *coefficients[5], *tmp, *tmp2;
+
+    coefficients[0] = values[0];
+    coefficients[4] = values[4];
+
+    coefficients[3] = simple_bigint_sub(values[3], values[1]);
+    simple_bigint_div_exact(coefficients[3], 3);
+
+    coefficients[1] = simple_bigint_sub(values[1], values[2]);
+    simple_bigint_div_exact(coefficients[1], 2);
+
+    coefficients[2] = simple_bigint_sub(values[2], values[0]);
+
+    tmp = simple_bigint_sub(coefficients[2], coefficients[3]);
+    simple_bigint_div_exact(tmp, 2);
+    tmp2 = simple_bigint_add(values[4], values[4]);
+    simple_bigint_destroy(coefficients[3]);
+    coefficients[3] = simple_bigint_add(tmp, tmp2);
+    simple_bigint_destroy(tmp);
+    simple_bigint_destroy(tmp2);
+
+    tmp = simple_bigint_add(coefficients[2], coefficients[1]);
+    simple_bigint_destroy(coefficients[2]);
+    coefficients[2] = simple_bigint_sub(tmp, values[4]);
+    simple_bigint_destroy(tmp);
+
+    tmp = simple_bigint_sub(coefficients[1], coefficients[3]);
+    simple_bigint_destroy(coefficients[1]);
+    coefficients[1] = tmp;
+
+    size_t result_length = lhs_length + rhs_length;
+    memset(result, 0, result_length * sizeof *result);
+    for (size_t i = 0; i < 5; i++) {
+        size_t offset = i * part_length;
+        if (offset < result_length) {
+            mag_add_into(result + offset, result_length - offset,
+                coefficients[i]->limbs, coefficients[i]->length);
+        }
+    }
+
+    for (size_t i = 0; i < 5; i++) {
+        simple_bigint_destroy(coefficients[i]);
+        simple_bigint_destroy(lhs_points[i]);
+        simple_bigint_destroy(rhs_points[i]);
+    }
+    for (size_t i = 0; i < 3; i++) {
+        simple_bigint_destroy(lhs_parts[i]);
+        simple_bigint_destroy(rhs_parts[i]);
+    }
+    simple_bigint_destroy(values[1]);
+    simple_bigint_destroy(values[2]);
+    simple_bigint_destroy(values[3]);
+}
+
+// result must hold lhs_length + rhs_length limbs
+static void mag_mul(
+    uint64_t *result,
+    const uint64_t *lhs,
+    size_t lhs_length,
+    const uint64_t *rhs,
+    size_t rhs_length,
+    enum simple_bigint_mul_algorithm algorithm
+) {
+    if (lhs_length < rhs_length) {
+        const uint64_t *swap = lhs;
+        lhs = rhs;
+        rhs = swap;
+        size_t swap_length = lhs_length;
+        lhs_length = rhs_length;
+        rhs_length = swap_length;
+    }
+
+    if (algorithm == SIMPLE_BIGINT_MUL_AUTO) {
+        if (rhs_length < SIMPLE_BIGINT_KARATSUBA_THRESHOLD) {
+            algorithm = SIMPLE_BIGINT_MUL_SCHOOLBOOK;
+        } else if (rhs_length < SIMPLE_BIGINT_TOOM3_THRESHOLD) {
+            algorithm = SIMPLE_BIGINT_MUL_KARATSUBA;
+        } else {
+            algorithm = SIMPLE_BIGINT_MUL_TOOM3;
+        }
+    }
+
+    switch (algorithm) {
+        case SIMPLE_BIGINT_MUL_AUTO:
+        case SIMPLE_BIGINT_MUL_SCHOOLBOOK:
+            mag_mul_schoolbook(result, lhs, lhs_length, rhs, rhs_length);
+            break;
+        case SIMPLE_BIGINT_MUL_KARATSUBA:
+            mag_mul_karatsuba(result, lhs, lhs_length, rhs, rhs_length);
+            break;
+        case SIMPLE_BIGINT_MUL_TOOM3:
+            mag_mul_toom3(result, lhs, lhs_length, rhs, rhs_length);
+            break;
+    }
+}
+
+struct simple_bigint *simple_bigint_new(
+    int64_t value
+) {
+    struct simple_bigint *bigint = simple_bigint_alloc(1);
+    if (value < 0) {
+        // avoid overflow when negating INT64_MIN
+        bigint->limbs[0] = (uint64_t)(-(value + 1)) + 1;
+        bigint->negative = true;
+    } else {
+        bigint->limbs[0] = (uint64_t)value;
+    }
+    simple_bigint_normalize(bigint);
+    return bigint;
+}
+
+struct simple_bigint *simple_bigint_new_limbs(
+    const uint64_t *limbs,
+    size_t limb_count,
+    bool negative
+) {
+    struct simple_bigint *bigint = simple_bigint_alloc(limb_count);
+    if (limb_count) {
+        memcpy(bigint->limbs, limbs, limb_count * sizeof *limbs);
+    }
+    bigint->negative = negative;
+    simple_bigint_normalize(bigint);
+    return bigint;
+}
+
+struct simple_error *simple_bigint_parse(
+    const char *decimal,
+    struct simple_bigint **result
+) {
+    const char *digits = decimal;
+    bool negative = false;
+
+    if (*digits == '-' || *digits == '+') {
+        negative = *digits == '-';
+        digits++;
+    }
+
+    size_t digit_count = strlen(digits);
+    if (!digit_count) {
+        *result = NULL;
+        return simple_error_new("Cannot parse '%s' as bigint.", decimal);
+    }
+
+    for (size_t i = 0; i < digit_count; i++) {
+        if (digits[i] < '0' || digits[i] > '9') {
+            *result = NULL;
+            return simple_error_new("Invalid digit '%c' in bigint '%s'.",
+                digits[i], decimal);
+        }
+    }
+
+    struct simple_bigint *bigint;
+    bigint = simple_bigint_alloc(digit_count / SIMPLE_BIGINT_DECIMAL_DIGITS
+        + 1);
+    bigint->length = 0;
+
+    // consume a short leading chunk so the rest is in full 19 digit chunks
+    size_t chunk_length = digit_count % SIMPLE_BIGINT_DECIMAL_DIGITS;
+    if (!chunk_length) {
+        chunk_length = SIMPLE_BIGINT_DECIMAL_DIGITS;
+    }
+
+    while (*digits) {
+        uint64_t chunk = 0, factor = 1;
+        for (size_t i = 0; i < chunk_length; i++) {
+            chunk = chunk * 10 + (uint64_t)(digits[i] - '0');
+            factor *= 10;
+        }
+        mag_mul_small_add(bigint->limbs, &bigint->length, factor, chunk);
+        digits += chunk_length;
+        chunk_length = SIMPLE_BIGINT_DECIMAL_DIGITS;
+    }
+
+    bigint->negative = negative;
+    simple_bigint_normalize(bigint);
+    *result = bigint;
+    return NULL;
+}
+
+struct simple_bigint *simple_bigint_copy(
+    const struct simple_bigint *bigint
+) {
+    return simple_bigint_new_limbs(bigint->limbs, bigint->length,
+        bigint->negative);
+}
+
+void simple_bigint_destroy(
+    struct simple_bigint *bigint
+) {
+    if (!bigint) {
+        return;
+    }
+    free(bigint->limbs);
+    free(bigint);
+}
+
+size_t simple_bigint_limb_count(
+    const struct simple_bigint *bigint
+) {
+    return bigint->length;
+}
+
+bool simple_bigint_get_int64(
+    const struct simple_bigint *bigint,
+    int64_t *result
+) {
+    *result = 0;
+    if (bigint->length == 0) {
+        return true;
+    }
+    if (bigint->length > 1) {
+        return false;
+    }
+
+    uint64_t magnitude = bigint->limbs[0];
+    if (bigint->negative) {
+        if (magnitude > (uint64_t)INT64_MAX + 1) {
+            return false;
+        }
+        *result = -(int64_t)(magnitude - 1) - 1;
+    } else {
+        if (magnitude > (uint64_t)INT64_MAX) {
+            return false;
+        }
+        *result = (int64_t)magnitude;
+    }
+    return true;
+}
+
+int simple_bigint_compare(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+) {
+    if (lhs->negative != rhs->negative) {
+        return lhs->negative ? -1 : 1;
+    }
+    int compare = mag_compare(lhs->limbs, lhs->length, rhs->limbs,
+        rhs->length);
+    return lhs->negative ? -compare : compare;
+}
+
+bool simple_bigint_equals(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+) {
+    return simple_bigint_compare(lhs, rhs) == 0;
+}
+
+size_t simple_bigint_hash(
+    const struct simple_bigint *bigint
+) {
+    // must agree with object_get_hash() for values that fit in an int
+    int64_t small;
+    if (simple_bigint_get_int64(bigint, &small)) {
+        return simple_hash_integer((uint64_t)small);
+    }
+
+    size_t hash = bigint->negative;
+    for (size_t i = 0; i < bigint->length; i++) {
+        hash = simple_hash_combine(hash, bigint->limbs[i]);
+    }
+    return hash;
+}
+
+struct simple_bigint *simple_bigint_add(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+) {
+    return simple_bigint_add_signed(lhs, rhs, false);
+}
+
+struct simple_bigint *simple_bigint_sub(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+) {
+    return simple_bigint_add_signed(lhs, rhs, true);
+}
+
+struct simple_bigint *simple_bigint_mul(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+) {
+    return simple_bigint_mul_with(lhs, rhs, SIMPLE_BIGINT_MUL_AUTO);
+}
+
+struct simple_bigint *simple_bigint_mul_with(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs,
+    enum simple_bigint_mul_algorithm algorithm
+) {
+    struct simple_bigint *result;
+    result = simple_bigint_alloc(lhs->length + rhs->length);
+
+    if (lhs->length && rhs->length) {
+        mag_mul(result->limbs, lhs->limbs, lhs->length, rhs->limbs,
+            rhs->length, algorithm);
+    }
+
+    result->negative = lhs->negative != rhs->negative;
+    simple_bigint_normalize(result);
+    return result;
+}
+
+struct simple_error *simple_bigint_div_small(
+    const struct simple_bigint *bigint,
+    uint64_t divisor,
+    struct simple_bigint **quotient,
+    uint64_t *remainder
+) {
+    if (!divisor) {
+        *quotient = NULL;
+        *remainder = 0;
+        return simple_error_new("%s", "Division of bigint by zero.");
+    }
+
+    *quotient = simple_bigint_copy(bigint);
+    *remainder = mag_div_small((*quotient)->limbs, (*quotient)->limbs,
+        (*quotient)->length, divisor);
+    simple_bigint_normalize(*quotient);
+    return NULL;
+}
+
+// writes exactly width digits, zero padded, ending right before end
+static void simple_bigint_write_digits(
+    char *end,
+    uint64_t value,
+    size_t width
+) {
+    for (size_t i = 0; i < width; i++) {
+        *--end = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+char *simple_bigint_to_decimal(
+    const struct simple_bigint *bigint
+) {
+    // every limb yields at most 20 digits, plus sign and terminator
+    char *buff = calloc(bigint->length * 20 + 3, sizeof *buff);
+    char *position = buff;
+
+    if (!bigint->length) {
+        buff[0] = '0';
+        return buff;
+    }
+
+    if (bigint->negative) {
+        *position++ = '-';
+    }
+
+    // peel off 19 digits per division instead of one
+    size_t length = bigint->length;
+    uint64_t *work = calloc(length, sizeof *work);
+    uint64_t *chunks = calloc(2 * length, sizeof *chunks);
+    size_t chunk_count = 0;
+
+    memcpy(work, bigint->limbs, length * sizeof *work);
+    while (length) {
+        chunks[chunk_count++] = mag_div_small(work, work, length,
+            SIMPLE_BIGINT_DECIMAL_BASE);
+        length = mag_normalize(work, length);
+    }
+
+    uint64_t leading = chunks[chunk_count - 1];
+    size_t leading_width = 1;
+    for (uint64_t rest = leading / 10; rest; rest /= 10) {
+        leading_width++;
+    }
+    position += leading_width;
+    simple_bigint_write_digits(position, leading, leading_width);
+
+    for (size_t i = chunk_count - 1; i > 0; i--) {
+        position += SIMPLE_BIGINT_DECIMAL_DIGITS;
+        simple_bigint_write_digits(position, chunks[i - 1],
+            SIMPLE_BIGINT_DECIMAL_DIGITS);
+    }
+
+    free(work);
+    free(chunks);
+    return buff;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct simple_error;
+struct simple_bigint;
+
+enum simple_bigint_mul_algorithm {
+    SIMPLE_BIGINT_MUL_AUTO,
+    SIMPLE_BIGINT_MUL_SCHOOLBOOK,
+    SIMPLE_BIGINT_MUL_KARATSUBA,
+    SIMPLE_BIGINT_MUL_TOOM3
+};
+
+struct simple_bigint *simple_bigint_new(
+    int64_t value
+) __attribute__((warn_unused_result));
+
+struct simple_bigint *simple_bigint_new_limbs(
+    const uint64_t *limbs,
+    size_t limb_count,
+    bool negative
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_bigint_parse(
+    const char *decimal,
+    struct simple_bigint **result
+) __attribute__((warn_unused_result));
+
+struct simple_bigint *simple_bigint_copy(
+    const struct simple_bigint *bigint
+) __attribute__((warn_unused_result));
+
+void simple_bigint_destroy(
+    struct simple_bigint *bigint
+);
+
+size_t simple_bigint_limb_count(
+    const struct simple_bigint *bigint
+);
+
+bool simple_bigint_get_int64(
+    const struct simple_bigint *bigint,
+    int64_t *result
+);
+
+int simple_bigint_compare(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+);
+
+bool simple_bigint_equals(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+);
+
+size_t simple_bigint_hash(
+    const struct simple_bigint *bigint
+);
+
+struct simple_bigint *simple_bigint_add(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+) __attribute__((warn_unused_result));
+
+struct simple_bigint *simple_bigint_sub(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+) __attribute__((warn_unused_result));
+
+// Picks schoolbook, Karatsuba or Toom-3 by operand size.
+struct simple_bigint *simple_bigint_mul(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs
+) __attribute__((warn_unused_result));
+
+// Forces the algorithm for the top level only, recursion goes back to AUTO.
+struct simple_bigint *simple_bigint_mul_with(
+    const struct simple_bigint *lhs,
+    const struct simple_bigint *rhs,
+    enum simple_bigint_mul_algorithm algorithm
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_bigint_div_small(
+    const struct simple_bigint *bigint,
+    uint64_t divisor,
+    struct simple_bigint **quotient,
+    uint64_t *remainder
+) __attribute__((warn_unused_result));
+
+// Returned buffer is owned by the caller.
+char *simple_bigint_to_decimal(
+    const struct simple_bigint *bigint
+) __attribute__((warn_unused_result));
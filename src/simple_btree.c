@@ -0,0 +1,830 @@
+#include "simple_btree.h"
+
+#include <malloc.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_error.h"
+#include "simple_object.h"
+
+// 16 unboxed int keys fill two cache lines and are searched in one pass
+#define SIMPLE_BTREE_MAX_KEYS 16
+#define SIMPLE_BTREE_MIN_KEYS (SIMPLE_BTREE_MAX_KEYS / 2 - 1)
+
+// Separator keys[i] of an inner node is the smallest key below
+// children[i + 1]. Separators hold a reference to the key they copy.
+struct simple_btree_node {
+    // copies of int keys, only searched while the tree holds nothing else
+    _Alignas(64) int64_t int_keys[SIMPLE_BTREE_MAX_KEYS];
+    struct object *keys[SIMPLE_BTREE_MAX_KEYS];
+    union {
+        struct {
+            struct object *values[SIMPLE_BTREE_MAX_KEYS];
+            struct simple_btree_node *next;
+        };
+        struct simple_btree_node *children[SIMPLE_BTREE_MAX_KEYS + 1];
+    };
+    uint32_t count;
+    bool leaf;
+};
+
+struct simple_btree {
+    const struct type *key_type, *value_type;
+    struct simple_btree_node *root;
+    size_t size;
+    bool int_keys;
+};
+
+// a key prepared once per operation
+struct simple_btree_probe {
+    const struct object *key;
+    int64_t int_key;
+    bool is_int;
+};
+
+// the right half of a node that split, with the key separating it
+struct simple_btree_split {
+    struct object *key;
+    int64_t int_key;
+    struct simple_btree_node *node;
+};
+
+static struct simple_btree_node *simple_btree_node_new(
+    bool leaf
+) {
+    struct simple_btree_node *node;
+    node = aligned_alloc(_Alignof(struct simple_btree_node), sizeof *node);
+    memset(node, 0, sizeof *node);
+    node->leaf = leaf;
+    return node;
+}
+
+static void simple_btree_node_destroy(
+    struct simple_btree_node *node
+) {
+    for (uint32_t i = 0; i < node->count; i++) {
+        object_refcount_decrease(node->keys[i]);
+        if (node->leaf) {
+            object_refcount_decrease(node->values[i]);
+        } else {
+            simple_btree_node_destroy(node->children[i]);
+        }
+    }
+    if (!node->leaf) {
+        simple_btree_node_destroy(node->children[node->count]);
+    }
+    free(node);
+}
+
+static void simple_btree_set_key(
+    struct simple_btree_node *node,
+    uint32_t index,
+    struct object *key,
+    int64_t int_key
+) {
+    node->keys[index] = key;
+    node->int_keys[index] = int_key;
+}
+
+// moves count keys along with their values, dst and src may be the same
+static void simple_btree_move(
+    struct simple_btree_node *dst,
+    uint32_t dst_index,
+    struct simple_btree_node *src,
+    uint32_t src_index,
+    uint32_t count
+) {
+    memmove(dst->keys + dst_index, src->keys + src_index,
+        count * sizeof *dst->keys);
+    memmove(dst->int_keys + dst_index, src->int_keys + src_index,
+        count * sizeof *dst->int_keys);
+    if (src->leaf) {
+        memmove(dst->values + dst_index, src->values + src_index,
+            count * sizeof *dst->values);
+    }
+}
+
+static void simple_btree_move_children(
+    struct simple_btree_node *dst,
+    uint32_t dst_index,
+    struct simple_btree_node *src,
+    uint32_t src_index,
+    uint32_t count
+) {
+    memmove(dst->children + dst_index, src->children + src_index,
+        count * sizeof *dst->children);
+}
+
+static struct simple_error *simple_btree_probe_init(
+    const struct simple_btree *tree,
+    const struct object *key,
+    struct simple_btree_probe *probe
+) {
+    struct simple_error *error = object_check_type(key, tree->key_type);
+    simple_error_check(error);
+
+    *probe = (struct simple_btree_probe) {
+        .key = key,
+        .int_key = 0,
+        .is_int = object_get_kind(key) == OBJECT_INTEGER
+    };
+
+    if (probe->is_int) {
+        int value;
+        error = object_get_int(key, &value);
+        simple_error_check(error);
+        probe->int_key = value;
+    }
+
+    cleanup:
+    return error;
+}
+
+// The number of keys in node less than the probe, or not greater than it
+// if upper is set.
+static struct simple_error *simple_btree_search(
+    const struct simple_btree *tree,
+    const struct simple_btree_node *node,
+    const struct simple_btree_probe *probe,
+    bool upper,
+    uint32_t *result
+) {
+    struct simple_error *error = NULL;
+
+    if (tree->int_keys && probe->is_int) {
+        // counting instead of branching, this compiles to vector compares
+        uint32_t index = 0;
+        if (upper) {
+            for (uint32_t i = 0; i < node->count; i++) {
+                index += node->int_keys[i] <= probe->int_key;
+            }
+        } else {
+            for (uint32_t i = 0; i < node->count; i++) {
+                index += node->int_keys[i] < probe->int_key;
+            }
+        }
+        *result = index;
+        return NULL;
+    }
+
+    uint32_t low = 0, high = node->count;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        int compare;
+        error = object_compare(node->keys[middle], probe->key, &compare);
+        simple_error_check(error);
+
+        if (compare < 0 || (upper && compare == 0)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *result = low;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_btree_matches(
+    const struct simple_btree *tree,
+    const struct simple_btree_node *node,
+    uint32_t index,
+    const struct simple_btree_probe *probe,
+    bool *result
+) {
+    struct simple_error *error = NULL;
+    *result = false;
+
+    if (index >= node->count) {
+        return NULL;
+    }
+
+    if (tree->int_keys && probe->is_int) {
+        *result = node->int_keys[index] == probe->int_key;
+        return NULL;
+    }
+
+    int compare;
+    error = object_compare(node->keys[index], probe->key, &compare);
+    simple_error_check(error);
+    *result = compare == 0;
+
+    cleanup:
+    return error;
+}
+
+// the leaf that holds the probe if it is in the tree
+static struct simple_error *simple_btree_find_leaf(
+    const struct simple_btree *tree,
+    const struct simple_btree_probe *probe,
+    const struct simple_btree_node **result
+) {
+    struct simple_error *error = NULL;
+    const struct simple_btree_node *node = tree->root;
+
+    while (!node->leaf) {
+        uint32_t index;
+        error = simple_btree_search(tree, node, probe, true, &index);
+        simple_error_check(error);
+        node = node->children[index];
+    }
+
+    cleanup:
+    *result = error ? NULL : node;
+    return error;
+}
+
+struct simple_btree *simple_btree_new(
+    const struct type *key_type,
+    const struct type *value_type
+) {
+    struct simple_btree *tree = calloc(1, sizeof *tree);
+    *tree = (struct simple_btree) {
+        .key_type = key_type,
+        .value_type = value_type,
+        .root = simple_btree_node_new(true),
+        .size = 0,
+        .int_keys = true
+    };
+    return tree;
+}
+
+static struct simple_error *simple_btree_copy_entry(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    return simple_btree_insert(context, key, value);
+}
+
+struct simple_error *simple_btree_copy(
+    const struct simple_btree *tree,
+    struct simple_btree **result
+) {
+    *result = simple_btree_new(tree->key_type, tree->value_type);
+
+    struct simple_error *error = simple_btree_foreach(tree,
+        simple_btree_copy_entry, *result);
+    simple_error_check(error);
+
+    cleanup:
+    if (error) {
+        simple_btree_destroy(*result);
+        *result = NULL;
+    }
+    return error;
+}
+
+void simple_btree_destroy(
+    struct simple_btree *tree
+) {
+    if (!tree) {
+        return;
+    }
+    simple_btree_node_destroy(tree->root);
+    free(tree);
+}
+
+size_t simple_btree_size(
+    const struct simple_btree *tree
+) {
+    return tree->size;
+}
+
+struct simple_error *simple_btree_find(
+    const struct simple_btree *tree,
+    const struct object *key,
+    struct object **result
+) {
+    struct simple_btree_probe probe;
+    const struct simple_btree_node *leaf;
+    uint32_t index;
+    bool matches;
+    struct simple_error *error;
+
+    *result = NULL;
+
+    error = simple_btree_probe_init(tree, key, &probe);
+    simple_error_check(error);
+
+    error = simple_btree_find_leaf(tree, &probe, &leaf);
+    simple_error_check(error);
+
+    error = simple_btree_search(tree, leaf, &probe, false, &index);
+    simple_error_check(error);
+
+    error = simple_btree_matches(tree, leaf, index, &probe, &matches);
+    simple_error_check(error);
+
+    if (matches) {
+        *result = leaf->values[index];
+        object_refcount_increase(*result);
+    }
+
+    cleanup:
+    return error;
+}
+
+// Takes the copies only on success, nothing changes before the last
+// comparison so errors leave the tree as it was.
+static struct simple_error *simple_btree_insert_node(
+    struct simple_btree *tree,
+    struct simple_btree_node *node,
+    const struct simple_btree_probe *probe,
+    struct object *key,
+    struct object *value,
+    bool *added,
+    struct simple_btree_split *split
+) {
+    struct simple_error *error;
+    struct simple_btree_node *target = node, *right;
+    uint32_t index, half = SIMPLE_BTREE_MAX_KEYS / 2;
+
+    split->node = NULL;
+
+    if (node->leaf) {
+        bool matches;
+        error = simple_btree_search(tree, node, probe, false, &index);
+        simple_error_check(error);
+
+        error = simple_btree_matches(tree, node, index, probe, &matches);
+        simple_error_check(error);
+
+        *added = !matches;
+        if (matches) {
+            object_refcount_decrease(node->values[index]);
+            node->values[index] = value;
+            object_refcount_decrease(key);
+            return NULL;
+        }
+
+        if (node->count == SIMPLE_BTREE_MAX_KEYS) {
+            right = simple_btree_node_new(true);
+            simple_btree_move(right, 0, node, half, node->count - half);
+            right->count = node->count - half;
+            node->count = half;
+            right->next = node->next;
+            node->next = right;
+
+            *split = (struct simple_btree_split) {
+                .key = right->keys[0],
+                .int_key = right->int_keys[0],
+                .node = right
+            };
+            object_refcount_increase(split->key);
+
+            if (index > half) {
+                target = right;
+                index -= half;
+            }
+        }
+
+        simple_btree_move(target, index + 1, target, index,
+            target->count - index);
+        simple_btree_set_key(target, index, key, probe->int_key);
+        target->values[index] = value;
+        target->count++;
+        return NULL;
+    }
+
+    struct simple_btree_split child_split;
+    error = simple_btree_search(tree, node, probe, true, &index);
+    simple_error_check(error);
+
+    error = simple_btree_insert_node(tree, node->children[index], probe, key,
+        value, added, &child_split);
+    simple_error_check(error);
+
+    if (!child_split.node) {
+        return NULL;
+    }
+
+    // the middle key moves up, the new separator goes where the child was
+    if (node->count == SIMPLE_BTREE_MAX_KEYS) {
+        right = simple_btree_node_new(false);
+        simple_btree_move(right, 0, node, half + 1, node->count - half - 1);
+        simple_btree_move_children(right, 0, node, half + 1,
+            node->count - half);
+        right->count = node->count - half - 1;
+        node->count = half;
+
+        *split = (struct simple_btree_split) {
+            .key = node->keys[half],
+            .int_key = node->int_keys[half],
+            .node = right
+        };
+
+        if (index > half) {
+            target = right;
+            index -= half + 1;
+        }
+    }
+
+    simple_btree_move(target, index + 1, target, index,
+        target->count - index);
+    simple_btree_move_children(target, index + 2, target, index + 1,
+        target->count - index);
+    simple_btree_set_key(target, index, child_split.key,
+        child_split.int_key);
+    target->children[index + 1] = child_split.node;
+    target->count++;
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_btree_insert(
+    struct simple_btree *tree,
+    const struct object *key,
+    const struct object *value
+) {
+    struct simple_btree_probe probe;
+    struct simple_btree_split split;
+    struct object *key_copy = NULL, *value_copy = NULL;
+    bool added;
+    struct simple_error *error;
+
+    error = simple_btree_probe_init(tree, key, &probe);
+    simple_error_check(error);
+
+    error = object_copy(key, &key_copy);
+    simple_error_check(error);
+
+    error = object_copy(value, &value_copy);
+    simple_error_check(error);
+
+    error = simple_btree_insert_node(tree, tree->root, &probe, key_copy,
+        value_copy, &added, &split);
+    simple_error_check(error);
+    key_copy = NULL;
+    value_copy = NULL;
+
+    if (split.node) {
+        struct simple_btree_node *root = simple_btree_node_new(false);
+        simple_btree_set_key(root, 0, split.key, split.int_key);
+        root->children[0] = tree->root;
+        root->children[1] = split.node;
+        root->count = 1;
+        tree->root = root;
+    }
+
+    if (added) {
+        tree->size++;
+        tree->int_keys = tree->int_keys && probe.is_int;
+    }
+
+    cleanup:
+    object_refcount_decrease(key_copy);
+    object_refcount_decrease(value_copy);
+    return error;
+}
+
+static void simple_btree_borrow_left(
+    struct simple_btree_node *parent,
+    uint32_t index
+) {
+    struct simple_btree_node *child = parent->children[index];
+    struct simple_btree_node *left = parent->children[index - 1];
+
+    simple_btree_move(child, 1, child, 0, child->count);
+
+    if (child->leaf) {
+        simple_btree_move(child, 0, left, left->count - 1, 1);
+        object_refcount_decrease(parent->keys[index - 1]);
+        simple_btree_set_key(parent, index - 1, child->keys[0],
+            child->int_keys[0]);
+        object_refcount_increase(child->keys[0]);
+    } else {
+        simple_btree_move_children(child, 1, child, 0, child->count + 1);
+        simple_btree_set_key(child, 0, parent->keys[index - 1],
+            parent->int_keys[index - 1]);
+        child->children[0] = left->children[left->count];
+        simple_btree_set_key(parent, index - 1, left->keys[left->count - 1],
+            left->int_keys[left->count - 1]);
+    }
+
+    left->count--;
+    child->count++;
+}
+
+static void simple_btree_borrow_right(
+    struct simple_btree_node *parent,
+    uint32_t index
+) {
+    struct simple_btree_node *child = parent->children[index];
+    struct simple_btree_node *right = parent->children[index + 1];
+
+    if (child->leaf) {
+        simple_btree_move(child, child->count, right, 0, 1);
+        simple_btree_move(right, 0, right, 1, right->count - 1);
+        object_refcount_decrease(parent->keys[index]);
+        simple_btree_set_key(parent, index, right->keys[0],
+            right->int_keys[0]);
+        object_refcount_increase(right->keys[0]);
+    } else {
+        simple_btree_set_key(child, child->count, parent->keys[index],
+            parent->int_keys[index]);
+        child->children[child->count + 1] = right->children[0];
+        simple_btree_set_key(parent, index, right->keys[0],
+            right->int_keys[0]);
+        simple_btree_move(right, 0, right, 1, right->count - 1);
+        simple_btree_move_children(right, 0, right, 1, right->count);
+    }
+
+    child->count++;
+    right->count--;
+}
+
+// merges children[index + 1] into children[index]
+static void simple_btree_merge(
+    struct simple_btree_node *parent,
+    uint32_t index
+) {
+    struct simple_btree_node *left = parent->children[index];
+    struct simple_btree_node *right = parent->children[index + 1];
+
+    if (left->leaf) {
+        simple_btree_move(left, left->count, right, 0, right->count);
+        left->count += right->count;
+        left->next = right->next;
+        object_refcount_decrease(parent->keys[index]);
+    } else {
+        // the separator moves down between the two halves
+        simple_btree_set_key(left, left->count, parent->keys[index],
+            parent->int_keys[index]);
+        simple_btree_move(left, left->count + 1, right, 0, right->count);
+        simple_btree_move_children(left, left->count + 1, right, 0,
+            right->count + 1);
+        left->count += right->count + 1;
+    }
+    free(right);
+
+    simple_btree_move(parent, index, parent, index + 1,
+        parent->count - index - 1);
+    simple_btree_move_children(parent, index + 1, parent, index + 2,
+        parent->count - index - 1);
+    parent->count--;
+}
+
+// refills children[index] from a sibling, or merges it with one
+static void simple_btree_rebalance(
+    struct simple_btree_node *parent,
+    uint32_t index
+) {
+    struct simple_btree_node *left = NULL, *right = NULL;
+    if (index > 0) {
+        left = parent->children[index - 1];
+    }
+    if (index < parent->count) {
+        right = parent->children[index + 1];
+    }
+
+    if (left && left->count > SIMPLE_BTREE_MIN_KEYS) {
+        simple_btree_borrow_left(parent, index);
+    } else if (right && right->count > SIMPLE_BTREE_MIN_KEYS) {
+        simple_btree_borrow_right(parent, index);
+    } else if (left) {
+        simple_btree_merge(parent, index - 1);
+    } else {
+        simple_btree_merge(parent, index);
+    }
+}
+
+static struct simple_error *simple_btree_erase_node(
+    const struct simple_btree *tree,
+    struct simple_btree_node *node,
+    const struct simple_btree_probe *probe,
+    bool *erased
+) {
+    struct simple_error *error;
+    uint32_t index;
+
+    if (node->leaf) {
+        error = simple_btree_search(tree, node, probe, false, &index);
+        simple_error_check(error);
+
+        error = simple_btree_matches(tree, node, index, probe, erased);
+        simple_error_check(error);
+
+        if (*erased) {
+            object_refcount_decrease(node->keys[index]);
+            object_refcount_decrease(node->values[index]);
+            simple_btree_move(node, index, node, index + 1,
+                node->count - index - 1);
+            node->count--;
+        }
+        return NULL;
+    }
+
+    error = simple_btree_search(tree, node, probe, true, &index);
+    simple_error_check(error);
+
+    error = simple_btree_erase_node(tree, node->children[index], probe,
+        erased);
+    simple_error_check(error);
+
+    if (*erased && node->children[index]->count < SIMPLE_BTREE_MIN_KEYS) {
+        simple_btree_rebalance(node, index);
+    }
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_btree_erase(
+    struct simple_btree *tree,
+    const struct object *key,
+    bool *erased
+) {
+    struct simple_btree_probe probe;
+    struct simple_error *error;
+
+    *erased = false;
+
+    error = simple_btree_probe_init(tree, key, &probe);
+    simple_error_check(error);
+
+    error = simple_btree_erase_node(tree, tree->root, &probe, erased);
+    simple_error_check(error);
+
+    if (!tree->root->leaf && !tree->root->count) {
+        struct simple_btree_node *root = tree->root;
+        tree->root = root->children[0];
+        free(root);
+    }
+
+    if (*erased && !--tree->size) {
+        tree->int_keys = true;
+    }
+
+    cleanup:
+    return error;
+}
+
+void simple_btree_first(
+    const struct simple_btree *tree,
+    struct simple_btree_cursor *cursor
+) {
+    const struct simple_btree_node *node = tree->root;
+    while (!node->leaf) {
+        node = node->children[0];
+    }
+    *cursor = (struct simple_btree_cursor) {
+        .leaf = node,
+        .index = 0
+    };
+}
+
+static struct simple_error *simple_btree_bound(
+    const struct simple_btree *tree,
+    const struct object *key,
+    bool upper,
+    struct simple_btree_cursor *cursor
+) {
+    struct simple_btree_probe probe;
+    const struct simple_btree_node *leaf;
+    uint32_t index;
+    struct simple_error *error;
+
+    error = simple_btree_probe_init(tree, key, &probe);
+    simple_error_check(error);
+
+    error = simple_btree_find_leaf(tree, &probe, &leaf);
+    simple_error_check(error);
+
+    error = simple_btree_search(tree, leaf, &probe, upper, &index);
+    simple_error_check(error);
+
+    // past the end of leaf, cursor_next moves on to the next one
+    *cursor = (struct simple_btree_cursor) {
+        .leaf = leaf,
+        .index = index
+    };
+
+    cleanup:
+    if (error) {
+        *cursor = (struct simple_btree_cursor) {
+            .leaf = NULL,
+            .index = 0
+        };
+    }
+    return error;
+}
+
+struct simple_error *simple_btree_lower_bound(
+    const struct simple_btree *tree,
+    const struct object *key,
+    struct simple_btree_cursor *cursor
+) {
+    return simple_btree_bound(tree, key, false, cursor);
+}
+
+struct simple_error *simple_btree_upper_bound(
+    const struct simple_btree *tree,
+    const struct object *key,
+    struct simple_btree_cursor *cursor
+) {
+    return simple_btree_bound(tree, key, true, cursor);
+}
+
+bool simple_btree_cursor_next(
+    struct simple_btree_cursor *cursor,
+    const struct object **key,
+    const struct object **value
+) {
+    while (cursor->leaf && cursor->index >= cursor->leaf->count) {
+        cursor->leaf = cursor->leaf->next;
+        cursor->index = 0;
+    }
+
+    if (!cursor->leaf) {
+        *key = NULL;
+        *value = NULL;
+        return false;
+    }
+
+    *key = cursor->leaf->keys[cursor->index];
+    *value = cursor->leaf->values[cursor->index];
+    cursor->index++;
+    return true;
+}
+
+struct simple_error *simple_btree_foreach(
+    const struct simple_btree *tree,
+    simple_btree_visit_func func,
+    void *context
+) {
+    return simple_btree_range(tree, NULL, NULL, func, context);
+}
+
+struct simple_error *simple_btree_range(
+    const struct simple_btree *tree,
+    const struct object *low,
+    const struct object *high,
+    simple_btree_visit_func func,
+    void *context
+) {
+    struct simple_btree_cursor cursor;
+    const struct object *key, *value;
+    struct simple_error *error = NULL;
+
+    if (low) {
+        error = simple_btree_lower_bound(tree, low, &cursor);
+        simple_error_check(error);
+    } else {
+        simple_btree_first(tree, &cursor);
+    }
+
+    while (simple_btree_cursor_next(&cursor, &key, &value)) {
+        if (high) {
+            int compare;
+            error = object_compare(key, high, &compare);
+            simple_error_check(error);
+            if (compare >= 0) {
+                break;
+            }
+        }
+
+        error = func(key, value, context);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+// both trees are ordered, so they are walked side by side
+struct simple_error *simple_btree_equals(
+    const struct simple_btree *lhs,
+    const struct simple_btree *rhs,
+    bool *result
+) {
+    struct simple_btree_cursor lhs_cursor, rhs_cursor;
+    const struct object *lhs_key, *lhs_value, *rhs_key, *rhs_value;
+    struct simple_error *error = NULL;
+
+    *result = lhs->size == rhs->size;
+    simple_btree_first(lhs, &lhs_cursor);
+    simple_btree_first(rhs, &rhs_cursor);
+
+    while (*result && simple_btree_cursor_next(&lhs_cursor, &lhs_key,
+            &lhs_value)) {
+        (void)simple_btree_cursor_next(&rhs_cursor, &rhs_key, &rhs_value);
+
+        error = object_equals(lhs_key, rhs_key, result);
+        simple_error_check(error);
+
+        if (*result) {
+            error = object_equals(lhs_value, rhs_value, result);
+            simple_error_check(error);
+        }
+    }
+
+    cleanup:
+    if (error) {
+        *result = false;
+    }
+    return error;
+}
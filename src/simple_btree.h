@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct object;
+struct simple_error;
+struct type;
+struct simple_btree;
+struct simple_btree_node;
+
+// Ordered map, a B+-tree whose entries all sit in leaves linked front to
+// back. Keys are ordered with object_compare. Trees holding only int keys
+// search nodes without calling it.
+
+// Position in the leaf chain. Inserting into or erasing from the tree
+// invalidates cursors.
+struct simple_btree_cursor {
+    const struct simple_btree_node *leaf;
+    size_t index;
+};
+
+// Called for every entry in order, returning an error stops the iteration.
+typedef struct simple_error *(*simple_btree_visit_func)(
+    const struct object *key,
+    const struct object *value,
+    void *context
+);
+
+struct simple_btree *simple_btree_new(
+    const struct type *key_type,
+    const struct type *value_type
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_btree_copy(
+    const struct simple_btree *tree,
+    struct simple_btree **result
+) __attribute__((warn_unused_result));
+
+void simple_btree_destroy(
+    struct simple_btree *tree
+);
+
+size_t simple_btree_size(
+    const struct simple_btree *tree
+);
+
+// Increases the reference count of the result, like simple_hashtable_find.
+struct simple_error *simple_btree_find(
+    const struct simple_btree *tree,
+    const struct object *key,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+// Key and value are copied, an existing value for key is replaced.
+struct simple_error *simple_btree_insert(
+    struct simple_btree *tree,
+    const struct object *key,
+    const struct object *value
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_btree_erase(
+    struct simple_btree *tree,
+    const struct object *key,
+    bool *erased
+) __attribute__((warn_unused_result));
+
+// Cursor at the smallest key.
+void simple_btree_first(
+    const struct simple_btree *tree,
+    struct simple_btree_cursor *cursor
+);
+
+// Cursor at the first key not less than key.
+struct simple_error *simple_btree_lower_bound(
+    const struct simple_btree *tree,
+    const struct object *key,
+    struct simple_btree_cursor *cursor
+) __attribute__((warn_unused_result));
+
+// Cursor at the first key greater than key.
+struct simple_error *simple_btree_upper_bound(
+    const struct simple_btree *tree,
+    const struct object *key,
+    struct simple_btree_cursor *cursor
+) __attribute__((warn_unused_result));
+
+// Returns the entry at cursor and moves past it, false at the end. Key and
+// value are borrowed from the tree.
+bool simple_btree_cursor_next(
+    struct simple_btree_cursor *cursor,
+    const struct object **key,
+    const struct object **value
+);
+
+struct simple_error *simple_btree_foreach(
+    const struct simple_btree *tree,
+    simple_btree_visit_func func,
+    void *context
+) __attribute__((warn_unused_result));
+
+// Visits the keys in [low, high) in order. NULL bounds are open.
+struct simple_error *simple_btree_range(
+    const struct simple_btree *tree,
+    const struct object *low,
+    const struct object *high,
+    simple_btree_visit_func func,
+    void *context
+) __attribute__((warn_unused_result));
+
+// Equal when both hold equal keys mapped to equal values.
+struct simple_error *simple_btree_equals(
+    const struct simple_btree *lhs,
+    const struct simple_btree *rhs,
+    bool *result
+) __attribute__((warn_unused_result));
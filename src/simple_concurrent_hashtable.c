@@ -0,0 +1,494 @@
+#include "simple_concurrent_hashtable.h"
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_epoch.h"
+#include "simple_error.h"
+#include "simple_hash.h"
+#include "simple_object.h"
+
+#define SIMPLE_CONCURRENT_HASHTABLE_MAX_LOAD_FACTOR 0.75
+
+// every stripe needs at least one bucket in the smallest table
+#define SIMPLE_CONCURRENT_HASHTABLE_MIN_BUCKETS \
+    (4 * SIMPLE_CONCURRENT_HASHTABLE_STRIPES)
+
+struct simple_concurrent_hashtable_entry {
+    struct object *key;
+    _Atomic(struct object *) value;
+    size_t hash;
+    _Atomic(struct simple_concurrent_hashtable_entry *) next;
+};
+
+// While growing, the old bucket array links to the new one. A stripe is
+// moved over entry by entry under its lock and then flagged as migrated,
+// from then on readers of that stripe follow next. Old chains are never
+// modified once migrated, readers still walking them stay safe.
+struct simple_concurrent_hashtable_buckets {
+    size_t mask;
+    _Atomic(struct simple_concurrent_hashtable_buckets *) next;
+    atomic_size_t migrated_count;
+    atomic_bool migrated[SIMPLE_CONCURRENT_HASHTABLE_STRIPES];
+    _Atomic(struct simple_concurrent_hashtable_entry *) heads[];
+};
+
+// one cache line each, so writers on different stripes do not contend
+struct simple_concurrent_hashtable_stripe {
+    _Alignas(64) pthread_mutex_t lock;
+    atomic_size_t size;
+};
+
+struct simple_concurrent_hashtable {
+    const struct type *key_type, *value_type;
+    _Atomic(struct simple_concurrent_hashtable_buckets *) buckets;
+    struct simple_concurrent_hashtable_stripe
+        stripes[SIMPLE_CONCURRENT_HASHTABLE_STRIPES];
+};
+
+static struct simple_concurrent_hashtable_buckets *
+simple_concurrent_hashtable_buckets_new(
+    size_t bucket_count
+) {
+    struct simple_concurrent_hashtable_buckets *buckets;
+    buckets = calloc(1, sizeof *buckets + bucket_count *
+        sizeof *buckets->heads);
+
+    buckets->mask = bucket_count - 1;
+    atomic_init(&buckets->next, NULL);
+    atomic_init(&buckets->migrated_count, 0);
+    for (size_t i = 0; i < SIMPLE_CONCURRENT_HASHTABLE_STRIPES; i++) {
+        atomic_init(&buckets->migrated[i], false);
+    }
+    for (size_t i = 0; i < bucket_count; i++) {
+        atomic_init(&buckets->heads[i], NULL);
+    }
+    return buckets;
+}
+
+static void simple_concurrent_hashtable_entry_destroy(
+    void *pointer
+) {
+    struct simple_concurrent_hashtable_entry *entry = pointer;
+    object_refcount_decrease(entry->key);
+    object_refcount_decrease(atomic_load_explicit(&entry->value,
+        memory_order_relaxed));
+    free(entry);
+}
+
+static void simple_concurrent_hashtable_value_destroy(
+    void *pointer
+) {
+    object_refcount_decrease(pointer);
+}
+
+// entries in migrated stripes are copies, the key and value moved on
+static void simple_concurrent_hashtable_buckets_destroy(
+    void *pointer
+) {
+    struct simple_concurrent_hashtable_buckets *buckets = pointer;
+
+    for (size_t i = 0; i <= buckets->mask; i++) {
+        bool migrated = atomic_load_explicit(&buckets->migrated[
+            i & (SIMPLE_CONCURRENT_HASHTABLE_STRIPES - 1)],
+            memory_order_relaxed);
+
+        struct simple_concurrent_hashtable_entry *entry, *next;
+        entry = atomic_load_explicit(&buckets->heads[i], memory_order_relaxed);
+        while (entry) {
+            next = atomic_load_explicit(&entry->next, memory_order_relaxed);
+            if (migrated) {
+                free(entry);
+            } else {
+                simple_concurrent_hashtable_entry_destroy(entry);
+            }
+            entry = next;
+        }
+    }
+    free(buckets);
+}
+
+struct simple_concurrent_hashtable *simple_concurrent_hashtable_new(
+    const struct type *key_type,
+    const struct type *value_type
+) {
+    struct simple_concurrent_hashtable *table;
+    table = aligned_alloc(_Alignof(struct simple_concurrent_hashtable),
+        sizeof *table);
+    memset(table, 0, sizeof *table);
+
+    table->key_type = key_type;
+    table->value_type = value_type;
+    atomic_init(&table->buckets, simple_concurrent_hashtable_buckets_new(
+        SIMPLE_CONCURRENT_HASHTABLE_MIN_BUCKETS));
+
+    for (size_t i = 0; i < SIMPLE_CONCURRENT_HASHTABLE_STRIPES; i++) {
+        pthread_mutex_init(&table->stripes[i].lock, NULL);
+        atomic_init(&table->stripes[i].size, 0);
+    }
+    return table;
+}
+
+void simple_concurrent_hashtable_destroy(
+    struct simple_concurrent_hashtable *table
+) {
+    if (!table) {
+        return;
+    }
+
+    struct simple_concurrent_hashtable_buckets *buckets, *next;
+    buckets = atomic_load_explicit(&table->buckets, memory_order_relaxed);
+    while (buckets) {
+        next = atomic_load_explicit(&buckets->next, memory_order_relaxed);
+        simple_concurrent_hashtable_buckets_destroy(buckets);
+        buckets = next;
+    }
+
+    for (size_t i = 0; i < SIMPLE_CONCURRENT_HASHTABLE_STRIPES; i++) {
+        pthread_mutex_destroy(&table->stripes[i].lock);
+    }
+    free(table);
+}
+
+static struct simple_error *simple_concurrent_hashtable_get_hash(
+    const struct simple_concurrent_hashtable *table,
+    const struct object *key,
+    size_t *result
+) {
+    struct simple_error *error = object_check_type(key, table->key_type);
+    simple_error_check(error);
+
+    *result = simple_hash_integer(object_get_hash(key));
+
+    cleanup:
+    if (error) {
+        *result = 0;
+    }
+    return error;
+}
+
+static size_t simple_concurrent_hashtable_stripe_id(
+    size_t hash
+) {
+    return hash & (SIMPLE_CONCURRENT_HASHTABLE_STRIPES - 1);
+}
+
+// Drops old bucket arrays from the front once all their stripes moved
+// on. Growth may run ahead of this, so it advances as far as it can.
+static void simple_concurrent_hashtable_publish(
+    struct simple_concurrent_hashtable *table
+) {
+    struct simple_concurrent_hashtable_buckets *buckets, *next;
+    buckets = atomic_load_explicit(&table->buckets, memory_order_acquire);
+
+    while (atomic_load_explicit(&buckets->migrated_count,
+            memory_order_acquire) == SIMPLE_CONCURRENT_HASHTABLE_STRIPES) {
+        next = atomic_load_explicit(&buckets->next, memory_order_acquire);
+        if (atomic_compare_exchange_strong_explicit(&table->buckets,
+                &buckets, next, memory_order_acq_rel,
+                memory_order_acquire)) {
+            simple_epoch_retire(simple_concurrent_hashtable_buckets_destroy,
+                buckets);
+            buckets = next;
+        }
+    }
+}
+
+// Copies the entries of one stripe into the next bucket array. The
+// stripe lock is held, so nothing else changes these chains meanwhile.
+static void simple_concurrent_hashtable_migrate_stripe(
+    struct simple_concurrent_hashtable *table,
+    struct simple_concurrent_hashtable_buckets *from,
+    struct simple_concurrent_hashtable_buckets *to,
+    size_t stripe_id
+) {
+    for (size_t i = stripe_id; i <= from->mask;
+            i += SIMPLE_CONCURRENT_HASHTABLE_STRIPES) {
+        struct simple_concurrent_hashtable_entry *entry;
+        entry = atomic_load_explicit(&from->heads[i], memory_order_relaxed);
+        while (entry) {
+            struct simple_concurrent_hashtable_entry *copy;
+            copy = calloc(1, sizeof *copy);
+            copy->key = entry->key;
+            copy->hash = entry->hash;
+            atomic_init(&copy->value, atomic_load_explicit(&entry->value,
+                memory_order_relaxed));
+
+            _Atomic(struct simple_concurrent_hashtable_entry *) *head;
+            head = &to->heads[entry->hash & to->mask];
+            atomic_init(&copy->next, atomic_load_explicit(head,
+                memory_order_relaxed));
+            atomic_store_explicit(head, copy, memory_order_release);
+
+            entry = atomic_load_explicit(&entry->next, memory_order_relaxed);
+        }
+    }
+
+    atomic_store_explicit(&from->migrated[stripe_id], true,
+        memory_order_release);
+    if (atomic_fetch_add_explicit(&from->migrated_count, 1,
+            memory_order_acq_rel) + 1 == SIMPLE_CONCURRENT_HASHTABLE_STRIPES) {
+        simple_concurrent_hashtable_publish(table);
+    }
+}
+
+// The bucket array holding the stripe, for readers.
+static struct simple_concurrent_hashtable_buckets *
+simple_concurrent_hashtable_read_buckets(
+    const struct simple_concurrent_hashtable *table,
+    size_t stripe_id
+) {
+    struct simple_concurrent_hashtable_buckets *buckets;
+    buckets = atomic_load_explicit(&table->buckets, memory_order_acquire);
+    while (atomic_load_explicit(&buckets->migrated[stripe_id],
+            memory_order_acquire)) {
+        buckets = atomic_load_explicit(&buckets->next, memory_order_acquire);
+    }
+    return buckets;
+}
+
+// The newest bucket array, for writers holding the stripe lock. Moves the
+// stripe along first if a resize is under way.
+static struct simple_concurrent_hashtable_buckets *
+simple_concurrent_hashtable_write_buckets(
+    struct simple_concurrent_hashtable *table,
+    size_t stripe_id
+) {
+    struct simple_concurrent_hashtable_buckets *buckets, *next;
+    buckets = atomic_load_explicit(&table->buckets, memory_order_acquire);
+
+    while ((next = atomic_load_explicit(&buckets->next,
+            memory_order_acquire))) {
+        if (!atomic_load_explicit(&buckets->migrated[stripe_id],
+                memory_order_relaxed)) {
+            simple_concurrent_hashtable_migrate_stripe(table, buckets, next,
+                stripe_id);
+        }
+        buckets = next;
+    }
+    return buckets;
+}
+
+// Links a bigger bucket array behind buckets, then walks all stripes so the
+// resize finishes even if writers stop coming. Losing the race to start it
+// is fine, somebody else is already growing the table.
+static void simple_concurrent_hashtable_grow(
+    struct simple_concurrent_hashtable *table,
+    struct simple_concurrent_hashtable_buckets *buckets
+) {
+    struct simple_concurrent_hashtable_buckets *next, *expected = NULL;
+    next = simple_concurrent_hashtable_buckets_new((buckets->mask + 1) * 2);
+
+    if (!atomic_compare_exchange_strong_explicit(&buckets->next, &expected,
+            next, memory_order_acq_rel, memory_order_acquire)) {
+        free(next);
+        return;
+    }
+
+    for (size_t i = 0; i < SIMPLE_CONCURRENT_HASHTABLE_STRIPES; i++) {
+        pthread_mutex_lock(&table->stripes[i].lock);
+        (void)simple_concurrent_hashtable_write_buckets(table, i);
+        pthread_mutex_unlock(&table->stripes[i].lock);
+    }
+}
+
+static bool simple_concurrent_hashtable_needs_growth(
+    const struct simple_concurrent_hashtable *table,
+    const struct simple_concurrent_hashtable_buckets *buckets,
+    size_t stripe_id
+) {
+    size_t stripe_buckets = (buckets->mask + 1) /
+        SIMPLE_CONCURRENT_HASHTABLE_STRIPES;
+    size_t size = atomic_load_explicit(&table->stripes[stripe_id].size,
+        memory_order_relaxed);
+    return (double)size > (double)stripe_buckets *
+        SIMPLE_CONCURRENT_HASHTABLE_MAX_LOAD_FACTOR;
+}
+
+// Finds the link pointing at the entry for key, or the bucket's last link.
+// The entry is returned as well, readers must not load the link again as
+// an erase may have pointed it at the next entry by then.
+static struct simple_error *simple_concurrent_hashtable_find_link(
+    struct simple_concurrent_hashtable_buckets *buckets,
+    const struct object *key,
+    size_t hash,
+    _Atomic(struct simple_concurrent_hashtable_entry *) **result,
+    struct simple_concurrent_hashtable_entry **result_entry
+) {
+    struct simple_error *error = NULL;
+    _Atomic(struct simple_concurrent_hashtable_entry *) *link;
+    struct simple_concurrent_hashtable_entry *entry;
+
+    link = &buckets->heads[hash & buckets->mask];
+    while ((entry = atomic_load_explicit(link, memory_order_acquire))) {
+        if (entry->hash == hash) {
+            bool equals;
+            error = object_equals(entry->key, key, &equals);
+            simple_error_check(error);
+            if (equals) {
+                break;
+            }
+        }
+        link = &entry->next;
+    }
+
+    cleanup:
+    *result = link;
+    *result_entry = error ? NULL : entry;
+    return error;
+}
+
+struct simple_error *simple_concurrent_hashtable_find(
+    const struct simple_concurrent_hashtable *table,
+    const struct object *key,
+    const struct object **result
+) {
+    size_t hash;
+    _Atomic(struct simple_concurrent_hashtable_entry *) *link;
+    struct simple_concurrent_hashtable_entry *entry;
+    struct simple_error *error;
+
+    *result = NULL;
+
+    error = simple_concurrent_hashtable_get_hash(table, key, &hash);
+    simple_error_check(error);
+
+    simple_epoch_enter();
+    error = simple_concurrent_hashtable_find_link(
+        simple_concurrent_hashtable_read_buckets(table,
+        simple_concurrent_hashtable_stripe_id(hash)), key, hash, &link,
+        &entry);
+    if (entry) {
+        *result = atomic_load_explicit(&entry->value, memory_order_acquire);
+    }
+    simple_epoch_leave();
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_concurrent_hashtable_insert(
+    struct simple_concurrent_hashtable *table,
+    const struct object *key,
+    const struct object *value
+) {
+    size_t hash;
+    struct object *key_copy = NULL, *value_copy = NULL;
+    struct simple_concurrent_hashtable_buckets *buckets;
+    _Atomic(struct simple_concurrent_hashtable_entry *) *link;
+    struct simple_concurrent_hashtable_entry *entry;
+    bool grow = false;
+    struct simple_error *error;
+
+    error = simple_concurrent_hashtable_get_hash(table, key, &hash);
+    simple_error_check(error);
+
+    // copy outside the lock to keep the critical section short
+    error = object_copy(key, &key_copy);
+    simple_error_check(error);
+
+    error = object_copy(value, &value_copy);
+    simple_error_check(error);
+
+    size_t stripe_id = simple_concurrent_hashtable_stripe_id(hash);
+    struct simple_concurrent_hashtable_stripe *stripe;
+    stripe = table->stripes + stripe_id;
+
+    simple_epoch_enter();
+    pthread_mutex_lock(&stripe->lock);
+    buckets = simple_concurrent_hashtable_write_buckets(table, stripe_id);
+
+    error = simple_concurrent_hashtable_find_link(buckets, key, hash, &link,
+        &entry);
+    if (!error) {
+        if (entry) {
+            struct object *old_value = atomic_exchange_explicit(
+                &entry->value, value_copy, memory_order_acq_rel);
+            simple_epoch_retire(simple_concurrent_hashtable_value_destroy,
+                old_value);
+        } else {
+            entry = calloc(1, sizeof *entry);
+            entry->key = key_copy;
+            entry->hash = hash;
+            atomic_init(&entry->value, value_copy);
+            atomic_init(&entry->next, NULL);
+            atomic_store_explicit(link, entry, memory_order_release);
+            key_copy = NULL;
+
+            atomic_fetch_add_explicit(&stripe->size, 1,
+                memory_order_relaxed);
+            grow = simple_concurrent_hashtable_needs_growth(table, buckets,
+                stripe_id);
+        }
+        value_copy = NULL;
+    }
+    pthread_mutex_unlock(&stripe->lock);
+
+    if (grow) {
+        simple_concurrent_hashtable_grow(table, buckets);
+    }
+    simple_epoch_leave();
+    simple_error_check(error);
+
+    cleanup:
+    object_refcount_decrease(key_copy);
+    object_refcount_decrease(value_copy);
+    return error;
+}
+
+struct simple_error *simple_concurrent_hashtable_erase(
+    struct simple_concurrent_hashtable *table,
+    const struct object *key,
+    bool *erased
+) {
+    size_t hash;
+    struct simple_concurrent_hashtable_buckets *buckets;
+    _Atomic(struct simple_concurrent_hashtable_entry *) *link;
+    struct simple_concurrent_hashtable_entry *entry;
+    struct simple_error *error;
+
+    *erased = false;
+
+    error = simple_concurrent_hashtable_get_hash(table, key, &hash);
+    simple_error_check(error);
+
+    size_t stripe_id = simple_concurrent_hashtable_stripe_id(hash);
+    struct simple_concurrent_hashtable_stripe *stripe;
+    stripe = table->stripes + stripe_id;
+
+    simple_epoch_enter();
+    pthread_mutex_lock(&stripe->lock);
+    buckets = simple_concurrent_hashtable_write_buckets(table, stripe_id);
+
+    error = simple_concurrent_hashtable_find_link(buckets, key, hash, &link,
+        &entry);
+    if (entry) {
+        // readers standing on entry still find the rest of the chain
+        atomic_store_explicit(link, atomic_load_explicit(&entry->next,
+            memory_order_relaxed), memory_order_release);
+        atomic_fetch_sub_explicit(&stripe->size, 1, memory_order_relaxed);
+        simple_epoch_retire(simple_concurrent_hashtable_entry_destroy, entry);
+        *erased = true;
+    }
+    pthread_mutex_unlock(&stripe->lock);
+    simple_epoch_leave();
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+size_t simple_concurrent_hashtable_size(
+    const struct simple_concurrent_hashtable *table
+) {
+    size_t size = 0;
+    for (size_t i = 0; i < SIMPLE_CONCURRENT_HASHTABLE_STRIPES; i++) {
+        size += atomic_load_explicit(&table->stripes[i].size,
+            memory_order_relaxed);
+    }
+    return size;
+}
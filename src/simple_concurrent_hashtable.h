@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct object;
+struct simple_error;
+struct type;
+struct simple_concurrent_hashtable;
+
+// Writers serialize per stripe, a stripe owns every bucket whose index
+// has the same low bits.
+#define SIMPLE_CONCURRENT_HASHTABLE_STRIPES 64
+
+// A hashtable that may be shared between threads. Readers take no locks.
+// Writers lock one of the stripes, and growing is split per stripe so
+// writers help move entries instead of waiting on one thread doing it all.
+//
+// Keys and values are copied on insert, like in simple_hashtable. Erased
+// entries, replaced values and outgrown bucket arrays go through
+// simple_epoch, they are released once no reader can see them anymore.
+struct simple_concurrent_hashtable *simple_concurrent_hashtable_new(
+    const struct type *key_type,
+    const struct type *value_type
+) __attribute__((warn_unused_result));
+
+// Must not race with any other operation on the table.
+void simple_concurrent_hashtable_destroy(
+    struct simple_concurrent_hashtable *table
+);
+
+// Lock free. The result is borrowed from the table and its reference count
+// is left alone. Callers that keep it past the next write to key enter an
+// epoch critical section before the call and use it before leaving.
+struct simple_error *simple_concurrent_hashtable_find(
+    const struct simple_concurrent_hashtable *table,
+    const struct object *key,
+    const struct object **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_concurrent_hashtable_insert(
+    struct simple_concurrent_hashtable *table,
+    const struct object *key,
+    const struct object *value
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_concurrent_hashtable_erase(
+    struct simple_concurrent_hashtable *table,
+    const struct object *key,
+    bool *erased
+) __attribute__((warn_unused_result));
+
+// Exact when no writer is active, a snapshot otherwise.
+size_t simple_concurrent_hashtable_size(
+    const struct simple_concurrent_hashtable *table
+);
@@ -0,0 +1,283 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "simple_epoch.h"
+
+#include <assert.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// retirements between automatic collections
+#define SIMPLE_EPOCH_COLLECT_INTERVAL 64
+
+struct simple_epoch_retired {
+    void (*func)(void *pointer);
+    void *pointer;
+    uint64_t epoch;
+    struct simple_epoch_retired *next;
+};
+
+// One per thread, reused after the thread exits. Records are never freed
+// so advancing the epoch can walk the list without locks.
+struct simple_epoch_record {
+    // the epoch the thread entered in, shifted left, low bit set if active
+    _Alignas(64) _Atomic(uint64_t) state;
+    size_t nesting;
+    size_t retired_since_collect;
+    struct simple_epoch_retired *retired;
+    atomic_size_t retired_count;
+    atomic_size_t reclaimed_count;
+    atomic_bool in_use;
+    struct simple_epoch_record *next;
+};
+
+static _Atomic(uint64_t) simple_epoch_global = 0;
+static _Atomic(struct simple_epoch_record *) simple_epoch_records = NULL;
+
+// retirements left behind by exited threads
+static pthread_mutex_t simple_epoch_orphan_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct simple_epoch_retired *simple_epoch_orphans = NULL;
+static atomic_size_t simple_epoch_orphans_reclaimed = 0;
+
+static pthread_once_t simple_epoch_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t simple_epoch_key;
+static _Thread_local struct simple_epoch_record *simple_epoch_local = NULL;
+
+// hands the retirements of an exiting thread over, the record is reused
+static void simple_epoch_record_release(
+    void *pointer
+) {
+    struct simple_epoch_record *record = pointer;
+
+    if (record->retired) {
+        struct simple_epoch_retired *last = record->retired;
+        while (last->next) {
+            last = last->next;
+        }
+        pthread_mutex_lock(&simple_epoch_orphan_lock);
+        last->next = simple_epoch_orphans;
+        simple_epoch_orphans = record->retired;
+        pthread_mutex_unlock(&simple_epoch_orphan_lock);
+        record->retired = NULL;
+    }
+
+    record->nesting = 0;
+    record->retired_since_collect = 0;
+    atomic_store_explicit(&record->state, 0, memory_order_release);
+    atomic_store_explicit(&record->in_use, false, memory_order_release);
+}
+
+static void simple_epoch_key_create(
+    void
+) {
+    pthread_key_create(&simple_epoch_key, simple_epoch_record_release);
+}
+
+static struct simple_epoch_record *simple_epoch_get_record(
+    void
+) {
+    if (simple_epoch_local) {
+        return simple_epoch_local;
+    }
+
+    struct simple_epoch_record *record;
+    record = atomic_load_explicit(&simple_epoch_records,
+        memory_order_acquire);
+    for (; record; record = record->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong_explicit(&record->in_use,
+                &expected, true, memory_order_acq_rel,
+                memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (!record) {
+        record = aligned_alloc(_Alignof(struct simple_epoch_record),
+            sizeof *record);
+        memset(record, 0, sizeof *record);
+        atomic_init(&record->state, 0);
+        atomic_init(&record->retired_count, 0);
+        atomic_init(&record->reclaimed_count, 0);
+        atomic_init(&record->in_use, true);
+
+        record->next = atomic_load_explicit(&simple_epoch_records,
+            memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&simple_epoch_records,
+                &record->next, record, memory_order_release,
+                memory_order_relaxed)) {
+        }
+    }
+
+    pthread_once(&simple_epoch_key_once, simple_epoch_key_create);
+    pthread_setspecific(simple_epoch_key, record);
+    simple_epoch_local = record;
+    return record;
+}
+
+void simple_epoch_enter(
+    void
+) {
+    struct simple_epoch_record *record = simple_epoch_get_record();
+    if (record->nesting++) {
+        return;
+    }
+
+    // Announce, then check the epoch did not move in between. Otherwise
+    // an advance could have missed the announcement.
+    uint64_t epoch = atomic_load(&simple_epoch_global);
+    for (;;) {
+        atomic_store(&record->state, (epoch << 1) | 1);
+        uint64_t current = atomic_load(&simple_epoch_global);
+        if (current == epoch) {
+            break;
+        }
+        epoch = current;
+    }
+}
+
+void simple_epoch_leave(
+    void
+) {
+    struct simple_epoch_record *record = simple_epoch_local;
+    assert(record && record->nesting);
+
+    if (!--record->nesting) {
+        atomic_store_explicit(&record->state, 0, memory_order_release);
+    }
+}
+
+// The epoch moves on once every active thread has seen the current one.
+// Memory retired in epoch e is unreachable for everyone by epoch e + 2.
+static void simple_epoch_try_advance(
+    void
+) {
+    uint64_t epoch = atomic_load(&simple_epoch_global);
+
+    struct simple_epoch_record *record;
+    record = atomic_load_explicit(&simple_epoch_records,
+        memory_order_acquire);
+    for (; record; record = record->next) {
+        uint64_t state = atomic_load(&record->state);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return;
+        }
+    }
+
+    atomic_compare_exchange_strong(&simple_epoch_global, &epoch, epoch + 1);
+}
+
+// frees the entries of list that are old enough, returns how many
+static size_t simple_epoch_reclaim(
+    struct simple_epoch_retired **list,
+    uint64_t epoch
+) {
+    size_t reclaimed = 0;
+    struct simple_epoch_retired **link = list;
+
+    while (*link) {
+        struct simple_epoch_retired *retired = *link;
+        if (retired->epoch + 2 <= epoch) {
+            *link = retired->next;
+            retired->func(retired->pointer);
+            free(retired);
+            reclaimed++;
+        } else {
+            link = &retired->next;
+        }
+    }
+    return reclaimed;
+}
+
+void simple_epoch_collect(
+    void
+) {
+    struct simple_epoch_record *record = simple_epoch_get_record();
+    record->retired_since_collect = 0;
+
+    simple_epoch_try_advance();
+    uint64_t epoch = atomic_load(&simple_epoch_global);
+
+    atomic_fetch_add_explicit(&record->reclaimed_count,
+        simple_epoch_reclaim(&record->retired, epoch), memory_order_relaxed);
+
+    if (!pthread_mutex_trylock(&simple_epoch_orphan_lock)) {
+        atomic_fetch_add_explicit(&simple_epoch_orphans_reclaimed,
+            simple_epoch_reclaim(&simple_epoch_orphans, epoch),
+            memory_order_relaxed);
+        pthread_mutex_unlock(&simple_epoch_orphan_lock);
+    }
+}
+
+void simple_epoch_retire(
+    void (*func)(void *pointer),
+    void *pointer
+) {
+    struct simple_epoch_record *record = simple_epoch_get_record();
+
+    struct simple_epoch_retired *retired = calloc(1, sizeof *retired);
+    retired->func = func;
+    retired->pointer = pointer;
+    retired->epoch = atomic_load(&simple_epoch_global);
+    retired->next = record->retired;
+    record->retired = retired;
+    atomic_fetch_add_explicit(&record->retired_count, 1,
+        memory_order_relaxed);
+
+    if (++record->retired_since_collect >= SIMPLE_EPOCH_COLLECT_INTERVAL) {
+        simple_epoch_collect();
+    }
+}
+
+void simple_epoch_synchronize(
+    void
+) {
+    struct simple_epoch_record *record = simple_epoch_get_record();
+    assert(!record->nesting);
+    (void)record;
+
+    uint64_t target = atomic_load(&simple_epoch_global) + 2;
+    while (atomic_load(&simple_epoch_global) < target) {
+        simple_epoch_try_advance();
+        if (atomic_load(&simple_epoch_global) < target) {
+            sched_yield();
+        }
+    }
+
+    simple_epoch_collect();
+
+    pthread_mutex_lock(&simple_epoch_orphan_lock);
+    atomic_fetch_add_explicit(&simple_epoch_orphans_reclaimed,
+        simple_epoch_reclaim(&simple_epoch_orphans,
+        atomic_load(&simple_epoch_global)), memory_order_relaxed);
+    pthread_mutex_unlock(&simple_epoch_orphan_lock);
+}
+
+void simple_epoch_get_stats(
+    struct simple_epoch_stats *stats
+) {
+    *stats = (struct simple_epoch_stats) {
+        .epoch = atomic_load(&simple_epoch_global),
+        .retired = 0,
+        .reclaimed = atomic_load_explicit(&simple_epoch_orphans_reclaimed,
+            memory_order_relaxed),
+        .pending = 0
+    };
+
+    struct simple_epoch_record *record;
+    record = atomic_load_explicit(&simple_epoch_records,
+        memory_order_acquire);
+    for (; record; record = record->next) {
+        stats->retired += atomic_load_explicit(&record->retired_count,
+            memory_order_relaxed);
+        stats->reclaimed += atomic_load_explicit(&record->reclaimed_count,
+            memory_order_relaxed);
+    }
+    // the counters are read one by one, keep a racing snapshot sane
+    stats->pending = stats->retired > stats->reclaimed ?
+        stats->retired - stats->reclaimed : 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Epoch based reclamation for memory shared with lock free readers.
+//
+// Readers wrap every access to shared memory in enter and leave. Writers
+// unlink memory first and then retire it, it is freed once every thread
+// that could still see it has left its critical section. Sections nest
+// and cost a thread local counter plus one fence on the outermost level.
+
+struct simple_epoch_stats {
+    uint64_t epoch;
+    size_t retired;
+    size_t reclaimed;
+    size_t pending;
+};
+
+void simple_epoch_enter(
+    void
+);
+
+void simple_epoch_leave(
+    void
+);
+
+// Calls func(pointer) once no reader can hold pointer anymore. Retiring
+// from inside a critical section is fine.
+void simple_epoch_retire(
+    void (*func)(void *pointer),
+    void *pointer
+);
+
+// Tries to advance the epoch and reclaims what became safe to free. Runs
+// on its own every few retirements, never blocks.
+void simple_epoch_collect(
+    void
+);
+
+// Waits until everything retired so far was reclaimed. Must not be called
+// from inside a critical section, and waits for as long as other threads
+// stay inside theirs.
+void simple_epoch_synchronize(
+    void
+);
+
+void simple_epoch_get_stats(
+    struct simple_epoch_stats *stats
+);
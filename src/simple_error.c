@@ -1,15 +1,292 @@
 #include "simple_error.h"
 
+#include "simple_alloc.h"
+
 #include <malloc.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SIMPLE_ERROR_MAX_ARGS 8
+#define SIMPLE_ERROR_STRING_BYTES 128
+
+// nodes allocated at once when a thread's pool runs dry
+#define SIMPLE_ERROR_POOL_BLOCK 32
 
+enum simple_error_length {
+    SIMPLE_ERROR_LENGTH_NONE,
+    SIMPLE_ERROR_LENGTH_HH,
+    SIMPLE_ERROR_LENGTH_H,
+    SIMPLE_ERROR_LENGTH_L,
+    SIMPLE_ERROR_LENGTH_LL,
+    SIMPLE_ERROR_LENGTH_Z,
+    SIMPLE_ERROR_LENGTH_J,
+    SIMPLE_ERROR_LENGTH_T,
+    SIMPLE_ERROR_LENGTH_BIG_L
+};
+
+// one conversion of a printf format
+struct simple_error_spec {
+    const char *start, *length_start, *end;
+    size_t stars;
+    enum simple_error_length length;
+    char conversion;
+};
+
+union simple_error_arg {
+    intmax_t signed_value;
+    uintmax_t unsigned_value;
+    long double real;
+    const void *pointer;
+    size_t string_offset;
+};
+
+// Strings are copied into the node, they may not outlive the call. A
+// message with more arguments or string bytes than fit is formatted when
+// raised into message instead.
 struct simple_error {
     struct simple_error *cause;
     const char *filename;
     size_t line;
     const char *function;
+    const char *format;
+    size_t arg_count;
+    union simple_error_arg args[SIMPLE_ERROR_MAX_ARGS];
+    size_t string_length;
+    char strings[SIMPLE_ERROR_STRING_BYTES];
     char *message;
 };
 
+// Destroyed nodes go back to the pool of the destroying thread, blocks are
+// never freed. Steady state error handling does not allocate, only
+// messages too big for a node do.
+static _Thread_local struct simple_error *simple_error_pool = NULL;
+
+static struct simple_error *simple_error_alloc(
+    void
+) {
+    if (!simple_error_pool) {
+        struct simple_error *block = calloc(SIMPLE_ERROR_POOL_BLOCK,
+            sizeof *block);
+        simple_alloc_record("error_pool", SIMPLE_ERROR_POOL_BLOCK *
+            sizeof *block);
+        for (size_t i = 0; i + 1 < SIMPLE_ERROR_POOL_BLOCK; i++) {
+            block[i].cause = block + i + 1;
+        }
+        simple_error_pool = block;
+    }
+
+    struct simple_error *error = simple_error_pool;
+    simple_error_pool = error->cause;
+    return error;
+}
+
+// Finds the next conversion in format, false once there is none.
+static bool simple_error_next_spec(
+    const char *format,
+    struct simple_error_spec *spec
+) {
+    const char *p = strchr(format, '%');
+    while (p && p[1] == '%') {
+        p = strchr(p + 2, '%');
+    }
+    if (!p) {
+        return false;
+    }
+
+    spec->start = p++;
+    spec->stars = 0;
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+    for (int part = 0; part < 2; part++) {
+        if (*p == '*') {
+            spec->stars++;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        if (part == 0 && *p == '.') {
+            p++;
+        } else {
+            break;
+        }
+    }
+
+    spec->length_start = p;
+    spec->length = SIMPLE_ERROR_LENGTH_NONE;
+    switch (*p) {
+        case 'h':
+            spec->length = p[1] == 'h' ? SIMPLE_ERROR_LENGTH_HH :
+                SIMPLE_ERROR_LENGTH_H;
+            break;
+        case 'l':
+            spec->length = p[1] == 'l' ? SIMPLE_ERROR_LENGTH_LL :
+                SIMPLE_ERROR_LENGTH_L;
+            break;
+        case 'z':
+            spec->length = SIMPLE_ERROR_LENGTH_Z;
+            break;
+        case 'j':
+            spec->length = SIMPLE_ERROR_LENGTH_J;
+            break;
+        case 't':
+            spec->length = SIMPLE_ERROR_LENGTH_T;
+            break;
+        case 'L':
+            spec->length = SIMPLE_ERROR_LENGTH_BIG_L;
+            break;
+        default:
+            break;
+    }
+    if (spec->length == SIMPLE_ERROR_LENGTH_HH ||
+            spec->length == SIMPLE_ERROR_LENGTH_LL) {
+        p += 2;
+    } else if (spec->length != SIMPLE_ERROR_LENGTH_NONE) {
+        p++;
+    }
+
+    spec->conversion = *p;
+    if (!*p) {
+        return false;
+    }
+    spec->end = p + 1;
+    return true;
+}
+
+static intmax_t simple_error_read_signed(
+    enum simple_error_length length,
+    va_list *args
+) {
+    switch (length) {
+        case SIMPLE_ERROR_LENGTH_HH:
+            return (signed char)va_arg(*args, int);
+        case SIMPLE_ERROR_LENGTH_H:
+            return (short)va_arg(*args, int);
+        case SIMPLE_ERROR_LENGTH_L:
+            return va_arg(*args, long);
+        case SIMPLE_ERROR_LENGTH_LL:
+        case SIMPLE_ERROR_LENGTH_BIG_L:
+            return va_arg(*args, long long);
+        case SIMPLE_ERROR_LENGTH_Z:
+            return (intmax_t)va_arg(*args, size_t);
+        case SIMPLE_ERROR_LENGTH_J:
+            return va_arg(*args, intmax_t);
+        case SIMPLE_ERROR_LENGTH_T:
+            return va_arg(*args, ptrdiff_t);
+        case SIMPLE_ERROR_LENGTH_NONE:
+            break;
+    }
+    return va_arg(*args, int);
+}
+
+static uintmax_t simple_error_read_unsigned(
+    enum simple_error_length length,
+    va_list *args
+) {
+    switch (length) {
+        case SIMPLE_ERROR_LENGTH_HH:
+            return (unsigned char)va_arg(*args, unsigned int);
+        case SIMPLE_ERROR_LENGTH_H:
+            return (unsigned short)va_arg(*args, unsigned int);
+        case SIMPLE_ERROR_LENGTH_L:
+            return va_arg(*args, unsigned long);
+        case SIMPLE_ERROR_LENGTH_LL:
+        case SIMPLE_ERROR_LENGTH_BIG_L:
+            return va_arg(*args, unsigned long long);
+        case SIMPLE_ERROR_LENGTH_Z:
+            return va_arg(*args, size_t);
+        case SIMPLE_ERROR_LENGTH_J:
+            return va_arg(*args, uintmax_t);
+        case SIMPLE_ERROR_LENGTH_T:
+            return (uintmax_t)va_arg(*args, ptrdiff_t);
+        case SIMPLE_ERROR_LENGTH_NONE:
+            break;
+    }
+    return va_arg(*args, unsigned int);
+}
+
+// copies string and its '\0' into the node, false if it does not fit
+static bool simple_error_save_string(
+    struct simple_error *error,
+    const char *string,
+    size_t *offset
+) {
+    string = string ? string : "(null)";
+    size_t length = strlen(string) + 1;
+
+    if (length > SIMPLE_ERROR_STRING_BYTES - error->string_length) {
+        return false;
+    }
+    *offset = error->string_length;
+    memcpy(error->strings + *offset, string, length);
+    error->string_length += length;
+    return true;
+}
+
+// false if the argument is a string that does not fit into the node
+static bool simple_error_save_arg(
+    struct simple_error *error,
+    const struct simple_error_spec *spec,
+    va_list *args
+) {
+    union simple_error_arg *arg = error->args + error->arg_count++;
+
+    switch (spec->conversion) {
+        case 'd':
+        case 'i':
+        case 'c':
+            arg->signed_value = simple_error_read_signed(spec->length, args);
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            arg->unsigned_value = simple_error_read_unsigned(spec->length,
+                args);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (spec->length == SIMPLE_ERROR_LENGTH_BIG_L) {
+                arg->real = va_arg(*args, long double);
+            } else {
+                arg->real = va_arg(*args, double);
+            }
+            break;
+        case 's':
+            return simple_error_save_string(error,
+                va_arg(*args, const char *), &arg->string_offset);
+        default:
+            arg->pointer = va_arg(*args, const void *);
+            break;
+    }
+    return true;
+}
+
+static void simple_error_format_message(
+    struct simple_error *error,
+    va_list args
+) {
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(NULL, 0, error->format, copy);
+    va_end(copy);
+
+    size_t size = length > 0 ? (size_t)length + 1 : 1;
+    error->message = calloc(size, 1);
+    simple_alloc_record("error_message", size);
+    vsnprintf(error->message, size, error->format, args);
+}
+
 struct simple_error *simple_error_new_full(
     struct simple_error *cause,
     const char *filename,
@@ -18,30 +295,181 @@ struct simple_error *simple_error_new_full(
     const char *format,
     ...
 ) {
-    struct simple_error *error = calloc(1, sizeof *error);
-
-    *error = (struct simple_error) {
-        .filename = filename,
-        .line = line,
-        .function = function,
-        .cause = cause,
-        .message = NULL
-    };
+    struct simple_error *error = simple_error_wrap(cause, filename, line,
+        function);
+    error->format = format;
 
-    va_list args, args2;
+    va_list args, eager;
     va_start(args, format);
-    size_t message_length = (size_t)vsnprintf(error->message, 0, format, args);
-    va_end (args);
+    va_copy(eager, args);
+
+    struct simple_error_spec spec;
+    const char *cursor = format;
+    bool saved = true;
+    while (saved && simple_error_next_spec(cursor, &spec)) {
+        if (error->arg_count + spec.stars + 1 > SIMPLE_ERROR_MAX_ARGS) {
+            saved = false;
+            break;
+        }
+        for (size_t i = 0; i < spec.stars; i++) {
+            error->args[error->arg_count++].signed_value = va_arg(args, int);
+        }
+        saved = simple_error_save_arg(error, &spec, &args);
+        cursor = spec.end;
+    }
 
-    error->message = calloc(message_length + 1, sizeof *error->message);
+    // too big to save, format it now rather than cut it short
+    if (!saved) {
+        simple_error_format_message(error, eager);
+    }
 
-    va_start(args2, format);
-    vsnprintf(error->message, message_length, format, args2);
-    va_end (args2);
+    va_end(eager);
+    va_end(args);
+    return error;
+}
 
+struct simple_error *simple_error_wrap(
+    struct simple_error *cause,
+    const char *filename,
+    size_t line,
+    const char *function
+) {
+    // counted where the error is raised, not where the pool is refilled
+    struct simple_error *error = simple_error_alloc();
+    simple_alloc_record_at(filename, line, function, "error", sizeof *error);
+    error->cause = cause;
+    error->filename = filename;
+    error->line = line;
+    error->function = function;
+    error->format = NULL;
+    error->arg_count = 0;
+    error->string_length = 0;
+    error->message = NULL;
     return error;
 }
 
+// prints format up to end, or all of it if end is NULL
+static void simple_error_print_literal(
+    FILE *file,
+    const char *format,
+    const char *end
+) {
+    for (const char *p = format; *p && p != end; p++) {
+        fputc(*p, file);
+        if (p[0] == '%' && p[1] == '%') {
+            p++;
+        }
+    }
+}
+
+// Rebuilds the conversion with star widths filled in and a length that
+// matches how the argument was saved.
+static void simple_error_print_arg(
+    FILE *file,
+    const struct simple_error *error,
+    const struct simple_error_spec *spec,
+    const union simple_error_arg *args
+) {
+    char format[64];
+    size_t length = 0;
+
+    for (const char *p = spec->start; p != spec->length_start &&
+            length < sizeof format - 24; p++) {
+        if (*p == '*') {
+            length += (size_t)snprintf(format + length,
+                sizeof format - length, "%jd", (args++)->signed_value);
+        } else {
+            format[length++] = *p;
+        }
+    }
+
+    const char *suffix = "";
+    switch (spec->conversion) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            suffix = "j";
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            suffix = "L";
+            break;
+        default:
+            break;
+    }
+    snprintf(format + length, sizeof format - length, "%s%c", suffix,
+        spec->conversion);
+
+    switch (spec->conversion) {
+        case 'd':
+        case 'i':
+            fprintf(file, format, args->signed_value);
+            break;
+        case 'c':
+            fprintf(file, format, (int)args->signed_value);
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            fprintf(file, format, args->unsigned_value);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            fprintf(file, format, args->real);
+            break;
+        case 's':
+            fprintf(file, format, error->strings + args->string_offset);
+            break;
+        case 'p':
+            fprintf(file, format, args->pointer);
+            break;
+        default:
+            break;
+    }
+}
+
+static void simple_error_print_message(
+    FILE *file,
+    const struct simple_error *error
+) {
+    struct simple_error_spec spec;
+    const char *cursor = error->format;
+    size_t used = 0;
+
+    if (error->message) {
+        fputs(error->message, file);
+        return;
+    }
+    if (!cursor) {
+        return;
+    }
+
+    while (simple_error_next_spec(cursor, &spec) &&
+            used + spec.stars + 1 <= error->arg_count) {
+        simple_error_print_literal(file, cursor, spec.start);
+        simple_error_print_arg(file, error, &spec, error->args + used);
+        used += spec.stars + 1;
+        cursor = spec.end;
+    }
+    simple_error_print_literal(file, cursor, NULL);
+}
+
 void simple_error_show(
     const struct simple_error *error,
     FILE *file
@@ -51,8 +479,10 @@ void simple_error_show(
     }
     fprintf(file, "%s\n", "An error occurred, stacktrace:");
     while (error) {
-        fprintf(file, "%s:%zu %s() %s\n", error->filename, error->line,
-            error->function, error->message);
+        fprintf(file, "%s:%zu %s() ", error->filename, error->line,
+            error->function);
+        simple_error_print_message(file, error);
+        fputc('\n', file);
         error = error->cause;
     }
 }
@@ -60,9 +490,12 @@ void simple_error_show(
 void simple_error_destroy(
     struct simple_error *error
 ) {
-    if (error->cause) {
-        simple_error_destroy(error->cause);
+    while (error) {
+        struct simple_error *cause = error->cause;
+        free(error->message);
+        error->message = NULL;
+        error->cause = simple_error_pool;
+        simple_error_pool = error;
+        error = cause;
     }
-    free(error->message);
-    free(error);
 }
@@ -2,20 +2,38 @@
 
 #include <stdio.h>
 
+// The format must outlive the error, in practice it is a string literal.
+// Only the arguments are saved, the message is formatted when shown. One
+// with more than 8 arguments or 128 bytes of strings is formatted right
+// away instead.
 #define simple_error_new(format, ...) \
     simple_error_new_full(NULL, __FILE__, __LINE__, __FUNCTION__, \
         format, __VA_ARGS__)
 
 #define simple_error_check(error) \
     if (error) { \
-        error = simple_error_new_full(error, __FILE__, __LINE__, \
-        __FUNCTION__, "%s", ""); \
+        error = simple_error_wrap(error, __FILE__, __LINE__, __FUNCTION__); \
         goto cleanup; \
     } \
     (void)0
 
 struct simple_error;
 
+// Outcome of a lookup. A miss is a status, not an error, so probing
+// callers pay nothing for it. A miss carries no error, wrappers that treat
+// it as one build the detailed message only after SIMPLE_STATUS_NOT_FOUND.
+enum simple_status {
+    SIMPLE_STATUS_OK,
+    SIMPLE_STATUS_NOT_FOUND,
+    SIMPLE_STATUS_ERROR
+};
+
+// error is only set with SIMPLE_STATUS_ERROR
+struct simple_result {
+    enum simple_status status;
+    struct simple_error *error;
+};
+
 struct simple_error *simple_error_new_full(
     struct simple_error *cause,
     const char *filename,
@@ -25,6 +43,14 @@ struct simple_error *simple_error_new_full(
     ...
 ) __attribute__((warn_unused_result));
 
+// Adds a stack frame without a message to cause.
+struct simple_error *simple_error_wrap(
+    struct simple_error *cause,
+    const char *filename,
+    size_t line,
+    const char *function
+) __attribute__((warn_unused_result));
+
 void simple_error_show(
     const struct simple_error *error,
     FILE *file
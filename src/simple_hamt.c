@@ -0,0 +1,755 @@
+#include "simple_hamt.h"
+
+#include <malloc.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "simple_error.h"
+#include "simple_hash.h"
+#include "simple_object.h"
+#include "simple_string.h"
+
+// each level consumes this many hash bits, nodes have up to 32 slots
+#define SIMPLE_HAMT_BITS 5
+#define SIMPLE_HAMT_MASK ((1u << SIMPLE_HAMT_BITS) - 1)
+#define SIMPLE_HAMT_HASH_BITS (sizeof(size_t) * 8)
+
+// Leaves are shared between all nodes and maps that contain the entry.
+struct simple_hamt_leaf {
+    atomic_size_t ref_count;
+    size_t hash;
+    struct object *key, *value;
+};
+
+union simple_hamt_slot {
+    struct simple_hamt_node *node;
+    struct simple_hamt_leaf *leaf;
+};
+
+// Only slots present in bitmap are stored, node_bitmap tells which of them
+// hold child nodes. Once the hash bits run out, collision nodes hold
+// count leaves with the same hash and use neither bitmap.
+struct simple_hamt_node {
+    atomic_size_t ref_count;
+    uint32_t bitmap, node_bitmap;
+    uint32_t count;
+    bool collision;
+    union simple_hamt_slot slots[];
+};
+
+struct simple_hamt {
+    atomic_size_t ref_count;
+    const struct type *key_type, *value_type;
+    struct simple_hamt_node *root;
+    size_t size;
+};
+
+static uint32_t simple_hamt_bit(
+    size_t hash,
+    size_t shift
+) {
+    return 1u << ((hash >> shift) & SIMPLE_HAMT_MASK);
+}
+
+static uint32_t simple_hamt_index(
+    uint32_t bitmap,
+    uint32_t bit
+) {
+    return (uint32_t)__builtin_popcount(bitmap & (bit - 1));
+}
+
+static void simple_hamt_leaf_retain(
+    struct simple_hamt_leaf *leaf
+) {
+    atomic_fetch_add_explicit(&leaf->ref_count, 1, memory_order_relaxed);
+}
+
+static void simple_hamt_leaf_release(
+    struct simple_hamt_leaf *leaf
+) {
+    if (atomic_fetch_sub_explicit(&leaf->ref_count, 1,
+            memory_order_acq_rel) == 1) {
+        object_refcount_decrease(leaf->key);
+        object_refcount_decrease(leaf->value);
+        free(leaf);
+    }
+}
+
+static struct simple_hamt_node *simple_hamt_node_new(
+    uint32_t bitmap,
+    uint32_t node_bitmap,
+    uint32_t count,
+    bool collision
+) {
+    struct simple_hamt_node *node;
+    node = calloc(1, sizeof *node + count * sizeof *node->slots);
+    atomic_init(&node->ref_count, 1);
+    node->bitmap = bitmap;
+    node->node_bitmap = node_bitmap;
+    node->count = count;
+    node->collision = collision;
+    return node;
+}
+
+static void simple_hamt_node_retain(
+    struct simple_hamt_node *node
+) {
+    atomic_fetch_add_explicit(&node->ref_count, 1, memory_order_relaxed);
+}
+
+// calls func on every slot with whether it holds a child node
+static void simple_hamt_node_slots(
+    const struct simple_hamt_node *node,
+    uint32_t skip,
+    void (*func)(union simple_hamt_slot slot, bool is_node)
+) {
+    uint32_t bits = node->bitmap;
+    for (uint32_t i = 0; i < node->count; i++) {
+        uint32_t bit = bits & (~bits + 1);
+        bits ^= bit;
+        if (i != skip) {
+            func(node->slots[i], !node->collision &&
+                (node->node_bitmap & bit));
+        }
+    }
+}
+
+static void simple_hamt_node_release(
+    struct simple_hamt_node *node
+);
+
+static void simple_hamt_slot_retain(
+    union simple_hamt_slot slot,
+    bool is_node
+) {
+    if (is_node) {
+        simple_hamt_node_retain(slot.node);
+    } else {
+        simple_hamt_leaf_retain(slot.leaf);
+    }
+}
+
+static void simple_hamt_slot_release(
+    union simple_hamt_slot slot,
+    bool is_node
+) {
+    if (is_node) {
+        simple_hamt_node_release(slot.node);
+    } else {
+        simple_hamt_leaf_release(slot.leaf);
+    }
+}
+
+static void simple_hamt_node_release(
+    struct simple_hamt_node *node
+) {
+    if (node && atomic_fetch_sub_explicit(&node->ref_count, 1,
+            memory_order_acq_rel) == 1) {
+        simple_hamt_node_slots(node, UINT32_MAX, simple_hamt_slot_release);
+        free(node);
+    }
+}
+
+// Copy of node with slot index replaced, the new slot is owned already.
+static struct simple_hamt_node *simple_hamt_node_replace(
+    const struct simple_hamt_node *node,
+    uint32_t index,
+    uint32_t bit,
+    union simple_hamt_slot slot,
+    bool is_node
+) {
+    uint32_t node_bitmap = is_node ? node->node_bitmap | bit :
+        node->node_bitmap & ~bit;
+    struct simple_hamt_node *copy = simple_hamt_node_new(node->bitmap,
+        node_bitmap, node->count, node->collision);
+
+    memcpy(copy->slots, node->slots, node->count * sizeof *node->slots);
+    simple_hamt_node_slots(node, index, simple_hamt_slot_retain);
+    copy->slots[index] = slot;
+    return copy;
+}
+
+// Copy of node with a leaf added at index, the leaf is owned already.
+static struct simple_hamt_node *simple_hamt_node_add(
+    const struct simple_hamt_node *node,
+    uint32_t index,
+    uint32_t bit,
+    struct simple_hamt_leaf *leaf
+) {
+    struct simple_hamt_node *copy = simple_hamt_node_new(node->bitmap | bit,
+        node->node_bitmap, node->count + 1, node->collision);
+
+    memcpy(copy->slots, node->slots, index * sizeof *node->slots);
+    memcpy(copy->slots + index + 1, node->slots + index,
+        (node->count - index) * sizeof *node->slots);
+    simple_hamt_node_slots(node, UINT32_MAX, simple_hamt_slot_retain);
+    copy->slots[index].leaf = leaf;
+    return copy;
+}
+
+// Copy of node without slot index, NULL once nothing is left.
+static struct simple_hamt_node *simple_hamt_node_remove(
+    const struct simple_hamt_node *node,
+    uint32_t index,
+    uint32_t bit
+) {
+    if (node->count == 1) {
+        return NULL;
+    }
+
+    struct simple_hamt_node *copy = simple_hamt_node_new(node->bitmap & ~bit,
+        node->node_bitmap & ~bit, node->count - 1, node->collision);
+
+    memcpy(copy->slots, node->slots, index * sizeof *node->slots);
+    memcpy(copy->slots + index, node->slots + index + 1,
+        (node->count - index - 1) * sizeof *node->slots);
+    simple_hamt_node_slots(node, index, simple_hamt_slot_retain);
+    return copy;
+}
+
+// The only leaf of node, if it holds nothing else.
+static struct simple_hamt_leaf *simple_hamt_node_single_leaf(
+    const struct simple_hamt_node *node
+) {
+    if (node->count == 1 && (node->collision || !node->node_bitmap)) {
+        return node->slots[0].leaf;
+    }
+    return NULL;
+}
+
+// Builds the subtree holding two leaves with different keys, owns both.
+static struct simple_hamt_node *simple_hamt_merge(
+    struct simple_hamt_leaf *lhs,
+    struct simple_hamt_leaf *rhs,
+    size_t shift
+) {
+    struct simple_hamt_node *node;
+
+    if (shift >= SIMPLE_HAMT_HASH_BITS) {
+        node = simple_hamt_node_new(0, 0, 2, true);
+        node->slots[0].leaf = lhs;
+        node->slots[1].leaf = rhs;
+        return node;
+    }
+
+    uint32_t lhs_bit = simple_hamt_bit(lhs->hash, shift);
+    uint32_t rhs_bit = simple_hamt_bit(rhs->hash, shift);
+
+    if (lhs_bit == rhs_bit) {
+        node = simple_hamt_node_new(lhs_bit, lhs_bit, 1, false);
+        node->slots[0].node = simple_hamt_merge(lhs, rhs,
+            shift + SIMPLE_HAMT_BITS);
+        return node;
+    }
+
+    node = simple_hamt_node_new(lhs_bit | rhs_bit, 0, 2, false);
+    node->slots[lhs_bit < rhs_bit ? 0 : 1].leaf = lhs;
+    node->slots[lhs_bit < rhs_bit ? 1 : 0].leaf = rhs;
+    return node;
+}
+
+static struct simple_error *simple_hamt_leaf_matches(
+    const struct simple_hamt_leaf *leaf,
+    size_t hash,
+    const struct object *key,
+    bool *result
+) {
+    *result = false;
+    if (leaf->hash != hash) {
+        return NULL;
+    }
+    return object_equals(leaf->key, key, result);
+}
+
+// tells whether a leaf with the hash looked for holds the key looked for
+typedef struct simple_error *(*simple_hamt_match_func)(
+    const struct simple_hamt_leaf *leaf,
+    const void *key,
+    bool *result
+);
+
+// Path copying insert. The leaf is owned by the new node on success and
+// still by the caller on error.
+static struct simple_error *simple_hamt_node_insert(
+    const struct simple_hamt_node *node,
+    size_t shift,
+    struct simple_hamt_leaf *leaf,
+    struct simple_hamt_node **result,
+    bool *added
+) {
+    struct simple_error *error = NULL;
+    bool matches;
+
+    *result = NULL;
+    *added = false;
+
+    if (!node) {
+        uint32_t bit = simple_hamt_bit(leaf->hash, shift);
+        *result = simple_hamt_node_new(bit, 0, 1, false);
+        (*result)->slots[0].leaf = leaf;
+        *added = true;
+        return NULL;
+    }
+
+    if (node->collision) {
+        for (uint32_t i = 0; i < node->count; i++) {
+            error = simple_hamt_leaf_matches(node->slots[i].leaf, leaf->hash,
+                leaf->key, &matches);
+            simple_error_check(error);
+            if (matches) {
+                *result = simple_hamt_node_replace(node, i, 0,
+                    (union simple_hamt_slot) {.leaf = leaf}, false);
+                return NULL;
+            }
+        }
+        *result = simple_hamt_node_add(node, node->count, 0, leaf);
+        *added = true;
+        return NULL;
+    }
+
+    uint32_t bit = simple_hamt_bit(leaf->hash, shift);
+    uint32_t index = simple_hamt_index(node->bitmap, bit);
+
+    if (!(node->bitmap & bit)) {
+        *result = simple_hamt_node_add(node, index, bit, leaf);
+        *added = true;
+    } else if (node->node_bitmap & bit) {
+        struct simple_hamt_node *child;
+        error = simple_hamt_node_insert(node->slots[index].node,
+            shift + SIMPLE_HAMT_BITS, leaf, &child, added);
+        simple_error_check(error);
+        *result = simple_hamt_node_replace(node, index, bit,
+            (union simple_hamt_slot) {.node = child}, true);
+    } else {
+        struct simple_hamt_leaf *existing = node->slots[index].leaf;
+        error = simple_hamt_leaf_matches(existing, leaf->hash, leaf->key,
+            &matches);
+        simple_error_check(error);
+
+        union simple_hamt_slot slot = {.leaf = leaf};
+        if (!matches) {
+            simple_hamt_leaf_retain(existing);
+            slot.node = simple_hamt_merge(existing, leaf,
+                shift + SIMPLE_HAMT_BITS);
+            *added = true;
+        }
+        *result = simple_hamt_node_replace(node, index, bit, slot, !matches);
+    }
+
+    cleanup:
+    return error;
+}
+
+// Path copying erase. Result is only set if something was erased, then it
+// is the new node or NULL if it became empty.
+static struct simple_error *simple_hamt_node_erase(
+    const struct simple_hamt_node *node,
+    size_t shift,
+    size_t hash,
+    const struct object *key,
+    struct simple_hamt_node **result,
+    bool *erased
+) {
+    struct simple_error *error = NULL;
+    bool matches;
+
+    *result = NULL;
+    *erased = false;
+
+    if (!node) {
+        return NULL;
+    }
+
+    if (node->collision) {
+        for (uint32_t i = 0; i < node->count; i++) {
+            error = simple_hamt_leaf_matches(node->slots[i].leaf, hash, key,
+                &matches);
+            simple_error_check(error);
+            if (matches) {
+                *result = simple_hamt_node_remove(node, i, 0);
+                *erased = true;
+                break;
+            }
+        }
+        goto cleanup;
+    }
+
+    uint32_t bit = simple_hamt_bit(hash, shift);
+    uint32_t index = simple_hamt_index(node->bitmap, bit);
+
+    if (!(node->bitmap & bit)) {
+        goto cleanup;
+    }
+
+    if (!(node->node_bitmap & bit)) {
+        error = simple_hamt_leaf_matches(node->slots[index].leaf, hash, key,
+            &matches);
+        simple_error_check(error);
+        if (matches) {
+            *result = simple_hamt_node_remove(node, index, bit);
+            *erased = true;
+        }
+        goto cleanup;
+    }
+
+    struct simple_hamt_node *child;
+    error = simple_hamt_node_erase(node->slots[index].node,
+        shift + SIMPLE_HAMT_BITS, hash, key, &child, erased);
+    simple_error_check(error);
+
+    if (!*erased) {
+        goto cleanup;
+    }
+
+    // a child left with a single leaf is folded into this node
+    struct simple_hamt_leaf *single = child ?
+        simple_hamt_node_single_leaf(child) : NULL;
+    if (!child) {
+        *result = simple_hamt_node_remove(node, index, bit);
+    } else if (single) {
+        simple_hamt_leaf_retain(single);
+        simple_hamt_node_release(child);
+        *result = simple_hamt_node_replace(node, index, bit,
+            (union simple_hamt_slot) {.leaf = single}, false);
+    } else {
+        *result = simple_hamt_node_replace(node, index, bit,
+            (union simple_hamt_slot) {.node = child}, true);
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_hamt *simple_hamt_with_root(
+    const struct simple_hamt *map,
+    struct simple_hamt_node *root,
+    size_t size
+) {
+    struct simple_hamt *result = simple_hamt_new(map->key_type,
+        map->value_type);
+    result->root = root;
+    result->size = size;
+    return result;
+}
+
+struct simple_hamt *simple_hamt_new(
+    const struct type *key_type,
+    const struct type *value_type
+) {
+    struct simple_hamt *map = calloc(1, sizeof *map);
+    atomic_init(&map->ref_count, 1);
+    map->key_type = key_type;
+    map->value_type = value_type;
+    map->root = NULL;
+    map->size = 0;
+    return map;
+}
+
+struct simple_hamt *simple_hamt_share(
+    const struct simple_hamt *map
+) {
+    // the count is bookkeeping, not part of the immutable contents
+    struct simple_hamt *shared = (struct simple_hamt *)map;
+    atomic_fetch_add_explicit(&shared->ref_count, 1, memory_order_relaxed);
+    return shared;
+}
+
+void simple_hamt_release(
+    struct simple_hamt *map
+) {
+    if (map && atomic_fetch_sub_explicit(&map->ref_count, 1,
+            memory_order_acq_rel) == 1) {
+        simple_hamt_node_release(map->root);
+        free(map);
+    }
+}
+
+size_t simple_hamt_size(
+    const struct simple_hamt *map
+) {
+    return map->size;
+}
+
+static struct simple_error *simple_hamt_get_hash(
+    const struct simple_hamt *map,
+    const struct object *key,
+    size_t *result
+) {
+    struct simple_error *error = object_check_type(key, map->key_type);
+    simple_error_check(error);
+
+    *result = simple_hash_integer(object_get_hash(key));
+
+    cleanup:
+    if (error) {
+        *result = 0;
+    }
+    return error;
+}
+
+// walks down by hash and asks match about every leaf carrying it
+static struct simple_error *simple_hamt_find_hashed(
+    const struct simple_hamt *map,
+    size_t hash,
+    simple_hamt_match_func match,
+    const void *key,
+    const struct object **result
+) {
+    const struct simple_hamt_node *node = map->root;
+    const struct simple_hamt_leaf *leaf;
+    size_t shift = 0;
+    bool matches = false;
+    struct simple_error *error = NULL;
+
+    *result = NULL;
+
+    while (node && !node->collision) {
+        uint32_t bit = simple_hamt_bit(hash, shift);
+        if (!(node->bitmap & bit)) {
+            return NULL;
+        }
+
+        uint32_t index = simple_hamt_index(node->bitmap, bit);
+        if (!(node->node_bitmap & bit)) {
+            leaf = node->slots[index].leaf;
+            if (leaf->hash == hash) {
+                error = match(leaf, key, &matches);
+                simple_error_check(error);
+            }
+            if (matches) {
+                *result = leaf->value;
+            }
+            return NULL;
+        }
+
+        node = node->slots[index].node;
+        shift += SIMPLE_HAMT_BITS;
+    }
+
+    for (uint32_t i = 0; node && i < node->count; i++) {
+        leaf = node->slots[i].leaf;
+        if (leaf->hash == hash) {
+            error = match(leaf, key, &matches);
+            simple_error_check(error);
+        }
+        if (matches) {
+            *result = leaf->value;
+            break;
+        }
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_hamt_match_object(
+    const struct simple_hamt_leaf *leaf,
+    const void *key,
+    bool *result
+) {
+    return object_equals(leaf->key, key, result);
+}
+
+static struct simple_error *simple_hamt_match_cstring(
+    const struct simple_hamt_leaf *leaf,
+    const void *key,
+    bool *result
+) {
+    struct simple_string *string;
+    struct simple_error *error = NULL;
+
+    *result = false;
+    if (object_get_kind(leaf->key) != OBJECT_STRING) {
+        return NULL;
+    }
+    error = object_get_string(leaf->key, &string);
+    simple_error_check(error);
+    *result = strcmp(simple_string_get(string), key) == 0;
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_hamt_find(
+    const struct simple_hamt *map,
+    const struct object *key,
+    const struct object **result
+) {
+    size_t hash;
+
+    *result = NULL;
+
+    struct simple_error *error = simple_hamt_get_hash(map, key, &hash);
+    simple_error_check(error);
+
+    error = simple_hamt_find_hashed(map, hash, simple_hamt_match_object, key,
+        result);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_hamt_find_cstring(
+    const struct simple_hamt *map,
+    const char *key,
+    const struct object **result
+) {
+    size_t hash = simple_string_hash_bytes(key, strlen(key));
+    return simple_hamt_find_hashed(map, simple_hash_integer(hash),
+        simple_hamt_match_cstring, key, result);
+}
+
+struct simple_error *simple_hamt_insert(
+    const struct simple_hamt *map,
+    const struct object *key,
+    const struct object *value,
+    struct simple_hamt **result
+) {
+    struct simple_hamt_leaf *leaf = calloc(1, sizeof *leaf);
+    struct simple_hamt_node *root;
+    bool added;
+    struct simple_error *error;
+
+    *result = NULL;
+    atomic_init(&leaf->ref_count, 1);
+
+    error = simple_hamt_get_hash(map, key, &leaf->hash);
+    simple_error_check(error);
+
+    error = object_copy(key, &leaf->key);
+    simple_error_check(error);
+
+    error = object_copy(value, &leaf->value);
+    simple_error_check(error);
+
+    error = simple_hamt_node_insert(map->root, 0, leaf, &root, &added);
+    simple_error_check(error);
+
+    *result = simple_hamt_with_root(map, root, map->size + added);
+    return NULL;
+
+    cleanup:
+    simple_hamt_leaf_release(leaf);
+    return error;
+}
+
+struct simple_error *simple_hamt_erase(
+    const struct simple_hamt *map,
+    const struct object *key,
+    struct simple_hamt **result,
+    bool *erased
+) {
+    struct simple_hamt_node *root;
+    size_t hash;
+    struct simple_error *error;
+
+    *result = NULL;
+    *erased = false;
+
+    error = simple_hamt_get_hash(map, key, &hash);
+    simple_error_check(error);
+
+    error = simple_hamt_node_erase(map->root, 0, hash, key, &root, erased);
+    simple_error_check(error);
+
+    if (*erased) {
+        *result = simple_hamt_with_root(map, root, map->size - 1);
+    } else {
+        *result = simple_hamt_share(map);
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_hamt_node_foreach(
+    const struct simple_hamt_node *node,
+    simple_hamt_visit_func func,
+    void *context
+) {
+    struct simple_error *error = NULL;
+    uint32_t bits = node->bitmap;
+
+    for (uint32_t i = 0; i < node->count; i++) {
+        uint32_t bit = bits & (~bits + 1);
+        bits ^= bit;
+        if (!node->collision && (node->node_bitmap & bit)) {
+            error = simple_hamt_node_foreach(node->slots[i].node, func,
+                context);
+        } else {
+            error = func(node->slots[i].leaf->key, node->slots[i].leaf->value,
+                context);
+        }
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_hamt_foreach(
+    const struct simple_hamt *map,
+    simple_hamt_visit_func func,
+    void *context
+) {
+    if (!map->root) {
+        return NULL;
+    }
+    return simple_hamt_node_foreach(map->root, func, context);
+}
+
+struct simple_hamt_equals_state {
+    const struct simple_hamt *other;
+    bool equals;
+};
+
+static struct simple_error *simple_hamt_equals_entry(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    struct simple_hamt_equals_state *state = context;
+    const struct object *other_value;
+    struct simple_error *error;
+
+    if (!state->equals) {
+        return NULL;
+    }
+
+    error = simple_hamt_find(state->other, key, &other_value);
+    simple_error_check(error);
+
+    if (!other_value) {
+        state->equals = false;
+    } else {
+        error = object_equals(value, other_value, &state->equals);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_hamt_equals(
+    const struct simple_hamt *lhs,
+    const struct simple_hamt *rhs,
+    bool *result
+) {
+    struct simple_hamt_equals_state state = {
+        .other = rhs,
+        .equals = lhs->size == rhs->size
+    };
+
+    // snapshots of the same map share their root
+    struct simple_error *error = NULL;
+    if (state.equals && lhs->root != rhs->root) {
+        error = simple_hamt_foreach(lhs, simple_hamt_equals_entry, &state);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    *result = !error && state.equals;
+    return error;
+}
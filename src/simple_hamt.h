@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct object;
+struct simple_error;
+struct type;
+struct simple_hamt;
+
+// Persistent hash array mapped trie. A map never changes once built,
+// insert and erase return a new map sharing all untouched nodes with the
+// old one, so they cost O(log32 n) and keeping a snapshot costs O(1).
+//
+// Maps and their nodes are reference counted atomically, a snapshot can
+// be handed to another thread and released there.
+
+// Called for every entry, returning an error stops the iteration.
+typedef struct simple_error *(*simple_hamt_visit_func)(
+    const struct object *key,
+    const struct object *value,
+    void *context
+);
+
+struct simple_hamt *simple_hamt_new(
+    const struct type *key_type,
+    const struct type *value_type
+) __attribute__((warn_unused_result));
+
+// Takes another reference to map, this is what a snapshot costs.
+struct simple_hamt *simple_hamt_share(
+    const struct simple_hamt *map
+) __attribute__((warn_unused_result));
+
+void simple_hamt_release(
+    struct simple_hamt *map
+);
+
+size_t simple_hamt_size(
+    const struct simple_hamt *map
+);
+
+// The result is borrowed from map and valid as long as map is held.
+struct simple_error *simple_hamt_find(
+    const struct simple_hamt *map,
+    const struct object *key,
+    const struct object **result
+) __attribute__((warn_unused_result));
+
+// Like find in a map with string keys, without creating a key object for
+// key.
+struct simple_error *simple_hamt_find_cstring(
+    const struct simple_hamt *map,
+    const char *key,
+    const struct object **result
+) __attribute__((warn_unused_result));
+
+// Key and value are copied like in simple_hashtable, map is unchanged.
+struct simple_error *simple_hamt_insert(
+    const struct simple_hamt *map,
+    const struct object *key,
+    const struct object *value,
+    struct simple_hamt **result
+) __attribute__((warn_unused_result));
+
+// Without key, result shares map if key was not in it.
+struct simple_error *simple_hamt_erase(
+    const struct simple_hamt *map,
+    const struct object *key,
+    struct simple_hamt **result,
+    bool *erased
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_hamt_foreach(
+    const struct simple_hamt *map,
+    simple_hamt_visit_func func,
+    void *context
+) __attribute__((warn_unused_result));
+
+// Equal when both hold the same keys mapped to equal values.
+struct simple_error *simple_hamt_equals(
+    const struct simple_hamt *lhs,
+    const struct simple_hamt *rhs,
+    bool *result
+) __attribute__((warn_unused_result));
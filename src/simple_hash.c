@@ -0,0 +1,21 @@
+#include "simple_hash.h"
+
+size_t simple_hash_integer(
+    uint64_t value
+) {
+    // splitmix64 finalizer, every input bit affects every output bit
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return (size_t)value;
+}
+
+size_t simple_hash_combine(
+    size_t seed,
+    size_t value
+) {
+    return simple_hash_integer(seed ^ (value + 0x9e3779b97f4a7c15ULL +
+        (seed << 6) + (seed >> 2)));
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+size_t simple_hash_integer(
+    uint64_t value
+);
+
+size_t simple_hash_combine(
+    size_t seed,
+    size_t value
+);
@@ -1,11 +1,21 @@
 #include <malloc.h>
 #include <string.h>
 
+#include "simple_alloc.h"
+#include "simple_hash.h"
 #include "simple_hashtable.h"
 #include "simple_object.h"
 
+// bucket counts are powers of two so scan cursors survive growth
+#define SIMPLE_HASHTABLE_MIN_BUCKETS 16
+#define SIMPLE_HASHTABLE_MAX_LOAD_FACTOR 0.75
+
+// keys hashed and prefetched together by the batch operations
+#define SIMPLE_HASHTABLE_BATCH_SIZE 16
+
 struct simple_hashtable_entry {
     struct object *key, *value;
+    size_t hash;
     struct simple_hashtable_entry *next;
 };
 
@@ -20,11 +30,14 @@ static void simple_hashtable_entry_destroy(
 static struct simple_error *simple_hashtable_entry_new(
     const struct object *key,
     const struct object *value,
+    size_t hash,
     struct simple_hashtable_entry *next,
     struct simple_hashtable_entry **result
 ) {
     struct simple_hashtable_entry *entry = calloc(1, sizeof *entry);
+    simple_alloc_record("hashtable_entry", sizeof *entry);
     entry->next = next;
+    entry->hash = hash;
 
     struct simple_error *error;
     error = object_copy(key, &entry->key);
@@ -49,13 +62,33 @@ struct simple_hashtable {
     size_t size;
 };
 
+// smallest bucket count that holds count entries without growing
+static size_t simple_hashtable_bucket_count_for(
+    size_t count
+) {
+    size_t bucket_count = SIMPLE_HASHTABLE_MIN_BUCKETS;
+    while ((double)count > (double)bucket_count *
+            SIMPLE_HASHTABLE_MAX_LOAD_FACTOR) {
+        bucket_count *= 2;
+    }
+    return bucket_count;
+}
+
 struct simple_hashtable *simple_hashtable_new(
     const struct type *key_type,
     const struct type *value_type
+) {
+    return simple_hashtable_new_with_capacity(key_type, value_type, 0);
+}
+
+struct simple_hashtable *simple_hashtable_new_with_capacity(
+    const struct type *key_type,
+    const struct type *value_type,
+    size_t capacity
 ) {
     struct simple_hashtable *table = calloc(1, sizeof *table);
     *table = (struct simple_hashtable) {
-        .bucket_count = 15,
+        .bucket_count = simple_hashtable_bucket_count_for(capacity),
         .size = 0,
         .key_type = key_type,
         .value_type = value_type
@@ -65,6 +98,9 @@ struct simple_hashtable *simple_hashtable_new(
 }
 
 void simple_hashtable_destroy(struct simple_hashtable *table) {
+    if (!table) {
+        return;
+    }
     for (size_t bucket_id=0; bucket_id < table->bucket_count; bucket_id++) {
         struct simple_hashtable_entry *entry, *next;
         entry = table->buckets[bucket_id];
@@ -84,7 +120,7 @@ static double simple_hashtable_load_factor(
     return ((double)table->size) / table->bucket_count;
 }
 
-static struct simple_error *simple_hashtable_get_bucket(
+static struct simple_error *simple_hashtable_get_hash(
     const struct simple_hashtable *table,
     const struct object *key,
     size_t *result
@@ -93,76 +129,173 @@ static struct simple_error *simple_hashtable_get_bucket(
     error = object_check_type(key, table->key_type);
     simple_error_check(error);
 
-    *result = object_get_hash(key) % table->bucket_count;
+    // buckets are picked by the low bits, spread the whole hash into them
+    *result = simple_hash_integer(object_get_hash(key));
 
     cleanup:
     if (error) {
         *result = 0;
     }
     return error;
-
-    return NULL;
 } __attribute__((warn_unused_result))
 
-static struct simple_error *simple_hashtable_rehash(
-    struct simple_hashtable *table
+// relinks the existing entries, keys are neither copied nor rehashed
+static void simple_hashtable_resize(
+    struct simple_hashtable *table,
+    size_t bucket_count
 ) {
-    struct simple_hashtable_entry **old_buckets = table->buckets;
-    size_t old_bucket_count = table->bucket_count;
-    table->bucket_count = (table->bucket_count * 2) - 1;
-    table->buckets = calloc(table->bucket_count, sizeof *table->buckets);
-
-    struct simple_error *error;
+    struct simple_hashtable_entry **buckets;
+    buckets = calloc(bucket_count, sizeof *buckets);
 
-    for (size_t i=0; i<old_bucket_count; i++) {
+    for (size_t i=0; i<table->bucket_count; i++) {
         struct simple_hashtable_entry *entry, *next;
-        entry = old_buckets[i];
+        entry = table->buckets[i];
         while (entry) {
-            error = simple_hashtable_insert(table, entry->key, entry->value);
-            simple_error_check(error);
             next = entry->next;
-            simple_hashtable_entry_destroy(entry);
+            size_t bucket_id = entry->hash & (bucket_count - 1);
+            entry->next = buckets[bucket_id];
+            buckets[bucket_id] = entry;
             entry = next;
         }
     }
-    free(old_buckets);
-    return NULL;
+
+    free(table->buckets);
+    table->buckets = buckets;
+    table->bucket_count = bucket_count;
+}
+
+// finds the link pointing at the entry for key, or the bucket's last link
+static struct simple_error *simple_hashtable_find_link(
+    const struct simple_hashtable *table,
+    const struct object *key,
+    size_t hash,
+    struct simple_hashtable_entry ***result
+) {
+    struct simple_error *error = NULL;
+    struct simple_hashtable_entry **link;
+    link = table->buckets + (hash & (table->bucket_count - 1));
+
+    while (*link) {
+        // cheap hash check first, keys of other types rarely get past it
+        if ((*link)->hash == hash) {
+            bool equals;
+            error = object_equals((*link)->key, key, &equals);
+            simple_error_check(error);
+            if (equals) {
+                break;
+            }
+        }
+        link = &(*link)->next;
+    }
 
     cleanup:
-    // TODO this leaks a lot, redo this
+    *result = link;
     return error;
+}
 
+struct simple_result simple_hashtable_lookup(
+    struct simple_hashtable *table,
+    const struct object *key,
+    struct object **result
+) {
+    size_t hash;
+    struct simple_hashtable_entry **link;
+    struct simple_error *error;
 
+    *result = NULL;
 
-} __attribute__((warn_unused_result))
+    error = simple_hashtable_get_hash(table, key, &hash);
+    simple_error_check(error);
+
+    error = simple_hashtable_find_link(table, key, hash, &link);
+    simple_error_check(error);
+
+    if (!*link) {
+        return (struct simple_result) {SIMPLE_STATUS_NOT_FOUND, NULL};
+    }
+
+    object_refcount_increase((*link)->value);
+    *result = (*link)->value;
+    return (struct simple_result) {SIMPLE_STATUS_OK, NULL};
+
+    cleanup:
+    return (struct simple_result) {SIMPLE_STATUS_ERROR, error};
+}
+
+struct simple_result simple_hashtable_lookup_cstring(
+    struct simple_hashtable *table,
+    const char *key,
+    struct object **result
+) {
+    struct simple_error *error = NULL;
+    struct simple_string *string;
+
+    *result = NULL;
+
+    size_t length = strlen(key);
+    size_t hash = simple_hash_integer(simple_string_hash_bytes(key, length));
+    struct simple_hashtable_entry *entry;
+    entry = table->buckets[hash & (table->bucket_count - 1)];
+
+    for (; entry; entry = entry->next) {
+        if (entry->hash != hash ||
+                object_get_kind(entry->key) != OBJECT_STRING) {
+            continue;
+        }
+        error = object_get_string(entry->key, &string);
+        simple_error_check(error);
+        if (simple_string_get_length(string) == length &&
+                memcmp(simple_string_get(string), key, length) == 0) {
+            object_refcount_increase(entry->value);
+            *result = entry->value;
+            return (struct simple_result) {SIMPLE_STATUS_OK, NULL};
+        }
+    }
+    return (struct simple_result) {SIMPLE_STATUS_NOT_FOUND, NULL};
+
+    cleanup:
+    return (struct simple_result) {SIMPLE_STATUS_ERROR, error};
+}
 
 struct simple_error *simple_hashtable_find(
     struct simple_hashtable *table,
     const struct object *key,
     struct object **result
 ) {
+    return simple_hashtable_lookup(table, key, result).error;
+}
 
-    size_t bucket_id;
+static struct simple_error *simple_hashtable_insert_hashed(
+    struct simple_hashtable *table,
+    const struct object *key,
+    const struct object *value,
+    size_t hash
+) {
+    struct simple_hashtable_entry **link;
     struct simple_error *error;
 
-    error = simple_hashtable_get_bucket(table, key, &bucket_id);
+    error = simple_hashtable_find_link(table, key, hash, &link);
     simple_error_check(error);
 
-    const struct simple_hashtable_entry *entry = table->buckets[bucket_id];
+    if (*link) {
+        object_refcount_decrease((*link)->value);
+        error = object_copy(value, &(*link)->value);
+        simple_error_check(error);
+    } else {
+        struct simple_hashtable_entry **bucket_head;
+        bucket_head = table->buckets + (hash & (table->bucket_count - 1));
+        error = simple_hashtable_entry_new(key, value, hash, *bucket_head,
+            bucket_head);
+        simple_error_check(error);
+        table->size++;
+    }
 
-    while (entry) {
-        bool equals;
-        object_equals(entry->key, key, &equals);
-        if (equals) {
-            object_refcount_increase(entry->value);
-            *result = entry->value;
-            return NULL;
-        }
-        entry = entry->next;
+    if (simple_hashtable_load_factor(table) >
+            SIMPLE_HASHTABLE_MAX_LOAD_FACTOR) {
+        simple_hashtable_resize(table, table->bucket_count * 2);
     }
 
     cleanup:
-    *result = NULL;
     return error;
 }
 
@@ -171,77 +304,398 @@ struct simple_error *simple_hashtable_insert(
     const struct object *key,
     const struct object *value
 ) {
-    size_t bucket_id;
+    size_t hash;
     struct simple_error *error;
 
-    error = simple_hashtable_get_bucket(table, key, &bucket_id);
+    error = simple_hashtable_get_hash(table, key, &hash);
+    simple_error_check(error);
+
+    error = simple_hashtable_insert_hashed(table, key, value, hash);
     simple_error_check(error);
 
-    struct simple_hashtable_entry *entry = table->buckets[bucket_id];
+    cleanup:
+    return error;
+}
+
+// Hashes a batch of keys and prefetches their bucket slots. The slots are
+// read only after the whole batch was hashed, so the cache misses of all
+// keys in the batch overlap instead of being paid one after the other.
+static struct simple_error *simple_hashtable_prepare_batch(
+    const struct simple_hashtable *table,
+    const struct object *const *keys,
+    size_t count,
+    size_t *hashes
+) {
+    struct simple_error *error = NULL;
+    size_t mask = table->bucket_count - 1;
 
-    while (entry) {
-        bool equals;
-        error = object_equals(entry->key, key, &equals);
+    for (size_t i = 0; i < count; i++) {
+        error = simple_hashtable_get_hash(table, keys[i], hashes + i);
         simple_error_check(error);
-        if (equals) {
-            break;
+        __builtin_prefetch(table->buckets + (hashes[i] & mask));
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const struct simple_hashtable_entry *head;
+        head = table->buckets[hashes[i] & mask];
+        if (head) {
+            __builtin_prefetch(head);
         }
-        entry = entry->next;
     }
 
-    if (entry) {
-        object_refcount_decrease(entry->value);
-        error = object_copy(value, &entry->value);
-    } else {
-        struct simple_hashtable_entry **bucket_head;
-        bucket_head = table->buckets + bucket_id;
-        error = simple_hashtable_entry_new(key, value, *bucket_head,
-            bucket_head);
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_hashtable_insert_many(
+    struct simple_hashtable *table,
+    const struct object *const *keys,
+    const struct object *const *values,
+    size_t count
+) {
+    size_t hashes[SIMPLE_HASHTABLE_BATCH_SIZE];
+    struct simple_error *error = NULL;
+
+    // growing once up front also keeps the prefetched slots valid
+    simple_hashtable_reserve(table, table->size + count);
+
+    for (size_t offset = 0; offset < count;
+            offset += SIMPLE_HASHTABLE_BATCH_SIZE) {
+        size_t batch = count - offset;
+        if (batch > SIMPLE_HASHTABLE_BATCH_SIZE) {
+            batch = SIMPLE_HASHTABLE_BATCH_SIZE;
+        }
+
+        error = simple_hashtable_prepare_batch(table, keys + offset, batch,
+            hashes);
         simple_error_check(error);
-        table->size++;
+
+        for (size_t i = 0; i < batch; i++) {
+            error = simple_hashtable_insert_hashed(table, keys[offset + i],
+                values[offset + i], hashes[i]);
+            simple_error_check(error);
+        }
     }
 
-    if (simple_hashtable_load_factor(table) > 0.75) {
-        error = simple_hashtable_rehash(table);
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_hashtable_find_many(
+    struct simple_hashtable *table,
+    const struct object *const *keys,
+    size_t count,
+    struct object **results
+) {
+    size_t hashes[SIMPLE_HASHTABLE_BATCH_SIZE];
+    struct simple_error *error = NULL;
+    size_t found = 0;
+
+    for (size_t offset = 0; offset < count;
+            offset += SIMPLE_HASHTABLE_BATCH_SIZE) {
+        size_t batch = count - offset;
+        if (batch > SIMPLE_HASHTABLE_BATCH_SIZE) {
+            batch = SIMPLE_HASHTABLE_BATCH_SIZE;
+        }
+
+        error = simple_hashtable_prepare_batch(table, keys + offset, batch,
+            hashes);
         simple_error_check(error);
+
+        for (size_t i = 0; i < batch; i++, found++) {
+            struct simple_hashtable_entry **link;
+            error = simple_hashtable_find_link(table, keys[offset + i],
+                hashes[i], &link);
+            simple_error_check(error);
+
+            results[offset + i] = NULL;
+            if (*link) {
+                object_refcount_increase((*link)->value);
+                results[offset + i] = (*link)->value;
+            }
+        }
     }
 
     cleanup:
+    if (error) {
+        for (size_t i = 0; i < found; i++) {
+            object_refcount_decrease(results[i]);
+        }
+        for (size_t i = 0; i < count; i++) {
+            results[i] = NULL;
+        }
+    }
     return error;
 }
 
+struct simple_result simple_hashtable_remove(
+    struct simple_hashtable *table,
+    const struct object *key
+) {
+    size_t hash;
+    struct simple_hashtable_entry **link;
+    struct simple_error *error;
+
+    error = simple_hashtable_get_hash(table, key, &hash);
+    simple_error_check(error);
+
+    error = simple_hashtable_find_link(table, key, hash, &link);
+    simple_error_check(error);
+
+    if (!*link) {
+        return (struct simple_result) {SIMPLE_STATUS_NOT_FOUND, NULL};
+    }
+
+    struct simple_hashtable_entry *entry = *link;
+    *link = entry->next;
+    simple_hashtable_entry_destroy(entry);
+    table->size--;
+    return (struct simple_result) {SIMPLE_STATUS_OK, NULL};
+
+    cleanup:
+    return (struct simple_result) {SIMPLE_STATUS_ERROR, error};
+}
+
 struct simple_error *simple_hashtable_erase(
     struct simple_hashtable *table,
     const struct object *key,
     bool *erased
 ) {
-    size_t bucket_id;
+    struct simple_result result = simple_hashtable_remove(table, key);
+    *erased = result.status == SIMPLE_STATUS_OK;
+    return result.error;
+}
+
+size_t simple_hashtable_size(
+    const struct simple_hashtable *table
+) {
+    return table->size;
+}
+
+const struct type *simple_hashtable_get_key_type(
+    const struct simple_hashtable *table
+) {
+    return table->key_type;
+}
+
+const struct type *simple_hashtable_get_value_type(
+    const struct simple_hashtable *table
+) {
+    return table->value_type;
+}
+
+size_t simple_hashtable_get_memory(
+    const struct simple_hashtable *table
+) {
+    return sizeof *table + table->bucket_count * sizeof *table->buckets +
+        table->size * sizeof(struct simple_hashtable_entry);
+}
+
+void simple_hashtable_reserve(
+    struct simple_hashtable *table,
+    size_t count
+) {
+    size_t bucket_count = simple_hashtable_bucket_count_for(count);
+    if (bucket_count > table->bucket_count) {
+        simple_hashtable_resize(table, bucket_count);
+    }
+}
+
+void simple_hashtable_iterator_init(
+    struct simple_hashtable_iterator *iterator,
+    const struct simple_hashtable *table
+) {
+    *iterator = (struct simple_hashtable_iterator) {
+        .table = table,
+        .bucket_id = 0,
+        .entry = NULL
+    };
+}
+
+bool simple_hashtable_iterator_next(
+    struct simple_hashtable_iterator *iterator,
+    const struct object **key,
+    const struct object **value
+) {
+    const struct simple_hashtable *table = iterator->table;
+    const struct simple_hashtable_entry *entry = iterator->entry;
+
+    if (entry) {
+        entry = entry->next;
+    }
+
+    while (!entry && iterator->bucket_id < table->bucket_count) {
+        entry = table->buckets[iterator->bucket_id++];
+        // the bucket array is read in order, start pulling in the entry
+        // hanging off the next bucket while this one is being visited
+        if (iterator->bucket_id < table->bucket_count) {
+            __builtin_prefetch(table->buckets[iterator->bucket_id]);
+        }
+    }
+
+    iterator->entry = entry;
+    if (!entry) {
+        return false;
+    }
+
+    if (entry->next) {
+        __builtin_prefetch(entry->next);
+    }
+    *key = entry->key;
+    *value = entry->value;
+    return true;
+}
+
+struct simple_error *simple_hashtable_foreach(
+    const struct simple_hashtable *table,
+    simple_hashtable_visit_func func,
+    void *context
+) {
+    struct simple_error *error = NULL;
+    struct simple_hashtable_iterator iterator;
+    const struct object *key, *value;
+
+    simple_hashtable_iterator_init(&iterator, table);
+    while (simple_hashtable_iterator_next(&iterator, &key, &value)) {
+        error = func(key, value, context);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+static size_t simple_hashtable_reverse_bits(
+    size_t value
+) {
+    size_t result = 0;
+    for (size_t i = 0; i < sizeof value * 8; i++) {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+
+// Increments the high bits of the cursor first. Buckets split by growth
+// share the low bits of their parent, so they all come after it.
+static size_t simple_hashtable_next_cursor(
+    size_t cursor,
+    size_t mask
+) {
+    cursor |= ~mask;
+    cursor = simple_hashtable_reverse_bits(cursor);
+    cursor++;
+    return simple_hashtable_reverse_bits(cursor);
+}
+
+struct simple_error *simple_hashtable_scan(
+    const struct simple_hashtable *table,
+    size_t *cursor,
+    size_t count,
+    simple_hashtable_visit_func func,
+    void *context
+) {
+    struct simple_error *error = NULL;
+    size_t mask = table->bucket_count - 1;
+    size_t visited = 0;
+
+    do {
+        const struct simple_hashtable_entry *entry;
+        entry = table->buckets[*cursor & mask];
+        while (entry) {
+            error = func(entry->key, entry->value, context);
+            simple_error_check(error);
+            visited++;
+            entry = entry->next;
+        }
+        *cursor = simple_hashtable_next_cursor(*cursor, mask);
+    } while (*cursor && visited < count);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_hashtable_copy_entry(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    return simple_hashtable_insert(context, key, value);
+}
+
+struct simple_error *simple_hashtable_copy(
+    const struct simple_hashtable *table,
+    struct simple_hashtable **result
+) {
     struct simple_error *error;
-    error = simple_hashtable_get_bucket(table, key, &bucket_id);
+    struct simple_hashtable *copy;
+
+    copy = simple_hashtable_new_with_capacity(table->key_type,
+        table->value_type, table->size);
+
+    error = simple_hashtable_foreach(table, simple_hashtable_copy_entry, copy);
     simple_error_check(error);
 
-    struct simple_hashtable_entry **entry = table->buckets + bucket_id;
-
-    while (*entry) {
-        bool equals;
-        object_equals((*entry)->key, key, &equals);
-        simple_hashtable_entry_destroy(*entry);
-        if (equals) {
-            *entry = (*entry)->next;
-            *erased = true;
-            table->size--;
-            return NULL;
-        }
-        entry = &((*entry)->next);
+    *result = copy;
+    return NULL;
+
+    cleanup:
+    simple_hashtable_destroy(copy);
+    *result = NULL;
+    return error;
+}
+
+struct simple_hashtable_equals_state {
+    struct simple_hashtable *other;
+    bool equals;
+};
+
+static struct simple_error *simple_hashtable_equals_entry(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    struct simple_hashtable_equals_state *state = context;
+    struct object *other_value = NULL;
+    struct simple_error *error;
+
+    if (!state->equals) {
+        return NULL;
+    }
+
+    error = simple_hashtable_find(state->other, key, &other_value);
+    simple_error_check(error);
+
+    if (!other_value) {
+        state->equals = false;
+    } else {
+        error = object_equals(value, other_value, &state->equals);
+        simple_error_check(error);
     }
-    *erased = false;
 
     cleanup:
+    object_refcount_decrease(other_value);
     return error;
 }
 
-size_t simple_hashtable_size(
-    const struct simple_hashtable *table
+struct simple_error *simple_hashtable_equals(
+    const struct simple_hashtable *lhs,
+    const struct simple_hashtable *rhs,
+    bool *result
 ) {
-    return table->size;
+    struct simple_hashtable_equals_state state = {
+        .other = (struct simple_hashtable *)rhs,
+        .equals = lhs->size == rhs->size
+    };
+
+    struct simple_error *error = NULL;
+    if (state.equals) {
+        error = simple_hashtable_foreach(lhs, simple_hashtable_equals_entry,
+            &state);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    *result = !error && state.equals;
+    return error;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 
@@ -8,34 +9,166 @@
 #include "type.h"
 
 struct simple_hashtable;
+struct simple_hashtable_entry;
+
+// Walks the bucket array once, front to back. Inserting into or erasing
+// from the table invalidates the iterator, use scan for that.
+struct simple_hashtable_iterator {
+    const struct simple_hashtable *table;
+    size_t bucket_id;
+    const struct simple_hashtable_entry *entry;
+};
+
+// Called for every entry, returning an error stops the iteration.
+typedef struct simple_error *(*simple_hashtable_visit_func)(
+    const struct object *key,
+    const struct object *value,
+    void *context
+);
 
 struct simple_hashtable *simple_hashtable_new(
     const struct type *key_type,
     const struct type *value_type
 ) __attribute__((warn_unused_result));
 
+// Sized up front so capacity entries fit without growing.
+struct simple_hashtable *simple_hashtable_new_with_capacity(
+    const struct type *key_type,
+    const struct type *value_type,
+    size_t capacity
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_hashtable_copy(
+    const struct simple_hashtable *table,
+    struct simple_hashtable **result
+) __attribute__((warn_unused_result));
+
 void simple_hashtable_destroy(
     struct simple_hashtable *table
 );
 
+// Increases the reference count of the result, a missing key leaves it
+// NULL without an error.
 struct simple_error *simple_hashtable_find(
     struct simple_hashtable *table,
     const struct object *key,
     struct object **result
 ) __attribute__((warn_unused_result));
 
+// Like find, but reports a missing key as SIMPLE_STATUS_NOT_FOUND.
+struct simple_result simple_hashtable_lookup(
+    struct simple_hashtable *table,
+    const struct object *key,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+// Like lookup in a table with string keys, without creating a key object
+// for key, so a miss allocates nothing.
+struct simple_result simple_hashtable_lookup_cstring(
+    struct simple_hashtable *table,
+    const char *key,
+    struct object **result
+) __attribute__((warn_unused_result));
+
 struct simple_error *simple_hashtable_insert(
     struct simple_hashtable *table,
     const struct object *key,
     const struct object *value
 ) __attribute__((warn_unused_result));
 
+// Inserts count key value pairs like repeated inserts. The table grows
+// once up front and keys are hashed and prefetched in batches, so memory
+// latency overlaps across keys. Stops at the first error, entries before
+// it stay inserted.
+struct simple_error *simple_hashtable_insert_many(
+    struct simple_hashtable *table,
+    const struct object *const *keys,
+    const struct object *const *values,
+    size_t count
+) __attribute__((warn_unused_result));
+
+// Batched find, results[i] is the value for keys[i] or NULL. On error no
+// results are returned.
+struct simple_error *simple_hashtable_find_many(
+    struct simple_hashtable *table,
+    const struct object *const *keys,
+    size_t count,
+    struct object **results
+) __attribute__((warn_unused_result));
+
 struct simple_error *simple_hashtable_erase(
     struct simple_hashtable *table,
     const struct object *key,
     bool *erased
 ) __attribute__((warn_unused_result));
 
+// Like erase, but reports a missing key as SIMPLE_STATUS_NOT_FOUND.
+struct simple_result simple_hashtable_remove(
+    struct simple_hashtable *table,
+    const struct object *key
+) __attribute__((warn_unused_result));
+
 size_t simple_hashtable_size(
     const struct simple_hashtable *table
 );
+
+const struct type *simple_hashtable_get_key_type(
+    const struct simple_hashtable *table
+);
+
+const struct type *simple_hashtable_get_value_type(
+    const struct simple_hashtable *table
+);
+
+// Bytes held by the table and its entries, not counting keys and values.
+size_t simple_hashtable_get_memory(
+    const struct simple_hashtable *table
+);
+
+// Equal when both hold the same keys mapped to equal values.
+struct simple_error *simple_hashtable_equals(
+    const struct simple_hashtable *lhs,
+    const struct simple_hashtable *rhs,
+    bool *result
+) __attribute__((warn_unused_result));
+
+// Grows the bucket array once so count entries fit without growing.
+void simple_hashtable_reserve(
+    struct simple_hashtable *table,
+    size_t count
+);
+
+void simple_hashtable_iterator_init(
+    struct simple_hashtable_iterator *iterator,
+    const struct simple_hashtable *table
+);
+
+// Returns false once every entry was visited. Key and value stay owned
+// by the table.
+bool simple_hashtable_iterator_next(
+    struct simple_hashtable_iterator *iterator,
+    const struct object **key,
+    const struct object **value
+);
+
+// Visits the entries in bucket order, which is unrelated to insertion order.
+struct simple_error *simple_hashtable_foreach(
+    const struct simple_hashtable *table,
+    simple_hashtable_visit_func func,
+    void *context
+) __attribute__((warn_unused_result));
+
+// Resumable iteration in the style of the Redis SCAN command. Start with
+// cursor 0 and call again with the updated cursor until it is 0. Each
+// call visits whole buckets until at least count entries were seen.
+//
+// The table may be modified between calls. Entries present for the whole
+// scan are visited exactly once, even if the table grows in between.
+// Entries inserted or erased during the scan may or may not be visited.
+struct simple_error *simple_hashtable_scan(
+    const struct simple_hashtable *table,
+    size_t *cursor,
+    size_t count,
+    simple_hashtable_visit_func func,
+    void *context
+) __attribute__((warn_unused_result));
@@ -0,0 +1,830 @@
+#include "simple_heap.h"
+
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_object.h"
+#include "type.h"
+
+#define SIMPLE_HEAP_MAGIC "SIMPLEHS"
+#define SIMPLE_HEAP_BYTE_ORDER 0x01020304
+
+// longest type name the reader accepts
+#define SIMPLE_HEAP_MAX_NAME 4096
+
+// marks references to objects missing from the snapshot and unset
+// dominators
+#define SIMPLE_HEAP_NONE SIZE_MAX
+
+struct simple_heap_type {
+    uint64_t id;
+    char *name;
+    size_t count;
+    size_t size;
+    size_t retained;
+    size_t unreferenced;
+};
+
+struct simple_heap_object {
+    uint64_t id;
+    uint64_t type_id;
+    size_t type;
+    enum object_kind kind;
+    int32_t refcount;
+    size_t size;
+    size_t retained;
+    size_t first_reference;
+    size_t reference_count;
+};
+
+struct simple_heap_snapshot {
+    struct simple_heap_type *types;
+    size_t type_count;
+    struct simple_heap_object *objects;
+    size_t object_count;
+    // indices into objects after loading, ids while reading
+    size_t *references;
+    uint64_t *reference_ids;
+    size_t reference_count;
+    size_t total_size;
+};
+
+// The object graph with a synthetic root as node 0 and object i as node
+// i + 1. The successors of objects and the predecessors of all nodes are
+// ranges of a shared array, from the start of the node to that of the next.
+struct simple_heap_graph {
+    size_t node_count;
+    size_t *roots;
+    size_t root_count;
+    size_t *successor_start;
+    size_t *successors;
+    size_t *predecessor_start;
+    size_t *predecessors;
+    bool *visited;
+    size_t *postorder;
+    size_t *order;
+    size_t *dominator;
+};
+
+struct simple_heap_writer {
+    FILE *file;
+    const struct type **types;
+    size_t type_count;
+    size_t type_capacity;
+};
+
+// grows array to hold one more element of size element_size
+static void *simple_heap_reserve(
+    void *array,
+    size_t count,
+    size_t *capacity,
+    size_t element_size
+) {
+    if (count < *capacity) {
+        return array;
+    }
+    *capacity = *capacity ? *capacity * 2 : 32;
+    return realloc(array, *capacity * element_size);
+}
+
+static void simple_heap_write_u64(
+    FILE *file,
+    uint64_t value
+) {
+    fwrite(&value, sizeof value, 1, file);
+}
+
+static struct simple_error *simple_heap_write_reference(
+    const struct object *o,
+    void *context
+) {
+    simple_heap_write_u64(context, (uint64_t)(uintptr_t)o);
+    return NULL;
+}
+
+// writes the type record of type unless it was written before
+static struct simple_error *simple_heap_write_type(
+    struct simple_heap_writer *writer,
+    const struct type *type
+) {
+    struct simple_error *error = NULL;
+    const char *name = "<none>";
+
+    for (size_t i = 0; i < writer->type_count; i++) {
+        if (writer->types[i] == type) {
+            return NULL;
+        }
+    }
+
+    if (type) {
+        error = type_get_name(type, &name);
+        simple_error_check(error);
+    }
+
+    uint32_t length = (uint32_t)strlen(name);
+    fputc('T', writer->file);
+    simple_heap_write_u64(writer->file, (uint64_t)(uintptr_t)type);
+    fwrite(&length, sizeof length, 1, writer->file);
+    fwrite(name, 1, length, writer->file);
+
+    writer->types = simple_heap_reserve(writer->types, writer->type_count,
+        &writer->type_capacity, sizeof *writer->types);
+    writer->types[writer->type_count++] = type;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_heap_write_object(
+    const struct object *o,
+    void *context
+) {
+    struct simple_heap_writer *writer = context;
+    const struct type *type = object_type(o);
+
+    struct simple_error *error = simple_heap_write_type(writer, type);
+    simple_error_check(error);
+
+    uint8_t kind = (uint8_t)object_get_kind(o);
+    int32_t refcount = object_get_refcount(o);
+
+    fputc('O', writer->file);
+    simple_heap_write_u64(writer->file, (uint64_t)(uintptr_t)o);
+    simple_heap_write_u64(writer->file, (uint64_t)(uintptr_t)type);
+    fwrite(&kind, sizeof kind, 1, writer->file);
+    fwrite(&refcount, sizeof refcount, 1, writer->file);
+    simple_heap_write_u64(writer->file, object_get_memory(o));
+
+    error = object_foreach_reference(o, simple_heap_write_reference,
+        writer->file);
+    simple_error_check(error);
+    simple_heap_write_u64(writer->file, 0);
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_heap_write_snapshot(
+    FILE *file
+) {
+    struct simple_error *error = NULL;
+    struct simple_heap_writer writer = {.file = file};
+    uint32_t header[2] = {SIMPLE_HEAP_VERSION, SIMPLE_HEAP_BYTE_ORDER};
+
+    fwrite(SIMPLE_HEAP_MAGIC, 1, strlen(SIMPLE_HEAP_MAGIC), file);
+    fwrite(header, sizeof header, 1, file);
+
+    error = object_foreach_allocated(simple_heap_write_object, &writer);
+    simple_error_check(error);
+
+    fputc('E', file);
+    if (fflush(file) != 0 || ferror(file)) {
+        error = simple_error_new("%s", "Writing the heap snapshot failed.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    free(writer.types);
+    return error;
+}
+
+static struct simple_error *simple_heap_read(
+    FILE *file,
+    void *buffer,
+    size_t size
+) {
+    if (fread(buffer, 1, size, file) != size) {
+        return simple_error_new("%s", "The heap snapshot is truncated.");
+    }
+    return NULL;
+}
+
+static struct simple_error *simple_heap_read_header(
+    FILE *file
+) {
+    struct simple_error *error = NULL;
+    char magic[sizeof SIMPLE_HEAP_MAGIC - 1];
+    uint32_t header[2];
+
+    error = simple_heap_read(file, magic, sizeof magic);
+    simple_error_check(error);
+    if (memcmp(magic, SIMPLE_HEAP_MAGIC, sizeof magic) != 0) {
+        error = simple_error_new("%s", "Not a heap snapshot.");
+        simple_error_check(error);
+    }
+
+    error = simple_heap_read(file, header, sizeof header);
+    simple_error_check(error);
+    if (header[0] != SIMPLE_HEAP_VERSION) {
+        error = simple_error_new("Unsupported heap snapshot version %u.",
+            header[0]);
+        simple_error_check(error);
+    }
+    if (header[1] != SIMPLE_HEAP_BYTE_ORDER) {
+        error = simple_error_new("%s",
+            "The heap snapshot was written with another byte order.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_heap_read_type(
+    FILE *file,
+    struct simple_heap_snapshot *snapshot,
+    size_t *capacity
+) {
+    struct simple_error *error = NULL;
+    struct simple_heap_type type = {.name = NULL};
+    uint32_t length;
+
+    error = simple_heap_read(file, &type.id, sizeof type.id);
+    simple_error_check(error);
+    error = simple_heap_read(file, &length, sizeof length);
+    simple_error_check(error);
+    if (length > SIMPLE_HEAP_MAX_NAME) {
+        error = simple_error_new("Type name of %u bytes in heap snapshot.",
+            length);
+        simple_error_check(error);
+    }
+
+    type.name = calloc(length + 1, 1);
+    error = simple_heap_read(file, type.name, length);
+    simple_error_check(error);
+
+    snapshot->types = simple_heap_reserve(snapshot->types,
+        snapshot->type_count, capacity, sizeof *snapshot->types);
+    snapshot->types[snapshot->type_count++] = type;
+    type.name = NULL;
+
+    cleanup:
+    free(type.name);
+    return error;
+}
+
+static struct simple_error *simple_heap_read_object(
+    FILE *file,
+    struct simple_heap_snapshot *snapshot,
+    size_t *capacity,
+    size_t *reference_capacity
+) {
+    struct simple_error *error = NULL;
+    struct simple_heap_object object = {.first_reference = 0};
+    uint64_t size, id;
+    uint8_t kind;
+
+    error = simple_heap_read(file, &object.id, sizeof object.id);
+    simple_error_check(error);
+    error = simple_heap_read(file, &object.type_id, sizeof object.type_id);
+    simple_error_check(error);
+    error = simple_heap_read(file, &kind, sizeof kind);
+    simple_error_check(error);
+    error = simple_heap_read(file, &object.refcount, sizeof object.refcount);
+    simple_error_check(error);
+    error = simple_heap_read(file, &size, sizeof size);
+    simple_error_check(error);
+
+    if (kind > OBJECT_SINK) {
+        error = simple_error_new("Unknown object kind %u in heap snapshot.",
+            kind);
+        simple_error_check(error);
+    }
+    object.kind = (enum object_kind)kind;
+    object.size = (size_t)size;
+    object.first_reference = snapshot->reference_count;
+
+    for (;;) {
+        error = simple_heap_read(file, &id, sizeof id);
+        simple_error_check(error);
+        if (!id) {
+            break;
+        }
+        snapshot->reference_ids = simple_heap_reserve(
+            snapshot->reference_ids, snapshot->reference_count,
+            reference_capacity, sizeof *snapshot->reference_ids);
+        snapshot->reference_ids[snapshot->reference_count++] = id;
+        object.reference_count++;
+    }
+
+    snapshot->objects = simple_heap_reserve(snapshot->objects,
+        snapshot->object_count, capacity, sizeof *snapshot->objects);
+    snapshot->objects[snapshot->object_count++] = object;
+
+    cleanup:
+    return error;
+}
+
+static int simple_heap_compare_objects(
+    const void *lhs,
+    const void *rhs
+) {
+    uint64_t left = ((const struct simple_heap_object *)lhs)->id;
+    uint64_t right = ((const struct simple_heap_object *)rhs)->id;
+    return (left > right) - (left < right);
+}
+
+static int simple_heap_compare_types(
+    const void *lhs,
+    const void *rhs
+) {
+    uint64_t left = ((const struct simple_heap_type *)lhs)->id;
+    uint64_t right = ((const struct simple_heap_type *)rhs)->id;
+    return (left > right) - (left < right);
+}
+
+static size_t simple_heap_find_object(
+    const struct simple_heap_snapshot *snapshot,
+    uint64_t id
+) {
+    struct simple_heap_object key = {.id = id};
+    const struct simple_heap_object *found = bsearch(&key, snapshot->objects,
+        snapshot->object_count, sizeof *snapshot->objects,
+        simple_heap_compare_objects);
+    return found ? (size_t)(found - snapshot->objects) : SIMPLE_HEAP_NONE;
+}
+
+// sorts objects and types by id and replaces ids by indices
+static struct simple_error *simple_heap_resolve(
+    struct simple_heap_snapshot *snapshot
+) {
+    struct simple_error *error = NULL;
+
+    qsort(snapshot->objects, snapshot->object_count,
+        sizeof *snapshot->objects, simple_heap_compare_objects);
+    qsort(snapshot->types, snapshot->type_count, sizeof *snapshot->types,
+        simple_heap_compare_types);
+
+    snapshot->references = calloc(snapshot->reference_count + 1,
+        sizeof *snapshot->references);
+    for (size_t i = 0; i < snapshot->reference_count; i++) {
+        snapshot->references[i] = simple_heap_find_object(snapshot,
+            snapshot->reference_ids[i]);
+    }
+
+    for (size_t i = 0; i < snapshot->object_count; i++) {
+        struct simple_heap_object *object = snapshot->objects + i;
+        struct simple_heap_type key = {.id = object->type_id};
+        const struct simple_heap_type *type = bsearch(&key, snapshot->types,
+            snapshot->type_count, sizeof *snapshot->types,
+            simple_heap_compare_types);
+        if (!type) {
+            error = simple_error_new("Object of unknown type %" PRIu64
+                " in heap snapshot.", object->type_id);
+            simple_error_check(error);
+        }
+        object->type = (size_t)(type - snapshot->types);
+        snapshot->total_size += object->size;
+    }
+
+    cleanup:
+    return error;
+}
+
+static const size_t *simple_heap_graph_get_successors(
+    const struct simple_heap_graph *graph,
+    size_t node,
+    size_t *count
+) {
+    if (!node) {
+        *count = graph->root_count;
+        return graph->roots;
+    }
+    *count = graph->successor_start[node + 1] - graph->successor_start[node];
+    return graph->successors + graph->successor_start[node];
+}
+
+// Numbers the nodes reachable from start in postorder, continuing at
+// *number. stack holds a node and the index of its next successor per
+// level.
+static void simple_heap_graph_visit(
+    struct simple_heap_graph *graph,
+    size_t start,
+    size_t *number,
+    size_t *stack
+) {
+    size_t depth = 1;
+    stack[0] = start;
+    stack[1] = 0;
+    graph->postorder[start] = *number;
+
+    while (depth) {
+        size_t node = stack[depth * 2 - 2];
+        size_t next = stack[depth * 2 - 1];
+        size_t count;
+        const size_t *successors = simple_heap_graph_get_successors(graph,
+            node, &count);
+
+        if (next == count) {
+            graph->postorder[node] = *number;
+            graph->order[(*number)++] = node;
+            depth--;
+            continue;
+        }
+
+        stack[depth * 2 - 1]++;
+        size_t successor = successors[next];
+        if (!graph->visited[successor]) {
+            graph->visited[successor] = true;
+            stack[depth * 2] = successor;
+            stack[depth * 2 + 1] = 0;
+            depth++;
+        }
+    }
+}
+
+static void simple_heap_graph_add_predecessors(
+    struct simple_heap_graph *graph
+) {
+    size_t node_count = graph->node_count;
+    size_t *filled = calloc(node_count, sizeof *filled);
+
+    graph->predecessor_start = calloc(node_count + 1,
+        sizeof *graph->predecessor_start);
+    for (size_t node = 0; node < node_count; node++) {
+        size_t count;
+        const size_t *successors = simple_heap_graph_get_successors(graph,
+            node, &count);
+        for (size_t i = 0; i < count; i++) {
+            graph->predecessor_start[successors[i] + 1]++;
+        }
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        graph->predecessor_start[node + 1] += graph->predecessor_start[node];
+    }
+
+    graph->predecessors = calloc(graph->predecessor_start[node_count] + 1,
+        sizeof *graph->predecessors);
+    for (size_t node = 0; node < node_count; node++) {
+        size_t count;
+        const size_t *successors = simple_heap_graph_get_successors(graph,
+            node, &count);
+        for (size_t i = 0; i < count; i++) {
+            size_t successor = successors[i];
+            graph->predecessors[graph->predecessor_start[successor] +
+                filled[successor]++] = node;
+        }
+    }
+    free(filled);
+}
+
+// Roots are the objects nothing in the snapshot references and those with
+// more references than the snapshot shows. Objects still unreachable, a
+// cycle only referenced from within, become roots as well.
+static void simple_heap_graph_build(
+    const struct simple_heap_snapshot *snapshot,
+    struct simple_heap_graph *graph
+) {
+    size_t node_count = snapshot->object_count + 1;
+    size_t *in_degree = calloc(node_count, sizeof *in_degree);
+
+    graph->node_count = node_count;
+    graph->roots = calloc(node_count, sizeof *graph->roots);
+    graph->successor_start = calloc(node_count + 1,
+        sizeof *graph->successor_start);
+    graph->successors = calloc(snapshot->reference_count + 1,
+        sizeof *graph->successors);
+    graph->visited = calloc(node_count, sizeof *graph->visited);
+    graph->postorder = calloc(node_count, sizeof *graph->postorder);
+    graph->order = calloc(node_count, sizeof *graph->order);
+    graph->dominator = calloc(node_count, sizeof *graph->dominator);
+
+    size_t count = 0;
+    for (size_t node = 1; node < node_count; node++) {
+        const struct simple_heap_object *object = snapshot->objects + node - 1;
+        graph->successor_start[node] = count;
+        for (size_t i = 0; i < object->reference_count; i++) {
+            size_t target = snapshot->references[object->first_reference + i];
+            if (target != SIMPLE_HEAP_NONE) {
+                graph->successors[count++] = target + 1;
+                in_degree[target + 1]++;
+            }
+        }
+    }
+    graph->successor_start[node_count] = count;
+
+    for (size_t node = 1; node < node_count; node++) {
+        int32_t refcount = snapshot->objects[node - 1].refcount;
+        if (!in_degree[node] || (refcount > 0 &&
+                (size_t)refcount > in_degree[node])) {
+            graph->roots[graph->root_count++] = node;
+        }
+    }
+
+    // the root is numbered last, after everything below it
+    size_t number = 0;
+    size_t *stack = calloc(node_count * 2, sizeof *stack);
+    graph->visited[0] = true;
+    for (size_t i = 0; i < graph->root_count; i++) {
+        graph->visited[graph->roots[i]] = true;
+    }
+    for (size_t i = 0; i < graph->root_count; i++) {
+        simple_heap_graph_visit(graph, graph->roots[i], &number, stack);
+    }
+    for (size_t node = 1; node < node_count; node++) {
+        if (!graph->visited[node]) {
+            graph->visited[node] = true;
+            graph->roots[graph->root_count++] = node;
+            simple_heap_graph_visit(graph, node, &number, stack);
+        }
+    }
+    graph->postorder[0] = number;
+    graph->order[number] = 0;
+    free(stack);
+
+    simple_heap_graph_add_predecessors(graph);
+    free(in_degree);
+}
+
+static size_t simple_heap_graph_intersect(
+    const struct simple_heap_graph *graph,
+    size_t left,
+    size_t right
+) {
+    while (left != right) {
+        while (graph->postorder[left] < graph->postorder[right]) {
+            left = graph->dominator[left];
+        }
+        while (graph->postorder[right] < graph->postorder[left]) {
+            right = graph->dominator[right];
+        }
+    }
+    return left;
+}
+
+// The iterative algorithm of Cooper, Harvey and Kennedy, "A Simple, Fast
+// Dominance Algorithm". Nodes are visited in reverse postorder until no
+// immediate dominator changes.
+static void simple_heap_graph_dominate(
+    struct simple_heap_graph *graph
+) {
+    for (size_t node = 0; node < graph->node_count; node++) {
+        graph->dominator[node] = SIMPLE_HEAP_NONE;
+    }
+    graph->dominator[0] = 0;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        // the root is last in postorder
+        for (size_t i = graph->node_count - 1; i-- > 0;) {
+            size_t node = graph->order[i];
+            size_t dominator = SIMPLE_HEAP_NONE;
+
+            for (size_t j = graph->predecessor_start[node];
+                    j < graph->predecessor_start[node + 1]; j++) {
+                size_t predecessor = graph->predecessors[j];
+                if (graph->dominator[predecessor] == SIMPLE_HEAP_NONE) {
+                    continue;
+                }
+                dominator = dominator == SIMPLE_HEAP_NONE ? predecessor :
+                    simple_heap_graph_intersect(graph, predecessor,
+                    dominator);
+            }
+
+            if (graph->dominator[node] != dominator) {
+                graph->dominator[node] = dominator;
+                changed = true;
+            }
+        }
+    }
+}
+
+// Sums the retained size of every type over the dominator tree, skipping
+// objects below another object of their type. active counts the objects of
+// each type on the path from the root.
+static void simple_heap_sum_types(
+    struct simple_heap_snapshot *snapshot,
+    const struct simple_heap_graph *graph
+) {
+    size_t node_count = graph->node_count;
+    size_t *child_start = calloc(node_count + 1, sizeof *child_start);
+    size_t *children = calloc(node_count, sizeof *children);
+    size_t *filled = calloc(node_count, sizeof *filled);
+    size_t *active = calloc(snapshot->type_count + 1, sizeof *active);
+    size_t *stack = calloc(node_count * 2, sizeof *stack);
+
+    for (size_t node = 1; node < node_count; node++) {
+        child_start[graph->dominator[node] + 1]++;
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        child_start[node + 1] += child_start[node];
+    }
+    for (size_t node = 1; node < node_count; node++) {
+        size_t parent = graph->dominator[node];
+        children[child_start[parent] + filled[parent]++] = node;
+    }
+
+    size_t depth = 1;
+    stack[0] = 0;
+    stack[1] = child_start[0];
+    while (depth) {
+        size_t node = stack[depth * 2 - 2];
+        size_t next = stack[depth * 2 - 1];
+
+        if (next == child_start[node + 1]) {
+            if (node) {
+                active[snapshot->objects[node - 1].type]--;
+            }
+            depth--;
+            continue;
+        }
+
+        stack[depth * 2 - 1]++;
+        size_t child = children[next];
+        struct simple_heap_object *object = snapshot->objects + child - 1;
+        if (!active[object->type]++) {
+            snapshot->types[object->type].retained += object->retained;
+        }
+        stack[depth * 2] = child;
+        stack[depth * 2 + 1] = child_start[child];
+        depth++;
+    }
+
+    free(stack);
+    free(active);
+    free(filled);
+    free(children);
+    free(child_start);
+}
+
+static void simple_heap_analyze(
+    struct simple_heap_snapshot *snapshot
+) {
+    struct simple_heap_graph graph = {.node_count = 0};
+    simple_heap_graph_build(snapshot, &graph);
+    simple_heap_graph_dominate(&graph);
+
+    // a dominator comes after everything it dominates in postorder
+    for (size_t i = 0; i + 1 < graph.node_count; i++) {
+        size_t node = graph.order[i];
+        struct simple_heap_object *object = snapshot->objects + node - 1;
+        object->retained += object->size;
+        if (graph.dominator[node]) {
+            snapshot->objects[graph.dominator[node] - 1].retained +=
+                object->retained;
+        }
+    }
+
+    for (size_t i = 0; i < snapshot->object_count; i++) {
+        struct simple_heap_object *object = snapshot->objects + i;
+        struct simple_heap_type *type = snapshot->types + object->type;
+        type->count++;
+        type->size += object->size;
+        type->unreferenced += object->refcount <= 0;
+    }
+    simple_heap_sum_types(snapshot, &graph);
+
+    free(graph.roots);
+    free(graph.successor_start);
+    free(graph.successors);
+    free(graph.predecessor_start);
+    free(graph.predecessors);
+    free(graph.visited);
+    free(graph.postorder);
+    free(graph.order);
+    free(graph.dominator);
+}
+
+struct simple_error *simple_heap_read_snapshot(
+    FILE *file,
+    struct simple_heap_snapshot **result
+) {
+    struct simple_error *error = NULL;
+    struct simple_heap_snapshot *snapshot = calloc(1, sizeof *snapshot);
+    size_t type_capacity = 0, object_capacity = 0, reference_capacity = 0;
+    int record;
+
+    error = simple_heap_read_header(file);
+    simple_error_check(error);
+
+    while ((record = fgetc(file)) != 'E') {
+        if (record == 'T') {
+            error = simple_heap_read_type(file, snapshot, &type_capacity);
+            simple_error_check(error);
+        } else if (record == 'O') {
+            error = simple_heap_read_object(file, snapshot, &object_capacity,
+                &reference_capacity);
+            simple_error_check(error);
+        } else if (record == EOF) {
+            error = simple_error_new("%s", "The heap snapshot is truncated.");
+            simple_error_check(error);
+        } else {
+            error = simple_error_new("Unknown record '%c' in heap snapshot.",
+                record);
+            simple_error_check(error);
+        }
+    }
+
+    error = simple_heap_resolve(snapshot);
+    simple_error_check(error);
+    simple_heap_analyze(snapshot);
+
+    *result = snapshot;
+    snapshot = NULL;
+
+    cleanup:
+    simple_heap_snapshot_destroy(snapshot);
+    return error;
+}
+
+void simple_heap_snapshot_destroy(
+    struct simple_heap_snapshot *snapshot
+) {
+    if (!snapshot) {
+        return;
+    }
+
+    for (size_t i = 0; i < snapshot->type_count; i++) {
+        free(snapshot->types[i].name);
+    }
+    free(snapshot->types);
+    free(snapshot->objects);
+    free(snapshot->references);
+    free(snapshot->reference_ids);
+    free(snapshot);
+}
+
+size_t simple_heap_snapshot_get_object_count(
+    const struct simple_heap_snapshot *snapshot
+) {
+    return snapshot->object_count;
+}
+
+struct simple_error *simple_heap_snapshot_get_retained(
+    const struct simple_heap_snapshot *snapshot,
+    uint64_t id,
+    size_t *result
+) {
+    size_t index = simple_heap_find_object(snapshot, id);
+    if (index == SIMPLE_HEAP_NONE) {
+        return simple_error_new("No object %" PRIu64 " in heap snapshot.",
+            id);
+    }
+    *result = snapshot->objects[index].retained;
+    return NULL;
+}
+
+static int simple_heap_compare_type_retained(
+    const void *lhs,
+    const void *rhs
+) {
+    size_t left = ((const struct simple_heap_type *)lhs)->retained;
+    size_t right = ((const struct simple_heap_type *)rhs)->retained;
+    return (left < right) - (left > right);
+}
+
+static int simple_heap_compare_object_retained(
+    const void *lhs,
+    const void *rhs
+) {
+    size_t left = (*(const struct simple_heap_object *const *)lhs)->retained;
+    size_t right = (*(const struct simple_heap_object *const *)rhs)->retained;
+    return (left < right) - (left > right);
+}
+
+void simple_heap_write_report(
+    const struct simple_heap_snapshot *snapshot,
+    FILE *file,
+    size_t top
+) {
+    struct simple_heap_type *types = calloc(snapshot->type_count + 1,
+        sizeof *types);
+    const struct simple_heap_object **objects = calloc(
+        snapshot->object_count + 1, sizeof *objects);
+
+    fprintf(file, "%zu objects, %zu bytes\n\n", snapshot->object_count,
+        snapshot->total_size);
+
+    memcpy(types, snapshot->types, snapshot->type_count * sizeof *types);
+    qsort(types, snapshot->type_count, sizeof *types,
+        simple_heap_compare_type_retained);
+    fprintf(file, "%-24s %10s %12s %12s %12s\n", "type", "objects", "bytes",
+        "retained", "unreferenced");
+    for (size_t i = 0; i < snapshot->type_count; i++) {
+        fprintf(file, "%-24s %10zu %12zu %12zu %12zu\n", types[i].name,
+            types[i].count, types[i].size, types[i].retained,
+            types[i].unreferenced);
+    }
+
+    for (size_t i = 0; i < snapshot->object_count; i++) {
+        objects[i] = snapshot->objects + i;
+    }
+    qsort(objects, snapshot->object_count, sizeof *objects,
+        simple_heap_compare_object_retained);
+    top = top < snapshot->object_count ? top : snapshot->object_count;
+    fprintf(file, "\n%-18s %-24s %-12s %12s %12s\n", "object", "type",
+        "kind", "bytes", "retained");
+    for (size_t i = 0; i < top; i++) {
+        fprintf(file, "0x%016" PRIx64 " %-24s %-12s %12zu %12zu\n",
+            objects[i]->id, snapshot->types[objects[i]->type].name,
+            object_kind_get_name(objects[i]->kind), objects[i]->size,
+            objects[i]->retained);
+    }
+
+    free(objects);
+    free(types);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "simple_error.h"
+
+// Heap snapshots. The writer streams every object ever created, see
+// object_foreach_allocated, with its type, size and the objects it
+// references to a file, keeping nothing but the types already written in
+// memory. The reader loads a snapshot and computes the dominator tree of
+// the object graph: an object dominates another if every path from the
+// roots to the other passes through it. The retained size of an object is
+// what would be freed along with it, its own size plus that of all objects
+// it dominates.
+//
+// Roots are the objects no other object references plus those with a
+// reference count above their references in the snapshot, which are held
+// from C. Objects are never freed, so objects with a reference count of 0
+// are reported as unreferenced.
+//
+// The format is native byte order, the reader refuses snapshots from a
+// machine with another one:
+//
+//     header: "SIMPLEHS", u32 version, u32 0x01020304
+//     type: 'T', u64 id, u32 name length, name
+//     object: 'O', u64 id, u64 type id, u8 kind, i32 reference count,
+//         u64 size, u64 referenced ids ending with 0
+//     end: 'E'
+//
+// A type record comes before the first object of that type.
+
+#define SIMPLE_HEAP_VERSION 1
+
+struct simple_heap_snapshot;
+
+struct simple_error *simple_heap_write_snapshot(
+    FILE *file
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_heap_read_snapshot(
+    FILE *file,
+    struct simple_heap_snapshot **result
+) __attribute__((warn_unused_result));
+
+void simple_heap_snapshot_destroy(
+    struct simple_heap_snapshot *snapshot
+);
+
+size_t simple_heap_snapshot_get_object_count(
+    const struct simple_heap_snapshot *snapshot
+);
+
+// id is the address the object had when the snapshot was written
+struct simple_error *simple_heap_snapshot_get_retained(
+    const struct simple_heap_snapshot *snapshot,
+    uint64_t id,
+    size_t *result
+) __attribute__((warn_unused_result));
+
+// Writes per type the object count, own size, retained size and
+// unreferenced objects, then the top objects by retained size. The retained
+// size of a type counts objects dominated by another object of the same
+// type once.
+void simple_heap_write_report(
+    const struct simple_heap_snapshot *snapshot,
+    FILE *file,
+    size_t top
+);
@@ -0,0 +1,216 @@
+#include "simple_int_hashtable.h"
+
+#include <malloc.h>
+
+#include "simple_error.h"
+#include "simple_hash.h"
+#include "simple_object.h"
+
+#define SIMPLE_INT_HASHTABLE_MIN_SLOTS 16
+#define SIMPLE_INT_HASHTABLE_MAX_LOAD_FACTOR 0.75
+
+// a slot is empty while its value is NULL, stored values never are
+struct simple_int_hashtable_slot {
+    int64_t key;
+    struct object *value;
+};
+
+struct simple_int_hashtable {
+    const struct type *value_type;
+    struct simple_int_hashtable_slot *slots;
+    size_t mask;
+    size_t size;
+};
+
+static size_t simple_int_hashtable_home(
+    const struct simple_int_hashtable *table,
+    int64_t key
+) {
+    return simple_hash_integer((uint64_t)key) & table->mask;
+}
+
+// smallest power of two slot count holding count entries
+static size_t simple_int_hashtable_slots_for(
+    size_t count
+) {
+    size_t slot_count = SIMPLE_INT_HASHTABLE_MIN_SLOTS;
+    while ((double)count > (double)slot_count *
+            SIMPLE_INT_HASHTABLE_MAX_LOAD_FACTOR) {
+        slot_count *= 2;
+    }
+    return slot_count;
+}
+
+static void simple_int_hashtable_resize(
+    struct simple_int_hashtable *table,
+    size_t slot_count
+) {
+    struct simple_int_hashtable_slot *old_slots = table->slots;
+    size_t old_slot_count = table->slots ? table->mask + 1 : 0;
+
+    table->slots = calloc(slot_count, sizeof *table->slots);
+    table->mask = slot_count - 1;
+
+    for (size_t i = 0; i < old_slot_count; i++) {
+        if (!old_slots[i].value) {
+            continue;
+        }
+        size_t index = simple_int_hashtable_home(table, old_slots[i].key);
+        while (table->slots[index].value) {
+            index = (index + 1) & table->mask;
+        }
+        table->slots[index] = old_slots[i];
+    }
+    free(old_slots);
+}
+
+struct simple_int_hashtable *simple_int_hashtable_new(
+    const struct type *value_type
+) {
+    return simple_int_hashtable_new_with_capacity(value_type, 0);
+}
+
+struct simple_int_hashtable *simple_int_hashtable_new_with_capacity(
+    const struct type *value_type,
+    size_t capacity
+) {
+    struct simple_int_hashtable *table = calloc(1, sizeof *table);
+    *table = (struct simple_int_hashtable) {
+        .value_type = value_type,
+        .slots = NULL,
+        .mask = 0,
+        .size = 0
+    };
+    simple_int_hashtable_resize(table,
+        simple_int_hashtable_slots_for(capacity));
+    return table;
+}
+
+void simple_int_hashtable_destroy(
+    struct simple_int_hashtable *table
+) {
+    if (!table) {
+        return;
+    }
+    for (size_t i = 0; i <= table->mask; i++) {
+        object_refcount_decrease(table->slots[i].value);
+    }
+    free(table->slots);
+    free(table);
+}
+
+size_t simple_int_hashtable_size(
+    const struct simple_int_hashtable *table
+) {
+    return table->size;
+}
+
+void simple_int_hashtable_reserve(
+    struct simple_int_hashtable *table,
+    size_t count
+) {
+    size_t slot_count = simple_int_hashtable_slots_for(count);
+    if (slot_count > table->mask + 1) {
+        simple_int_hashtable_resize(table, slot_count);
+    }
+}
+
+// the slot holding key, or the empty slot ending its probe sequence
+static size_t simple_int_hashtable_probe(
+    const struct simple_int_hashtable *table,
+    int64_t key
+) {
+    size_t index = simple_int_hashtable_home(table, key);
+    while (table->slots[index].value && table->slots[index].key != key) {
+        index = (index + 1) & table->mask;
+    }
+    return index;
+}
+
+struct simple_error *simple_int_hashtable_find(
+    const struct simple_int_hashtable *table,
+    int64_t key,
+    struct object **result
+) {
+    *result = table->slots[simple_int_hashtable_probe(table, key)].value;
+    object_refcount_increase(*result);
+    return NULL;
+}
+
+struct simple_error *simple_int_hashtable_insert(
+    struct simple_int_hashtable *table,
+    int64_t key,
+    const struct object *value
+) {
+    struct object *value_copy;
+    struct simple_error *error = object_copy(value, &value_copy);
+    simple_error_check(error);
+
+    simple_int_hashtable_reserve(table, table->size + 1);
+
+    struct simple_int_hashtable_slot *slot;
+    slot = table->slots + simple_int_hashtable_probe(table, key);
+    if (slot->value) {
+        object_refcount_decrease(slot->value);
+    } else {
+        slot->key = key;
+        table->size++;
+    }
+    slot->value = value_copy;
+
+    cleanup:
+    return error;
+}
+
+// Backward shift deletion: later entries of the probe sequence move into
+// the hole, so no tombstones pile up and lookups stay short.
+void simple_int_hashtable_erase(
+    struct simple_int_hashtable *table,
+    int64_t key,
+    bool *erased
+) {
+    size_t hole = simple_int_hashtable_probe(table, key);
+
+    *erased = table->slots[hole].value != NULL;
+    if (!*erased) {
+        return;
+    }
+
+    object_refcount_decrease(table->slots[hole].value);
+    table->size--;
+
+    size_t index = hole;
+    for (;;) {
+        index = (index + 1) & table->mask;
+        if (!table->slots[index].value) {
+            break;
+        }
+
+        // an entry may only move back if that keeps it after its home
+        size_t home = simple_int_hashtable_home(table,
+            table->slots[index].key);
+        if (((index - home) & table->mask) >= ((index - hole) & table->mask)) {
+            table->slots[hole] = table->slots[index];
+            hole = index;
+        }
+    }
+    table->slots[hole].value = NULL;
+}
+
+struct simple_error *simple_int_hashtable_foreach(
+    const struct simple_int_hashtable *table,
+    simple_int_hashtable_visit_func func,
+    void *context
+) {
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; i <= table->mask; i++) {
+        if (table->slots[i].value) {
+            error = func(table->slots[i].key, table->slots[i].value, context);
+            simple_error_check(error);
+        }
+    }
+
+    cleanup:
+    return error;
+}
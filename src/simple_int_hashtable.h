@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct object;
+struct simple_error;
+struct type;
+struct simple_int_hashtable;
+
+// Hashtable keyed by plain integers. Keys are stored unboxed next to the
+// value pointers in one open addressing array, so a lookup hashes the key
+// and probes neighbouring slots without dereferencing any object.
+
+// Called for every entry, returning an error stops the iteration.
+typedef struct simple_error *(*simple_int_hashtable_visit_func)(
+    int64_t key,
+    const struct object *value,
+    void *context
+);
+
+struct simple_int_hashtable *simple_int_hashtable_new(
+    const struct type *value_type
+) __attribute__((warn_unused_result));
+
+// Sized up front so capacity entries fit without growing.
+struct simple_int_hashtable *simple_int_hashtable_new_with_capacity(
+    const struct type *value_type,
+    size_t capacity
+) __attribute__((warn_unused_result));
+
+void simple_int_hashtable_destroy(
+    struct simple_int_hashtable *table
+);
+
+size_t simple_int_hashtable_size(
+    const struct simple_int_hashtable *table
+);
+
+// Grows the table so count entries fit without further growth.
+void simple_int_hashtable_reserve(
+    struct simple_int_hashtable *table,
+    size_t count
+);
+
+// Increases the reference count of the result, like simple_hashtable_find.
+struct simple_error *simple_int_hashtable_find(
+    const struct simple_int_hashtable *table,
+    int64_t key,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+// The value is copied, an existing value for key is replaced.
+struct simple_error *simple_int_hashtable_insert(
+    struct simple_int_hashtable *table,
+    int64_t key,
+    const struct object *value
+) __attribute__((warn_unused_result));
+
+void simple_int_hashtable_erase(
+    struct simple_int_hashtable *table,
+    int64_t key,
+    bool *erased
+);
+
+struct simple_error *simple_int_hashtable_foreach(
+    const struct simple_int_hashtable *table,
+    simple_int_hashtable_visit_func func,
+    void *context
+) __attribute__((warn_unused_result));
@@ -0,0 +1,211 @@
+#include "simple_list.h"
+
+#include <malloc.h>
+#include <string.h>
+
+#include "simple_error.h"
+#include "simple_object.h"
+
+struct simple_list {
+    struct object **elements;
+    size_t size, capacity;
+    // small lists live in the same allocation as the header
+    struct object *inline_elements[SIMPLE_LIST_INLINE_CAPACITY];
+};
+
+static bool simple_list_is_inline(
+    const struct simple_list *list
+) {
+    return list->elements == list->inline_elements;
+}
+
+static void simple_list_reallocate(
+    struct simple_list *list,
+    size_t capacity
+) {
+    if (capacity <= SIMPLE_LIST_INLINE_CAPACITY) {
+        if (!simple_list_is_inline(list)) {
+            memcpy(list->inline_elements, list->elements,
+                list->size * sizeof *list->elements);
+            free(list->elements);
+            list->elements = list->inline_elements;
+        }
+        list->capacity = SIMPLE_LIST_INLINE_CAPACITY;
+        return;
+    }
+
+    if (simple_list_is_inline(list)) {
+        struct object **elements = calloc(capacity, sizeof *elements);
+        memcpy(elements, list->inline_elements,
+            list->size * sizeof *elements);
+        list->elements = elements;
+    } else {
+        list->elements = realloc(list->elements,
+            capacity * sizeof *list->elements);
+    }
+    list->capacity = capacity;
+}
+
+// grows by half so freed blocks can be reused by later growth
+static void simple_list_grow(
+    struct simple_list *list,
+    size_t required
+) {
+    if (required <= list->capacity) {
+        return;
+    }
+    size_t capacity = list->capacity + list->capacity / 2;
+    simple_list_reallocate(list, capacity > required ? capacity : required);
+}
+
+struct simple_list *simple_list_new(
+    size_t capacity
+) {
+    struct simple_list *list = calloc(1, sizeof *list);
+    list->elements = list->inline_elements;
+    list->capacity = SIMPLE_LIST_INLINE_CAPACITY;
+    list->size = 0;
+    simple_list_reserve(list, capacity);
+    return list;
+}
+
+struct simple_list *simple_list_copy(
+    const struct simple_list *list
+) {
+    struct simple_list *copy = simple_list_new(list->size);
+    simple_list_extend(copy, list);
+    return copy;
+}
+
+void simple_list_destroy(
+    struct simple_list *list
+) {
+    if (!list) {
+        return;
+    }
+    for (size_t i = 0; i < list->size; i++) {
+        object_refcount_decrease(list->elements[i]);
+    }
+    if (!simple_list_is_inline(list)) {
+        free(list->elements);
+    }
+    free(list);
+}
+
+size_t simple_list_size(
+    const struct simple_list *list
+) {
+    return list->size;
+}
+
+size_t simple_list_capacity(
+    const struct simple_list *list
+) {
+    return list->capacity;
+}
+
+void simple_list_append(
+    struct simple_list *list,
+    struct object *element
+) {
+    if (list->size == list->capacity) {
+        simple_list_grow(list, list->size + 1);
+    }
+    object_refcount_increase(element);
+    list->elements[list->size++] = element;
+}
+
+void simple_list_extend(
+    struct simple_list *list,
+    const struct simple_list *other
+) {
+    // read the count first, other may be list itself
+    size_t count = other->size;
+    simple_list_grow(list, list->size + count);
+
+    for (size_t i = 0; i < count; i++) {
+        object_refcount_increase(other->elements[i]);
+    }
+    memcpy(list->elements + list->size, other->elements,
+        count * sizeof *list->elements);
+    list->size += count;
+}
+
+struct simple_error *simple_list_get(
+    const struct simple_list *list,
+    size_t index,
+    struct object **result
+) {
+    if (index >= list->size) {
+        *result = NULL;
+        return simple_error_new("Index %zu out of range for list of size "
+            "%zu.", index, list->size);
+    }
+    *result = list->elements[index];
+    return NULL;
+}
+
+struct simple_error *simple_list_set(
+    struct simple_list *list,
+    size_t index,
+    struct object *element
+) {
+    if (index >= list->size) {
+        return simple_error_new("Index %zu out of range for list of size "
+            "%zu.", index, list->size);
+    }
+    object_refcount_increase(element);
+    object_refcount_decrease(list->elements[index]);
+    list->elements[index] = element;
+    return NULL;
+}
+
+struct simple_error *simple_list_pop(
+    struct simple_list *list,
+    struct object **result
+) {
+    if (!list->size) {
+        *result = NULL;
+        return simple_error_new("%s", "Cannot pop from an empty list.");
+    }
+    // the reference moves to the caller
+    *result = list->elements[--list->size];
+    return NULL;
+}
+
+void simple_list_reserve(
+    struct simple_list *list,
+    size_t capacity
+) {
+    if (capacity > list->capacity) {
+        simple_list_reallocate(list, capacity);
+    }
+}
+
+void simple_list_shrink_to_fit(
+    struct simple_list *list
+) {
+    if (!simple_list_is_inline(list) && list->size < list->capacity) {
+        simple_list_reallocate(list, list->size);
+    }
+}
+
+struct simple_error *simple_list_equals(
+    const struct simple_list *lhs,
+    const struct simple_list *rhs,
+    bool *result
+) {
+    struct simple_error *error = NULL;
+
+    *result = lhs->size == rhs->size;
+    for (size_t i = 0; *result && i < lhs->size; i++) {
+        error = object_equals(lhs->elements[i], rhs->elements[i], result);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    if (error) {
+        *result = false;
+    }
+    return error;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct object;
+struct simple_error;
+struct simple_list;
+
+// Elements held inside the list header before spilling to the heap.
+#define SIMPLE_LIST_INLINE_CAPACITY 4
+
+struct simple_list *simple_list_new(
+    size_t capacity
+) __attribute__((warn_unused_result));
+
+struct simple_list *simple_list_copy(
+    const struct simple_list *list
+) __attribute__((warn_unused_result));
+
+void simple_list_destroy(
+    struct simple_list *list
+);
+
+size_t simple_list_size(
+    const struct simple_list *list
+);
+
+size_t simple_list_capacity(
+    const struct simple_list *list
+);
+
+// Elements are shared with the caller, the list holds a reference.
+void simple_list_append(
+    struct simple_list *list,
+    struct object *element
+);
+
+void simple_list_extend(
+    struct simple_list *list,
+    const struct simple_list *other
+);
+
+struct simple_error *simple_list_get(
+    const struct simple_list *list,
+    size_t index,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_list_set(
+    struct simple_list *list,
+    size_t index,
+    struct object *element
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_list_pop(
+    struct simple_list *list,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+// Makes room for capacity elements so appends up to it never reallocate.
+void simple_list_reserve(
+    struct simple_list *list,
+    size_t capacity
+);
+
+// Gives back unused heap storage, moves back inline when it fits.
+void simple_list_shrink_to_fit(
+    struct simple_list *list
+);
+
+struct simple_error *simple_list_equals(
+    const struct simple_list *lhs,
+    const struct simple_list *rhs,
+    bool *result
+) __attribute__((warn_unused_result));
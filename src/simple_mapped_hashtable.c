@@ -0,0 +1,616 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "simple_mapped_hashtable.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "simple_string.h"
+#include "type.h"
+
+#define SIMPLE_MAPPED_HASHTABLE_MAGIC "SIMPLEMH"
+#define SIMPLE_MAPPED_HASHTABLE_BYTE_ORDER 0x01020304
+
+// the only hash function so far, 64 bit FNV-1a
+#define SIMPLE_MAPPED_HASHTABLE_HASH_FNV1A 1
+#define SIMPLE_MAPPED_HASHTABLE_FNV_OFFSET 0xcbf29ce484222325
+#define SIMPLE_MAPPED_HASHTABLE_FNV_PRIME 0x100000001b3
+
+#define SIMPLE_MAPPED_HASHTABLE_INT 'i'
+#define SIMPLE_MAPPED_HASHTABLE_STRING 's'
+
+// linear probing stays short below half full
+#define SIMPLE_MAPPED_HASHTABLE_MIN_SLOTS 16
+#define SIMPLE_MAPPED_HASHTABLE_MAX_LOAD_FACTOR 0.5
+
+struct simple_mapped_hashtable_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t hash_function;
+    uint32_t reserved;
+    uint64_t size;
+    uint64_t slot_count;
+    uint64_t slots;
+    uint64_t key_type;
+    uint64_t value_type;
+};
+
+struct simple_mapped_hashtable_slot {
+    uint64_t hash;
+    uint64_t key;
+    uint64_t value;
+};
+
+// the header of a key or value, as in simple_serial.h
+struct simple_mapped_hashtable_value {
+    uint32_t tag;
+    uint32_t reserved;
+    uint64_t length;
+};
+
+struct simple_mapped_hashtable {
+    void *mapping;
+    const char *data;
+    size_t data_size;
+    size_t size;
+    size_t slot_count;
+    size_t slots;
+    const struct type *key_type, *value_type;
+};
+
+static const char simple_mapped_hashtable_zeros[8];
+
+static size_t simple_mapped_hashtable_align(
+    size_t length
+) {
+    return (length + 7) & ~(size_t)7;
+}
+
+static uint64_t simple_mapped_hashtable_fnv1a(
+    uint64_t hash,
+    const unsigned char *bytes,
+    size_t length
+) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= SIMPLE_MAPPED_HASHTABLE_FNV_PRIME;
+    }
+    return hash;
+}
+
+// FNV-1a of the string bytes, or of an int as 8 little endian bytes, so
+// the hash does not depend on the signedness of char or the byte order
+static struct simple_error *simple_mapped_hashtable_hash(
+    const struct object *key,
+    uint64_t *result
+) {
+    struct simple_error *error = NULL;
+    struct simple_string *string;
+    unsigned char bytes[8];
+    int value;
+
+    if (object_get_kind(key) == OBJECT_INTEGER) {
+        error = object_get_int(key, &value);
+        simple_error_check(error);
+        uint64_t wide = (uint64_t)(int64_t)value;
+        for (size_t i = 0; i < sizeof bytes; i++) {
+            bytes[i] = (unsigned char)(wide >> (8 * i));
+        }
+        *result = simple_mapped_hashtable_fnv1a(
+            SIMPLE_MAPPED_HASHTABLE_FNV_OFFSET, bytes, sizeof bytes);
+    } else {
+        error = object_get_string(key, &string);
+        simple_error_check(error);
+        *result = simple_mapped_hashtable_fnv1a(
+            SIMPLE_MAPPED_HASHTABLE_FNV_OFFSET,
+            (const unsigned char *)simple_string_get(string),
+            simple_string_get_length(string));
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_mapped_hashtable_get_size(
+    const struct object *o,
+    size_t *result
+) {
+    struct simple_error *error = NULL;
+    struct simple_string *string;
+
+    if (object_get_kind(o) == OBJECT_INTEGER) {
+        *result = sizeof(struct simple_mapped_hashtable_value) +
+            sizeof(int64_t);
+    } else if (object_get_kind(o) == OBJECT_STRING) {
+        error = object_get_string(o, &string);
+        simple_error_check(error);
+        *result = sizeof(struct simple_mapped_hashtable_value) +
+            simple_mapped_hashtable_align(
+            simple_string_get_length(string) + 1);
+    } else {
+        error = simple_error_new("Cannot map a %s, only ints and strings.",
+            object_kind_get_name(object_get_kind(o)));
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_mapped_hashtable_write_value(
+    FILE *file,
+    const struct object *o
+) {
+    struct simple_error *error = NULL;
+    struct simple_mapped_hashtable_value header = {.reserved = 0};
+    struct simple_string *string;
+    int value;
+
+    if (object_get_kind(o) == OBJECT_INTEGER) {
+        error = object_get_int(o, &value);
+        simple_error_check(error);
+        int64_t wide = value;
+        header.tag = SIMPLE_MAPPED_HASHTABLE_INT;
+        header.length = sizeof wide;
+        fwrite(&header, sizeof header, 1, file);
+        fwrite(&wide, sizeof wide, 1, file);
+    } else {
+        error = object_get_string(o, &string);
+        simple_error_check(error);
+        size_t length = simple_string_get_length(string);
+        header.tag = SIMPLE_MAPPED_HASHTABLE_STRING;
+        header.length = length;
+        fwrite(&header, sizeof header, 1, file);
+        fwrite(simple_string_get(string), 1, length + 1, file);
+        fwrite(simple_mapped_hashtable_zeros, 1,
+            simple_mapped_hashtable_align(length + 1) - length - 1, file);
+    }
+
+    cleanup:
+    return error;
+}
+
+// writes the '\0' terminated name of type, aligned
+static struct simple_error *simple_mapped_hashtable_write_name(
+    FILE *file,
+    const struct type *type
+) {
+    const char *name;
+    struct simple_error *error = type_get_name(type, &name);
+    simple_error_check(error);
+
+    size_t length = strlen(name) + 1;
+    fwrite(name, 1, length, file);
+    fwrite(simple_mapped_hashtable_zeros, 1,
+        simple_mapped_hashtable_align(length) - length, file);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_mapped_hashtable_get_name_size(
+    const struct type *type,
+    size_t *result
+) {
+    const char *name;
+    struct simple_error *error = type_get_name(type, &name);
+    simple_error_check(error);
+
+    *result = simple_mapped_hashtable_align(strlen(name) + 1);
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_mapped_hashtable_write(
+    const struct simple_hashtable *table,
+    FILE *file
+) {
+    struct simple_error *error = NULL;
+    struct simple_mapped_hashtable_slot *slots = NULL;
+    struct simple_hashtable_iterator iterator;
+    const struct object *key, *value;
+    size_t key_size, value_size;
+
+    struct simple_mapped_hashtable_header header = {
+        .version = SIMPLE_MAPPED_HASHTABLE_VERSION,
+        .byte_order = SIMPLE_MAPPED_HASHTABLE_BYTE_ORDER,
+        .hash_function = SIMPLE_MAPPED_HASHTABLE_HASH_FNV1A,
+        .size = simple_hashtable_size(table),
+        .slot_count = SIMPLE_MAPPED_HASHTABLE_MIN_SLOTS
+    };
+    memcpy(header.magic, SIMPLE_MAPPED_HASHTABLE_MAGIC, sizeof header.magic);
+    double load_factor = SIMPLE_MAPPED_HASHTABLE_MAX_LOAD_FACTOR;
+    while ((double)header.size > (double)header.slot_count * load_factor) {
+        header.slot_count *= 2;
+    }
+
+    header.key_type = sizeof header;
+    error = simple_mapped_hashtable_get_name_size(
+        simple_hashtable_get_key_type(table), &key_size);
+    simple_error_check(error);
+    header.value_type = header.key_type + key_size;
+    error = simple_mapped_hashtable_get_name_size(
+        simple_hashtable_get_value_type(table), &value_size);
+    simple_error_check(error);
+    header.slots = header.value_type + value_size;
+
+    // keys and values follow the slots in iteration order
+    size_t slot_count = (size_t)header.slot_count, mask = slot_count - 1;
+    size_t offset = (size_t)header.slots + slot_count * sizeof *slots;
+    slots = calloc(slot_count, sizeof *slots);
+    simple_hashtable_iterator_init(&iterator, table);
+    while (simple_hashtable_iterator_next(&iterator, &key, &value)) {
+        error = simple_mapped_hashtable_get_size(key, &key_size);
+        simple_error_check(error);
+        error = simple_mapped_hashtable_get_size(value, &value_size);
+        simple_error_check(error);
+
+        uint64_t hash;
+        error = simple_mapped_hashtable_hash(key, &hash);
+        simple_error_check(error);
+        size_t index = (size_t)hash & mask;
+        while (slots[index].key) {
+            index = (index + 1) & mask;
+        }
+        slots[index] = (struct simple_mapped_hashtable_slot) {
+            .hash = hash,
+            .key = offset,
+            .value = offset + key_size
+        };
+        offset += key_size + value_size;
+    }
+
+    fwrite(&header, sizeof header, 1, file);
+    error = simple_mapped_hashtable_write_name(file,
+        simple_hashtable_get_key_type(table));
+    simple_error_check(error);
+    error = simple_mapped_hashtable_write_name(file,
+        simple_hashtable_get_value_type(table));
+    simple_error_check(error);
+    fwrite(slots, sizeof *slots, slot_count, file);
+
+    simple_hashtable_iterator_init(&iterator, table);
+    while (simple_hashtable_iterator_next(&iterator, &key, &value)) {
+        error = simple_mapped_hashtable_write_value(file, key);
+        simple_error_check(error);
+        error = simple_mapped_hashtable_write_value(file, value);
+        simple_error_check(error);
+    }
+
+    if (fflush(file) != 0 || ferror(file)) {
+        error = simple_error_new("%s", "Writing the mapped hashtable failed.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    free(slots);
+    return error;
+}
+
+// Finds the type named by the '\0' terminated string at offset.
+static struct simple_error *simple_mapped_hashtable_get_type(
+    const char *data,
+    size_t size,
+    uint64_t offset,
+    const struct type **result
+) {
+    struct simple_error *error = NULL;
+    struct type *type;
+
+    if (offset >= size || !memchr(data + offset, '\0', size - offset)) {
+        error = simple_error_new("%s", "Malformed type in mapped hashtable.");
+        simple_error_check(error);
+    }
+
+    error = type_registry_get_type(data + offset, &type);
+    simple_error_check(error);
+    *result = type;
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_mapped_hashtable_check_header(
+    struct simple_mapped_hashtable *table
+) {
+    struct simple_error *error = NULL;
+    struct simple_mapped_hashtable_header header;
+    size_t size = table->data_size;
+
+    if (size < sizeof header) {
+        error = simple_error_new("%s", "Not a mapped hashtable.");
+        simple_error_check(error);
+    }
+    memcpy(&header, table->data, sizeof header);
+
+    if (memcmp(header.magic, SIMPLE_MAPPED_HASHTABLE_MAGIC,
+            sizeof header.magic) != 0) {
+        error = simple_error_new("%s", "Not a mapped hashtable.");
+        simple_error_check(error);
+    }
+    if (header.version != SIMPLE_MAPPED_HASHTABLE_VERSION) {
+        error = simple_error_new("Unsupported mapped hashtable version %u.",
+            header.version);
+        simple_error_check(error);
+    }
+    if (header.byte_order != SIMPLE_MAPPED_HASHTABLE_BYTE_ORDER) {
+        error = simple_error_new("%s",
+            "The hashtable was written with another byte order.");
+        simple_error_check(error);
+    }
+    if (header.hash_function != SIMPLE_MAPPED_HASHTABLE_HASH_FNV1A) {
+        error = simple_error_new("Unsupported mapped hashtable hash "
+            "function %u.", header.hash_function);
+        simple_error_check(error);
+    }
+
+    // at least one slot stays empty so probing ends
+    size_t slot_size = sizeof(struct simple_mapped_hashtable_slot);
+    if (!header.slot_count || header.slot_count & (header.slot_count - 1) ||
+            header.size >= header.slot_count || header.slots % 8 ||
+            header.slots > size ||
+            header.slot_count > (size - header.slots) / slot_size) {
+        error = simple_error_new("%s", "Malformed mapped hashtable header.");
+        simple_error_check(error);
+    }
+
+    table->size = (size_t)header.size;
+    table->slot_count = (size_t)header.slot_count;
+    table->slots = (size_t)header.slots;
+
+    error = simple_mapped_hashtable_get_type(table->data, size,
+        header.key_type, &table->key_type);
+    simple_error_check(error);
+    error = simple_mapped_hashtable_get_type(table->data, size,
+        header.value_type, &table->value_type);
+    simple_error_check(error);
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_mapped_hashtable_open(
+    const char *path,
+    struct simple_mapped_hashtable **result
+) {
+    struct simple_error *error = NULL;
+    struct simple_mapped_hashtable *table = NULL;
+    void *mapping = MAP_FAILED;
+    struct stat info;
+    size_t size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        error = simple_error_new("Cannot open '%s': %s", path,
+            strerror(errno));
+        simple_error_check(error);
+    }
+    if (fstat(fd, &info) != 0) {
+        error = simple_error_new("Cannot stat '%s': %s", path,
+            strerror(errno));
+        simple_error_check(error);
+    }
+
+    size = (size_t)info.st_size;
+    if (!size) {
+        error = simple_error_new("'%s' is empty.", path);
+        simple_error_check(error);
+    }
+
+    mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        error = simple_error_new("Cannot map '%s': %s", path,
+            strerror(errno));
+        simple_error_check(error);
+    }
+
+    table = calloc(1, sizeof *table);
+    table->mapping = mapping;
+    table->data = mapping;
+    table->data_size = size;
+    error = simple_mapped_hashtable_check_header(table);
+    simple_error_check(error);
+
+    *result = table;
+    table = NULL;
+
+    cleanup:
+    free(table);
+    if (error && mapping != MAP_FAILED) {
+        munmap(mapping, size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    return error;
+}
+
+void simple_mapped_hashtable_destroy(
+    struct simple_mapped_hashtable *table
+) {
+    if (!table) {
+        return;
+    }
+    munmap(table->mapping, table->data_size);
+    free(table);
+}
+
+size_t simple_mapped_hashtable_size(
+    const struct simple_mapped_hashtable *table
+) {
+    return table->size;
+}
+
+// Reads the key or value header at offset and checks that it and its
+// payload, '\0' included for strings, lie within the file.
+static struct simple_error *simple_mapped_hashtable_get_value(
+    const struct simple_mapped_hashtable *table,
+    uint64_t offset,
+    struct simple_mapped_hashtable_value *header,
+    const char **payload
+) {
+    size_t size = table->data_size;
+
+    if (offset % 8 || offset > size || size - offset < sizeof *header) {
+        return simple_error_new("Malformed offset %llu in mapped hashtable.",
+            (unsigned long long)offset);
+    }
+    memcpy(header, table->data + offset, sizeof *header);
+
+    size_t available = size - (size_t)offset - sizeof *header;
+    bool fits = header->tag == SIMPLE_MAPPED_HASHTABLE_INT ?
+        header->length == sizeof(int64_t) && available >= sizeof(int64_t) :
+        header->length < available;
+    if (!fits) {
+        return simple_error_new("Malformed value at %llu in mapped hashtable.",
+            (unsigned long long)offset);
+    }
+    *payload = table->data + offset + sizeof *header;
+    return NULL;
+}
+
+static struct simple_error *simple_mapped_hashtable_key_equals(
+    const struct simple_mapped_hashtable *table,
+    uint64_t offset,
+    const struct object *key,
+    bool *result
+) {
+    struct simple_error *error = NULL;
+    struct simple_mapped_hashtable_value header;
+    struct simple_string *string;
+    const char *payload;
+    int64_t mapped;
+    int value;
+
+    error = simple_mapped_hashtable_get_value(table, offset, &header,
+        &payload);
+    simple_error_check(error);
+
+    *result = false;
+    if (object_get_kind(key) == OBJECT_INTEGER) {
+        error = object_get_int(key, &value);
+        simple_error_check(error);
+        if (header.tag == SIMPLE_MAPPED_HASHTABLE_INT) {
+            memcpy(&mapped, payload, sizeof mapped);
+            *result = mapped == value;
+        }
+    } else {
+        error = object_get_string(key, &string);
+        simple_error_check(error);
+        *result = header.tag == SIMPLE_MAPPED_HASHTABLE_STRING &&
+            header.length == simple_string_get_length(string) &&
+            memcmp(payload, simple_string_get(string),
+            (size_t)header.length) == 0;
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_mapped_hashtable_decode(
+    const struct simple_mapped_hashtable *table,
+    uint64_t offset,
+    struct object **result
+) {
+    struct simple_error *error = NULL;
+    struct simple_mapped_hashtable_value header;
+    const char *payload;
+    int64_t value;
+
+    error = simple_mapped_hashtable_get_value(table, offset, &header,
+        &payload);
+    simple_error_check(error);
+
+    size_t length = (size_t)header.length;
+    if (header.tag == SIMPLE_MAPPED_HASHTABLE_INT) {
+        memcpy(&value, payload, sizeof value);
+        if (value < INT_MIN || value > INT_MAX) {
+            error = simple_error_new("Mapped int %lld out of range.",
+                (long long)value);
+            simple_error_check(error);
+        }
+        error = object_new_int((int)value, result);
+        simple_error_check(error);
+    } else if (header.tag == SIMPLE_MAPPED_HASHTABLE_STRING &&
+            payload[length] == '\0' && !memchr(payload, '\0', length)) {
+        error = object_wrap_string(simple_string_new_view(payload, length),
+            result);
+        simple_error_check(error);
+    } else {
+        error = simple_error_new("Malformed value at %llu in mapped "
+            "hashtable.", (unsigned long long)offset);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+struct simple_result simple_mapped_hashtable_lookup(
+    const struct simple_mapped_hashtable *table,
+    const struct object *key,
+    struct object **result
+) {
+    struct simple_mapped_hashtable_slot slot;
+    struct simple_error *error;
+    bool equals;
+
+    *result = NULL;
+
+    error = object_check_type(key, table->key_type);
+    simple_error_check(error);
+
+    // only ints and strings were written
+    if (object_get_kind(key) != OBJECT_INTEGER &&
+            object_get_kind(key) != OBJECT_STRING) {
+        return (struct simple_result) {SIMPLE_STATUS_NOT_FOUND, NULL};
+    }
+
+    uint64_t hash;
+    error = simple_mapped_hashtable_hash(key, &hash);
+    simple_error_check(error);
+
+    size_t mask = table->slot_count - 1;
+    const char *slots = table->data + table->slots;
+    for (size_t i = 0, index = (size_t)hash & mask; i < table->slot_count;
+            i++, index = (index + 1) & mask) {
+        memcpy(&slot, slots + index * sizeof slot, sizeof slot);
+        if (!slot.key) {
+            break;
+        }
+        if (slot.hash != hash) {
+            continue;
+        }
+
+        error = simple_mapped_hashtable_key_equals(table, slot.key, key,
+            &equals);
+        simple_error_check(error);
+        if (equals) {
+            error = simple_mapped_hashtable_decode(table, slot.value, result);
+            simple_error_check(error);
+            return (struct simple_result) {SIMPLE_STATUS_OK, NULL};
+        }
+    }
+    return (struct simple_result) {SIMPLE_STATUS_NOT_FOUND, NULL};
+
+    cleanup:
+    return (struct simple_result) {SIMPLE_STATUS_ERROR, error};
+}
+
+struct simple_error *simple_mapped_hashtable_find(
+    const struct simple_mapped_hashtable *table,
+    const struct object *key,
+    struct object **result
+) {
+    return simple_mapped_hashtable_lookup(table, key, result).error;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "simple_error.h"
+#include "simple_hashtable.h"
+#include "simple_object.h"
+
+// A read only hashtable laid out for mmap. It is written once from a
+// simple_hashtable and then mapped by any number of processes, which share
+// it through the page cache. Opening costs a map call and a look at the
+// header, lookups probe the mapped memory directly and only allocate the
+// object they return.
+//
+// The file holds a header, the key and value type names, an open
+// addressing slot array with linear probing and the keys and values. A
+// slot is the hash of its key and the offsets of the key and value from
+// the start of the file, a key offset of 0 marks an empty slot. Keys and
+// values are ints and strings, encoded like simple_serial.h values. The
+// format is native byte order.
+//
+// The header names the hash function, so far always 64 bit FNV-1a over the
+// bytes of a string key, or over an int key as 8 little endian bytes. It
+// does not depend on the platform, unlike object_get_hash.
+//
+// Offsets are checked against the file size when they are used, so a
+// damaged file makes lookups fail instead of reading out of bounds.
+
+#define SIMPLE_MAPPED_HASHTABLE_VERSION 2
+
+struct simple_mapped_hashtable;
+
+// Writes table to file, which stays open. Keys and values must be ints or
+// strings.
+struct simple_error *simple_mapped_hashtable_write(
+    const struct simple_hashtable *table,
+    FILE *file
+) __attribute__((warn_unused_result));
+
+// Maps the file at path read only.
+struct simple_error *simple_mapped_hashtable_open(
+    const char *path,
+    struct simple_mapped_hashtable **result
+) __attribute__((warn_unused_result));
+
+// Unmaps the table, strings found in it may no longer be used.
+void simple_mapped_hashtable_destroy(
+    struct simple_mapped_hashtable *table
+);
+
+// Like simple_hashtable_find, found strings are views into the mapping.
+struct simple_error *simple_mapped_hashtable_find(
+    const struct simple_mapped_hashtable *table,
+    const struct object *key,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+// Like simple_hashtable_lookup.
+struct simple_result simple_mapped_hashtable_lookup(
+    const struct simple_mapped_hashtable *table,
+    const struct object *key,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+size_t simple_mapped_hashtable_size(
+    const struct simple_mapped_hashtable *table
+);
@@ -1,8 +1,19 @@
 #include <malloc.h>
+#include <stdatomic.h>
 #include <string.h>
 
+#include "simple_alloc.h"
+#include "simple_array.h"
+#include "simple_bigint.h"
+#include "simple_btree.h"
 #include "simple_error.h"
+#include "simple_hamt.h"
+#include "simple_hash.h"
+#include "simple_hashtable.h"
+#include "simple_list.h"
 #include "simple_object.h"
+#include "simple_profile.h"
+#include "simple_sink.h"
 #include "simple_string.h"
 #include "type.h"
 
@@ -16,6 +27,20 @@ const char *object_kind_get_name(enum object_kind kind) {
             return "function";
         case OBJECT_TYPE:
             return "type";
+        case OBJECT_BIGINT:
+            return "bigint";
+        case OBJECT_ARRAY:
+            return "array";
+        case OBJECT_LIST:
+            return "list";
+        case OBJECT_DICT:
+            return "dict";
+        case OBJECT_FROZEN_DICT:
+            return "frozen_dict";
+        case OBJECT_SORTED_DICT:
+            return "sorted_dict";
+        case OBJECT_SINK:
+            return "sink";
     }
 }
 
@@ -28,10 +53,28 @@ struct object {
         struct simple_string *value_string;
         memberfunc_t value_function;
         struct type *value_type;
+        struct simple_bigint *value_bigint;
+        struct simple_array *value_array;
+        struct simple_list *value_list;
+        struct simple_hashtable *value_dict;
+        struct simple_hamt *value_frozen_dict;
+        struct simple_btree *value_sorted_dict;
+        struct simple_sink *value_sink;
     };
     const struct type *type;
+    // the next older object in object_allocated
+    struct object *allocated_next;
 };
 
+// every object ever created, for heap snapshots
+static _Atomic(struct object *) object_allocated = NULL;
+
+enum object_kind object_get_kind(
+    const struct object *o
+) {
+    return o->kind;
+}
+
 size_t object_get_hash(
     const struct object *o
 ) {
@@ -39,23 +82,64 @@ size_t object_get_hash(
         case OBJECT_STRING:
             return simple_string_hash(o->value_string);
         case OBJECT_INTEGER:
+            return simple_hash_integer((uint64_t)(int64_t)o->value_integer);
+        case OBJECT_BIGINT:
+            return simple_bigint_hash(o->value_bigint);
         case OBJECT_FUNCTION:
         case OBJECT_TYPE:
+        case OBJECT_ARRAY:
+        case OBJECT_LIST:
+        case OBJECT_DICT:
+        case OBJECT_FROZEN_DICT:
+        case OBJECT_SORTED_DICT:
+        case OBJECT_SINK:
             printf("object_get_hash() not defined for this type!\n");
             return 0;
     }
 }
 
+// Objects are never freed, live means referenced. Only counted in builds
+// with SIMPLE_ALLOC_TRACKING.
+static void object_count_live(
+    const struct object *o,
+    long delta
+) {
+#ifdef SIMPLE_ALLOC_TRACKING
+    const char *type_name = "<no type>";
+    if (o->type) {
+        (void)type_get_name(o->type, &type_name);
+    }
+    simple_alloc_live_update(type_name, delta);
+#else
+    (void)o;
+    (void)delta;
+#endif
+}
+
+static void object_track(
+    struct object *o
+) {
+    o->allocated_next = atomic_load_explicit(&object_allocated,
+        memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&object_allocated,
+            &o->allocated_next, o, memory_order_release,
+            memory_order_relaxed)) {
+    }
+}
+
 struct object *object_new(
     enum object_kind kind,
     bool constant,
     const struct type *type
 ) {
     struct object *o = calloc(1, sizeof *o);
+    simple_alloc_record(object_kind_get_name(kind), sizeof *o);
     o->kind = kind;
     o->constant = constant;
     o->type = type;
     o->ref_count = 1;
+    object_count_live(o, 1);
+    object_track(o);
     return o;
 }
 
@@ -84,6 +168,157 @@ struct simple_error *object_new_type(
     return error;
 }
 
+struct simple_error *object_wrap_type(
+    struct type *type,
+    struct object **result
+) {
+    struct simple_error *error;
+    struct type *type_type = NULL;
+
+    error = type_registry_get_type("type", &type_type);
+    simple_error_check(error);
+
+    *result = object_new(OBJECT_TYPE, false, type_type);
+    (*result)->value_type = type;
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *object_new_bigint(
+    struct simple_bigint *value,
+    struct object **result
+) {
+    struct simple_error *error = type_registry_construct("bigint", result);
+    simple_error_check(error);
+
+    (*result)->value_bigint = value;
+
+    cleanup:
+    if (error) {
+        simple_bigint_destroy(value);
+        *result = NULL;
+    }
+    return error;
+}
+
+struct simple_error *object_new_int(
+    int value,
+    struct object **result
+) {
+    struct simple_error *error = type_registry_construct("int", result);
+    simple_error_check(error);
+
+    (*result)->value_integer = value;
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *object_new_array(
+    struct simple_array *value,
+    struct object **result
+) {
+    struct simple_error *error = type_registry_construct("array", result);
+    simple_error_check(error);
+
+    (*result)->value_array = value;
+
+    cleanup:
+    if (error) {
+        simple_array_destroy(value);
+        *result = NULL;
+    }
+    return error;
+}
+
+struct simple_error *object_new_list(
+    struct simple_list *value,
+    struct object **result
+) {
+    struct simple_error *error = type_registry_construct("list", result);
+    simple_error_check(error);
+
+    (*result)->value_list = value;
+
+    cleanup:
+    if (error) {
+        simple_list_destroy(value);
+        *result = NULL;
+    }
+    return error;
+}
+
+struct simple_error *object_new_dict(
+    struct simple_hashtable *value,
+    struct object **result
+) {
+    struct simple_error *error = type_registry_construct("dict", result);
+    simple_error_check(error);
+
+    (*result)->value_dict = value;
+
+    cleanup:
+    if (error) {
+        simple_hashtable_destroy(value);
+        *result = NULL;
+    }
+    return error;
+}
+
+struct simple_error *object_new_frozen_dict(
+    struct simple_hamt *value,
+    struct object **result
+) {
+    struct simple_error *error = type_registry_construct("frozen_dict",
+        result);
+    simple_error_check(error);
+
+    (*result)->value_frozen_dict = value;
+
+    cleanup:
+    if (error) {
+        simple_hamt_release(value);
+        *result = NULL;
+    }
+    return error;
+}
+
+struct simple_error *object_new_sorted_dict(
+    struct simple_btree *value,
+    struct object **result
+) {
+    struct simple_error *error = type_registry_construct("sorted_dict",
+        result);
+    simple_error_check(error);
+
+    (*result)->value_sorted_dict = value;
+
+    cleanup:
+    if (error) {
+        simple_btree_destroy(value);
+        *result = NULL;
+    }
+    return error;
+}
+
+struct simple_error *object_new_sink(
+    struct simple_sink *value,
+    struct object **result
+) {
+    struct simple_error *error = type_registry_construct("sink", result);
+    simple_error_check(error);
+
+    (*result)->value_sink = value;
+
+    cleanup:
+    if (error) {
+        simple_sink_destroy(value);
+        *result = NULL;
+    }
+    return error;
+}
+
 struct simple_error *object_new_function(
     memberfunc_t func,
     struct object **result
@@ -107,20 +342,180 @@ struct simple_error *object_get_int(
 ) {
     if (o->kind != OBJECT_INTEGER) {
         *result = 0;
-        return simple_error_new(__FILE__, __LINE__, __FUNCTION__, "%s",
+        return simple_error_new("%s",
             "Object is not an int.");
     }
     *result = o->value_integer;
     return NULL;
 }
 
-struct simple_error *object_get_string(
+struct simple_error *object_get_bigint(
+    const struct object *o,
+    const struct simple_bigint **result
+) {
+    if (o->kind != OBJECT_BIGINT) {
+        *result = NULL;
+        return simple_error_new("Object is not a bigint but %s",
+            object_kind_get_name(o->kind));
+    }
+    *result = o->value_bigint;
+    return NULL;
+}
+
+struct simple_error *object_get_array(
+    const struct object *o,
+    struct simple_array **result
+) {
+    if (o->kind != OBJECT_ARRAY) {
+        *result = NULL;
+        return simple_error_new("Object is not an array but %s",
+            object_kind_get_name(o->kind));
+    }
+    *result = o->value_array;
+    return NULL;
+}
+
+struct simple_error *object_get_list(
+    const struct object *o,
+    struct simple_list **result
+) {
+    if (o->kind != OBJECT_LIST) {
+        *result = NULL;
+        return simple_error_new("Object is not a list but %s",
+            object_kind_get_name(o->kind));
+    }
+    *result = o->value_list;
+    return NULL;
+}
+
+struct simple_error *object_set_list(
     struct object *o,
+    struct simple_list *value
+) {
+    if (o->kind != OBJECT_LIST) {
+        simple_list_destroy(value);
+        return simple_error_new("Object is not a list but %s",
+            object_kind_get_name(o->kind));
+    }
+    simple_list_destroy(o->value_list);
+    o->value_list = value;
+    return NULL;
+}
+
+struct simple_error *object_get_dict(
+    const struct object *o,
+    struct simple_hashtable **result
+) {
+    if (o->kind != OBJECT_DICT) {
+        *result = NULL;
+        return simple_error_new("Object is not a dict but %s",
+            object_kind_get_name(o->kind));
+    }
+    *result = o->value_dict;
+    return NULL;
+}
+
+struct simple_error *object_set_dict(
+    struct object *o,
+    struct simple_hashtable *value
+) {
+    if (o->kind != OBJECT_DICT) {
+        simple_hashtable_destroy(value);
+        return simple_error_new("Object is not a dict but %s",
+            object_kind_get_name(o->kind));
+    }
+    simple_hashtable_destroy(o->value_dict);
+    o->value_dict = value;
+    return NULL;
+}
+
+struct simple_error *object_get_frozen_dict(
+    const struct object *o,
+    const struct simple_hamt **result
+) {
+    if (o->kind != OBJECT_FROZEN_DICT) {
+        *result = NULL;
+        return simple_error_new("Object is not a frozen_dict but %s",
+            object_kind_get_name(o->kind));
+    }
+    *result = o->value_frozen_dict;
+    return NULL;
+}
+
+struct simple_error *object_set_frozen_dict(
+    struct object *o,
+    struct simple_hamt *value
+) {
+    if (o->kind != OBJECT_FROZEN_DICT) {
+        simple_hamt_release(value);
+        return simple_error_new("Object is not a frozen_dict but %s",
+            object_kind_get_name(o->kind));
+    }
+    simple_hamt_release(o->value_frozen_dict);
+    o->value_frozen_dict = value;
+    return NULL;
+}
+
+struct simple_error *object_get_sorted_dict(
+    const struct object *o,
+    struct simple_btree **result
+) {
+    if (o->kind != OBJECT_SORTED_DICT) {
+        *result = NULL;
+        return simple_error_new("Object is not a sorted_dict but %s",
+            object_kind_get_name(o->kind));
+    }
+    *result = o->value_sorted_dict;
+    return NULL;
+}
+
+struct simple_error *object_set_sorted_dict(
+    struct object *o,
+    struct simple_btree *value
+) {
+    if (o->kind != OBJECT_SORTED_DICT) {
+        simple_btree_destroy(value);
+        return simple_error_new("Object is not a sorted_dict but %s",
+            object_kind_get_name(o->kind));
+    }
+    simple_btree_destroy(o->value_sorted_dict);
+    o->value_sorted_dict = value;
+    return NULL;
+}
+
+struct simple_error *object_get_sink(
+    const struct object *o,
+    struct simple_sink **result
+) {
+    if (o->kind != OBJECT_SINK) {
+        *result = NULL;
+        return simple_error_new("Object is not a sink but %s",
+            object_kind_get_name(o->kind));
+    }
+    *result = o->value_sink;
+    return NULL;
+}
+
+struct simple_error *object_set_sink(
+    struct object *o,
+    struct simple_sink *value
+) {
+    if (o->kind != OBJECT_SINK) {
+        simple_sink_destroy(value);
+        return simple_error_new("Object is not a sink but %s",
+            object_kind_get_name(o->kind));
+    }
+    o->value_sink = value;
+    return NULL;
+}
+
+struct simple_error *object_get_string(
+    const struct object *o,
     struct simple_string **result
 ) {
     if (o->kind != OBJECT_STRING) {
         *result = NULL;
-        return simple_error_new(__FILE__, __LINE__, __FUNCTION__, "%s",
+        return simple_error_new("%s",
             "Object is not a string.");
     }
     *result = o->value_string;
@@ -132,13 +527,41 @@ struct simple_error *object_set_int(
     int value
 ) {
     if (o->kind != OBJECT_INTEGER) {
-        return simple_error_new(__FILE__, __LINE__, __FUNCTION__, "%s",
+        return simple_error_new("%s",
             "Object is not an int.");
     }
     o->value_integer = value;
     return NULL;
 }
 
+struct simple_error *object_set_bigint(
+    struct object *o,
+    struct simple_bigint *value
+) {
+    if (o->kind != OBJECT_BIGINT) {
+        simple_bigint_destroy(value);
+        return simple_error_new("Object is not a bigint but %s",
+            object_kind_get_name(o->kind));
+    }
+    simple_bigint_destroy(o->value_bigint);
+    o->value_bigint = value;
+    return NULL;
+}
+
+struct simple_error *object_set_array(
+    struct object *o,
+    struct simple_array *value
+) {
+    if (o->kind != OBJECT_ARRAY) {
+        simple_array_destroy(value);
+        return simple_error_new("Object is not an array but %s",
+            object_kind_get_name(o->kind));
+    }
+    simple_array_destroy(o->value_array);
+    o->value_array = value;
+    return NULL;
+}
+
 struct simple_error *object_new_string(
     struct object **result,
     const char *format,
@@ -176,22 +599,73 @@ struct simple_error *object_new_string(
     return error;
 }
 
+struct simple_error *object_wrap_string(
+    struct simple_string *value,
+    struct object **result
+) {
+    struct simple_error *error;
+    struct type *string_type;
+
+    error = type_registry_get_string_type(&string_type);
+    simple_error_check(error);
+
+    *result = object_new(OBJECT_STRING, true, string_type);
+    (*result)->value_string = value;
+
+    cleanup:
+    return error;
+}
+
 struct simple_error *object_copy(
     const struct object *o,
     struct object **copy
 ) {
+    *copy = calloc(1, sizeof **copy);
+    simple_alloc_record(object_kind_get_name(o->kind), sizeof **copy);
+    memcpy(*copy, o, sizeof **copy);
+    (*copy)->constant = false;
+    (*copy)->ref_count = 1;
+    object_count_live(*copy, 1);
+    object_track(*copy);
+
     switch (o->kind) {
         case OBJECT_INTEGER:
         case OBJECT_TYPE:
         case OBJECT_FUNCTION:
-        case OBJECT_STRING: {
-            *copy = calloc(1, sizeof **copy);
-            memcpy(*copy, o, sizeof **copy);
+        case OBJECT_SINK:
+            break;
+        case OBJECT_STRING:
             (*copy)->value_string = simple_string_copy(o->value_string);
-            (*copy)->constant = false;
-            return NULL;
-        }
+            break;
+        case OBJECT_BIGINT:
+            (*copy)->value_bigint = simple_bigint_copy(o->value_bigint);
+            break;
+        case OBJECT_ARRAY:
+            (*copy)->value_array = simple_array_copy(o->value_array);
+            break;
+        case OBJECT_LIST:
+            (*copy)->value_list = simple_list_copy(o->value_list);
+            break;
+        case OBJECT_DICT:
+            if (o->value_dict) {
+                return simple_hashtable_copy(o->value_dict,
+                    &(*copy)->value_dict);
+            }
+            break;
+        case OBJECT_FROZEN_DICT:
+            if (o->value_frozen_dict) {
+                (*copy)->value_frozen_dict = simple_hamt_share(
+                    o->value_frozen_dict);
+            }
+            break;
+        case OBJECT_SORTED_DICT:
+            if (o->value_sorted_dict) {
+                return simple_btree_copy(o->value_sorted_dict,
+                    &(*copy)->value_sorted_dict);
+            }
+            break;
     }
+    return NULL;
 }
 
 struct simple_error *object_has_type(
@@ -246,6 +720,30 @@ struct simple_error *object_check_type(
     return error;
 }
 
+static bool object_is_numeric(
+    const struct object *o
+) {
+    return o->kind == OBJECT_INTEGER || o->kind == OBJECT_BIGINT;
+}
+
+// ints and bigints holding the same value are equal and hash the same
+static bool object_numeric_equals(
+    const struct object *lhs,
+    const struct object *rhs
+) {
+    const struct object *small = lhs, *big = rhs;
+    if (lhs->kind == OBJECT_BIGINT) {
+        small = rhs;
+        big = lhs;
+    }
+
+    int64_t value;
+    if (!simple_bigint_get_int64(big->value_bigint, &value)) {
+        return false;
+    }
+    return value == small->value_integer;
+}
+
 struct simple_error *object_equals(
     const struct object *lhs,
     const struct object *rhs,
@@ -257,15 +755,20 @@ struct simple_error *object_equals(
     error = type_get_name(lhs->type, &lhs_type_name);
     simple_error_check(error);
 
+    if (object_is_numeric(lhs) && object_is_numeric(rhs) &&
+            lhs->kind != rhs->kind) {
+        *result = object_numeric_equals(lhs, rhs);
+        goto cleanup;
+    }
+
     if (lhs->type != rhs->type) {
 
         const char *rhs_type_name;
         error = type_get_name(rhs->type, &rhs_type_name);
         simple_error_check(error);
 
-        error = simple_error_new(__FILE__, __LINE__, __FUNCTION__,
-            "Cannot check objects with different types '%s' and '%s' "
-            "for equality", lhs_type_name, rhs_type_name);
+        error = simple_error_new("Cannot check objects with different "
+            "types '%s' and '%s' for equality", lhs_type_name, rhs_type_name);
         simple_error_check(error);
     }
 
@@ -277,11 +780,41 @@ struct simple_error *object_equals(
             *result = simple_string_equals(lhs->value_string,
                 rhs->value_string);
             break;
+        case OBJECT_BIGINT:
+            *result = simple_bigint_equals(lhs->value_bigint,
+                rhs->value_bigint);
+            break;
+        case OBJECT_ARRAY:
+            *result = simple_array_equals(lhs->value_array,
+                rhs->value_array);
+            break;
+        case OBJECT_LIST:
+            error = simple_list_equals(lhs->value_list, rhs->value_list,
+                result);
+            simple_error_check(error);
+            break;
+        case OBJECT_DICT:
+            error = simple_hashtable_equals(lhs->value_dict, rhs->value_dict,
+                result);
+            simple_error_check(error);
+            break;
+        case OBJECT_FROZEN_DICT:
+            error = simple_hamt_equals(lhs->value_frozen_dict,
+                rhs->value_frozen_dict, result);
+            simple_error_check(error);
+            break;
+        case OBJECT_SORTED_DICT:
+            error = simple_btree_equals(lhs->value_sorted_dict,
+                rhs->value_sorted_dict, result);
+            simple_error_check(error);
+            break;
+        case OBJECT_SINK:
+            *result = lhs->value_sink == rhs->value_sink;
+            break;
         case OBJECT_FUNCTION:
         case OBJECT_TYPE: {
-            error = simple_error_new(__FILE__, __LINE__, __FUNCTION__,
-                "object_equals() is not implemented for type '%s'.",
-                lhs_type_name);
+            error = simple_error_new("object_equals() is not implemented "
+                "for type '%s'.", lhs_type_name);
         }
     }
 
@@ -292,6 +825,59 @@ struct simple_error *object_equals(
     return error;
 }
 
+struct simple_error *object_compare(
+    const struct object *lhs,
+    const struct object *rhs,
+    int *result
+) {
+    struct simple_error *error = NULL;
+    const char *lhs_type_name, *rhs_type_name;
+
+    *result = 0;
+
+    if (object_is_numeric(lhs) && object_is_numeric(rhs)) {
+        if (lhs->kind == OBJECT_INTEGER && rhs->kind == OBJECT_INTEGER) {
+            *result = (lhs->value_integer > rhs->value_integer) -
+                (lhs->value_integer < rhs->value_integer);
+            goto cleanup;
+        }
+
+        // widen the int side, mixed comparisons are rare
+        struct simple_bigint *lhs_big = lhs->kind == OBJECT_BIGINT ?
+            lhs->value_bigint : simple_bigint_new(lhs->value_integer);
+        struct simple_bigint *rhs_big = rhs->kind == OBJECT_BIGINT ?
+            rhs->value_bigint : simple_bigint_new(rhs->value_integer);
+
+        *result = simple_bigint_compare(lhs_big, rhs_big);
+
+        if (lhs->kind == OBJECT_INTEGER) {
+            simple_bigint_destroy(lhs_big);
+        }
+        if (rhs->kind == OBJECT_INTEGER) {
+            simple_bigint_destroy(rhs_big);
+        }
+        goto cleanup;
+    }
+
+    error = type_get_name(lhs->type, &lhs_type_name);
+    simple_error_check(error);
+
+    error = type_get_name(rhs->type, &rhs_type_name);
+    simple_error_check(error);
+
+    if (lhs->kind != OBJECT_STRING || rhs->kind != OBJECT_STRING) {
+        error = simple_error_new("Cannot order objects of types '%s' and "
+            "'%s'.", lhs_type_name, rhs_type_name);
+        simple_error_check(error);
+    }
+
+    *result = strcmp(simple_string_get(lhs->value_string),
+        simple_string_get(rhs->value_string));
+
+    cleanup:
+    return error;
+}
+
 struct simple_error *object_get_type(
     const struct object *o,
     struct type **result
@@ -311,7 +897,9 @@ void object_refcount_decrease(
     if (!o) {
         return;
     }
-    o->ref_count--;
+    if (--o->ref_count == 0) {
+        object_count_live(o, -1);
+    }
 }
 
 void object_refcount_increase(
@@ -320,5 +908,209 @@ void object_refcount_increase(
     if (!o) {
         return;
     }
-    o->ref_count++;
+    if (o->ref_count++ == 0) {
+        object_count_live(o, 1);
+    }
+}
+
+int object_get_refcount(
+    const struct object *o
+) {
+    return o->ref_count;
+}
+
+const struct type *object_type(
+    const struct object *o
+) {
+    return o->type;
+}
+
+struct simple_error *object_foreach_allocated(
+    object_visit_func func,
+    void *context
+) {
+    struct simple_error *error = NULL;
+    const struct object *o = atomic_load_explicit(&object_allocated,
+        memory_order_acquire);
+
+    for (; o && !error; o = o->allocated_next) {
+        error = func(o, context);
+    }
+    return error;
+}
+
+struct object_reference_visit {
+    object_visit_func func;
+    void *context;
+};
+
+// adapts the key value visitors of the maps to object_visit_func
+static struct simple_error *object_visit_entry(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    const struct object_reference_visit *visit = context;
+    struct simple_error *error = visit->func(key, visit->context);
+    if (!error) {
+        error = visit->func(value, visit->context);
+    }
+    return error;
+}
+
+struct simple_error *object_foreach_reference(
+    const struct object *o,
+    object_visit_func func,
+    void *context
+) {
+    struct simple_error *error = NULL;
+    struct object_reference_visit visit = {func, context};
+    struct simple_hamt *attributes = NULL;
+
+    switch (o->kind) {
+        case OBJECT_INTEGER:
+        case OBJECT_STRING:
+        case OBJECT_FUNCTION:
+        case OBJECT_BIGINT:
+        case OBJECT_ARRAY:
+        case OBJECT_SINK:
+            break;
+        case OBJECT_TYPE:
+            error = type_get_attributes(o->value_type, &attributes);
+            simple_error_check(error);
+            error = simple_hamt_foreach(attributes, object_visit_entry,
+                &visit);
+            simple_error_check(error);
+            break;
+        case OBJECT_LIST:
+            for (size_t i = 0; o->value_list &&
+                    i < simple_list_size(o->value_list); i++) {
+                struct object *element;
+                error = simple_list_get(o->value_list, i, &element);
+                simple_error_check(error);
+                error = func(element, context);
+                simple_error_check(error);
+            }
+            break;
+        case OBJECT_DICT:
+            if (o->value_dict) {
+                error = simple_hashtable_foreach(o->value_dict,
+                    object_visit_entry, &visit);
+                simple_error_check(error);
+            }
+            break;
+        case OBJECT_FROZEN_DICT:
+            if (o->value_frozen_dict) {
+                error = simple_hamt_foreach(o->value_frozen_dict,
+                    object_visit_entry, &visit);
+                simple_error_check(error);
+            }
+            break;
+        case OBJECT_SORTED_DICT:
+            if (o->value_sorted_dict) {
+                error = simple_btree_foreach(o->value_sorted_dict,
+                    object_visit_entry, &visit);
+                simple_error_check(error);
+            }
+            break;
+    }
+
+    cleanup:
+    simple_hamt_release(attributes);
+    return error;
+}
+
+size_t object_get_memory(
+    const struct object *o
+) {
+    size_t size = sizeof *o;
+
+    switch (o->kind) {
+        case OBJECT_INTEGER:
+        case OBJECT_FUNCTION:
+        case OBJECT_TYPE:
+        case OBJECT_SINK:
+            break;
+        case OBJECT_STRING:
+            if (o->value_string) {
+                size += sizeof(char *) + sizeof(size_t) +
+                    simple_string_get_length(o->value_string) + 1;
+            }
+            break;
+        case OBJECT_BIGINT:
+            if (o->value_bigint) {
+                size += simple_bigint_limb_count(o->value_bigint) *
+                    sizeof(uint64_t);
+            }
+            break;
+        case OBJECT_ARRAY:
+            if (o->value_array) {
+                size += simple_array_length(o->value_array) *
+                    (simple_array_get_element(o->value_array) ==
+                    SIMPLE_ARRAY_INT32 ? sizeof(int32_t) : sizeof(int64_t));
+            }
+            break;
+        case OBJECT_LIST:
+            if (o->value_list) {
+                size += simple_list_capacity(o->value_list) *
+                    sizeof(struct object *);
+            }
+            break;
+        case OBJECT_DICT:
+            if (o->value_dict) {
+                size += simple_hashtable_get_memory(o->value_dict);
+            }
+            break;
+        case OBJECT_FROZEN_DICT:
+            if (o->value_frozen_dict) {
+                size += simple_hamt_size(o->value_frozen_dict) * 2 *
+                    sizeof(struct object *);
+            }
+            break;
+        case OBJECT_SORTED_DICT:
+            if (o->value_sorted_dict) {
+                size += simple_btree_size(o->value_sorted_dict) * 2 *
+                    sizeof(struct object *);
+            }
+            break;
+    }
+    return size;
+}
+
+struct simple_error *object_call_method(
+    struct object *o,
+    const char *name,
+    const struct object *args,
+    struct object **result
+) {
+    struct simple_error *error;
+    struct object *method = NULL;
+    const char *type_name;
+
+    *result = NULL;
+
+    error = type_get_name(o->type, &type_name);
+    if (error) {
+        return error;
+    }
+
+    // the lookup counts towards the method in profiles
+    simple_profile_push(type_name, name);
+
+    error = type_get_attribute(o->type, name, &method);
+    simple_error_check(error);
+
+    if (method->kind != OBJECT_FUNCTION) {
+        error = simple_error_new("Attribute '%s' of type '%s' is not a "
+            "function.", name, type_name);
+        simple_error_check(error);
+    }
+
+    error = method->value_function(o, args, result);
+    simple_error_check(error);
+
+    cleanup:
+    simple_profile_pop();
+    object_refcount_decrease(method);
+    return error;
 }
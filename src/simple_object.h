@@ -3,7 +3,14 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+struct simple_array;
+struct simple_bigint;
+struct simple_btree;
 struct simple_error;
+struct simple_hamt;
+struct simple_hashtable;
+struct simple_list;
+struct simple_sink;
 struct simple_string;
 struct object;
 struct type;
@@ -14,17 +21,34 @@ typedef struct simple_error *(*memberfunc_t)(
     struct object **result
 );
 
+// Returning an error stops the iteration.
+typedef struct simple_error *(*object_visit_func)(
+    const struct object *o,
+    void *context
+);
+
 enum object_kind {
     OBJECT_INTEGER,
     OBJECT_STRING,
     OBJECT_FUNCTION,
     OBJECT_TYPE,
+    OBJECT_BIGINT,
+    OBJECT_ARRAY,
+    OBJECT_LIST,
+    OBJECT_DICT,
+    OBJECT_FROZEN_DICT,
+    OBJECT_SORTED_DICT,
+    OBJECT_SINK,
 };
 
 const char *object_kind_get_name(
     enum object_kind kind
 );
 
+enum object_kind object_get_kind(
+    const struct object *o
+);
+
 struct object *object_new(
     enum object_kind kind,
     bool constant,
@@ -36,6 +60,42 @@ struct simple_error *object_new_int(
     struct object **result
 ) __attribute__((warn_unused_result));
 
+struct simple_error *object_new_bigint(
+    struct simple_bigint *value,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_new_array(
+    struct simple_array *value,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_new_list(
+    struct simple_list *value,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_new_dict(
+    struct simple_hashtable *value,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_new_frozen_dict(
+    struct simple_hamt *value,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_new_sorted_dict(
+    struct simple_btree *value,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+// Copies of the object write to the same sink.
+struct simple_error *object_new_sink(
+    struct simple_sink *value,
+    struct object **result
+) __attribute__((warn_unused_result));
+
 struct simple_error *object_new_function(
     memberfunc_t value,
     struct object **result
@@ -47,6 +107,12 @@ struct simple_error *object_new_string(
     ...
 ) __attribute__((warn_unused_result));
 
+// Takes ownership of value.
+struct simple_error *object_wrap_string(
+    struct simple_string *value,
+    struct object **result
+) __attribute__((warn_unused_result));
+
 struct simple_error *object_copy(
     const struct object *o,
     struct object **copy
@@ -58,6 +124,11 @@ struct simple_error *object_new_type(
     struct object **result
 ) __attribute__((warn_unused_result));
 
+struct simple_error *object_wrap_type(
+    struct type *type,
+    struct object **result
+) __attribute__((warn_unused_result));
+
 void object_refcount_increase(
     struct object *o
 );
@@ -78,9 +149,35 @@ struct simple_error *object_check_type(
 );
 
 const struct type *object_type(
-    struct object *o
+    const struct object *o
 ) __attribute__((warn_unused_result));
 
+int object_get_refcount(
+    const struct object *o
+);
+
+// Visits every object ever created, newest first. Objects are never freed,
+// so this includes those nothing references anymore. Objects created
+// during the iteration may or may not be visited.
+struct simple_error *object_foreach_allocated(
+    object_visit_func func,
+    void *context
+) __attribute__((warn_unused_result));
+
+// Visits the objects o holds directly, like the elements of a list or the
+// keys and values of a dict. Types visit their attributes.
+struct simple_error *object_foreach_reference(
+    const struct object *o,
+    object_visit_func func,
+    void *context
+) __attribute__((warn_unused_result));
+
+// Bytes held by o itself, without the objects it references. Frozen and
+// sorted dicts may share nodes, their size is estimated from their entries.
+size_t object_get_memory(
+    const struct object *o
+);
+
 size_t object_get_hash(
     const struct object *o
 );
@@ -91,6 +188,14 @@ struct simple_error *object_equals(
     bool *result
 );
 
+// Negative, zero or positive like strcmp. Numbers compare by value and
+// strings bytewise, other kinds have no order.
+struct simple_error *object_compare(
+    const struct object *lhs,
+    const struct object *rhs,
+    int *result
+) __attribute__((warn_unused_result));
+
 struct simple_error *object_get_int(
     const struct object *o,
     int *result
@@ -101,6 +206,78 @@ struct simple_error *object_set_int(
     int value
 ) __attribute__((warn_unused_result));
 
+struct simple_error *object_get_bigint(
+    const struct object *o,
+    const struct simple_bigint **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_set_bigint(
+    struct object *o,
+    struct simple_bigint *value
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_get_array(
+    const struct object *o,
+    struct simple_array **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_set_array(
+    struct object *o,
+    struct simple_array *value
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_get_list(
+    const struct object *o,
+    struct simple_list **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_set_list(
+    struct object *o,
+    struct simple_list *value
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_get_dict(
+    const struct object *o,
+    struct simple_hashtable **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_set_dict(
+    struct object *o,
+    struct simple_hashtable *value
+) __attribute__((warn_unused_result));
+
+// The result is borrowed, use simple_hamt_share to keep it.
+struct simple_error *object_get_frozen_dict(
+    const struct object *o,
+    const struct simple_hamt **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_set_frozen_dict(
+    struct object *o,
+    struct simple_hamt *value
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_get_sorted_dict(
+    const struct object *o,
+    struct simple_btree **result
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_set_sorted_dict(
+    struct object *o,
+    struct simple_btree *value
+) __attribute__((warn_unused_result));
+
+struct simple_error *object_get_sink(
+    const struct object *o,
+    struct simple_sink **result
+) __attribute__((warn_unused_result));
+
+// The previous sink is not destroyed, copies may still write to it.
+struct simple_error *object_set_sink(
+    struct object *o,
+    struct simple_sink *value
+) __attribute__((warn_unused_result));
+
 struct simple_error *object_get_type(
     const struct object *o,
     struct type **result
@@ -108,6 +285,14 @@ struct simple_error *object_get_type(
 
 
 struct simple_error *object_get_string(
-    struct object *o,
+    const struct object *o,
     struct simple_string **result
 ) __attribute__((warn_unused_result));
+
+// Calls the member function name of the type of o.
+struct simple_error *object_call_method(
+    struct object *o,
+    const char *name,
+    const struct object *args,
+    struct object **result
+) __attribute__((warn_unused_result));
@@ -0,0 +1,172 @@
+#define _DEFAULT_SOURCE
+
+#include "simple_perf.h"
+
+#include <malloc.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+struct simple_perf {
+    int fds[SIMPLE_PERF_COUNTER_COUNT];
+};
+
+// read format of a single counter with PERF_FORMAT_TOTAL_TIME_*
+struct simple_perf_reading {
+    uint64_t value;
+    uint64_t time_enabled;
+    uint64_t time_running;
+};
+
+static const char *simple_perf_counter_names[SIMPLE_PERF_COUNTER_COUNT] = {
+    "cycles",
+    "instructions",
+    "l1d_misses",
+    "llc_misses",
+    "branch_misses"
+};
+
+#ifdef __linux__
+static int simple_perf_open(
+    enum simple_perf_counter counter
+) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+        PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (counter) {
+        case SIMPLE_PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case SIMPLE_PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case SIMPLE_PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case SIMPLE_PERF_LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case SIMPLE_PERF_BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case SIMPLE_PERF_COUNTER_COUNT:
+            return -1;
+    }
+
+    // counters are not grouped, a group fails as a whole when one of its
+    // members is missing
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+struct simple_perf *simple_perf_new(
+    void
+) {
+    struct simple_perf *perf = calloc(1, sizeof *perf);
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+#ifdef __linux__
+        perf->fds[i] = simple_perf_open((enum simple_perf_counter)i);
+#else
+        perf->fds[i] = -1;
+#endif
+    }
+    return perf;
+}
+
+void simple_perf_destroy(
+    struct simple_perf *perf
+) {
+    if (!perf) {
+        return;
+    }
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+        if (perf->fds[i] >= 0) {
+            close(perf->fds[i]);
+        }
+    }
+    free(perf);
+}
+
+bool simple_perf_available(
+    const struct simple_perf *perf
+) {
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+        if (perf->fds[i] >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void simple_perf_start(
+    struct simple_perf *perf
+) {
+#ifdef __linux__
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+        if (perf->fds[i] >= 0) {
+            ioctl(perf->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)perf;
+#endif
+}
+
+void simple_perf_stop(
+    struct simple_perf *perf,
+    struct simple_perf_counts *result
+) {
+    memset(result, 0, sizeof *result);
+
+#ifdef __linux__
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+        if (perf->fds[i] >= 0) {
+            ioctl(perf->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+        struct simple_perf_reading reading;
+        if (perf->fds[i] < 0 ||
+                read(perf->fds[i], &reading, sizeof reading) !=
+                (ssize_t)sizeof reading || !reading.time_running) {
+            continue;
+        }
+
+        double scale = (double)reading.time_enabled /
+            (double)reading.time_running;
+        result->values[i] = (uint64_t)((double)reading.value * scale);
+        result->counted[i] = true;
+    }
+#else
+    (void)perf;
+#endif
+}
+
+const char *simple_perf_counter_get_name(
+    enum simple_perf_counter counter
+) {
+    if (counter >= SIMPLE_PERF_COUNTER_COUNT) {
+        return "<unknown counter>";
+    }
+    return simple_perf_counter_names[counter];
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Hardware performance counters of the calling thread, opened with
+// perf_event_open on Linux. Counters the kernel or the cpu does not
+// provide stay closed and are reported as not counted, which includes
+// every counter on other systems or when perf_event_paranoid forbids it.
+// Counting excludes the kernel so it works for unprivileged users.
+
+enum simple_perf_counter {
+    SIMPLE_PERF_CYCLES,
+    SIMPLE_PERF_INSTRUCTIONS,
+    SIMPLE_PERF_L1D_MISSES,
+    SIMPLE_PERF_LLC_MISSES,
+    SIMPLE_PERF_BRANCH_MISSES,
+    SIMPLE_PERF_COUNTER_COUNT
+};
+
+struct simple_perf;
+
+// Counts between start and stop. Values are scaled up when the kernel had
+// to multiplex the counter with others.
+struct simple_perf_counts {
+    uint64_t values[SIMPLE_PERF_COUNTER_COUNT];
+    bool counted[SIMPLE_PERF_COUNTER_COUNT];
+};
+
+// Never fails, check simple_perf_available for whether anything counts.
+struct simple_perf *simple_perf_new(
+    void
+) __attribute__((warn_unused_result));
+
+void simple_perf_destroy(
+    struct simple_perf *perf
+);
+
+bool simple_perf_available(
+    const struct simple_perf *perf
+);
+
+// Resets and enables all open counters.
+void simple_perf_start(
+    struct simple_perf *perf
+);
+
+void simple_perf_stop(
+    struct simple_perf *perf,
+    struct simple_perf_counts *result
+);
+
+const char *simple_perf_counter_get_name(
+    enum simple_perf_counter counter
+);
@@ -0,0 +1,280 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "simple_profile.h"
+
+#include <errno.h>
+#include <malloc.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct simple_profile_frame {
+    const char *type_name;
+    const char *name;
+};
+
+// Only the owning thread and signal handlers running on it touch a stack,
+// the signal fences keep the compiler from reordering around them.
+struct simple_profile_stack {
+    size_t depth;
+    struct simple_profile_frame frames[SIMPLE_PROFILE_MAX_DEPTH];
+};
+
+struct simple_profile_sample {
+    size_t depth;
+    struct simple_profile_frame frames[SIMPLE_PROFILE_MAX_DEPTH];
+};
+
+static _Thread_local struct simple_profile_stack simple_profile_stack;
+
+static struct simple_profile_sample *simple_profile_samples;
+static size_t simple_profile_capacity;
+static atomic_size_t simple_profile_used;
+static atomic_size_t simple_profile_dropped;
+
+static bool simple_profile_running;
+static timer_t simple_profile_timer;
+static struct sigaction simple_profile_previous;
+
+void simple_profile_push(
+    const char *type_name,
+    const char *name
+) {
+    struct simple_profile_stack *stack = &simple_profile_stack;
+    if (stack->depth < SIMPLE_PROFILE_MAX_DEPTH) {
+        stack->frames[stack->depth] = (struct simple_profile_frame) {
+            .type_name = type_name,
+            .name = name
+        };
+    }
+    atomic_signal_fence(memory_order_release);
+    stack->depth++;
+}
+
+void simple_profile_pop(
+    void
+) {
+    simple_profile_stack.depth--;
+    atomic_signal_fence(memory_order_release);
+}
+
+static void simple_profile_handler(
+    int signal,
+    siginfo_t *info,
+    void *context
+) {
+    (void)signal;
+    (void)info;
+    (void)context;
+
+    // several threads may take a sample at once
+    size_t index = atomic_fetch_add(&simple_profile_used, 1);
+    if (index >= simple_profile_capacity) {
+        atomic_fetch_add(&simple_profile_dropped, 1);
+        return;
+    }
+
+    atomic_signal_fence(memory_order_acquire);
+    const struct simple_profile_stack *stack = &simple_profile_stack;
+    struct simple_profile_sample *sample = simple_profile_samples + index;
+    sample->depth = stack->depth;
+
+    size_t recorded = stack->depth < SIMPLE_PROFILE_MAX_DEPTH ?
+        stack->depth : SIMPLE_PROFILE_MAX_DEPTH;
+    for (size_t i = 0; i < recorded; i++) {
+        sample->frames[i] = stack->frames[i];
+    }
+}
+
+struct simple_error *simple_profile_start(
+    unsigned frequency,
+    size_t capacity
+) {
+    struct simple_error *error = NULL;
+    bool handler_installed = false;
+
+    if (simple_profile_running) {
+        error = simple_error_new("%s", "The profiler is already running.");
+        simple_error_check(error);
+    }
+
+    frequency = frequency ? frequency : SIMPLE_PROFILE_DEFAULT_FREQUENCY;
+    capacity = capacity ? capacity : SIMPLE_PROFILE_DEFAULT_CAPACITY;
+
+    free(simple_profile_samples);
+    simple_profile_samples = calloc(capacity, sizeof *simple_profile_samples);
+    simple_profile_capacity = capacity;
+    atomic_store(&simple_profile_used, 0);
+    atomic_store(&simple_profile_dropped, 0);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof action);
+    action.sa_sigaction = simple_profile_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &simple_profile_previous) != 0) {
+        error = simple_error_new("Cannot install the SIGPROF handler: %s",
+            strerror(errno));
+        simple_error_check(error);
+    }
+    handler_installed = true;
+
+    struct sigevent event;
+    memset(&event, 0, sizeof event);
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+    if (timer_create(CLOCK_PROCESS_CPUTIME_ID, &event,
+            &simple_profile_timer) != 0) {
+        error = simple_error_new("Cannot create the profiling timer: %s",
+            strerror(errno));
+        simple_error_check(error);
+    }
+
+    long interval = 1000000000L / (long)frequency;
+    struct itimerspec spec = {
+        .it_interval = {interval / 1000000000L, interval % 1000000000L},
+        .it_value = {interval / 1000000000L, interval % 1000000000L}
+    };
+    if (timer_settime(simple_profile_timer, 0, &spec, NULL) != 0) {
+        error = simple_error_new("Cannot start the profiling timer: %s",
+            strerror(errno));
+        timer_delete(simple_profile_timer);
+        simple_error_check(error);
+    }
+
+    simple_profile_running = true;
+
+    cleanup:
+    if (error && handler_installed) {
+        sigaction(SIGPROF, &simple_profile_previous, NULL);
+    }
+    return error;
+}
+
+void simple_profile_stop(
+    void
+) {
+    if (!simple_profile_running) {
+        return;
+    }
+
+    // a SIGPROF may still be pending after the timer is gone, ignoring the
+    // signal discards it before the previous action can see it
+    struct sigaction ignore;
+    memset(&ignore, 0, sizeof ignore);
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+
+    timer_delete(simple_profile_timer);
+    sigaction(SIGPROF, &ignore, NULL);
+    sigaction(SIGPROF, &simple_profile_previous, NULL);
+    simple_profile_running = false;
+}
+
+static size_t simple_profile_recorded(
+    const struct simple_profile_sample *sample
+) {
+    return sample->depth < SIMPLE_PROFILE_MAX_DEPTH ? sample->depth :
+        SIMPLE_PROFILE_MAX_DEPTH;
+}
+
+// folds the stack of sample into buff, truncating at buff_len
+static void simple_profile_fold(
+    const struct simple_profile_sample *sample,
+    char *buff,
+    size_t buff_len
+) {
+    size_t used = 0;
+    size_t recorded = simple_profile_recorded(sample);
+
+    buff[0] = '\0';
+    if (!recorded) {
+        snprintf(buff, buff_len, "%s", "<native>");
+        return;
+    }
+
+    for (size_t i = 0; i < recorded && used < buff_len; i++) {
+        int length = snprintf(buff + used, buff_len - used, "%s%s.%s",
+            i ? ";" : "", sample->frames[i].type_name,
+            sample->frames[i].name);
+        used += length > 0 ? (size_t)length : 0;
+    }
+    if (sample->depth > recorded && used < buff_len) {
+        snprintf(buff + used, buff_len - used, "%s", ";<truncated>");
+    }
+}
+
+// orders samples by their recorded frames, equal stacks end up adjacent
+static int simple_profile_compare_samples(
+    const void *lhs,
+    const void *rhs
+) {
+    const struct simple_profile_sample *a, *b;
+    a = *(const struct simple_profile_sample *const *)lhs;
+    b = *(const struct simple_profile_sample *const *)rhs;
+    size_t a_recorded = simple_profile_recorded(a);
+    size_t b_recorded = simple_profile_recorded(b);
+
+    for (size_t i = 0; i < a_recorded && i < b_recorded; i++) {
+        int order = strcmp(a->frames[i].type_name, b->frames[i].type_name);
+        if (!order) {
+            order = strcmp(a->frames[i].name, b->frames[i].name);
+        }
+        if (order) {
+            return order;
+        }
+    }
+    if (a_recorded != b_recorded) {
+        return a_recorded < b_recorded ? -1 : 1;
+    }
+
+    // stacks cut off at the same frames fold to the same line
+    bool a_truncated = a->depth > a_recorded;
+    bool b_truncated = b->depth > b_recorded;
+    return (int)a_truncated - (int)b_truncated;
+}
+
+void simple_profile_write_folded(
+    FILE *file
+) {
+    size_t count = atomic_load(&simple_profile_used);
+    count = count < simple_profile_capacity ? count : simple_profile_capacity;
+    if (!count) {
+        return;
+    }
+
+    // samples are grouped before folding, so only one line is ever built
+    const struct simple_profile_sample **samples;
+    samples = calloc(count, sizeof *samples);
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = simple_profile_samples + i;
+    }
+    qsort(samples, count, sizeof *samples, simple_profile_compare_samples);
+
+    // a frame is at most two names of a few dozen characters
+    char line[SIMPLE_PROFILE_MAX_DEPTH * 80];
+    for (size_t i = 0; i < count;) {
+        size_t j = i + 1;
+        while (j < count &&
+                simple_profile_compare_samples(samples + i, samples + j) == 0) {
+            j++;
+        }
+        simple_profile_fold(samples[i], line, sizeof line);
+        fprintf(file, "%s %zu\n", line, j - i);
+        i = j;
+    }
+
+    free(samples);
+}
+
+void simple_profile_get_stats(
+    struct simple_profile_stats *stats
+) {
+    size_t used = atomic_load(&simple_profile_used);
+    stats->samples = used < simple_profile_capacity ? used :
+        simple_profile_capacity;
+    stats->dropped = atomic_load(&simple_profile_dropped);
+}
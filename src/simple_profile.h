@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "simple_error.h"
+
+// Sampling profiler for member functions. Every thread keeps a shadow
+// stack of the member functions it is in, object_call_method pushes and
+// pops it. While profiling, a CPU time timer raises SIGPROF and the thread
+// it lands on copies its shadow stack, not the C stack, into a buffer
+// allocated up front. The handler does not allocate or lock.
+//
+// Frames keep the type and member function names as pointers, so names
+// passed to object_call_method must outlive the profile. String literals
+// do.
+
+// pushes deeper than this are counted but not recorded
+#define SIMPLE_PROFILE_MAX_DEPTH 32
+
+#define SIMPLE_PROFILE_DEFAULT_FREQUENCY 199
+#define SIMPLE_PROFILE_DEFAULT_CAPACITY 65536
+
+struct simple_profile_stats {
+    size_t samples;
+    size_t dropped;
+};
+
+void simple_profile_push(
+    const char *type_name,
+    const char *name
+);
+
+void simple_profile_pop(
+    void
+);
+
+// Samples frequency times per second of CPU time used by the process, 0
+// for the default. At most capacity samples are kept, 0 for the default,
+// later ones are dropped. Samples from an earlier run are discarded.
+struct simple_error *simple_profile_start(
+    unsigned frequency,
+    size_t capacity
+) __attribute__((warn_unused_result));
+
+void simple_profile_stop(
+    void
+);
+
+// Writes one line per distinct stack, call it once the profiler stopped.
+// Each line lists the stack outermost frame first, followed by its sample
+// count. This is the folded format of flamegraph.pl and speedscope.
+// Samples outside any member function show up as <native>.
+void simple_profile_write_folded(
+    FILE *file
+);
+
+void simple_profile_get_stats(
+    struct simple_profile_stats *stats
+);
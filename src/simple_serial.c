@@ -0,0 +1,648 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "simple_serial.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "simple_hashtable.h"
+#include "simple_string.h"
+#include "type.h"
+
+#define SIMPLE_SERIAL_MAGIC "SIMPLESR"
+#define SIMPLE_SERIAL_BYTE_ORDER 0x01020304
+
+#define SIMPLE_SERIAL_INT 'i'
+#define SIMPLE_SERIAL_STRING 's'
+#define SIMPLE_SERIAL_TYPE 't'
+#define SIMPLE_SERIAL_DICT 'd'
+
+// values are gathered here and handed to stdio in large writes
+#define SIMPLE_SERIAL_BUFFER_SIZE 65536
+
+struct simple_serial_header {
+    uint32_t tag;
+    uint32_t reserved;
+    uint64_t length;
+};
+
+struct simple_serial_writer {
+    FILE *file;
+    size_t used;
+    char buffer[SIMPLE_SERIAL_BUFFER_SIZE];
+};
+
+struct simple_serial_reader {
+    const char *data;
+    size_t size;
+    size_t offset;
+    // set when the reader mapped the file itself
+    void *mapping;
+};
+
+static const char simple_serial_zeros[8];
+
+// rounds length up to the alignment of values
+static size_t simple_serial_align(
+    size_t length
+) {
+    return (length + 7) & ~(size_t)7;
+}
+
+static void simple_serial_flush(
+    struct simple_serial_writer *writer
+) {
+    fwrite(writer->buffer, 1, writer->used, writer->file);
+    writer->used = 0;
+}
+
+static void simple_serial_put(
+    struct simple_serial_writer *writer,
+    const void *data,
+    size_t length
+) {
+    if (SIMPLE_SERIAL_BUFFER_SIZE - writer->used < length) {
+        simple_serial_flush(writer);
+    }
+    if (length > SIMPLE_SERIAL_BUFFER_SIZE) {
+        fwrite(data, 1, length, writer->file);
+        return;
+    }
+    memcpy(writer->buffer + writer->used, data, length);
+    writer->used += length;
+}
+
+static void simple_serial_write_header(
+    struct simple_serial_writer *writer,
+    uint32_t tag,
+    size_t length
+) {
+    struct simple_serial_header header = {
+        .tag = tag,
+        .reserved = 0,
+        .length = length
+    };
+    simple_serial_put(writer, &header, sizeof header);
+}
+
+// writes length bytes of data and the zeros that align them
+static void simple_serial_write_payload(
+    struct simple_serial_writer *writer,
+    const void *data,
+    size_t length
+) {
+    simple_serial_put(writer, data, length);
+    simple_serial_put(writer, simple_serial_zeros,
+        simple_serial_align(length) - length);
+}
+
+static struct simple_error *simple_serial_get_type_size(
+    const struct type *type,
+    size_t *result
+) {
+    const char *name;
+    struct simple_error *error = type_get_name(type, &name);
+    simple_error_check(error);
+
+    *result = sizeof(struct simple_serial_header) +
+        simple_serial_align(strlen(name) + 1);
+
+    cleanup:
+    return error;
+}
+
+// the payload of a dict, its header excluded
+static struct simple_error *simple_serial_get_dict_size(
+    const struct simple_hashtable *table,
+    size_t *result
+) {
+    struct simple_error *error = NULL;
+    struct simple_hashtable_iterator iterator;
+    const struct object *key, *value;
+    size_t size;
+
+    *result = sizeof(uint64_t);
+    error = simple_serial_get_type_size(
+        simple_hashtable_get_key_type(table), &size);
+    simple_error_check(error);
+    *result += size;
+    error = simple_serial_get_type_size(
+        simple_hashtable_get_value_type(table), &size);
+    simple_error_check(error);
+    *result += size;
+
+    simple_hashtable_iterator_init(&iterator, table);
+    while (simple_hashtable_iterator_next(&iterator, &key, &value)) {
+        error = simple_serial_get_size(key, &size);
+        simple_error_check(error);
+        *result += size;
+        error = simple_serial_get_size(value, &size);
+        simple_error_check(error);
+        *result += size;
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_serial_unsupported(
+    const struct object *o
+) {
+    return simple_error_new("Cannot serialize a %s.",
+        object_kind_get_name(object_get_kind(o)));
+}
+
+struct simple_error *simple_serial_get_size(
+    const struct object *o,
+    size_t *result
+) {
+    struct simple_error *error = NULL;
+    struct simple_string *string;
+    struct simple_hashtable *table;
+    struct type *type;
+    size_t payload = 0;
+
+    switch (object_get_kind(o)) {
+        case OBJECT_INTEGER:
+            payload = sizeof(int64_t);
+            break;
+        case OBJECT_STRING:
+            error = object_get_string(o, &string);
+            simple_error_check(error);
+            payload = simple_serial_align(
+                simple_string_get_length(string) + 1);
+            break;
+        case OBJECT_TYPE:
+            error = object_get_type(o, &type);
+            simple_error_check(error);
+            return simple_serial_get_type_size(type, result);
+        case OBJECT_DICT:
+            error = object_get_dict(o, &table);
+            simple_error_check(error);
+            error = simple_serial_get_dict_size(table, &payload);
+            simple_error_check(error);
+            break;
+        case OBJECT_FUNCTION:
+        case OBJECT_BIGINT:
+        case OBJECT_ARRAY:
+        case OBJECT_LIST:
+        case OBJECT_FROZEN_DICT:
+        case OBJECT_SORTED_DICT:
+        case OBJECT_SINK:
+            error = simple_serial_unsupported(o);
+            simple_error_check(error);
+            break;
+    }
+    *result = sizeof(struct simple_serial_header) + payload;
+
+    cleanup:
+    return error;
+}
+
+struct simple_serial_writer *simple_serial_writer_new(
+    FILE *file
+) {
+    struct simple_serial_writer *writer = calloc(1, sizeof *writer);
+    uint32_t header[2] = {SIMPLE_SERIAL_VERSION, SIMPLE_SERIAL_BYTE_ORDER};
+
+    writer->file = file;
+    simple_serial_put(writer, SIMPLE_SERIAL_MAGIC,
+        strlen(SIMPLE_SERIAL_MAGIC));
+    simple_serial_put(writer, header, sizeof header);
+    simple_serial_flush(writer);
+    return writer;
+}
+
+void simple_serial_writer_destroy(
+    struct simple_serial_writer *writer
+) {
+    free(writer);
+}
+
+static struct simple_error *simple_serial_write_type(
+    struct simple_serial_writer *writer,
+    const struct type *type
+) {
+    const char *name;
+    struct simple_error *error = type_get_name(type, &name);
+    simple_error_check(error);
+
+    size_t length = strlen(name);
+    simple_serial_write_header(writer, SIMPLE_SERIAL_TYPE, length);
+    simple_serial_write_payload(writer, name, length + 1);
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_serial_write_value(
+    struct simple_serial_writer *writer,
+    const struct object *o
+);
+
+static struct simple_error *simple_serial_write_dict(
+    struct simple_serial_writer *writer,
+    const struct simple_hashtable *table
+) {
+    struct simple_error *error = NULL;
+    struct simple_hashtable_iterator iterator;
+    const struct object *key, *value;
+    size_t payload;
+
+    error = simple_serial_get_dict_size(table, &payload);
+    simple_error_check(error);
+
+    uint64_t count = simple_hashtable_size(table);
+    simple_serial_write_header(writer, SIMPLE_SERIAL_DICT, payload);
+    simple_serial_put(writer, &count, sizeof count);
+
+    error = simple_serial_write_type(writer,
+        simple_hashtable_get_key_type(table));
+    simple_error_check(error);
+    error = simple_serial_write_type(writer,
+        simple_hashtable_get_value_type(table));
+    simple_error_check(error);
+
+    simple_hashtable_iterator_init(&iterator, table);
+    while (simple_hashtable_iterator_next(&iterator, &key, &value)) {
+        error = simple_serial_write_value(writer, key);
+        simple_error_check(error);
+        error = simple_serial_write_value(writer, value);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *simple_serial_write_value(
+    struct simple_serial_writer *writer,
+    const struct object *o
+) {
+    struct simple_error *error = NULL;
+    struct simple_string *string;
+    struct simple_hashtable *table;
+    struct type *type;
+    int value;
+    int64_t wide;
+    size_t length;
+
+    switch (object_get_kind(o)) {
+        case OBJECT_INTEGER:
+            error = object_get_int(o, &value);
+            simple_error_check(error);
+            wide = value;
+            simple_serial_write_header(writer, SIMPLE_SERIAL_INT,
+                sizeof wide);
+            simple_serial_put(writer, &wide, sizeof wide);
+            break;
+        case OBJECT_STRING:
+            error = object_get_string(o, &string);
+            simple_error_check(error);
+            length = simple_string_get_length(string);
+            simple_serial_write_header(writer, SIMPLE_SERIAL_STRING, length);
+            simple_serial_write_payload(writer, simple_string_get(string),
+                length + 1);
+            break;
+        case OBJECT_TYPE:
+            error = object_get_type(o, &type);
+            simple_error_check(error);
+            error = simple_serial_write_type(writer, type);
+            simple_error_check(error);
+            break;
+        case OBJECT_DICT:
+            error = object_get_dict(o, &table);
+            simple_error_check(error);
+            error = simple_serial_write_dict(writer, table);
+            simple_error_check(error);
+            break;
+        case OBJECT_FUNCTION:
+        case OBJECT_BIGINT:
+        case OBJECT_ARRAY:
+        case OBJECT_LIST:
+        case OBJECT_FROZEN_DICT:
+        case OBJECT_SORTED_DICT:
+        case OBJECT_SINK:
+            error = simple_serial_unsupported(o);
+            simple_error_check(error);
+            break;
+    }
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_serial_write(
+    struct simple_serial_writer *writer,
+    const struct object *o
+) {
+    struct simple_error *error = simple_serial_write_value(writer, o);
+    simple_serial_flush(writer);
+    simple_error_check(error);
+
+    if (ferror(writer->file)) {
+        error = simple_error_new("%s", "Writing the serialized value failed.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_serial_reader_new(
+    const void *data,
+    size_t size,
+    struct simple_serial_reader **result
+) {
+    struct simple_error *error = NULL;
+    size_t magic_length = strlen(SIMPLE_SERIAL_MAGIC);
+    uint32_t header[2];
+
+    if ((uintptr_t)data % 8) {
+        error = simple_error_new("%s", "Serialized data is not aligned.");
+        simple_error_check(error);
+    }
+    if (size < magic_length + sizeof header ||
+            memcmp(data, SIMPLE_SERIAL_MAGIC, magic_length) != 0) {
+        error = simple_error_new("%s", "Not serialized data.");
+        simple_error_check(error);
+    }
+
+    memcpy(header, (const char *)data + magic_length, sizeof header);
+    if (header[0] != SIMPLE_SERIAL_VERSION) {
+        error = simple_error_new("Unsupported serialization version %u.",
+            header[0]);
+        simple_error_check(error);
+    }
+    if (header[1] != SIMPLE_SERIAL_BYTE_ORDER) {
+        error = simple_error_new("%s",
+            "The data was serialized with another byte order.");
+        simple_error_check(error);
+    }
+
+    *result = calloc(1, sizeof **result);
+    (*result)->data = data;
+    (*result)->size = size;
+    (*result)->offset = magic_length + sizeof header;
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_serial_reader_open(
+    const char *path,
+    struct simple_serial_reader **result
+) {
+    struct simple_error *error = NULL;
+    void *mapping = MAP_FAILED;
+    struct stat info;
+    size_t size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        error = simple_error_new("Cannot open '%s': %s", path,
+            strerror(errno));
+        simple_error_check(error);
+    }
+    if (fstat(fd, &info) != 0) {
+        error = simple_error_new("Cannot stat '%s': %s", path,
+            strerror(errno));
+        simple_error_check(error);
+    }
+
+    size = (size_t)info.st_size;
+    if (!size) {
+        error = simple_error_new("'%s' is empty.", path);
+        simple_error_check(error);
+    }
+
+    mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        error = simple_error_new("Cannot map '%s': %s", path,
+            strerror(errno));
+        simple_error_check(error);
+    }
+
+    error = simple_serial_reader_new(mapping, size, result);
+    simple_error_check(error);
+    (*result)->mapping = mapping;
+
+    cleanup:
+    if (error && mapping != MAP_FAILED) {
+        munmap(mapping, size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    return error;
+}
+
+void simple_serial_reader_destroy(
+    struct simple_serial_reader *reader
+) {
+    if (reader && reader->mapping) {
+        munmap(reader->mapping, reader->size);
+    }
+    free(reader);
+}
+
+// Checks that the payload of length bytes is followed by a '\0' and holds
+// no other one.
+static struct simple_error *simple_serial_check_string(
+    const char *payload,
+    size_t length
+) {
+    if (payload[length] != '\0' || memchr(payload, '\0', length)) {
+        return simple_error_new("%s", "Malformed serialized string.");
+    }
+    return NULL;
+}
+
+static struct simple_error *simple_serial_read_value(
+    struct simple_serial_reader *reader,
+    size_t end,
+    size_t depth,
+    struct object **result
+);
+
+static struct simple_error *simple_serial_read_type(
+    struct simple_serial_reader *reader,
+    size_t end,
+    struct type **result
+) {
+    struct object *o = NULL;
+
+    // at the maximum depth, a dict in place of the type is rejected
+    struct simple_error *error = simple_serial_read_value(reader, end,
+        SIMPLE_SERIAL_MAX_DEPTH, &o);
+    simple_error_check(error);
+
+    error = object_get_type(o, result);
+    simple_error_check(error);
+
+    cleanup:
+    object_refcount_decrease(o);
+    return error;
+}
+
+static struct simple_error *simple_serial_read_dict(
+    struct simple_serial_reader *reader,
+    size_t length,
+    size_t depth,
+    struct object **result
+) {
+    struct simple_error *error = NULL;
+    struct simple_hashtable *table = NULL;
+    struct object *key = NULL, *value = NULL;
+    struct type *key_type, *value_type;
+    size_t end = reader->offset + length;
+    uint64_t count;
+
+    if (depth >= SIMPLE_SERIAL_MAX_DEPTH) {
+        error = simple_error_new("%s", "Serialized dicts nest too deep.");
+        simple_error_check(error);
+    }
+    if (length < sizeof count) {
+        error = simple_error_new("%s", "Truncated serialized dict.");
+        simple_error_check(error);
+    }
+    memcpy(&count, reader->data + reader->offset, sizeof count);
+    reader->offset += sizeof count;
+
+    // a key and a value take two headers at least
+    if (count > length / (2 * sizeof(struct simple_serial_header))) {
+        error = simple_error_new("Serialized dict of %llu entries in %zu "
+            "bytes.", (unsigned long long)count, length);
+        simple_error_check(error);
+    }
+
+    error = simple_serial_read_type(reader, end, &key_type);
+    simple_error_check(error);
+    error = simple_serial_read_type(reader, end, &value_type);
+    simple_error_check(error);
+
+    table = simple_hashtable_new_with_capacity(key_type, value_type,
+        (size_t)count);
+    for (uint64_t i = 0; i < count; i++) {
+        error = simple_serial_read_value(reader, end, depth + 1, &key);
+        simple_error_check(error);
+        error = simple_serial_read_value(reader, end, depth + 1, &value);
+        simple_error_check(error);
+        error = simple_hashtable_insert(table, key, value);
+        simple_error_check(error);
+        object_refcount_decrease(key);
+        object_refcount_decrease(value);
+        key = value = NULL;
+    }
+
+    if (reader->offset != end) {
+        error = simple_error_new("%s", "Serialized dict length mismatch.");
+        simple_error_check(error);
+    }
+
+    error = object_new_dict(table, result);
+    simple_error_check(error);
+    table = NULL;
+
+    cleanup:
+    object_refcount_decrease(key);
+    object_refcount_decrease(value);
+    if (table) {
+        simple_hashtable_destroy(table);
+    }
+    return error;
+}
+
+static struct simple_error *simple_serial_read_value(
+    struct simple_serial_reader *reader,
+    size_t end,
+    size_t depth,
+    struct object **result
+) {
+    struct simple_error *error = NULL;
+    struct simple_serial_header header;
+    size_t start = reader->offset;
+    struct type *type;
+    int64_t value;
+
+    *result = NULL;
+    if (end - start < sizeof header) {
+        error = simple_error_new("Truncated value at offset %zu.", start);
+        simple_error_check(error);
+    }
+    memcpy(&header, reader->data + start, sizeof header);
+
+    // strings and types keep a '\0' after their length
+    size_t terminated = header.tag == SIMPLE_SERIAL_STRING ||
+        header.tag == SIMPLE_SERIAL_TYPE ? 1 : 0;
+    size_t available = end - start - sizeof header;
+    if (header.reserved || header.length > available ||
+            simple_serial_align((size_t)header.length + terminated) >
+            available) {
+        error = simple_error_new("Malformed value at offset %zu.", start);
+        simple_error_check(error);
+    }
+
+    size_t length = (size_t)header.length;
+    const char *payload = reader->data + start + sizeof header;
+    reader->offset = start + sizeof header;
+
+    if (header.tag == SIMPLE_SERIAL_INT) {
+        if (length != sizeof value) {
+            error = simple_error_new("Malformed int at offset %zu.", start);
+            simple_error_check(error);
+        }
+        memcpy(&value, payload, sizeof value);
+        if (value < INT_MIN || value > INT_MAX) {
+            error = simple_error_new("Serialized int %lld out of range.",
+                (long long)value);
+            simple_error_check(error);
+        }
+        error = object_new_int((int)value, result);
+        simple_error_check(error);
+    } else if (header.tag == SIMPLE_SERIAL_STRING) {
+        error = simple_serial_check_string(payload, length);
+        simple_error_check(error);
+        error = object_wrap_string(simple_string_new_view(payload, length),
+            result);
+        simple_error_check(error);
+    } else if (header.tag == SIMPLE_SERIAL_TYPE) {
+        error = simple_serial_check_string(payload, length);
+        simple_error_check(error);
+        error = type_registry_get_type(payload, &type);
+        simple_error_check(error);
+        error = object_wrap_type(type, result);
+        simple_error_check(error);
+    } else if (header.tag == SIMPLE_SERIAL_DICT) {
+        error = simple_serial_read_dict(reader, length, depth, result);
+        simple_error_check(error);
+    } else {
+        error = simple_error_new("Unknown tag %u at offset %zu.", header.tag,
+            start);
+        simple_error_check(error);
+    }
+
+    reader->offset = start + sizeof header +
+        simple_serial_align(length + terminated);
+
+    cleanup:
+    return error;
+}
+
+struct simple_error *simple_serial_read(
+    struct simple_serial_reader *reader,
+    struct object **result
+) {
+    if (reader->offset == reader->size) {
+        *result = NULL;
+        return NULL;
+    }
+    return simple_serial_read_value(reader, reader->size, 0, result);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "simple_error.h"
+#include "simple_object.h"
+
+// Binary serialization of ints, strings, types and dicts. A file is a
+// header followed by values, every value starts 8 byte aligned with a tag
+// and the length of its payload:
+//
+//     header: "SIMPLESR", u32 version, u32 0x01020304
+//     value: u32 tag, u32 0, u64 length, payload, zeros up to 8 bytes
+//     int: 'i', i64
+//     string: 's', the bytes and a '\0' not counted in the length
+//     type: 't', the type name like a string
+//     dict: 'd', u64 count, key type, value type, count keys and values
+//
+// The format is native byte order. The reader validates every length and
+// tag before using it. It maps the file and decodes strings as views into
+// the mapping, see simple_string_new_view, so string payloads are never
+// copied. Types are looked up by name in the type registry.
+
+#define SIMPLE_SERIAL_VERSION 1
+
+// dicts nested deeper than this are rejected by the reader
+#define SIMPLE_SERIAL_MAX_DEPTH 64
+
+struct simple_serial_writer;
+struct simple_serial_reader;
+
+// Writes the header, the file stays open.
+struct simple_serial_writer *simple_serial_writer_new(
+    FILE *file
+) __attribute__((warn_unused_result));
+
+void simple_serial_writer_destroy(
+    struct simple_serial_writer *writer
+);
+
+// Streams o to the file, dicts are walked twice, once for their size. On
+// error the file may end in part of o.
+struct simple_error *simple_serial_write(
+    struct simple_serial_writer *writer,
+    const struct object *o
+) __attribute__((warn_unused_result));
+
+// Bytes o takes up when written, its header and padding included.
+struct simple_error *simple_serial_get_size(
+    const struct object *o,
+    size_t *result
+) __attribute__((warn_unused_result));
+
+// Reads from size bytes at data, which must be 8 byte aligned and outlive
+// the strings read.
+struct simple_error *simple_serial_reader_new(
+    const void *data,
+    size_t size,
+    struct simple_serial_reader **result
+) __attribute__((warn_unused_result));
+
+// Maps the file at path read only, strings read are views into it.
+struct simple_error *simple_serial_reader_open(
+    const char *path,
+    struct simple_serial_reader **result
+) __attribute__((warn_unused_result));
+
+// Unmaps an opened file, strings read from it may no longer be used.
+void simple_serial_reader_destroy(
+    struct simple_serial_reader *reader
+);
+
+// Sets result to the next value, NULL after the last one.
+struct simple_error *simple_serial_read(
+    struct simple_serial_reader *reader,
+    struct object **result
+) __attribute__((warn_unused_result));
@@ -0,0 +1,199 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "simple_sink.h"
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define SIMPLE_SINK_BUFFER_SIZE 65536
+
+// longest decimal int64_t, INT64_MIN, with its sign
+#define SIMPLE_SINK_INT_DIGITS 20
+
+struct simple_sink {
+    int fd;
+    size_t used;
+    char buffer[SIMPLE_SINK_BUFFER_SIZE];
+};
+
+static struct simple_sink *simple_sink_stdout;
+
+static const char simple_sink_digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+struct simple_sink *simple_sink_new(
+    int fd
+) {
+    struct simple_sink *sink = calloc(1, sizeof *sink);
+    sink->fd = fd;
+    return sink;
+}
+
+void simple_sink_destroy(
+    struct simple_sink *sink
+) {
+    free(sink);
+}
+
+static void simple_sink_flush_stdout(
+    void
+) {
+    struct simple_error *error = simple_sink_flush(simple_sink_stdout);
+    if (error) {
+        simple_error_show(error, stderr);
+        simple_error_destroy(error);
+    }
+}
+
+struct simple_sink *simple_sink_get_stdout(
+    void
+) {
+    if (!simple_sink_stdout) {
+        simple_sink_stdout = simple_sink_new(STDOUT_FILENO);
+        atexit(simple_sink_flush_stdout);
+    }
+    return simple_sink_stdout;
+}
+
+// Writes the buffer followed by length bytes of data, retrying partial
+// writes. The buffer is empty afterwards, even on error.
+static struct simple_error *simple_sink_write_out(
+    struct simple_sink *sink,
+    const char *data,
+    size_t length
+) {
+    struct simple_error *error = NULL;
+    struct iovec vectors[2] = {
+        {.iov_base = sink->buffer, .iov_len = sink->used},
+        {.iov_base = (void *)data, .iov_len = length}
+    };
+    struct iovec *next = vectors;
+    int count = 2;
+    size_t remaining = sink->used + length;
+
+    if (sink->fd == STDOUT_FILENO) {
+        fflush(stdout);
+    }
+
+    while (remaining) {
+        ssize_t written = writev(sink->fd, next, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = simple_error_new("Writing to fd %d failed: %s",
+                sink->fd, strerror(errno));
+            simple_error_check(error);
+        }
+
+        // skip what was written, the empty vectors included
+        size_t left = (size_t)written;
+        remaining -= left;
+        while (count && left >= next->iov_len) {
+            left -= next->iov_len;
+            next++;
+            count--;
+        }
+        if (count) {
+            next->iov_base = (char *)next->iov_base + left;
+            next->iov_len -= left;
+        }
+    }
+
+    cleanup:
+    sink->used = 0;
+    return error;
+}
+
+struct simple_error *simple_sink_write(
+    struct simple_sink *sink,
+    const char *data,
+    size_t length
+) {
+    if (SIMPLE_SINK_BUFFER_SIZE - sink->used >= length) {
+        memcpy(sink->buffer + sink->used, data, length);
+        sink->used += length;
+        return NULL;
+    }
+    if (length >= SIMPLE_SINK_BUFFER_SIZE / 2) {
+        return simple_sink_write_out(sink, data, length);
+    }
+
+    struct simple_error *error = simple_sink_write_out(sink, NULL, 0);
+    if (error) {
+        return error;
+    }
+    memcpy(sink->buffer, data, length);
+    sink->used = length;
+    return NULL;
+}
+
+struct simple_error *simple_sink_write_string(
+    struct simple_sink *sink,
+    const char *value
+) {
+    return simple_sink_write(sink, value, strlen(value));
+}
+
+struct simple_error *simple_sink_write_int(
+    struct simple_sink *sink,
+    int64_t value
+) {
+    char digits[SIMPLE_SINK_INT_DIGITS];
+    char *end = digits + SIMPLE_SINK_INT_DIGITS, *start = end;
+
+    // negated as unsigned, which also covers INT64_MIN
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    while (magnitude >= 100) {
+        size_t pair = (size_t)(magnitude % 100) * 2;
+        magnitude /= 100;
+        *--start = simple_sink_digit_pairs[pair + 1];
+        *--start = simple_sink_digit_pairs[pair];
+    }
+    if (magnitude >= 10) {
+        *--start = simple_sink_digit_pairs[magnitude * 2 + 1];
+        *--start = simple_sink_digit_pairs[magnitude * 2];
+    } else {
+        *--start = (char)('0' + magnitude);
+    }
+    if (value < 0) {
+        *--start = '-';
+    }
+
+    return simple_sink_write(sink, start, (size_t)(end - start));
+}
+
+struct simple_error *simple_sink_write_double(
+    struct simple_sink *sink,
+    double value
+) {
+    char buff[32];
+    int length = snprintf(buff, sizeof buff, "%g", value);
+    return simple_sink_write(sink, buff, (size_t)length);
+}
+
+struct simple_error *simple_sink_flush(
+    struct simple_sink *sink
+) {
+    return simple_sink_write_out(sink, NULL, 0);
+}
+
+size_t simple_sink_get_pending(
+    const struct simple_sink *sink
+) {
+    return sink->used;
+}
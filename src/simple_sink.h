@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simple_error.h"
+
+// Buffered output to a file descriptor that bypasses stdio and its locks.
+// Writes are copied into a large buffer which is written out once full or
+// on an explicit flush. Writes that do not fit the buffer are not copied,
+// they go out together with the buffered data in a single writev. A sink is
+// not thread safe.
+
+struct simple_sink;
+
+struct simple_sink *simple_sink_new(
+    int fd
+) __attribute__((warn_unused_result));
+
+// Does not flush, the fd stays open.
+void simple_sink_destroy(
+    struct simple_sink *sink
+);
+
+// The sink of standard output, created on first use and flushed at exit.
+// Flushing it flushes stdout first, so earlier printf output stays in front.
+struct simple_sink *simple_sink_get_stdout(
+    void
+);
+
+struct simple_error *simple_sink_write(
+    struct simple_sink *sink,
+    const char *data,
+    size_t length
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_sink_write_string(
+    struct simple_sink *sink,
+    const char *value
+) __attribute__((warn_unused_result));
+
+// Converts two digits at a time, without going through printf.
+struct simple_error *simple_sink_write_int(
+    struct simple_sink *sink,
+    int64_t value
+) __attribute__((warn_unused_result));
+
+// Formatted like printf %g.
+struct simple_error *simple_sink_write_double(
+    struct simple_sink *sink,
+    double value
+) __attribute__((warn_unused_result));
+
+struct simple_error *simple_sink_flush(
+    struct simple_sink *sink
+) __attribute__((warn_unused_result));
+
+// Bytes buffered and not yet written.
+size_t simple_sink_get_pending(
+    const struct simple_sink *sink
+);
@@ -1,6 +1,7 @@
 #include "simple_string.h"
 
 #include "type.h"
+#include "simple_alloc.h"
 #include "simple_error.h"
 
 #include <malloc.h>
@@ -10,6 +11,7 @@
 struct simple_string {
     char *cstring;
     size_t length;
+    bool view;
 };
 
 struct simple_string *simple_string_new(
@@ -18,20 +20,42 @@ struct simple_string *simple_string_new(
     struct simple_string *string = calloc(1, sizeof *string);
     string->length = strlen(cstring);
     string->cstring = calloc(string->length+ 1, sizeof *string->cstring);
+    simple_alloc_record("string", sizeof *string);
+    simple_alloc_record("string_data", string->length + 1);
     memcpy(string->cstring, cstring, string->length + 1);
     return string;
 }
 
+struct simple_string *simple_string_new_view(
+    const char *data,
+    size_t length
+) {
+    struct simple_string *string = calloc(1, sizeof *string);
+    simple_alloc_record("string", sizeof *string);
+    string->cstring = (char *)data;
+    string->length = length;
+    string->view = true;
+    return string;
+}
+
 struct simple_string *simple_string_copy(
     const struct simple_string *string
 ) {
+    if (string->view) {
+        return simple_string_new_view(string->cstring, string->length);
+    }
     return simple_string_new(simple_string_get(string));
 }
 
 void simple_string_destroy(
     struct simple_string *string
 ) {
-    free(string->cstring);
+    if (!string) {
+        return;
+    }
+    if (!string->view) {
+        free(string->cstring);
+    }
     free(string);
 }
 
@@ -39,6 +63,12 @@ const char *simple_string_get(const struct simple_string *string) {
     return string->cstring;
 }
 
+size_t simple_string_get_length(
+    const struct simple_string *string
+) {
+    return string->length;
+}
+
 bool simple_string_equals(
     const struct simple_string *lhs,
     const struct simple_string *rhs
@@ -58,10 +88,17 @@ bool simple_string_startswith(
 
 size_t simple_string_hash(
     const struct simple_string *string
+) {
+    return simple_string_hash_bytes(string->cstring, string->length);
+}
+
+size_t simple_string_hash_bytes(
+    const char *data,
+    size_t length
 ) {
     size_t hash = 8937;
-    for (size_t i=0; i<string->length; i++) {
-        hash += (size_t)string->cstring[i];
+    for (size_t i=0; i<length; i++) {
+        hash += (size_t)data[i];
         hash *= (size_t)123457;
     }
     return hash;
@@ -9,10 +9,19 @@ struct simple_string *simple_string_new(
     const char *cstring
 ) __attribute__((warn_unused_result));
 
+// A string over length bytes owned by someone else, data[length] must be
+// '\0'. The bytes are neither copied nor freed and must outlive the string
+// and its copies, which are views as well.
+struct simple_string *simple_string_new_view(
+    const char *data,
+    size_t length
+) __attribute__((warn_unused_result));
+
 struct simple_string *simple_string_copy(
     const struct simple_string *string
 ) __attribute__((warn_unused_result));
 
+// Does nothing for NULL, like free.
 void simple_string_destroy(
     struct simple_string *string
 );
@@ -21,6 +30,12 @@ size_t simple_string_hash(
     const struct simple_string *string
 );
 
+// The hash a string over length bytes at data would have.
+size_t simple_string_hash_bytes(
+    const char *data,
+    size_t length
+);
+
 bool simple_string_startswith(
     const struct simple_string *string,
     const char *search
@@ -34,3 +49,7 @@ bool simple_string_equals(
 const char *simple_string_get(
     const struct simple_string *string
 );
+
+size_t simple_string_get_length(
+    const struct simple_string *string
+);
@@ -1,16 +1,71 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <string.h>
 #include <malloc.h>
+#include <fnmatch.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "simple_test.h"
+#include "simple_alloc.h"
 #include "simple_error.h"
+#include "simple_sink.h"
+
+// a calibrated sample takes at least this long
+#define SIMPLE_TEST_BENCH_SAMPLE_SECONDS 0.005
+#define SIMPLE_TEST_BENCH_MAX_SAMPLES 50
+
+// sampling stops after this, but always keeps at least one sample
+#define SIMPLE_TEST_BENCH_BUDGET_SECONDS 0.25
+
+#define SIMPLE_TEST_MAX_FILTERS 16
+
+// first line of a baseline file, bump the version on format changes
+#define SIMPLE_TEST_BASELINE_MAGIC "simple_test"
+#define SIMPLE_TEST_BASELINE_VERSION " baseline 1"
+#define SIMPLE_TEST_BASELINE_HEADER \
+    SIMPLE_TEST_BASELINE_MAGIC SIMPLE_TEST_BASELINE_VERSION
+
+// the minimum of fewer samples is too noisy to call a regression
+#define SIMPLE_TEST_BASELINE_MIN_SAMPLES 5
+
+// leaves listed in the slowest tests report
+#define SIMPLE_TEST_SLOWEST 10
 
 static struct simple_test_item *simple_test_root;
+static FILE *simple_test_json_output;
+
+// set with --census, dumps the allocations of every leaf after it ran
+static bool simple_test_census;
+
+// opened by the first benchmark once counters are enabled
+static bool simple_test_perf_enabled;
+static struct simple_perf *simple_test_perf;
+
+// A benchmark of one run as stored in a baseline file, samples are per
+// operation. A baseline of several runs has an entry per run.
+struct simple_test_baseline_entry {
+    char name[1024];
+    double allocations;
+    size_t samples;
+    double values[SIMPLE_TEST_BENCH_MAX_SAMPLES];
+};
+
+static FILE *simple_test_baseline_output;
+static struct simple_test_baseline_entry *simple_test_baseline;
+static size_t simple_test_baseline_count;
+static double simple_test_baseline_threshold;
+static size_t simple_test_regression_count;
 
 enum simple_test_item_kind{
     SIMPLE_TEST_INTERNAL,
-    SIMPLE_TEST_LEAF
+    SIMPLE_TEST_LEAF,
+    SIMPLE_TEST_BENCH
 };
 
 struct simple_test_item{
@@ -22,6 +77,14 @@ struct simple_test_item{
         struct {
             struct simple_test_item *first_child, *last_child;
         };
+        struct {
+            simple_test_bench_func bench_func;
+            void *context;
+            size_t operations;
+            bool measured;
+            struct simple_test_bench_stats stats;
+            double samples[SIMPLE_TEST_BENCH_MAX_SAMPLES];
+        };
     };
 };
 
@@ -117,6 +180,190 @@ static int count_digits(
     return (int)(floor(log10(value))) + 1;
 }
 
+static double simple_test_now(
+    void
+) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static int simple_test_compare_doubles(
+    const void *lhs,
+    const void *rhs
+) {
+    double l = *(const double *)lhs, r = *(const double *)rhs;
+    return (l > r) - (l < r);
+}
+
+// Times one sample of iterations iterations, in seconds. Counter values
+// are added to totals unless it is NULL, a counter missing from any sample
+// is not counted at all.
+static struct simple_error *simple_test_bench_sample(
+    struct simple_test_item *item,
+    size_t iterations,
+    double *result,
+    struct simple_perf_counts *totals
+) {
+    bool counting = totals && simple_test_perf;
+    if (counting) {
+        simple_perf_start(simple_test_perf);
+    }
+
+    double start = simple_test_now();
+    struct simple_error *error = item->bench_func(item->context, iterations);
+    *result = simple_test_now() - start;
+
+    if (counting) {
+        struct simple_perf_counts counts;
+        simple_perf_stop(simple_test_perf, &counts);
+        for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+            totals->values[i] += counts.values[i];
+            totals->counted[i] = totals->counted[i] && counts.counted[i];
+        }
+    }
+    return error;
+}
+
+static void simple_test_perf_init(
+    void
+) {
+    if (!simple_test_perf_enabled || simple_test_perf) {
+        return;
+    }
+
+    simple_test_perf = simple_perf_new();
+    if (!simple_perf_available(simple_test_perf)) {
+        printf("%s\n", "Hardware counters are not available, check "
+            "/proc/sys/kernel/perf_event_paranoid. Reporting time only.");
+        simple_perf_destroy(simple_test_perf);
+        simple_test_perf = NULL;
+        simple_test_perf_enabled = false;
+    }
+}
+
+static void simple_test_bench_print_counters(
+    const struct simple_test_bench_stats *stats
+) {
+    bool any = false;
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+        if (stats->counted[i]) {
+            printf("%s %s %.2f", any ? "," : "\033[0;32m   ",
+                simple_perf_counter_get_name((enum simple_perf_counter)i),
+                stats->counters[i]);
+            any = true;
+        }
+    }
+    if (!any) {
+        return;
+    }
+
+    if (stats->counted[SIMPLE_PERF_CYCLES] &&
+            stats->counted[SIMPLE_PERF_INSTRUCTIONS] &&
+            stats->counters[SIMPLE_PERF_CYCLES] > 0) {
+        printf(", ipc %.2f", stats->counters[SIMPLE_PERF_INSTRUCTIONS] /
+            stats->counters[SIMPLE_PERF_CYCLES]);
+    }
+    printf("%s\n", " per op\033[0m");
+}
+
+static void simple_test_bench_compute_stats(
+    struct simple_test_bench_stats *stats,
+    double *samples
+) {
+    size_t count = stats->samples;
+    double sum = 0, squares = 0;
+
+    qsort(samples, count, sizeof *samples, simple_test_compare_doubles);
+    for (size_t i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    stats->mean = sum / (double)count;
+    for (size_t i = 0; i < count; i++) {
+        squares += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+    }
+
+    stats->min = samples[0];
+    stats->median = count % 2 ? samples[count / 2] :
+        (samples[count / 2 - 1] + samples[count / 2]) / 2;
+    stats->p99 = samples[(size_t)ceil(0.99 * (double)count) - 1];
+    stats->stddev = count > 1 ? sqrt(squares / (double)(count - 1)) : 0;
+    stats->ops_per_second = 1e9 / stats->mean;
+}
+
+// Calibration doubles the iteration count until a sample is long enough
+// for the clock, which also warms up caches and the allocator.
+static struct simple_error *simple_test_bench_run(
+    struct simple_test_item *item
+) {
+    struct simple_error *error;
+    double *samples = item->samples;
+    double elapsed, spent = 0;
+    size_t iterations = 1;
+    struct simple_alloc_totals allocations_before, allocations_after;
+
+    struct simple_perf_counts totals;
+    memset(&totals, 0, sizeof totals);
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+        totals.counted[i] = true;
+    }
+    simple_test_perf_init();
+
+    // a cold first call would end calibration early
+    error = simple_test_bench_sample(item, 1, &elapsed, NULL);
+    simple_error_check(error);
+
+    for (;;) {
+        error = simple_test_bench_sample(item, iterations, &elapsed, NULL);
+        simple_error_check(error);
+        if (elapsed >= SIMPLE_TEST_BENCH_SAMPLE_SECONDS) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    item->stats = (struct simple_test_bench_stats) {
+        .iterations = iterations,
+        .samples = 0
+    };
+    simple_alloc_get_totals(&allocations_before);
+    while (item->stats.samples < SIMPLE_TEST_BENCH_MAX_SAMPLES &&
+            (item->stats.samples == 0 ||
+            spent < SIMPLE_TEST_BENCH_BUDGET_SECONDS)) {
+        error = simple_test_bench_sample(item, iterations, &elapsed,
+            &totals);
+        simple_error_check(error);
+        spent += elapsed;
+        samples[item->stats.samples++] = elapsed * 1e9 /
+            (double)(iterations * item->operations);
+    }
+
+    simple_alloc_get_totals(&allocations_after);
+
+    simple_test_bench_compute_stats(&item->stats, samples);
+    double operations = (double)(item->stats.samples * iterations *
+        item->operations);
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+        item->stats.counted[i] = simple_test_perf && totals.counted[i];
+        item->stats.counters[i] = (double)totals.values[i] / operations;
+    }
+    item->stats.allocations = (double)(allocations_after.allocations -
+        allocations_before.allocations) / operations;
+    item->stats.bytes = (double)(allocations_after.bytes -
+        allocations_before.bytes) / operations;
+    item->measured = true;
+
+    printf("\033[0;32m    %.1f ns/op, %.4g ops/s, min %.1f, median %.1f, "
+        "p99 %.1f, stddev %.1f (%zu samples of %zu)\033[0m\n",
+        item->stats.mean, item->stats.ops_per_second, item->stats.min,
+        item->stats.median, item->stats.p99, item->stats.stddev,
+        item->stats.samples, item->stats.iterations);
+    simple_test_bench_print_counters(&item->stats);
+
+    cleanup:
+    return error;
+}
+
 static void simple_test_run_recursively(
     struct simple_test_item *item,
     size_t *nodes_visited,
@@ -134,24 +381,217 @@ static void simple_test_run_recursively(
         count_digits(node_count), *nodes_visited, count_digits(node_count),
         node_count, buff);
 
+    struct simple_error *error = NULL;
     switch (item->kind) {
         case SIMPLE_TEST_INTERNAL:
             simple_test_run_recursively(item->first_child, nodes_visited,
                 node_count);
             break;
-        case SIMPLE_TEST_LEAF: {
-            struct simple_error *error = item->func();
-            if (error) {
-                simple_error_show(error, stderr);
-                simple_error_destroy(error);
-            }
+        case SIMPLE_TEST_LEAF:
+            error = item->func();
+            break;
+        case SIMPLE_TEST_BENCH:
+            error = simple_test_bench_run(item);
             break;
-        }
     }
 
+    if (error) {
+        simple_error_show(error, stderr);
+        simple_error_destroy(error);
+    }
+    fflush(stdout);
+
     simple_test_run_recursively(item->next, nodes_visited, node_count);
 }
 
+static void simple_test_write_json(
+    const struct simple_test_item *item,
+    FILE *file,
+    bool *first
+) {
+    for (; item; item = item->next) {
+        if (item->kind == SIMPLE_TEST_INTERNAL) {
+            simple_test_write_json(item->first_child, file, first);
+        }
+        if (item->kind != SIMPLE_TEST_BENCH || !item->measured) {
+            continue;
+        }
+
+        char buff[1024];
+        simple_test_get_full_name(item, buff, 1024);
+        fprintf(file, "%s\n    {\"name\": \"%s\", \"iterations\": %zu, "
+            "\"samples\": %zu, \"ns_per_op\": %.3f, "
+            "\"ops_per_second\": %.3f, \"min_ns\": %.3f, "
+            "\"median_ns\": %.3f, \"p99_ns\": %.3f, "
+            "\"stddev_ns\": %.3f", *first ? "" : ",", buff,
+            item->stats.iterations, item->stats.samples, item->stats.mean,
+            item->stats.ops_per_second, item->stats.min, item->stats.median,
+            item->stats.p99, item->stats.stddev);
+        if (simple_alloc_enabled()) {
+            fprintf(file, ", \"allocations_per_op\": %.4f, "
+                "\"bytes_per_op\": %.4f", item->stats.allocations,
+                item->stats.bytes);
+        }
+        for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+            if (item->stats.counted[i]) {
+                fprintf(file, ", \"%s_per_op\": %.4f",
+                    simple_perf_counter_get_name((enum simple_perf_counter)i),
+                    item->stats.counters[i]);
+            }
+        }
+        fprintf(file, "%s", "}");
+        *first = false;
+    }
+}
+
+static void simple_test_write_baseline(
+    const struct simple_test_item *item,
+    FILE *file
+) {
+    for (; item; item = item->next) {
+        if (item->kind == SIMPLE_TEST_INTERNAL) {
+            simple_test_write_baseline(item->first_child, file);
+        }
+        if (item->kind != SIMPLE_TEST_BENCH || !item->measured) {
+            continue;
+        }
+
+        char buff[1024];
+        simple_test_get_full_name(item, buff, 1024);
+        fprintf(file, "%s %.6g %zu", buff,
+            simple_alloc_enabled() ? item->stats.allocations : -1.0,
+            item->stats.samples);
+        for (size_t i = 0; i < item->stats.samples; i++) {
+            fprintf(file, " %.6g", item->samples[i]);
+        }
+        fprintf(file, "%s", "\n");
+    }
+}
+
+static double simple_test_baseline_median(
+    const struct simple_test_baseline_entry *entry
+) {
+    size_t half = entry->samples / 2;
+    return entry->samples % 2 ? entry->values[half] :
+        (entry->values[half - 1] + entry->values[half]) / 2;
+}
+
+// What the runs of a benchmark in the baseline agree on.
+struct simple_test_baseline_runs {
+    size_t count;
+    double worst_median;
+    double best_min;
+    double allocations;
+};
+
+static void simple_test_baseline_find_runs(
+    const char *name,
+    struct simple_test_baseline_runs *runs
+) {
+    *runs = (struct simple_test_baseline_runs) {.allocations = -1};
+    for (size_t i = 0; i < simple_test_baseline_count; i++) {
+        const struct simple_test_baseline_entry *entry;
+        entry = simple_test_baseline + i;
+        if (strcmp(entry->name, name) != 0) {
+            continue;
+        }
+
+        double median = simple_test_baseline_median(entry);
+        if (!runs->count || median > runs->worst_median) {
+            runs->worst_median = median;
+        }
+        if (!runs->count || entry->values[0] < runs->best_min) {
+            runs->best_min = entry->values[0];
+        }
+        if (entry->allocations > runs->allocations) {
+            runs->allocations = entry->allocations;
+        }
+        runs->count++;
+    }
+}
+
+static void simple_test_compare_baseline(
+    const struct simple_test_item *item
+) {
+    for (; item; item = item->next) {
+        if (item->kind == SIMPLE_TEST_INTERNAL) {
+            simple_test_compare_baseline(item->first_child);
+        }
+        if (item->kind != SIMPLE_TEST_BENCH || !item->measured) {
+            continue;
+        }
+
+        char buff[1024];
+        simple_test_get_full_name(item, buff, 1024);
+        struct simple_test_baseline_runs runs;
+        simple_test_baseline_find_runs(buff, &runs);
+        if (!runs.count) {
+            printf("    new       %s\n", buff);
+            continue;
+        }
+
+        // samples of one run are not independent of each other, so whole
+        // runs are compared: even the fastest sample must be slower than
+        // the typical sample of every baseline run
+        double threshold = simple_test_baseline_threshold;
+        double change = item->stats.min / runs.worst_median - 1;
+        bool slower = item->stats.samples >=
+            SIMPLE_TEST_BASELINE_MIN_SAMPLES && change > threshold;
+        bool allocates = runs.allocations >= 0 && simple_alloc_enabled() &&
+            item->stats.allocations > runs.allocations * (1 + threshold) &&
+            item->stats.allocations - runs.allocations > 1e-9;
+
+        if (slower || allocates) {
+            simple_test_regression_count++;
+            printf("\033[0;31m    regressed %s: min %.1f ns/op against a "
+                "median of %.1f (%+.1f%%, %zu runs)", buff, item->stats.min,
+                runs.worst_median, change * 100, runs.count);
+            if (allocates) {
+                printf(", allocations %.2f -> %.2f per op",
+                    runs.allocations, item->stats.allocations);
+            }
+            printf("%s\n", "\033[0m");
+        } else if (item->stats.median < runs.best_min * (1 - threshold)) {
+            printf("\033[0;32m    improved  %s: median %.1f ns/op against "
+                "a min of %.1f (%+.1f%%)\033[0m\n", buff,
+                item->stats.median, runs.best_min,
+                (item->stats.median / runs.best_min - 1) * 100);
+        }
+    }
+}
+
+// writes the baseline and compares against the loaded one, if any
+static void simple_test_finish_baseline(
+    void
+) {
+    if (simple_test_baseline_output) {
+        fprintf(simple_test_baseline_output, "%s\n",
+            SIMPLE_TEST_BASELINE_HEADER);
+        simple_test_write_baseline(simple_test_root,
+            simple_test_baseline_output);
+        fflush(simple_test_baseline_output);
+    }
+
+    if (simple_test_baseline) {
+        printf("Compared to baseline, %.1f%% threshold:\n",
+            simple_test_baseline_threshold * 100);
+        simple_test_compare_baseline(simple_test_root);
+        printf("%zu regressions\n", simple_test_regression_count);
+    }
+}
+
+static void simple_test_finish_json(
+    void
+) {
+    if (simple_test_json_output) {
+        bool first = true;
+        fprintf(simple_test_json_output, "%s", "{\"benchmarks\": [");
+        simple_test_write_json(simple_test_root, simple_test_json_output,
+            &first);
+        fprintf(simple_test_json_output, "%s", "\n]}\n");
+        fflush(simple_test_json_output);
+    }
+}
 
 void simple_test_run(
     void
@@ -159,35 +599,492 @@ void simple_test_run(
     size_t nodes_visited = 0;
     size_t node_count = simple_test_item_count(simple_test_root);
     simple_test_run_recursively(simple_test_root, &nodes_visited, node_count);
+    simple_test_finish_json();
+    simple_test_finish_baseline();
+}
+
+void simple_test_set_json_output(
+    FILE *file
+) {
+    simple_test_json_output = file;
+}
+
+void simple_test_set_perf_counters(
+    bool enabled
+) {
+    simple_test_perf_enabled = enabled;
+}
+
+void simple_test_set_baseline_output(
+    FILE *file
+) {
+    simple_test_baseline_output = file;
+}
+
+struct simple_error *simple_test_load_baseline(
+    FILE *file,
+    double threshold
+) {
+    struct simple_error *error = NULL;
+    struct simple_test_baseline_entry *entries = NULL;
+    size_t count = 0, capacity = 0;
+    char header[64];
+
+    if (!fgets(header, sizeof header, file) ||
+            strcmp(header, SIMPLE_TEST_BASELINE_HEADER "\n") != 0) {
+        error = simple_error_new("Baseline does not start with '%s'.",
+            SIMPLE_TEST_BASELINE_HEADER);
+        simple_error_check(error);
+    }
+
+    for (;;) {
+        if (count == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            struct simple_test_baseline_entry *grown;
+            grown = realloc(entries, capacity * sizeof *entries);
+            if (!grown) {
+                error = simple_error_new("Cannot allocate %zu baseline "
+                    "entries.", capacity);
+                simple_error_check(error);
+            }
+            entries = grown;
+        }
+
+        struct simple_test_baseline_entry *entry = entries + count;
+        if (fscanf(file, "%1023s", entry->name) == EOF) {
+            break;
+        }
+
+        // baselines of several runs are concatenated, headers included
+        if (strcmp(entry->name, SIMPLE_TEST_BASELINE_MAGIC) == 0) {
+            if (!fgets(header, sizeof header, file) ||
+                    strcmp(header, SIMPLE_TEST_BASELINE_VERSION "\n") != 0) {
+                error = simple_error_new("Malformed baseline header before "
+                    "entry %zu.", count + 1);
+                simple_error_check(error);
+            }
+            continue;
+        }
+
+        int fields = fscanf(file, "%lf %zu", &entry->allocations,
+            &entry->samples);
+        if (fields != 2 || entry->samples == 0 ||
+                entry->samples > SIMPLE_TEST_BENCH_MAX_SAMPLES) {
+            error = simple_error_new("Malformed baseline entry %zu.",
+                count + 1);
+            simple_error_check(error);
+        }
+        for (size_t i = 0; i < entry->samples; i++) {
+            if (fscanf(file, "%lf", entry->values + i) != 1) {
+                error = simple_error_new("Baseline entry %s is truncated.",
+                    entry->name);
+                simple_error_check(error);
+            }
+        }
+        qsort(entry->values, entry->samples, sizeof *entry->values,
+            simple_test_compare_doubles);
+        count++;
+    }
+
+    free(simple_test_baseline);
+    simple_test_baseline = entries;
+    simple_test_baseline_count = count;
+    simple_test_baseline_threshold = threshold;
+    simple_test_regression_count = 0;
+    entries = NULL;
+
+    cleanup:
+    free(entries);
+    return error;
+}
+
+size_t simple_test_get_regression_count(
+    void
+) {
+    return simple_test_regression_count;
+}
+
+enum simple_test_outcome {
+    SIMPLE_TEST_NOT_RUN,
+    SIMPLE_TEST_STARTED,
+    SIMPLE_TEST_PASSED,
+    SIMPLE_TEST_FAILED,
+    SIMPLE_TEST_CRASHED
+};
+
+struct simple_test_result {
+    struct simple_test_item *item;
+    enum simple_test_outcome outcome;
+    double seconds;
+};
+
+struct simple_test_options {
+    const char *filters[SIMPLE_TEST_MAX_FILTERS];
+    size_t filter_count;
+    size_t shard_index, shard_count;
+    size_t jobs;
+    bool census;
+};
+
+// Sent from workers to the runner, small enough for atomic pipe writes.
+struct simple_test_message {
+    uint32_t index;
+    uint32_t worker;
+    uint32_t outcome;
+    double seconds;
+};
+
+static int simple_test_parse_options(
+    int argc,
+    char **argv,
+    struct simple_test_options *options
+) {
+    *options = (struct simple_test_options) {
+        .filter_count = 0,
+        .shard_index = 0,
+        .shard_count = 1,
+        .jobs = 1,
+        .census = false
+    };
+
+    for (int i = 1; i < argc; i += 2) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool valid = value != NULL;
+
+        if (strcmp(argv[i], "--census") == 0) {
+            options->census = true;
+            valid = true;
+            i--;
+        } else if (valid && strcmp(argv[i], "--filter") == 0) {
+            valid = options->filter_count < SIMPLE_TEST_MAX_FILTERS;
+            if (valid) {
+                options->filters[options->filter_count++] = value;
+            }
+        } else if (valid && strcmp(argv[i], "--shard") == 0) {
+            valid = sscanf(value, "%zu/%zu", &options->shard_index,
+                &options->shard_count) == 2 && options->shard_count &&
+                options->shard_index < options->shard_count;
+        } else if (valid && strcmp(argv[i], "--jobs") == 0) {
+            valid = sscanf(value, "%zu", &options->jobs) == 1;
+            if (valid && !options->jobs) {
+                long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+                options->jobs = cpu_count > 1 ? (size_t)cpu_count : 1;
+            }
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            fprintf(stderr, "usage: %s [--filter pattern]... [--shard i/n] "
+                "[--jobs n] [--census]\n", argv[0]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Patterns are matched against full names without the root, with
+// fnmatch. A pattern naming a node selects everything below it.
+static bool simple_test_matches(
+    const struct simple_test_options *options,
+    const char *full_name
+) {
+    const char *name = strchr(full_name, '.');
+    name = name ? name + 1 : full_name;
+
+    if (!options->filter_count) {
+        return true;
+    }
+    for (size_t i = 0; i < options->filter_count; i++) {
+        size_t length = strlen(options->filters[i]);
+        if (fnmatch(options->filters[i], name, 0) == 0 ||
+                (strncmp(options->filters[i], name, length) == 0 &&
+                name[length] == '.')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// collects the selected leaves in tree order, counting matches in seen
+static void simple_test_collect(
+    struct simple_test_item *item,
+    const struct simple_test_options *options,
+    struct simple_test_result *results,
+    size_t *count,
+    size_t *seen
+) {
+    for (; item; item = item->next) {
+        if (item->kind == SIMPLE_TEST_INTERNAL) {
+            simple_test_collect(item->first_child, options, results, count,
+                seen);
+            continue;
+        }
+
+        char buff[1024];
+        simple_test_get_full_name(item, buff, 1024);
+        if (!simple_test_matches(options, buff)) {
+            continue;
+        }
+        if ((*seen)++ % options->shard_count == options->shard_index) {
+            results[(*count)++] = (struct simple_test_result) {
+                .item = item,
+                .outcome = SIMPLE_TEST_NOT_RUN,
+                .seconds = 0
+            };
+        }
+    }
+}
+
+static void simple_test_run_leaf(
+    struct simple_test_result *result
+) {
+    struct simple_test_item *item = result->item;
+    struct simple_error *error;
+
+    simple_alloc_reset();
+    double start = simple_test_now();
+    if (item->kind == SIMPLE_TEST_BENCH) {
+        error = simple_test_bench_run(item);
+    } else {
+        error = item->func();
+    }
+    result->seconds = simple_test_now() - start;
+
+    // output of the leaf goes before its result, and not lost by workers
+    if (!error) {
+        error = simple_sink_flush(simple_sink_get_stdout());
+    }
+    result->outcome = error ? SIMPLE_TEST_FAILED : SIMPLE_TEST_PASSED;
+
+    if (error) {
+        simple_error_show(error, stderr);
+        simple_error_destroy(error);
+    }
+
+    if (simple_test_census) {
+        char buff[1024];
+        simple_test_get_full_name(item, buff, 1024);
+        printf("Allocations of %s:\n", buff);
+        simple_alloc_census(stdout);
+        fflush(stdout);
+    }
+}
+
+static void simple_test_print_result(
+    const struct simple_test_result *result,
+    size_t done,
+    size_t count
+) {
+    static const char *labels[] = {"SKIP", "SKIP", "PASS", "FAIL", "CRASH"};
+    char buff[1024];
+    simple_test_get_full_name(result->item, buff, 1024);
+    printf("\033[0;%dm[ %*zu / %*zu ] %-5s %s (%.2f ms)\033[0m\n",
+        result->outcome == SIMPLE_TEST_PASSED ? 32 : 31, count_digits(count),
+        done, count_digits(count), count, labels[result->outcome], buff,
+        result->seconds * 1e3);
+    fflush(stdout);
+}
+
+// Runs in a forked worker: takes leaf indices from the work pipe until it
+// is drained and reports the start and the outcome of each.
+static _Noreturn void simple_test_worker(
+    struct simple_test_result *results,
+    uint32_t worker,
+    int work,
+    int report
+) {
+    uint32_t index;
+    while (read(work, &index, sizeof index) == sizeof index) {
+        struct simple_test_message message = {index, worker,
+            SIMPLE_TEST_STARTED, 0};
+        if (write(report, &message, sizeof message) != sizeof message) {
+            break;
+        }
+
+        simple_test_run_leaf(results + index);
+        message.outcome = results[index].outcome;
+        message.seconds = results[index].seconds;
+        if (write(report, &message, sizeof message) != sizeof message) {
+            break;
+        }
+    }
+    fflush(NULL);
+    _exit(0);
+}
+
+// Every worker is a forked process with its own copy of the runtime, so
+// leaves cannot disturb each other and a crash only fails its own leaf.
+static void simple_test_run_forked(
+    struct simple_test_result *results,
+    size_t count,
+    size_t jobs,
+    size_t *done
+) {
+    int work[2], report[2];
+    if (pipe(work) || pipe(report)) {
+        perror("pipe");
+        return;
+    }
+
+    // all indices fit into the pipe buffer, so workers never wait on it
+    for (uint32_t i = 0; i < count; i++) {
+        if (results[i].item->kind == SIMPLE_TEST_LEAF &&
+                write(work[1], &i, sizeof i) != sizeof i) {
+            perror("write");
+        }
+    }
+    close(work[1]);
+
+    pid_t *workers = calloc(jobs, sizeof *workers);
+    uint32_t *running = calloc(jobs, sizeof *running);
+    fflush(NULL);
+    for (size_t i = 0; i < jobs; i++) {
+        running[i] = UINT32_MAX;
+        workers[i] = fork();
+        if (workers[i] == 0) {
+            close(report[0]);
+            simple_test_worker(results, (uint32_t)i, work[0], report[1]);
+        }
+    }
+    close(work[0]);
+    close(report[1]);
+
+    struct simple_test_message message;
+    while (read(report[0], &message, sizeof message) == sizeof message) {
+        results[message.index].outcome = message.outcome;
+        results[message.index].seconds = message.seconds;
+        if (message.outcome == SIMPLE_TEST_STARTED) {
+            running[message.worker] = message.index;
+        } else {
+            running[message.worker] = UINT32_MAX;
+            simple_test_print_result(results + message.index, ++*done,
+                count);
+        }
+    }
+    close(report[0]);
+
+    for (size_t i = 0; i < jobs; i++) {
+        int status;
+        if (workers[i] < 0 || waitpid(workers[i], &status, 0) < 0) {
+            continue;
+        }
+        if (running[i] != UINT32_MAX) {
+            results[running[i]].outcome = SIMPLE_TEST_CRASHED;
+            simple_test_print_result(results + running[i], ++*done, count);
+        }
+    }
+    free(workers);
+    free(running);
+}
+
+static int simple_test_compare_slowest(
+    const void *lhs,
+    const void *rhs
+) {
+    const struct simple_test_result *l = lhs, *r = rhs;
+    return (l->seconds < r->seconds) - (l->seconds > r->seconds);
+}
+
+static void simple_test_report(
+    struct simple_test_result *results,
+    size_t count,
+    double seconds
+) {
+    size_t outcomes[SIMPLE_TEST_CRASHED + 1] = {0};
+    for (size_t i = 0; i < count; i++) {
+        outcomes[results[i].outcome]++;
+    }
+
+    qsort(results, count, sizeof *results, simple_test_compare_slowest);
+    printf("%s\n", "Slowest tests:");
+    for (size_t i = 0; i < count && i < SIMPLE_TEST_SLOWEST; i++) {
+        char buff[1024];
+        simple_test_get_full_name(results[i].item, buff, 1024);
+        printf("  %10.2f ms  %s\n", results[i].seconds * 1e3, buff);
+    }
+
+    printf("%zu passed, %zu failed, %zu crashed, %zu not run in %.2f s\n",
+        outcomes[SIMPLE_TEST_PASSED], outcomes[SIMPLE_TEST_FAILED],
+        outcomes[SIMPLE_TEST_CRASHED], outcomes[SIMPLE_TEST_NOT_RUN] +
+        outcomes[SIMPLE_TEST_STARTED], seconds);
+}
+
+int simple_test_run_with_args(
+    int argc,
+    char **argv
+) {
+    struct simple_test_options options;
+    if (simple_test_parse_options(argc, argv, &options)) {
+        return -1;
+    }
+
+    simple_test_census = options.census;
+
+    size_t count = 0, seen = 0;
+    struct simple_test_result *results = calloc(
+        simple_test_item_count(simple_test_root), sizeof *results);
+    simple_test_collect(simple_test_root, &options, results, &count, &seen);
+
+    double start = simple_test_now();
+    size_t done = 0;
+    if (options.jobs > 1) {
+        simple_test_run_forked(results, count, options.jobs, &done);
+    }
+
+    // benchmarks always run here, one at a time, so they measure alone
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].outcome == SIMPLE_TEST_NOT_RUN && (options.jobs <= 1 ||
+                results[i].item->kind == SIMPLE_TEST_BENCH)) {
+            simple_test_run_leaf(results + i);
+            simple_test_print_result(results + i, ++done, count);
+        }
+    }
+    simple_test_finish_json();
+    simple_test_finish_baseline();
+
+    simple_test_report(results, count, simple_test_now() - start);
+
+    int failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        failed += results[i].outcome != SIMPLE_TEST_PASSED;
+    }
+    free(results);
+    return failed;
 }
 
 void simple_test_destroy(
     void
 ) {
     simple_test_item_destroy(simple_test_root);
+    simple_perf_destroy(simple_test_perf);
+    simple_test_perf = NULL;
+    free(simple_test_baseline);
+    simple_test_baseline = NULL;
+    simple_test_baseline_count = 0;
 }
 
 
-void simple_test_create_leaf(
+// checks parent and appends a child item of the given kind to it
+static struct simple_test_item *simple_test_append_child(
     struct simple_test_item *parent,
     const char *name,
-    simple_test_func func
+    enum simple_test_item_kind kind
 ) {
     if (!parent) {
         fprintf(stderr, "Cannot create leaf '%s' to null parent.\n", name);
-        return;
+        return NULL;
     }
 
     if (parent->kind != SIMPLE_TEST_INTERNAL) {
         fprintf(stderr, "Cannot assign node '%s' to leaf.\n", name);
-        return;
+        return NULL;
     }
 
     struct simple_test_item *item = calloc(1, sizeof *item);
     *item = (struct simple_test_item) {
-        .kind = SIMPLE_TEST_LEAF,
+        .kind = kind,
         .next = NULL,
-        .func = func,
         .parent = parent
     };
 
@@ -200,7 +1097,35 @@ void simple_test_create_leaf(
     }
 
     parent->last_child = item;
+    return item;
+}
+
+void simple_test_create_leaf(
+    struct simple_test_item *parent,
+    const char *name,
+    simple_test_func func
+) {
+    struct simple_test_item *item;
+    item = simple_test_append_child(parent, name, SIMPLE_TEST_LEAF);
+    if (item) {
+        item->func = func;
+    }
+}
 
+void simple_test_create_bench(
+    struct simple_test_item *parent,
+    const char *name,
+    simple_test_bench_func func,
+    void *context,
+    size_t operations
+) {
+    struct simple_test_item *item;
+    item = simple_test_append_child(parent, name, SIMPLE_TEST_BENCH);
+    if (item) {
+        item->bench_func = func;
+        item->context = context;
+        item->operations = operations ? operations : 1;
+    }
 }
 
 struct simple_test_item *simple_test_create_node(
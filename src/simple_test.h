@@ -1,10 +1,34 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "simple_perf.h"
+
 struct simple_error;
 struct simple_test_item;
 
 typedef struct simple_error*(*simple_test_func)(void);
 
+// Runs the measured code iterations times in a row.
+typedef struct simple_error*(*simple_test_bench_func)(
+    void *context,
+    size_t iterations
+);
+
+// Times per operation over all samples of a benchmark, in nanoseconds.
+struct simple_test_bench_stats {
+    size_t iterations, samples;
+    double mean, min, median, p99, stddev;
+    double ops_per_second;
+    // hardware counter events per operation, see simple_perf.h
+    double counters[SIMPLE_PERF_COUNTER_COUNT];
+    bool counted[SIMPLE_PERF_COUNTER_COUNT];
+    // allocations and bytes per operation, with SIMPLE_ALLOC_TRACKING only
+    double allocations, bytes;
+};
+
 void simple_test_init(
     void
 );
@@ -13,6 +37,19 @@ void simple_test_run(
     void
 );
 
+// Runs the leaves selected on the command line and reports the slowest.
+// Returns the number of leaves that did not pass, -1 for bad arguments.
+//
+// --filter pattern: fnmatch pattern over full names without "<root>.", a
+// node name selects all below it, may be repeated.
+// --shard i/n: only every n-th selected leaf, starting at i.
+// --jobs n: run tests in n forked workers, 0 for one per cpu.
+// --census: dump the allocations of every leaf, see simple_alloc.h.
+int simple_test_run_with_args(
+    int argc,
+    char **argv
+);
+
 void simple_test_destroy(
     void
 );
@@ -28,6 +65,57 @@ void simple_test_create_leaf(
     simple_test_func func
 );
 
+// The iteration count is calibrated so one sample takes a few milliseconds,
+// then samples are taken until the time budget of the benchmark is used.
+// One iteration performs operations operations, stats are per operation.
+void simple_test_create_bench(
+    struct simple_test_item *parent,
+    const char *name,
+    simple_test_bench_func func,
+    void *context,
+    size_t operations
+);
+
+// Once the run completes, the stats of every benchmark are written to file
+// as JSON. NULL disables it, which is the default.
+void simple_test_set_json_output(
+    FILE *file
+);
+
+// Once the run completes, the samples of every benchmark are written to
+// file as a baseline to compare later runs against. NULL disables it.
+void simple_test_set_baseline_output(
+    FILE *file
+);
+
+// Compares the next run against a baseline written by earlier ones, saved
+// baselines of several runs can be concatenated. Samples of one run share
+// the state of the machine and process, so runs are compared as a whole: a
+// benchmark regressed when its fastest sample is more than threshold (0.05
+// for 5%) slower than the median of the slowest baseline run, or when it
+// allocates more than threshold more per operation. Allocations are only
+// compared when both runs had SIMPLE_ALLOC_TRACKING.
+//
+// Run to run noise sets the false positive rate, pick a threshold above
+// it. On a shared VM whose medians moved by 59% between runs of the same
+// binary, a 5% threshold flagged 23% of benchmarks against one baseline
+// run and 9% against three, a 100% threshold 1% and none.
+struct simple_error *simple_test_load_baseline(
+    FILE *file,
+    double threshold
+) __attribute__((warn_unused_result));
+
+// Regressions found by the last run against a baseline.
+size_t simple_test_get_regression_count(
+    void
+);
+
+// Counts cycles, instructions, cache and branch misses over the samples of
+// every benchmark when the system allows it, off by default.
+void simple_test_set_perf_counters(
+    bool enabled
+);
+
 struct simple_test_item *simple_test_create_node(
     struct simple_test_item *parent,
     const char *name
@@ -0,0 +1,228 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "simple_trace.h"
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// events per thread, a power of two
+#define SIMPLE_TRACE_CAPACITY 8192
+
+// 32 bytes, the thread is kept per event because buffers are reused
+struct simple_trace_event {
+    uint64_t timestamp;
+    const char *name;
+    int64_t value;
+    uint32_t thread;
+    uint32_t phase;
+};
+
+// A single producer single consumer ring. The owning thread advances head,
+// the exporter advances tail, each on its own cache line. Buffers are never
+// freed, the buffer of an exited thread is reused by the next new thread.
+struct simple_trace_buffer {
+    _Alignas(64) atomic_size_t head;
+    _Alignas(64) atomic_size_t tail;
+    _Alignas(64) uint32_t thread;
+    atomic_size_t recorded;
+    atomic_size_t dropped;
+    atomic_bool in_use;
+    struct simple_trace_buffer *next;
+    struct simple_trace_event events[SIMPLE_TRACE_CAPACITY];
+};
+
+static _Atomic(struct simple_trace_buffer *) simple_trace_buffers = NULL;
+static atomic_uint simple_trace_threads = 0;
+static atomic_size_t simple_trace_exported = 0;
+static pthread_mutex_t simple_trace_export_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t simple_trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t simple_trace_key;
+static _Thread_local struct simple_trace_buffer *simple_trace_local = NULL;
+
+// unrecorded events stay behind for the next export
+static void simple_trace_buffer_release(
+    void *pointer
+) {
+    struct simple_trace_buffer *buffer = pointer;
+    atomic_store_explicit(&buffer->in_use, false, memory_order_release);
+}
+
+static void simple_trace_key_create(
+    void
+) {
+    pthread_key_create(&simple_trace_key, simple_trace_buffer_release);
+}
+
+static struct simple_trace_buffer *simple_trace_get_buffer(
+    void
+) {
+    if (simple_trace_local) {
+        return simple_trace_local;
+    }
+
+    struct simple_trace_buffer *buffer;
+    buffer = atomic_load_explicit(&simple_trace_buffers,
+        memory_order_acquire);
+    for (; buffer; buffer = buffer->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong_explicit(&buffer->in_use,
+                &expected, true, memory_order_acq_rel,
+                memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (!buffer) {
+        buffer = aligned_alloc(_Alignof(struct simple_trace_buffer),
+            sizeof *buffer);
+        memset(buffer, 0, sizeof *buffer);
+        atomic_init(&buffer->head, 0);
+        atomic_init(&buffer->tail, 0);
+        atomic_init(&buffer->recorded, 0);
+        atomic_init(&buffer->dropped, 0);
+        atomic_init(&buffer->in_use, true);
+
+        buffer->next = atomic_load_explicit(&simple_trace_buffers,
+            memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&simple_trace_buffers,
+                &buffer->next, buffer, memory_order_release,
+                memory_order_relaxed)) {
+        }
+    }
+
+    // numbered from 1 in order of first use, reused buffers get a new one
+    buffer->thread = atomic_fetch_add(&simple_trace_threads, 1) + 1;
+
+    pthread_once(&simple_trace_key_once, simple_trace_key_create);
+    pthread_setspecific(simple_trace_key, buffer);
+    simple_trace_local = buffer;
+    return buffer;
+}
+
+void simple_trace_record(
+    enum simple_trace_phase phase,
+    const char *name,
+    int64_t value
+) {
+    struct simple_trace_buffer *buffer = simple_trace_get_buffer();
+    size_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+
+    if (head - tail == SIMPLE_TRACE_CAPACITY) {
+        atomic_store_explicit(&buffer->dropped,
+            atomic_load_explicit(&buffer->dropped, memory_order_relaxed) + 1,
+            memory_order_relaxed);
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    buffer->events[head & (SIMPLE_TRACE_CAPACITY - 1)] =
+        (struct simple_trace_event) {
+            .timestamp = (uint64_t)now.tv_sec * 1000000000 +
+                (uint64_t)now.tv_nsec,
+            .name = name,
+            .value = value,
+            .thread = buffer->thread,
+            .phase = phase
+        };
+    atomic_store_explicit(&buffer->recorded,
+        atomic_load_explicit(&buffer->recorded, memory_order_relaxed) + 1,
+        memory_order_relaxed);
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+bool simple_trace_enabled(
+    void
+) {
+#ifdef SIMPLE_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void simple_trace_write_event(
+    FILE *file,
+    const struct simple_trace_event *event,
+    pid_t pid,
+    bool first
+) {
+    static const char *phases[] = {"B", "E", "i", "C"};
+
+    // Chrome wants microseconds
+    fprintf(file, "%s\n    {\"name\": \"%s\", \"ph\": \"%s\", "
+        "\"ts\": %.3f, \"pid\": %ld, \"tid\": %u", first ? "" : ",",
+        event->name, phases[event->phase], (double)event->timestamp / 1e3,
+        (long)pid, event->thread);
+
+    if (event->phase == SIMPLE_TRACE_INSTANT) {
+        fprintf(file, "%s", ", \"s\": \"t\"");
+    } else if (event->phase == SIMPLE_TRACE_COUNTER) {
+        fprintf(file, ", \"args\": {\"value\": %lld}",
+            (long long)event->value);
+    }
+    fprintf(file, "%s", "}");
+}
+
+void simple_trace_export(
+    FILE *file
+) {
+    pid_t pid = getpid();
+    bool first = true;
+    size_t exported = 0;
+
+    pthread_mutex_lock(&simple_trace_export_lock);
+    fprintf(file, "%s", "{\"traceEvents\": [");
+
+    struct simple_trace_buffer *buffer;
+    buffer = atomic_load_explicit(&simple_trace_buffers,
+        memory_order_acquire);
+    for (; buffer; buffer = buffer->next) {
+        size_t head = atomic_load_explicit(&buffer->head,
+            memory_order_acquire);
+        size_t tail = atomic_load_explicit(&buffer->tail,
+            memory_order_relaxed);
+
+        for (; tail != head; tail++) {
+            simple_trace_write_event(file,
+                buffer->events + (tail & (SIMPLE_TRACE_CAPACITY - 1)), pid,
+                first);
+            first = false;
+            exported++;
+        }
+        atomic_store_explicit(&buffer->tail, tail, memory_order_release);
+    }
+
+    fprintf(file, "%s", "\n], \"displayTimeUnit\": \"ns\"}\n");
+    atomic_fetch_add(&simple_trace_exported, exported);
+    pthread_mutex_unlock(&simple_trace_export_lock);
+}
+
+void simple_trace_get_stats(
+    struct simple_trace_stats *stats
+) {
+    *stats = (struct simple_trace_stats) {
+        .recorded = 0,
+        .dropped = 0,
+        .exported = atomic_load(&simple_trace_exported),
+        .threads = atomic_load(&simple_trace_threads)
+    };
+
+    struct simple_trace_buffer *buffer;
+    buffer = atomic_load_explicit(&simple_trace_buffers,
+        memory_order_acquire);
+    for (; buffer; buffer = buffer->next) {
+        stats->recorded += atomic_load_explicit(&buffer->recorded,
+            memory_order_relaxed);
+        stats->dropped += atomic_load_explicit(&buffer->dropped,
+            memory_order_relaxed);
+    }
+}
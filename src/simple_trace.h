@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Trace points for hot paths. Compiled in only with SIMPLE_TRACING defined
+// (cmake -DSIMPLE_TRACING=ON), without it the macros below expand to
+// nothing and their arguments are not evaluated.
+//
+// Every thread writes binary events into its own ring buffer without locks
+// or stdio, a full buffer drops new events. simple_trace_export drains the
+// buffers of all threads as Chrome trace JSON, for chrome://tracing or
+// Perfetto. Names are written as they are, so keep them to identifiers, and
+// they must outlive the export, in practice they are string literals.
+
+#ifdef SIMPLE_TRACING
+#define simple_trace_begin(name) \
+    simple_trace_record(SIMPLE_TRACE_BEGIN, name, 0)
+#define simple_trace_end(name) \
+    simple_trace_record(SIMPLE_TRACE_END, name, 0)
+#define simple_trace_instant(name) \
+    simple_trace_record(SIMPLE_TRACE_INSTANT, name, 0)
+#define simple_trace_counter(name, value) \
+    simple_trace_record(SIMPLE_TRACE_COUNTER, name, value)
+#else
+#define simple_trace_begin(name) ((void)0)
+#define simple_trace_end(name) ((void)0)
+#define simple_trace_instant(name) ((void)0)
+#define simple_trace_counter(name, value) ((void)0)
+#endif
+
+enum simple_trace_phase {
+    SIMPLE_TRACE_BEGIN,
+    SIMPLE_TRACE_END,
+    SIMPLE_TRACE_INSTANT,
+    SIMPLE_TRACE_COUNTER
+};
+
+struct simple_trace_stats {
+    size_t recorded;
+    size_t dropped;
+    size_t exported;
+    size_t threads;
+};
+
+// Use the macros above, which compile out.
+void simple_trace_record(
+    enum simple_trace_phase phase,
+    const char *name,
+    int64_t value
+);
+
+bool simple_trace_enabled(
+    void
+);
+
+// Writes every event recorded since the last export as one Chrome trace
+// JSON document. Threads may keep recording meanwhile, exports are
+// serialized.
+void simple_trace_export(
+    FILE *file
+);
+
+void simple_trace_get_stats(
+    struct simple_trace_stats *stats
+);
@@ -1,27 +1,1809 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "../simple_test.h"
+#include "../simple_alloc.h"
+#include "../simple_perf.h"
+#include "../simple_profile.h"
+#include "../simple_sink.h"
+#include "../simple_trace.h"
+#include "../simple_array.h"
+#include "../simple_bigint.h"
+#include "../simple_btree.h"
+#include "../simple_concurrent_hashtable.h"
+#include "../simple_epoch.h"
 #include "../simple_error.h"
+#include "../simple_hamt.h"
 #include "../simple_hashtable.h"
+#include "../simple_heap.h"
+#include "../simple_int_hashtable.h"
+#include "../simple_list.h"
+#include "../simple_mapped_hashtable.h"
+#include "../simple_serial.h"
+#include "../simple_object.h"
 #include "../type.h"
 
-#include <malloc.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static struct simple_error *test_hashtable_init(
+    void
+) {
+    struct simple_error *error;
+    struct type *string_type;
+    error = type_registry_get_type("string", &string_type);
+    simple_error_check(error);
+
+    struct simple_hashtable *table;
+    table = simple_hashtable_new(string_type, string_type);
+    simple_hashtable_destroy(table);
+
+    cleanup:
+    return NULL;
+}
+
+static struct simple_error *test_hashtable_erase(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct type *int_type;
+    struct simple_hashtable *table = NULL;
+    struct object *key = NULL, *found = NULL;
+
+    error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    error = object_new_int(0, &key);
+    simple_error_check(error);
+
+    // large enough to grow the table several times
+    table = simple_hashtable_new(int_type, int_type);
+    for (int i = 0; i < 1000; i++) {
+        error = object_set_int(key, i);
+        simple_error_check(error);
+        error = simple_hashtable_insert(table, key, key);
+        simple_error_check(error);
+    }
+
+    for (int i = 0; i < 1000; i += 2) {
+        bool erased;
+        error = object_set_int(key, i);
+        simple_error_check(error);
+        error = simple_hashtable_erase(table, key, &erased);
+        simple_error_check(error);
+        if (!erased) {
+            error = simple_error_new("Key %d was not erased.", i);
+            simple_error_check(error);
+        }
+    }
+
+    if (simple_hashtable_size(table) != 500) {
+        error = simple_error_new("Expected 500 entries, got %zu.",
+            simple_hashtable_size(table));
+        simple_error_check(error);
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        error = object_set_int(key, i);
+        simple_error_check(error);
+        error = simple_hashtable_find(table, key, &found);
+        simple_error_check(error);
+
+        int value = -1;
+        if (found) {
+            error = object_get_int(found, &value);
+            simple_error_check(error);
+        }
+        object_refcount_decrease(found);
+
+        if ((i % 2 == 0) != !found || (found && value != i)) {
+            error = simple_error_new("Wrong lookup result for key %d.", i);
+            simple_error_check(error);
+        }
+    }
+
+    cleanup:
+    simple_hashtable_destroy(table);
+    object_refcount_decrease(key);
+    return error;
+}
+
+static struct simple_error *test_hashtable_count_visit(
+    const struct object *key,
+    const struct object *value,
+    void *context
+) {
+    (void)value;
+
+    int *visits = context, index;
+    struct simple_error *error = object_get_int(key, &index);
+    simple_error_check(error);
+
+    if (index < 100) {
+        visits[index]++;
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *test_hashtable_scan(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct type *int_type;
+    struct simple_hashtable *table = NULL;
+    struct object *key = NULL;
+    int visits[100] = {0};
+    size_t cursor = 0;
+    int next_key = 0;
+
+    error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    error = object_new_int(0, &key);
+    simple_error_check(error);
+
+    table = simple_hashtable_new(int_type, int_type);
+    for (; next_key < 100; next_key++) {
+        error = object_set_int(key, next_key);
+        simple_error_check(error);
+        error = simple_hashtable_insert(table, key, key);
+        simple_error_check(error);
+    }
+
+    // grow the table between scan calls, the first 100 keys must still be
+    // visited exactly once
+    do {
+        error = simple_hashtable_scan(table, &cursor, 10,
+            test_hashtable_count_visit, visits);
+        simple_error_check(error);
+
+        for (int i = 0; i < 50; i++, next_key++) {
+            error = object_set_int(key, next_key);
+            simple_error_check(error);
+            error = simple_hashtable_insert(table, key, key);
+            simple_error_check(error);
+        }
+    } while (cursor);
+
+    for (int i = 0; i < 100; i++) {
+        if (visits[i] != 1) {
+            error = simple_error_new("Key %d was visited %d times.", i,
+                visits[i]);
+            simple_error_check(error);
+        }
+    }
+
+    cleanup:
+    simple_hashtable_destroy(table);
+    object_refcount_decrease(key);
+    return error;
+}
+
+static struct simple_error *test_hashtable_batch(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct type *int_type;
+    struct simple_hashtable *table = NULL;
+    struct object *keys[2000] = {NULL}, *found[2000] = {NULL};
+
+    error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    for (int i = 0; i < 2000; i++) {
+        error = object_new_int(i, keys + i);
+        simple_error_check(error);
+    }
+
+    // the even keys go in, the odd ones must not be found
+    const struct object *even[1000];
+    for (size_t i = 0; i < 1000; i++) {
+        even[i] = keys[2 * i];
+    }
+
+    table = simple_hashtable_new(int_type, int_type);
+    error = simple_hashtable_insert_many(table, even, even, 1000);
+    simple_error_check(error);
+
+    error = simple_hashtable_find_many(table,
+        (const struct object *const *)keys, 2000, found);
+    simple_error_check(error);
+
+    for (int i = 0; i < 2000; i++) {
+        int value = -1;
+        if (found[i]) {
+            error = object_get_int(found[i], &value);
+            simple_error_check(error);
+        }
+        if ((i % 2 == 0) != !!found[i] || (found[i] && value != i)) {
+            error = simple_error_new("Wrong batch lookup for key %d.", i);
+            simple_error_check(error);
+        }
+    }
+
+    cleanup:
+    simple_hashtable_destroy(table);
+    for (int i = 0; i < 2000; i++) {
+        object_refcount_decrease(keys[i]);
+        object_refcount_decrease(found[i]);
+    }
+    return error;
+}
+
+static struct simple_error *test_int_hashtable_count(
+    int64_t key,
+    const struct object *value,
+    void *context
+) {
+    (void)key;
+    (void)value;
+    (*(size_t *)context)++;
+    return NULL;
+}
+
+static struct simple_error *test_hashtable_int(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct type *int_type;
+    struct simple_int_hashtable *table = NULL;
+    struct object *value = NULL, *found = NULL;
+    size_t visited = 0;
+    bool erased;
+
+    error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    error = object_new_int(7, &value);
+    simple_error_check(error);
+
+    // keys spread over the whole range, including negative ones
+    table = simple_int_hashtable_new(int_type);
+    for (int64_t i = -5000; i < 5000; i++) {
+        error = simple_int_hashtable_insert(table, i * 1000003, value);
+        simple_error_check(error);
+    }
+
+    // erasing shifts later entries back, everything else must stay found
+    for (int64_t i = -5000; i < 5000; i += 3) {
+        simple_int_hashtable_erase(table, i * 1000003, &erased);
+        if (!erased) {
+            error = simple_error_new("Key %lld was not erased.",
+                (long long)i);
+            simple_error_check(error);
+        }
+    }
+
+    for (int64_t i = -5000; i < 5000; i++) {
+        error = simple_int_hashtable_find(table, i * 1000003, &found);
+        simple_error_check(error);
+        if (!found != ((i + 5000) % 3 == 0)) {
+            error = simple_error_new("Wrong lookup for key %lld.",
+                (long long)i);
+            simple_error_check(error);
+        }
+        object_refcount_decrease(found);
+        found = NULL;
+    }
+
+    error = simple_int_hashtable_foreach(table, test_int_hashtable_count,
+        &visited);
+    simple_error_check(error);
+
+    if (visited != 6666 || simple_int_hashtable_size(table) != 6666) {
+        error = simple_error_new("Expected 6666 entries, visited %zu.",
+            visited);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    simple_int_hashtable_destroy(table);
+    object_refcount_decrease(value);
+    return error;
+}
+
+#define TEST_CONCURRENT_THREADS 4
+#define TEST_CONCURRENT_KEYS 20000
+
+struct test_concurrent_context {
+    struct simple_concurrent_hashtable *table;
+    struct object **keys;
+    size_t thread_id;
+    struct simple_error *error;
+};
+
+// every writer owns the keys equal to its id modulo the thread count
+static void *test_concurrent_writer(
+    void *pointer
+) {
+    struct test_concurrent_context *context = pointer;
+    struct simple_error *error = NULL;
+
+    for (size_t i = context->thread_id; i < TEST_CONCURRENT_KEYS;
+            i += TEST_CONCURRENT_THREADS) {
+        error = simple_concurrent_hashtable_insert(context->table,
+            context->keys[i], context->keys[i]);
+        simple_error_check(error);
+    }
+
+    // erase every other owned key again, the table keeps growing meanwhile
+    for (size_t i = context->thread_id; i < TEST_CONCURRENT_KEYS;
+            i += 2 * TEST_CONCURRENT_THREADS) {
+        bool erased;
+        error = simple_concurrent_hashtable_erase(context->table,
+            context->keys[i], &erased);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    context->error = error;
+    return NULL;
+}
+
+static void *test_concurrent_reader(
+    void *pointer
+) {
+    struct test_concurrent_context *context = pointer;
+    struct simple_error *error = NULL;
+
+    for (size_t i = 0; i < TEST_CONCURRENT_KEYS; i++) {
+        const struct object *found;
+        bool equals = true;
+
+        // found must not be reclaimed while it is compared
+        simple_epoch_enter();
+        error = simple_concurrent_hashtable_find(context->table,
+            context->keys[i], &found);
+        if (!error && found) {
+            error = object_equals(found, context->keys[i], &equals);
+        }
+        simple_epoch_leave();
+        simple_error_check(error);
+
+        if (!equals) {
+            error = simple_error_new("Key %zu maps to another value.", i);
+            simple_error_check(error);
+        }
+    }
+
+    cleanup:
+    context->error = error;
+    return NULL;
+}
+
+static struct simple_error *test_concurrent_hashtable_threads(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct type *int_type;
+    struct simple_concurrent_hashtable *table = NULL;
+    struct object **keys = calloc(TEST_CONCURRENT_KEYS, sizeof *keys);
+    struct test_concurrent_context contexts[2 * TEST_CONCURRENT_THREADS];
+    pthread_t threads[2 * TEST_CONCURRENT_THREADS];
+
+    error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    // objects are created up front, construction is not thread safe
+    for (int i = 0; i < TEST_CONCURRENT_KEYS; i++) {
+        error = object_new_int(i, keys + i);
+        simple_error_check(error);
+    }
+
+    table = simple_concurrent_hashtable_new(int_type, int_type);
+    for (size_t i = 0; i < 2 * TEST_CONCURRENT_THREADS; i++) {
+        contexts[i] = (struct test_concurrent_context) {
+            .table = table,
+            .keys = keys,
+            .thread_id = i % TEST_CONCURRENT_THREADS,
+            .error = NULL
+        };
+        pthread_create(threads + i, NULL, i < TEST_CONCURRENT_THREADS ?
+            test_concurrent_writer : test_concurrent_reader, contexts + i);
+    }
+    for (size_t i = 0; i < 2 * TEST_CONCURRENT_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        if (contexts[i].error && !error) {
+            error = contexts[i].error;
+        } else if (contexts[i].error) {
+            simple_error_destroy(contexts[i].error);
+        }
+    }
+    simple_error_check(error);
+
+    if (simple_concurrent_hashtable_size(table) != TEST_CONCURRENT_KEYS / 2) {
+        error = simple_error_new("Expected %d entries, got %zu.",
+            TEST_CONCURRENT_KEYS / 2, simple_concurrent_hashtable_size(table));
+        simple_error_check(error);
+    }
+
+    for (size_t i = 0; i < TEST_CONCURRENT_KEYS; i++) {
+        const struct object *found;
+        error = simple_concurrent_hashtable_find(table, keys[i], &found);
+        simple_error_check(error);
+
+        bool expected = (i / TEST_CONCURRENT_THREADS) % 2 == 1;
+        if (expected != !!found) {
+            error = simple_error_new("Wrong lookup result for key %zu.", i);
+            simple_error_check(error);
+        }
+    }
+
+    cleanup:
+    simple_concurrent_hashtable_destroy(table);
+    for (size_t i = 0; i < TEST_CONCURRENT_KEYS; i++) {
+        object_refcount_decrease(keys[i]);
+    }
+    free(keys);
+    return error;
+}
+
+struct test_epoch_reader {
+    atomic_bool entered, release;
+};
+
+static void *test_epoch_reader(
+    void *pointer
+) {
+    struct test_epoch_reader *reader = pointer;
+
+    simple_epoch_enter();
+    atomic_store(&reader->entered, true);
+    while (!atomic_load(&reader->release)) {
+        sched_yield();
+    }
+    simple_epoch_leave();
+    return NULL;
+}
+
+static void test_epoch_count_reclaim(
+    void *pointer
+) {
+    atomic_fetch_add((atomic_int *)pointer, 1);
+}
+
+static struct simple_error *test_epoch_reclaim(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct test_epoch_reader reader;
+    atomic_int reclaimed = 0;
+    struct simple_epoch_stats before, after;
+    pthread_t thread;
+
+    atomic_init(&reader.entered, false);
+    atomic_init(&reader.release, false);
+    simple_epoch_get_stats(&before);
+
+    pthread_create(&thread, NULL, test_epoch_reader, &reader);
+    while (!atomic_load(&reader.entered)) {
+        sched_yield();
+    }
+
+    // the reader may still see anything retired now
+    for (int i = 0; i < 1000; i++) {
+        simple_epoch_retire(test_epoch_count_reclaim, &reclaimed);
+    }
+    simple_epoch_collect();
+    int early = atomic_load(&reclaimed);
+
+    atomic_store(&reader.release, true);
+    pthread_join(thread, NULL);
+    simple_epoch_synchronize();
+    simple_epoch_get_stats(&after);
+
+    if (early != 0 || atomic_load(&reclaimed) != 1000 ||
+            after.retired - before.retired != 1000 || after.pending != 0) {
+        error = simple_error_new("Reclaimed %d during and %d after the "
+            "critical section, %zu pending.", early,
+            atomic_load(&reclaimed), after.pending);
+    }
+    return error;
+}
+
+// checks map holds exactly the keys in [0, count) that pass filter
+static struct simple_error *test_hamt_check(
+    const struct simple_hamt *map,
+    struct object **keys,
+    int count,
+    bool odd_only
+) {
+    struct simple_error *error = NULL;
+    size_t expected_size = 0;
+
+    for (int i = 0; i < 1000; i++) {
+        const struct object *found;
+        error = simple_hamt_find(map, keys[i], &found);
+        simple_error_check(error);
+
+        bool expected = i < count && (!odd_only || i % 2);
+        int value = -1;
+        if (found) {
+            error = object_get_int(found, &value);
+            simple_error_check(error);
+        }
+        if (expected != !!found || (found && value != i)) {
+            error = simple_error_new("Wrong lookup for key %d.", i);
+            simple_error_check(error);
+        }
+        expected_size += expected;
+    }
+
+    if (simple_hamt_size(map) != expected_size) {
+        error = simple_error_new("Expected size %zu, got %zu.", expected_size,
+            simple_hamt_size(map));
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *test_hamt_snapshot(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct type *int_type;
+    struct simple_hamt *map = NULL, *snapshot = NULL, *updated;
+    struct object *keys[1000] = {NULL}, *attribute = NULL;
+    bool erased, equals;
+
+    error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    for (int i = 0; i < 1000; i++) {
+        error = object_new_int(i, keys + i);
+        simple_error_check(error);
+    }
+
+    map = simple_hamt_new(int_type, int_type);
+    for (int i = 0; i < 1000; i++) {
+        if (i == 500) {
+            snapshot = simple_hamt_share(map);
+        }
+        error = simple_hamt_insert(map, keys[i], keys[i], &updated);
+        simple_error_check(error);
+        simple_hamt_release(map);
+        map = updated;
+    }
+
+    for (int i = 0; i < 1000; i += 2) {
+        error = simple_hamt_erase(map, keys[i], &updated, &erased);
+        simple_error_check(error);
+        simple_hamt_release(map);
+        map = updated;
+        if (!erased) {
+            error = simple_error_new("Key %d was not erased.", i);
+            simple_error_check(error);
+        }
+    }
+
+    // later updates must not show through the snapshot
+    error = test_hamt_check(snapshot, keys, 500, false);
+    simple_error_check(error);
+
+    error = test_hamt_check(map, keys, 1000, true);
+    simple_error_check(error);
+
+    error = simple_hamt_equals(map, snapshot, &equals);
+    simple_error_check(error);
+    if (equals) {
+        error = simple_error_new("%s", "Different maps compare equal.");
+        simple_error_check(error);
+    }
+
+    // type attributes are stored in a hamt as well
+    error = type_get_attribute(int_type, "_init", &attribute);
+    simple_error_check(error);
+
+    cleanup:
+    simple_hamt_release(map);
+    simple_hamt_release(snapshot);
+    object_refcount_decrease(attribute);
+    for (int i = 0; i < 1000; i++) {
+        object_refcount_decrease(keys[i]);
+    }
+    return error;
+}
+
+// walks tree in order, keys must be exactly the ints in [0, count) that
+// are not multiples of skip
+static struct simple_error *test_btree_check(
+    const struct simple_btree *tree,
+    int count,
+    int skip
+) {
+    struct simple_error *error = NULL;
+    struct simple_btree_cursor cursor;
+    const struct object *key, *value;
+    int expected = 0, found;
+
+    simple_btree_first(tree, &cursor);
+    while (simple_btree_cursor_next(&cursor, &key, &value)) {
+        while (expected % skip == 0) {
+            expected++;
+        }
+        error = object_get_int(key, &found);
+        simple_error_check(error);
+        if (found != expected) {
+            error = simple_error_new("Expected key %d, got %d.", expected,
+                found);
+            simple_error_check(error);
+        }
+        expected++;
+    }
+
+    while (expected < count && expected % skip == 0) {
+        expected++;
+    }
+    if (expected != count) {
+        error = simple_error_new("Iteration stopped at %d.", expected);
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *test_btree_order(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct type *int_type;
+    struct simple_btree *tree = NULL;
+    struct object *keys[5000] = {NULL}, *found = NULL;
+    struct simple_btree_cursor cursor;
+    const struct object *key, *value;
+    size_t order[5000];
+    uint64_t state = 42;
+    bool erased;
+    int bound;
+
+    error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    for (int i = 0; i < 5000; i++) {
+        error = object_new_int(i, keys + i);
+        simple_error_check(error);
+        order[i] = (size_t)i;
+    }
+
+    // shuffled, so nodes split and merge all over the tree
+    for (size_t i = 4999; i > 0; i--) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t j = (size_t)(state >> 33) % (i + 1);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    tree = simple_btree_new(int_type, int_type);
+    for (size_t i = 0; i < 5000; i++) {
+        error = simple_btree_insert(tree, keys[order[i]], keys[order[i]]);
+        simple_error_check(error);
+    }
+
+    for (size_t i = 0; i < 5000; i++) {
+        if (order[i] % 3 == 0) {
+            error = simple_btree_erase(tree, keys[order[i]], &erased);
+            simple_error_check(error);
+        }
+    }
+
+    if (simple_btree_size(tree) != 3333) {
+        error = simple_error_new("Expected 3333 keys, got %zu.",
+            simple_btree_size(tree));
+        simple_error_check(error);
+    }
+
+    error = test_btree_check(tree, 5000, 3);
+    simple_error_check(error);
+
+    error = simple_btree_find(tree, keys[301], &found);
+    simple_error_check(error);
+    if (!found) {
+        error = simple_error_new("%s", "Key 301 not found.");
+        simple_error_check(error);
+    }
+
+    // 300 is gone, so both bounds land on 301, and past it on 302
+    error = simple_btree_lower_bound(tree, keys[300], &cursor);
+    simple_error_check(error);
+    (void)simple_btree_cursor_next(&cursor, &key, &value);
+    error = object_get_int(key, &bound);
+    simple_error_check(error);
+
+    error = simple_btree_upper_bound(tree, keys[301], &cursor);
+    simple_error_check(error);
+    (void)simple_btree_cursor_next(&cursor, &key, &value);
+    int upper;
+    error = object_get_int(key, &upper);
+    simple_error_check(error);
+
+    if (bound != 301 || upper != 302) {
+        error = simple_error_new("Wrong bounds %d and %d.", bound, upper);
+        simple_error_check(error);
+    }
+
+    // erasing everything collapses the tree back to a single leaf
+    for (int i = 0; i < 5000; i++) {
+        error = simple_btree_erase(tree, keys[i], &erased);
+        simple_error_check(error);
+        if (erased != (i % 3 != 0)) {
+            error = simple_error_new("Wrong erase result for key %d.", i);
+            simple_error_check(error);
+        }
+    }
+
+    simple_btree_first(tree, &cursor);
+    if (simple_btree_size(tree) != 0 ||
+            simple_btree_cursor_next(&cursor, &key, &value)) {
+        error = simple_error_new("%s", "Empty tree still has entries.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    simple_btree_destroy(tree);
+    object_refcount_decrease(found);
+    for (int i = 0; i < 5000; i++) {
+        object_refcount_decrease(keys[i]);
+    }
+    return error;
+}
+
+static struct simple_bigint *test_random_bigint(
+    size_t limb_count,
+    uint64_t *state
+) {
+    uint64_t *limbs = calloc(limb_count, sizeof *limbs);
+    for (size_t i = 0; i < limb_count; i++) {
+        *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+        limbs[i] = *state;
+    }
+    struct simple_bigint *bigint;
+    bigint = simple_bigint_new_limbs(limbs, limb_count, *state & 1);
+    free(limbs);
+    return bigint;
+}
+
+static struct simple_error *test_bigint_mul(
+    void
+) {
+    static const size_t sizes[] = {1, 3, 31, 32, 77, 160, 171, 500};
+    struct simple_error *error = NULL;
+    uint64_t state = 42;
+
+    for (size_t i = 0; i < sizeof sizes / sizeof *sizes; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            struct simple_bigint *lhs, *rhs, *expected, *product;
+            lhs = test_random_bigint(sizes[i], &state);
+            rhs = test_random_bigint(sizes[j], &state);
+            expected = simple_bigint_mul_with(lhs, rhs,
+                SIMPLE_BIGINT_MUL_SCHOOLBOOK);
+
+            for (int algorithm = SIMPLE_BIGINT_MUL_AUTO;
+                    algorithm <= SIMPLE_BIGINT_MUL_TOOM3; algorithm++) {
+                product = simple_bigint_mul_with(lhs, rhs,
+                    (enum simple_bigint_mul_algorithm)algorithm);
+                if (!error && !simple_bigint_equals(product, expected)) {
+                    error = simple_error_new("Algorithm %d is wrong for "
+                        "%zu x %zu limbs.", algorithm, sizes[i], sizes[j]);
+                }
+                simple_bigint_destroy(product);
+            }
+
+            simple_bigint_destroy(lhs);
+            simple_bigint_destroy(rhs);
+            simple_bigint_destroy(expected);
+            simple_error_check(error);
+        }
+    }
+
+    cleanup:
+    return error;
+}
+
+static struct simple_error *test_bigint_decimal(
+    void
+) {
+    static const char *cases[] = {"0", "-1", "18446744073709551616",
+        "-9223372036854775808", "1000000000000000000000000000000000000001"};
+    struct simple_error *error = NULL;
+    struct simple_bigint *bigint = NULL;
+    char *decimal = NULL;
+
+    for (size_t i = 0; i < sizeof cases / sizeof *cases; i++) {
+        error = simple_bigint_parse(cases[i], &bigint);
+        simple_error_check(error);
+
+        decimal = simple_bigint_to_decimal(bigint);
+        if (strcmp(decimal, cases[i]) != 0) {
+            error = simple_error_new("Expected %s, got %s.", cases[i],
+                decimal);
+            simple_error_check(error);
+        }
+
+        free(decimal);
+        decimal = NULL;
+        simple_bigint_destroy(bigint);
+        bigint = NULL;
+    }
+
+    error = simple_bigint_parse("12a", &bigint);
+    if (!error) {
+        error = simple_error_new("%s", "Parsed invalid digits.");
+        simple_error_check(error);
+    }
+    simple_error_destroy(error);
+    error = NULL;
+
+    cleanup:
+    free(decimal);
+    simple_bigint_destroy(bigint);
+    return error;
+}
+
+static struct simple_error *test_bigint_hash(
+    void
+) {
+    struct simple_error *error;
+    struct object *small = NULL, *big = NULL;
+    bool equals;
+
+    error = type_registry_construct("int", &small);
+    simple_error_check(error);
+
+    error = object_set_int(small, -12345);
+    simple_error_check(error);
+
+    error = object_new_bigint(simple_bigint_new(-12345), &big);
+    simple_error_check(error);
+
+    if (object_get_hash(small) != object_get_hash(big)) {
+        error = simple_error_new("%s", "Hash of bigint differs from int.");
+        simple_error_check(error);
+    }
+
+    error = object_equals(small, big, &equals);
+    simple_error_check(error);
+
+    if (!equals) {
+        error = simple_error_new("%s", "Bigint does not equal int.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    object_refcount_decrease(small);
+    object_refcount_decrease(big);
+    return error;
+}
+
+// compares every kernel set the cpu supports against plain loops
+static struct simple_error *test_array_kernels(
+    void
+) {
+    struct simple_error *error = NULL;
+    enum simple_array_isa best = simple_array_get_isa();
+
+    for (int isa = SIMPLE_ARRAY_ISA_GENERIC; isa <= (int)best; isa++) {
+        simple_array_set_isa((enum simple_array_isa)isa);
+
+        for (size_t length = 1; length < 70; length++) {
+            struct simple_array *lhs, *rhs, *sum, *mask, *filtered;
+            union simple_array_value value, min, max;
+            int64_t expected_sum = 0, expected_min = 1000, expected_max = -1;
+            size_t expected_count = 0;
+
+            lhs = simple_array_new(SIMPLE_ARRAY_INT32, 0);
+            rhs = simple_array_new(SIMPLE_ARRAY_INT32, 0);
+            for (size_t i = 0; i < length; i++) {
+                int64_t element = (int64_t)((i * 37) % 101);
+                simple_array_append(lhs, (union simple_array_value) {
+                    .integer = element});
+                simple_array_append(rhs, (union simple_array_value) {
+                    .integer = 1});
+                expected_sum += element;
+                expected_min = element < expected_min ? element : expected_min;
+                expected_max = element > expected_max ? element : expected_max;
+                expected_count += element < 50;
+            }
+
+            error = simple_array_sum(lhs, &value);
+            simple_error_check(error);
+            error = simple_array_min(lhs, &min);
+            simple_error_check(error);
+            error = simple_array_max(lhs, &max);
+            simple_error_check(error);
+            error = simple_array_arithmetic(lhs, rhs, SIMPLE_ARRAY_ADD, &sum);
+            simple_error_check(error);
+            error = simple_array_compare(lhs, SIMPLE_ARRAY_LT,
+                (union simple_array_value) {.integer = 50}, &mask);
+            simple_error_check(error);
+            error = simple_array_filter(lhs, mask, &filtered);
+            simple_error_check(error);
+
+            union simple_array_value total, last;
+            error = simple_array_sum(sum, &total);
+            simple_error_check(error);
+            error = simple_array_get(sum, length - 1, &last);
+            simple_error_check(error);
+
+            if (value.integer != expected_sum ||
+                    min.integer != expected_min ||
+                    max.integer != expected_max ||
+                    total.integer != expected_sum + (int64_t)length ||
+                    last.integer != (int64_t)(((length - 1) * 37) % 101) + 1 ||
+                    simple_array_length(filtered) != expected_count) {
+                error = simple_error_new("Kernels for %s are wrong at length "
+                    "%zu.", simple_array_isa_get_name(
+                    (enum simple_array_isa)isa), length);
+            }
+
+            simple_array_destroy(lhs);
+            simple_array_destroy(rhs);
+            simple_array_destroy(sum);
+            simple_array_destroy(mask);
+            simple_array_destroy(filtered);
+            simple_error_check(error);
+        }
+    }
+
+    cleanup:
+    simple_array_set_isa(best);
+    return error;
+}
+
+static struct simple_error *test_list_growth(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct simple_list *list = simple_list_new(0);
+    struct object *element = NULL, *found;
+
+    error = object_new_int(7, &element);
+    simple_error_check(error);
+
+    for (size_t i = 0; i < 1000; i++) {
+        simple_list_append(list, element);
+    }
+
+    simple_list_extend(list, list);
+    if (simple_list_size(list) != 2000) {
+        error = simple_error_new("Expected 2000 elements, got %zu.",
+            simple_list_size(list));
+        simple_error_check(error);
+    }
+
+    for (size_t i = 0; i < 1998; i++) {
+        error = simple_list_pop(list, &found);
+        simple_error_check(error);
+        object_refcount_decrease(found);
+    }
+
+    simple_list_shrink_to_fit(list);
+    if (simple_list_capacity(list) != SIMPLE_LIST_INLINE_CAPACITY) {
+        error = simple_error_new("Expected inline capacity, got %zu.",
+            simple_list_capacity(list));
+        simple_error_check(error);
+    }
+
+    error = simple_list_get(list, 1, &found);
+    simple_error_check(error);
+
+    if (found != element) {
+        error = simple_error_new("%s", "Element changed while shrinking.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    simple_list_destroy(list);
+    object_refcount_decrease(element);
+    return error;
+}
+
+static struct simple_error *test_alloc_census(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct simple_alloc_totals before, after;
+    struct object *o = NULL;
+
+    simple_alloc_get_totals(&before);
+    error = object_new_int(3, &o);
+    simple_error_check(error);
+    simple_alloc_get_totals(&after);
+
+    // without tracking compiled in nothing is counted
+    bool counted = after.allocations > before.allocations &&
+        after.bytes > before.bytes;
+    if (counted != simple_alloc_enabled()) {
+        error = simple_error_new("Expected %s allocations to be counted.",
+            simple_alloc_enabled() ? "new" : "no");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    object_refcount_decrease(o);
+    return error;
+}
+
+static struct simple_error *test_perf_counters(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct simple_perf *perf = simple_perf_new();
+    struct simple_perf_counts counts;
+    volatile size_t sum = 0;
+
+    simple_perf_start(perf);
+    for (size_t i = 0; i < 100000; i++) {
+        sum += i;
+    }
+    simple_perf_stop(perf, &counts);
+
+    // counters may be missing on this machine, but never count nothing
+    for (size_t i = 0; i < SIMPLE_PERF_COUNTER_COUNT; i++) {
+        if (counts.counted[i] && !simple_perf_available(perf)) {
+            error = simple_error_new("Counter %s counted while unavailable.",
+                simple_perf_counter_get_name((enum simple_perf_counter)i));
+            simple_error_check(error);
+        }
+    }
+    if (counts.counted[SIMPLE_PERF_INSTRUCTIONS] &&
+            counts.values[SIMPLE_PERF_INSTRUCTIONS] < 100000) {
+        error = simple_error_new("Expected at least %d instructions, got %lu.",
+            100000, (unsigned long)counts.values[SIMPLE_PERF_INSTRUCTIONS]);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    simple_perf_destroy(perf);
+    return error;
+}
+
+static struct simple_error *test_trace_export(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct simple_trace_stats before, after;
+    char *buff = NULL;
+    size_t length;
+
+    simple_trace_get_stats(&before);
+    simple_trace_begin("test_trace");
+    simple_trace_counter("test_counter", 42);
+    simple_trace_end("test_trace");
 
-static struct simple_error *test_hashtable_init(
+    FILE *file = open_memstream(&buff, &length);
+    simple_trace_export(file);
+    fclose(file);
+    simple_trace_get_stats(&after);
+
+    // without tracing compiled in the trace points are gone
+    bool exported = strstr(buff, "\"name\": \"test_trace\", \"ph\": \"B\"") &&
+        strstr(buff, "\"args\": {\"value\": 42}");
+    if (exported != simple_trace_enabled()) {
+        error = simple_error_new("Unexpected trace export '%s'.", buff);
+        simple_error_check(error);
+    }
+
+    size_t recorded = simple_trace_enabled() ? 3 : 0;
+    if (after.recorded - before.recorded != recorded ||
+            after.exported - before.exported < recorded) {
+        error = simple_error_new("Expected %zu events to be recorded.",
+            recorded);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    free(buff);
+    return error;
+}
+
+// reads what was written to file from its start
+static struct simple_error *test_sink_read_back(
+    FILE *file,
+    const char *expected
+) {
+    struct simple_error *error = NULL;
+    size_t length = strlen(expected);
+    char *buff = calloc(length + 2, 1);
+
+    rewind(file);
+    size_t count = fread(buff, 1, length + 1, file);
+    if (count != length || memcmp(buff, expected, length) != 0) {
+        error = simple_error_new("Expected sink output '%s', got '%s'.",
+            expected, buff);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    free(buff);
+    return error;
+}
+
+static struct simple_error *test_sink_write(
     void
 ) {
-    struct simple_error *error;
+    struct simple_error *error = NULL;
+    FILE *file = tmpfile();
+    struct simple_sink *sink = simple_sink_new(fileno(file));
+    char *large = NULL, *expected = NULL;
+
+    error = simple_sink_write_int(sink, 0);
+    simple_error_check(error);
+    error = simple_sink_write_string(sink, " ");
+    simple_error_check(error);
+    error = simple_sink_write_int(sink, -1234567);
+    simple_error_check(error);
+    error = simple_sink_write_string(sink, " ");
+    simple_error_check(error);
+    error = simple_sink_write_int(sink, INT64_MIN);
+    simple_error_check(error);
+    error = simple_sink_write_string(sink, " ");
+    simple_error_check(error);
+    error = simple_sink_write_double(sink, 2.5);
+    simple_error_check(error);
+
+    if (simple_sink_get_pending(sink) != 35) {
+        error = simple_error_new("Expected 35 pending bytes, got %zu.",
+            simple_sink_get_pending(sink));
+        simple_error_check(error);
+    }
+
+    // larger than the buffer, written along with what is pending
+    size_t length = 200000;
+    large = calloc(length + 1, 1);
+    memset(large, 'x', length);
+    large[length] = '\0';
+    error = simple_sink_write(sink, large, length);
+    simple_error_check(error);
+
+    error = simple_sink_write_int(sink, 42);
+    simple_error_check(error);
+    error = simple_sink_flush(sink);
+    simple_error_check(error);
+
+    expected = calloc(length + 64, 1);
+    sprintf(expected, "0 -1234567 -9223372036854775808 2.5%s42", large);
+    error = test_sink_read_back(file, expected);
+    simple_error_check(error);
+
+    cleanup:
+    free(large);
+    free(expected);
+    simple_sink_destroy(sink);
+    fclose(file);
+    return error;
+}
+
+static struct simple_error *test_sink_print(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct object *sink = NULL, *fd = NULL, *value = NULL, *result;
+    FILE *file = tmpfile();
+
+    error = type_registry_construct("sink", &sink);
+    simple_error_check(error);
+
+    error = object_new_int(fileno(file), &fd);
+    simple_error_check(error);
+
+    error = object_call_method(sink, "_init", fd, &result);
+    simple_error_check(error);
+
+    error = object_new_int(-17, &value);
+    simple_error_check(error);
+
+    error = object_call_method(value, "_print", sink, &result);
+    simple_error_check(error);
+
+    error = object_call_method(sink, "_write", value, &result);
+    simple_error_check(error);
+
+    error = object_call_method(sink, "_flush", NULL, &result);
+    simple_error_check(error);
+
+    error = test_sink_read_back(file, "-17\n-17");
+    simple_error_check(error);
+
+    cleanup:
+    object_refcount_decrease(sink);
+    object_refcount_decrease(fd);
+    object_refcount_decrease(value);
+    fclose(file);
+    return error;
+}
+
+static struct simple_error *test_profile_folded(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct simple_profile_stats stats;
+    struct object *value = NULL, *argument = NULL, *result;
+    char *buff = NULL;
+    size_t length;
+
+    error = object_new_int(0, &value);
+    simple_error_check(error);
+
+    error = object_new_int(7, &argument);
+    simple_error_check(error);
+
+    error = simple_profile_start(1000, 0);
+    simple_error_check(error);
+
+    // spin until a few samples landed, or give up after a second of cpu
+    clock_t start = clock();
+    do {
+        for (size_t i = 0; !error && i < 1000; i++) {
+            error = object_call_method(value, "_assign", argument, &result);
+        }
+        simple_profile_get_stats(&stats);
+    } while (!error && stats.samples < 10 &&
+        clock() - start < CLOCKS_PER_SEC);
+    simple_profile_stop();
+    simple_error_check(error);
+
+    FILE *file = open_memstream(&buff, &length);
+    simple_profile_write_folded(file);
+    fclose(file);
+
+    if (!strstr(buff, "int._assign ")) {
+        error = simple_error_new("Expected int._assign in profile '%s'.",
+            buff);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    free(buff);
+    object_refcount_decrease(value);
+    object_refcount_decrease(argument);
+    return error;
+}
+
+static struct simple_error *test_heap_snapshot(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct simple_heap_snapshot *snapshot = NULL;
+    struct simple_list *list = simple_list_new(0);
+    struct object *o = NULL, *element;
+    char *buff = NULL;
+    size_t length, retained, expected;
+    FILE *file = tmpfile();
+
+    error = object_new_list(list, &o);
+    simple_error_check(error);
+
+    // held by the list alone, so it retains them
+    expected = 0;
+    for (size_t i = 0; i < 3; i++) {
+        error = object_new_string(&element, "element %zu", i);
+        simple_error_check(error);
+        simple_list_append(list, element);
+        expected += object_get_memory(element);
+        object_refcount_decrease(element);
+    }
+    expected += object_get_memory(o);
+
+    error = simple_heap_write_snapshot(file);
+    simple_error_check(error);
+    rewind(file);
+    error = simple_heap_read_snapshot(file, &snapshot);
+    simple_error_check(error);
+
+    if (simple_heap_snapshot_get_object_count(snapshot) < 4) {
+        error = simple_error_new("Expected at least 4 objects, got %zu.",
+            simple_heap_snapshot_get_object_count(snapshot));
+        simple_error_check(error);
+    }
+
+    error = simple_heap_snapshot_get_retained(snapshot,
+        (uint64_t)(uintptr_t)o, &retained);
+    simple_error_check(error);
+    if (retained != expected) {
+        error = simple_error_new("Expected the list to retain %zu bytes, "
+            "got %zu.", expected, retained);
+        simple_error_check(error);
+    }
+
+    FILE *report = open_memstream(&buff, &length);
+    simple_heap_write_report(snapshot, report, 5);
+    fclose(report);
+    if (!strstr(buff, "list")) {
+        error = simple_error_new("Expected list in report '%s'.", buff);
+        simple_error_check(error);
+    }
+
+    cleanup:
+    free(buff);
+    simple_heap_snapshot_destroy(snapshot);
+    object_refcount_decrease(o);
+    fclose(file);
+    return error;
+}
+
+static struct simple_error *test_serial_roundtrip(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct simple_serial_writer *writer = NULL;
+    struct simple_serial_reader *reader = NULL;
+    struct object *dict = NULL, *key = NULL, *value = NULL, *read = NULL;
+    struct type *string_type, *int_type;
+    char path[] = "/tmp/simple_serial_XXXXXX";
+    bool equals;
+
+    error = type_registry_get_type("string", &string_type);
+    simple_error_check(error);
+    error = type_registry_get_type("int", &int_type);
+    simple_error_check(error);
+
+    struct simple_hashtable *table = simple_hashtable_new(string_type,
+        int_type);
+    for (int i = 0; i < 100; i++) {
+        error = object_new_string(&key, "key %d", i);
+        simple_error_check(error);
+        error = object_new_int(-i, &value);
+        simple_error_check(error);
+        error = simple_hashtable_insert(table, key, value);
+        simple_error_check(error);
+        object_refcount_decrease(key);
+        object_refcount_decrease(value);
+        key = value = NULL;
+    }
+    error = object_new_dict(table, &dict);
+    simple_error_check(error);
+
+    FILE *file = fdopen(mkstemp(path), "wb");
+    writer = simple_serial_writer_new(file);
+    error = simple_serial_write(writer, dict);
+    if (!error) {
+        error = simple_serial_write(writer, dict);
+    }
+    fclose(file);
+    simple_error_check(error);
+
+    error = simple_serial_reader_open(path, &reader);
+    simple_error_check(error);
+    for (size_t i = 0; i < 2; i++) {
+        error = simple_serial_read(reader, &read);
+        simple_error_check(error);
+        error = object_equals(dict, read, &equals);
+        simple_error_check(error);
+        if (!equals) {
+            error = simple_error_new("Value %zu differs after reading.", i);
+            simple_error_check(error);
+        }
+        object_refcount_decrease(read);
+    }
+
+    error = simple_serial_read(reader, &read);
+    simple_error_check(error);
+    if (read) {
+        error = simple_error_new("%s", "Expected the end of the data.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    simple_serial_reader_destroy(reader);
+    simple_serial_writer_destroy(writer);
+    object_refcount_decrease(key);
+    object_refcount_decrease(value);
+    object_refcount_decrease(dict);
+    unlink(path);
+    return error;
+}
+
+static struct simple_error *test_serial_validate(
+    void
+) {
+    struct simple_error *error = NULL, *invalid;
+    struct simple_serial_writer *writer = NULL;
+    struct simple_serial_reader *reader = NULL;
+    struct object *o = NULL, *read = NULL;
+    uint64_t *data = NULL;
+    char *buff = NULL;
+    size_t length;
+
+    error = object_new_string(&o, "%s", "serialized");
+    simple_error_check(error);
+
+    FILE *file = open_memstream(&buff, &length);
+    writer = simple_serial_writer_new(file);
+    error = simple_serial_write(writer, o);
+    fclose(file);
+    simple_error_check(error);
+
+    // copied to an aligned buffer, then damaged one way at a time
+    data = calloc(length / sizeof *data + 1, sizeof *data);
+    const char *damages[] = {"tag", "length", "terminator", "truncated"};
+    for (size_t i = 0; i < sizeof damages / sizeof *damages; i++) {
+        size_t size = length;
+        memcpy(data, buff, length);
+        if (i == 0) {
+            data[2] = 'x';
+        } else if (i == 1) {
+            data[3] = 1 << 20;
+        } else if (i == 2) {
+            ((char *)data)[32 + strlen("serialized")] = '!';
+        } else {
+            size -= 8;
+        }
+
+        error = simple_serial_reader_new(data, size, &reader);
+        simple_error_check(error);
+        invalid = simple_serial_read(reader, &read);
+        simple_serial_reader_destroy(reader);
+        reader = NULL;
+        if (!invalid) {
+            error = simple_error_new("Expected a %s error.", damages[i]);
+            simple_error_check(error);
+        }
+        simple_error_destroy(invalid);
+    }
+
+    cleanup:
+    simple_serial_reader_destroy(reader);
+    simple_serial_writer_destroy(writer);
+    object_refcount_decrease(o);
+    free(data);
+    free(buff);
+    return error;
+}
+
+// writes a string to string table of count entries to path
+static struct simple_error *test_mapped_hashtable_write(
+    char *path,
+    size_t count
+) {
+    struct simple_error *error = NULL;
+    struct simple_hashtable *table = NULL;
+    struct object *key = NULL, *value = NULL;
     struct type *string_type;
+    FILE *file = NULL;
+
     error = type_registry_get_type("string", &string_type);
     simple_error_check(error);
 
-    struct simple_hashtable *table;
     table = simple_hashtable_new(string_type, string_type);
+    for (size_t i = 0; i < count; i++) {
+        error = object_new_string(&key, "key %zu", i);
+        simple_error_check(error);
+        error = object_new_string(&value, "value %zu", i);
+        simple_error_check(error);
+        error = simple_hashtable_insert(table, key, value);
+        simple_error_check(error);
+        object_refcount_decrease(key);
+        object_refcount_decrease(value);
+        key = value = NULL;
+    }
+
+    file = fdopen(mkstemp(path), "wb");
+    error = simple_mapped_hashtable_write(table, file);
+    simple_error_check(error);
+
+    cleanup:
+    if (file) {
+        fclose(file);
+    }
+    object_refcount_decrease(key);
+    object_refcount_decrease(value);
     simple_hashtable_destroy(table);
+    return error;
+}
+
+static struct simple_error *test_mapped_hashtable_find(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct simple_mapped_hashtable *table = NULL;
+    struct object *key = NULL, *found = NULL, *expected = NULL;
+    char path[] = "/tmp/simple_mapped_XXXXXX";
+    bool equals;
+
+    error = test_mapped_hashtable_write(path, 1000);
+    simple_error_check(error);
+    error = simple_mapped_hashtable_open(path, &table);
+    simple_error_check(error);
+
+    if (simple_mapped_hashtable_size(table) != 1000) {
+        error = simple_error_new("Expected 1000 entries, got %zu.",
+            simple_mapped_hashtable_size(table));
+        simple_error_check(error);
+    }
+
+    for (size_t i = 0; i < 1001; i++) {
+        error = object_new_string(&key, "key %zu", i);
+        simple_error_check(error);
+        error = object_new_string(&expected, "value %zu", i);
+        simple_error_check(error);
+        error = simple_mapped_hashtable_find(table, key, &found);
+        simple_error_check(error);
+
+        equals = !found;
+        if (found) {
+            error = object_equals(found, expected, &equals);
+            simple_error_check(error);
+            equals = equals && i < 1000;
+        }
+        if (!equals) {
+            error = simple_error_new("Wrong value for key %zu.", i);
+            simple_error_check(error);
+        }
+
+        object_refcount_decrease(key);
+        object_refcount_decrease(expected);
+        object_refcount_decrease(found);
+        key = expected = found = NULL;
+    }
+
+    cleanup:
+    object_refcount_decrease(key);
+    object_refcount_decrease(expected);
+    object_refcount_decrease(found);
+    simple_mapped_hashtable_destroy(table);
+    unlink(path);
+    return error;
+}
+
+static struct simple_error *test_mapped_hashtable_validate(
+    void
+) {
+    struct simple_error *error = NULL, *invalid = NULL;
+    struct simple_mapped_hashtable *table = NULL;
+    char path[] = "/tmp/simple_mapped_XXXXXX";
+    struct stat info;
+    uint32_t hash_function = 2;
+
+    error = test_mapped_hashtable_write(path, 100);
+    simple_error_check(error);
+
+    // a hash function the reader does not know, it follows the byte order
+    FILE *file = fopen(path, "r+b");
+    if (!file || fseek(file, 16, SEEK_SET) != 0 ||
+            fwrite(&hash_function, sizeof hash_function, 1, file) != 1) {
+        error = simple_error_new("Cannot patch '%s'.", path);
+    }
+    if (file) {
+        fclose(file);
+    }
+    simple_error_check(error);
+    invalid = simple_mapped_hashtable_open(path, &table);
+    if (!invalid) {
+        error = simple_error_new("%s", "Expected an unknown hash error.");
+        simple_error_check(error);
+    }
+    simple_error_destroy(invalid);
+    invalid = NULL;
+
+    // the slots no longer fit
+    if (stat(path, &info) != 0 || truncate(path, info.st_size / 4) != 0) {
+        error = simple_error_new("Cannot truncate '%s'.", path);
+        simple_error_check(error);
+    }
+    invalid = simple_mapped_hashtable_open(path, &table);
+    if (!invalid) {
+        error = simple_error_new("%s", "Expected a truncated table error.");
+        simple_error_check(error);
+    }
 
     cleanup:
+    simple_error_destroy(invalid);
+    simple_mapped_hashtable_destroy(table);
+    unlink(path);
+    return error;
+}
+
+static struct simple_error *test_count_object(
+    const struct object *o,
+    void *context
+) {
+    (void)o;
+    (*(size_t *)context)++;
     return NULL;
 }
 
-int main() {
+static struct simple_error *test_object_call_method(
+    void
+) {
+    struct simple_error *error = NULL, *missing;
+    struct object *o = NULL, *argument = NULL, *result;
+    size_t before = 0, after = 0;
+    int value;
+
+    error = object_new_int(0, &o);
+    simple_error_check(error);
+
+    error = object_new_int(5, &argument);
+    simple_error_check(error);
+
+    error = object_foreach_allocated(test_count_object, &before);
+    simple_error_check(error);
+
+    error = object_call_method(o, "_assign", argument, &result);
+    simple_error_check(error);
+
+    // dispatch looks the method up without creating a key object
+    error = object_foreach_allocated(test_count_object, &after);
+    simple_error_check(error);
+    if (after != before) {
+        error = simple_error_new("Expected a call to create no objects, "
+            "%zu were created.", after - before);
+        simple_error_check(error);
+    }
+
+    error = object_get_int(o, &value);
+    simple_error_check(error);
+
+    if (result != o || value != 5) {
+        error = simple_error_new("Expected 5 to be assigned, got %d.", value);
+        simple_error_check(error);
+    }
+
+    missing = object_call_method(o, "_missing", argument, &result);
+    if (!missing) {
+        error = simple_error_new("%s", "Expected an error for _missing.");
+        simple_error_check(error);
+    }
+    simple_error_destroy(missing);
+
+    cleanup:
+    object_refcount_decrease(o);
+    object_refcount_decrease(argument);
+    return error;
+}
+
+static struct simple_error *test_type_lookup(
+    void
+) {
+    struct simple_error *error = NULL;
+    struct simple_result found;
+    struct object *o = NULL;
+    struct type *type;
+    size_t before = 0, after = 0;
+
+    error = object_foreach_allocated(test_count_object, &before);
+    simple_error_check(error);
+
+    found = type_registry_find_type("no_such_type", &type);
+    if (found.status != SIMPLE_STATUS_NOT_FOUND || found.error || type) {
+        error = simple_error_new("%s", "Expected a miss without an error.");
+        simple_error_check(error);
+    }
+
+    error = object_foreach_allocated(test_count_object, &after);
+    simple_error_check(error);
+    if (after != before) {
+        error = simple_error_new("Expected a miss to create no objects, "
+            "%zu were created.", after - before);
+        simple_error_check(error);
+    }
+
+    found = type_registry_try_construct("int", &o);
+    if (found.status != SIMPLE_STATUS_OK || !o) {
+        error = simple_error_new("%s", "Expected to construct an int.");
+        simple_error_check(error);
+    }
+    object_refcount_decrease(o);
+
+    found = type_registry_try_construct("no_such_type", &o);
+    if (found.status != SIMPLE_STATUS_NOT_FOUND || o) {
+        error = simple_error_new("%s", "Expected no object for a miss.");
+        simple_error_check(error);
+    }
+
+    error = type_registry_get_type("int", &type);
+    simple_error_check(error);
+    found = type_find_attribute(type, "_missing", &o);
+    if (found.status != SIMPLE_STATUS_NOT_FOUND || found.error || o) {
+        error = simple_error_new("%s", "Expected an attribute miss without "
+            "an error.");
+        simple_error_check(error);
+    }
+
+    // the error returning variants still describe the miss
+    struct simple_error *missing = type_registry_get_type("no_such_type",
+        &type);
+    if (!missing) {
+        error = simple_error_new("%s", "Expected an error for a miss.");
+        simple_error_check(error);
+    }
+    simple_error_destroy(missing);
+
+    cleanup:
+    object_refcount_decrease(o);
+    return error;
+}
+
+static struct simple_error *test_error_format(
+    void
+) {
+    struct simple_error *error = NULL, *shown;
+    char *output = NULL;
+    size_t output_length;
+    char argument[] = "key";
+
+    shown = simple_error_new("%s '%s' at %zu, %d%% of %lld, %5.2f %c%-4s|",
+        "missing", argument, (size_t)42, -7, 1LL << 40, 2.5, 'x', "ab");
+    shown = simple_error_wrap(shown, __FILE__, __LINE__, __FUNCTION__);
+
+    // the argument is copied, changing it must not change the message
+    argument[0] = 'f';
+
+    FILE *file = open_memstream(&output, &output_length);
+    simple_error_show(shown, file);
+    fclose(file);
+
+    const char *expected = "missing 'key' at 42, -7% of 1099511627776, "
+        " 2.50 xab  |\n";
+    if (!strstr(output, expected)) {
+        error = simple_error_new("Unexpected error output '%s'.", output);
+        simple_error_check(error);
+    }
+
+    // more strings or arguments than a node holds are formatted up front
+    char long_argument[100];
+    memset(long_argument, 'a', sizeof long_argument - 1);
+    long_argument[sizeof long_argument - 1] = '\0';
+    char long_expected[400];
+    snprintf(long_expected, sizeof long_expected, "%s %s %s|\n",
+        long_argument, long_argument, long_argument);
+
+    simple_error_destroy(shown);
+    shown = simple_error_new("%s %s %s|", long_argument, long_argument,
+        long_argument);
+    free(output);
+    file = open_memstream(&output, &output_length);
+    simple_error_show(shown, file);
+    fclose(file);
+    if (!strstr(output, long_expected)) {
+        error = simple_error_new("Unexpected long error output '%s'.",
+            output);
+        simple_error_check(error);
+    }
+
+    simple_error_destroy(shown);
+    shown = simple_error_new("%d %d %d %d %d %d %d %d %d %d|", 1, 2, 3, 4,
+        5, 6, 7, 8, 9, 10);
+    free(output);
+    file = open_memstream(&output, &output_length);
+    simple_error_show(shown, file);
+    fclose(file);
+    if (!strstr(output, "1 2 3 4 5 6 7 8 9 10|\n")) {
+        error = simple_error_new("Unexpected many argument output '%s'.",
+            output);
+        simple_error_check(error);
+    }
+
+    // freed nodes are reused by the next error of this thread
+    simple_error_destroy(shown);
+    shown = simple_error_new("%s", "first");
+    uintptr_t first = (uintptr_t)shown;
+    simple_error_destroy(shown);
+    shown = simple_error_new("%s", "second");
+    if ((uintptr_t)shown != first) {
+        error = simple_error_new("%s", "Error node was not reused.");
+        simple_error_check(error);
+    }
+
+    cleanup:
+    simple_error_destroy(shown);
+    free(output);
+    return error;
+}
+
+int main(
+    int argc,
+    char **argv
+) {
 
     simple_test_init();
 
@@ -33,13 +1815,82 @@ int main() {
         return 1;
     }
 
-    struct simple_test_item *root, *hashtable;
+    struct simple_test_item *root, *hashtable, *concurrent_hashtable, *bigint;
+    struct simple_test_item *epoch, *hamt, *btree, *array, *list, *errors;
+    struct simple_test_item *types, *objects, *alloc, *perf, *trace, *sink;
+    struct simple_test_item *profile, *heap, *serial, *mapped;
 
     root = simple_test_get_root();
     hashtable = simple_test_create_node(root, "hashtable");
     simple_test_create_leaf(hashtable, "init", test_hashtable_init);
+    simple_test_create_leaf(hashtable, "erase", test_hashtable_erase);
+    simple_test_create_leaf(hashtable, "scan", test_hashtable_scan);
+    simple_test_create_leaf(hashtable, "batch", test_hashtable_batch);
+    simple_test_create_leaf(hashtable, "int", test_hashtable_int);
+
+    concurrent_hashtable = simple_test_create_node(root,
+        "concurrent_hashtable");
+    simple_test_create_leaf(concurrent_hashtable, "threads",
+        test_concurrent_hashtable_threads);
+
+    epoch = simple_test_create_node(root, "epoch");
+    simple_test_create_leaf(epoch, "reclaim", test_epoch_reclaim);
+
+    hamt = simple_test_create_node(root, "hamt");
+    simple_test_create_leaf(hamt, "snapshot", test_hamt_snapshot);
+
+    btree = simple_test_create_node(root, "btree");
+    simple_test_create_leaf(btree, "order", test_btree_order);
+
+    bigint = simple_test_create_node(root, "bigint");
+    simple_test_create_leaf(bigint, "mul", test_bigint_mul);
+    simple_test_create_leaf(bigint, "decimal", test_bigint_decimal);
+    simple_test_create_leaf(bigint, "hash", test_bigint_hash);
+
+    array = simple_test_create_node(root, "array");
+    simple_test_create_leaf(array, "kernels", test_array_kernels);
+
+    list = simple_test_create_node(root, "list");
+    simple_test_create_leaf(list, "growth", test_list_growth);
+
+    objects = simple_test_create_node(root, "object");
+    simple_test_create_leaf(objects, "call_method", test_object_call_method);
+
+    types = simple_test_create_node(root, "type");
+    simple_test_create_leaf(types, "lookup", test_type_lookup);
+
+    alloc = simple_test_create_node(root, "alloc");
+    simple_test_create_leaf(alloc, "census", test_alloc_census);
+
+    perf = simple_test_create_node(root, "perf");
+    simple_test_create_leaf(perf, "counters", test_perf_counters);
+
+    trace = simple_test_create_node(root, "trace");
+    simple_test_create_leaf(trace, "export", test_trace_export);
+
+    sink = simple_test_create_node(root, "sink");
+    simple_test_create_leaf(sink, "write", test_sink_write);
+    simple_test_create_leaf(sink, "print", test_sink_print);
+
+    profile = simple_test_create_node(root, "profile");
+    simple_test_create_leaf(profile, "folded", test_profile_folded);
+
+    heap = simple_test_create_node(root, "heap");
+    simple_test_create_leaf(heap, "snapshot", test_heap_snapshot);
+
+    serial = simple_test_create_node(root, "serial");
+    simple_test_create_leaf(serial, "roundtrip", test_serial_roundtrip);
+    simple_test_create_leaf(serial, "validate", test_serial_validate);
+
+    mapped = simple_test_create_node(root, "mapped_hashtable");
+    simple_test_create_leaf(mapped, "find", test_mapped_hashtable_find);
+    simple_test_create_leaf(mapped, "validate",
+        test_mapped_hashtable_validate);
+
+    errors = simple_test_create_node(root, "error");
+    simple_test_create_leaf(errors, "format", test_error_format);
 
-    simple_test_run();
+    int failed = simple_test_run_with_args(argc, argv);
     simple_test_destroy();
 
     error = type_registry_destroy();
@@ -48,5 +1899,5 @@ int main() {
         simple_error_destroy(error);
     }
 
-    return 0;
+    return failed ? 1 : 0;
 }
@@ -1,6 +1,8 @@
 #include "type.h"
 
+#include "simple_epoch.h"
 #include "simple_error.h"
+#include "simple_hamt.h"
 #include "simple_hashtable.h"
 #include "simple_object.h"
 #include "simple_string.h"
@@ -8,6 +10,7 @@
 
 #include <assert.h>
 #include <malloc.h>
+#include <stdatomic.h>
 #include <string.h>
 
 struct type_registry {
@@ -20,7 +23,9 @@ struct type_registry *registry;
 
 struct type {
     struct simple_string *name;
-    struct simple_hashtable *attributes;
+    // Replaced as a whole on every update, so readers never lock and can
+    // keep a snapshot for as long as they like.
+    _Atomic(struct simple_hamt *) attributes;
     bool instantiated;
     enum object_kind instance_kind;
 };
@@ -34,10 +39,24 @@ struct simple_error *type_registry_get_string_type(
 
 
 
+// object_type is still NULL while the bootstrap types are created, the
+// value type of attribute maps is not checked anyway
+static struct simple_hamt *type_attributes_new(
+    void
+) {
+    return simple_hamt_new(registry->string_type, registry->object_type);
+}
+
+static void type_attributes_release(
+    void *attributes
+) {
+    simple_hamt_release(attributes);
+}
+
 static void type_destroy(
     struct type *type
 ) {
-    simple_hashtable_destroy(type->attributes);
+    simple_hamt_release(atomic_load(&type->attributes));
     free(type);
 }
 
@@ -48,22 +67,85 @@ struct simple_error *type_set_attribute(
 ) {
     struct simple_error *error;
     struct object *key_object = NULL;
+    struct simple_hamt *current, *updated;
+
     error = object_new_string(&key_object, "%s", key);
     simple_error_check(error);
 
-    if (!type->attributes) {
-        type->attributes = simple_hashtable_new(registry->string_type,
-            registry->object_type);
+    // the old map may still be read elsewhere, hand it to simple_epoch
+    simple_epoch_enter();
+    current = atomic_load(&type->attributes);
+    for (;;) {
+        error = simple_hamt_insert(current, key_object, value, &updated);
+        if (error || atomic_compare_exchange_weak(&type->attributes, &current,
+                updated)) {
+            break;
+        }
+        simple_hamt_release(updated);
     }
-
-    error = simple_hashtable_insert(type->attributes, key_object, value);
+    simple_epoch_leave();
     simple_error_check(error);
 
+    simple_epoch_retire(type_attributes_release, current);
+
     cleanup:
     object_refcount_decrease(key_object);
     return error;
 }
 
+struct simple_error *type_get_attribute(
+    const struct type *type,
+    const char *key,
+    struct object **result
+) {
+    struct simple_result found = type_find_attribute(type, key, result);
+    if (found.status == SIMPLE_STATUS_NOT_FOUND) {
+        return simple_error_new("Type '%s' has no attribute '%s'.",
+            simple_string_get(type->name), key);
+    }
+    return found.error;
+}
+
+struct simple_result type_find_attribute(
+    const struct type *type,
+    const char *key,
+    struct object **result
+) {
+    struct simple_error *error;
+    const struct object *found = NULL;
+
+    *result = NULL;
+
+    // probes by the key itself, dispatch allocates nothing
+    simple_epoch_enter();
+    error = simple_hamt_find_cstring(atomic_load(&type->attributes), key,
+        &found);
+    if (found) {
+        *result = (struct object *)found;
+        object_refcount_increase(*result);
+    }
+    simple_epoch_leave();
+    simple_error_check(error);
+
+    if (!*result) {
+        return (struct simple_result) {SIMPLE_STATUS_NOT_FOUND, NULL};
+    }
+    return (struct simple_result) {SIMPLE_STATUS_OK, NULL};
+
+    cleanup:
+    return (struct simple_result) {SIMPLE_STATUS_ERROR, error};
+}
+
+struct simple_error *type_get_attributes(
+    const struct type *type,
+    struct simple_hamt **result
+) {
+    simple_epoch_enter();
+    *result = simple_hamt_share(atomic_load(&type->attributes));
+    simple_epoch_leave();
+    return NULL;
+}
+
 struct simple_error *type_registry_new(
     void
 ) {
@@ -81,18 +163,19 @@ struct simple_error *type_registry_new(
 
     *registry->type_type = (struct type) {
         .name = simple_string_new("type"),
-        .attributes = NULL,
         .instantiated = true,
         .instance_kind = OBJECT_TYPE
     };
 
     *registry->string_type = (struct type) {
         .name = simple_string_new("string"),
-        .attributes = NULL,
         .instantiated = true,
         .instance_kind = OBJECT_STRING
     };
 
+    atomic_init(&registry->type_type->attributes, type_attributes_new());
+    atomic_init(&registry->string_type->attributes, type_attributes_new());
+
     registry->types = simple_hashtable_new(registry->string_type,
         registry->type_type);
 
@@ -108,16 +191,11 @@ struct simple_error *type_registry_new(
     error = object_new_string(&string_string_object, "%s", "string");
     simple_error_check(error);
 
-    error = object_new_type("type", OBJECT_TYPE, &type_type_object);
-    simple_error_check(error);
-
-    error = object_get_type(type_type_object, &registry->type_type);
+    // wrap the bootstrap types, tables created so far refer to them
+    error = object_wrap_type(registry->type_type, &type_type_object);
     simple_error_check(error);
 
-    error = object_new_type("string", OBJECT_STRING, &string_type_object);
-    simple_error_check(error);
-
-    error = object_get_type(string_type_object, &registry->string_type);
+    error = object_wrap_type(registry->string_type, &string_type_object);
     simple_error_check(error);
 
     error = simple_hashtable_insert(registry->types, type_string_object,
@@ -162,37 +240,35 @@ struct simple_error *type_registry_destroy(
     return NULL;
 }
 
-struct simple_error *type_registry_get_type(
+struct simple_result type_registry_find_type(
     const char *type_name,
     struct type **result
 ) {
+    *result = NULL;
+
     if (registry->bootstrap) {
         if (strcmp(type_name, "string") == 0) {
             *result = registry->string_type;
-            return NULL;
+            return (struct simple_result) {SIMPLE_STATUS_OK, NULL};
         }
         if (strcmp(type_name, "type") == 0) {
             *result = registry->type_type;
-            return NULL;
+            return (struct simple_result) {SIMPLE_STATUS_OK, NULL};
         }
-        *result = NULL;
-        return simple_error_new(
-            "Cannot get type '%s' when bootstrapping type system.", type_name);
+        return (struct simple_result) {SIMPLE_STATUS_ERROR, simple_error_new(
+            "Cannot get type '%s' when bootstrapping type system.",
+            type_name)};
     }
 
     struct object *o = NULL;
-    struct object *type_name_object;
+    struct simple_result found;
     struct simple_error *error;
 
-    error = object_new_string(&type_name_object, "%s", type_name);
-    simple_error_check(error);
-
-    error = simple_hashtable_find(registry->types, type_name_object, &o);
-    simple_error_check(error);
-
-    if (!o) {
-        error = simple_error_new("Type '%s' does not exist.", type_name);
-        simple_error_check(error);
+    // probes by the name itself, a miss allocates nothing
+    found = simple_hashtable_lookup_cstring(registry->types, type_name, &o);
+    if (found.status != SIMPLE_STATUS_OK) {
+        error = found.error;
+        goto cleanup;
     }
 
     error = object_get_type(o, result);
@@ -201,9 +277,20 @@ struct simple_error *type_registry_get_type(
     cleanup:
     if (error) {
         object_refcount_decrease(o);
+        return (struct simple_result) {SIMPLE_STATUS_ERROR, error};
     }
+    return (struct simple_result) {found.status, NULL};
+}
 
-    return error;
+struct simple_error *type_registry_get_type(
+    const char *type_name,
+    struct type **result
+) {
+    struct simple_result found = type_registry_find_type(type_name, result);
+    if (found.status == SIMPLE_STATUS_NOT_FOUND) {
+        return simple_error_new("Type '%s' does not exist.", type_name);
+    }
+    return found.error;
 }
 
 struct simple_error *type_registry_create_type(
@@ -219,6 +306,20 @@ struct simple_error *type_registry_create_type(
 
     if (strcmp(type_name, "int") == 0) {
         instance_kind = OBJECT_INTEGER;
+    } else if (strcmp(type_name, "bigint") == 0) {
+        instance_kind = OBJECT_BIGINT;
+    } else if (strcmp(type_name, "array") == 0) {
+        instance_kind = OBJECT_ARRAY;
+    } else if (strcmp(type_name, "list") == 0) {
+        instance_kind = OBJECT_LIST;
+    } else if (strcmp(type_name, "dict") == 0) {
+        instance_kind = OBJECT_DICT;
+    } else if (strcmp(type_name, "frozen_dict") == 0) {
+        instance_kind = OBJECT_FROZEN_DICT;
+    } else if (strcmp(type_name, "sorted_dict") == 0) {
+        instance_kind = OBJECT_SORTED_DICT;
+    } else if (strcmp(type_name, "sink") == 0) {
+        instance_kind = OBJECT_SINK;
     } else if (strcmp(type_name, "string") == 0) {
         *result = NULL;
         return simple_error_new("%s", "Cannot override type 'string'");
@@ -258,38 +359,30 @@ struct simple_error *type_registry_create_type(
     return error;
 }
 
-struct simple_error *type_registry_construct(
+struct simple_result type_registry_try_construct(
     const char *type_name,
     struct object **result
 ) {
-    struct object *type_object, *type_name_object;
-    struct simple_error *error;
-
-    error = object_new_string(&type_name_object, "%s", type_name);
-    simple_error_check(error);
-
-    error = simple_hashtable_find(registry->types, type_name_object,
-        &type_object);
-    simple_error_check(error);
-
-    if (!type_object) {
-        *result = NULL;
-        return simple_error_new(__FILE__, __LINE__, __FUNCTION__,
-            "type '%s' does not exist.", type_name);
-    }
-
-
     struct type *type;
-    error = object_get_type(type_object, &type);
-    simple_error_check(error);
+    struct simple_result found = type_registry_find_type(type_name, &type);
 
-    *result = object_new(type->instance_kind, false, type);
+    *result = NULL;
+    if (found.status == SIMPLE_STATUS_OK) {
+        *result = object_new(type->instance_kind, false, type);
+    }
+    return found;
+}
 
-    cleanup:
-    if (error) {
-        *result = NULL;
+struct simple_error *type_registry_construct(
+    const char *type_name,
+    struct object **result
+) {
+    struct simple_result found = type_registry_try_construct(type_name,
+        result);
+    if (found.status == SIMPLE_STATUS_NOT_FOUND) {
+        return simple_error_new("Type '%s' does not exist.", type_name);
     }
-    return NULL;
+    return found.error;
 }
 
 struct simple_error *type_new(
@@ -300,11 +393,10 @@ struct simple_error *type_new(
     struct type *type = calloc(1, sizeof *type);
     *type = (struct type) {
         .name = simple_string_new(type_name),
-        .attributes = simple_hashtable_new(registry->string_type,
-            registry->type_type),
         .instance_kind = instance_kind,
         .instantiated = false
     };
+    atomic_init(&type->attributes, type_attributes_new());
     *result = type;
     return NULL;
 }
@@ -7,7 +7,9 @@ struct type_registry;
 struct type;
 struct object;
 struct simple_error;
+struct simple_result;
 struct simple_string;
+struct simple_hamt;
 enum object_kind;
 
 extern struct type_registry *registry;
@@ -25,6 +27,13 @@ struct simple_error *type_registry_get_type(
     struct type **result
 ) __attribute__((warn_unused_result));
 
+// Like get_type, but a missing type is SIMPLE_STATUS_NOT_FOUND instead of
+// an error, for callers that only check whether it exists.
+struct simple_result type_registry_find_type(
+    const char *type_name,
+    struct type **result
+) __attribute__((warn_unused_result));
+
 struct simple_error *type_registry_get_string_type(
     struct type **result
 ) __attribute__((warn_unused_result));
@@ -39,12 +48,40 @@ struct simple_error *type_registry_construct(
     struct object **result
 ) __attribute__((warn_unused_result));
 
+// Like construct, but a missing type is SIMPLE_STATUS_NOT_FOUND.
+struct simple_result type_registry_try_construct(
+    const char *type_name,
+    struct object **result
+) __attribute__((warn_unused_result));
+
 struct simple_error *type_set_attribute(
     struct type *type,
     const char *key,
     struct object *value
 ) __attribute__((warn_unused_result));
 
+// Takes a reference to the attribute, errors if type does not have it.
+struct simple_error *type_get_attribute(
+    const struct type *type,
+    const char *key,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+// Like get_attribute, but a missing attribute is SIMPLE_STATUS_NOT_FOUND
+// instead of an error, for callers that probe for it.
+struct simple_result type_find_attribute(
+    const struct type *type,
+    const char *key,
+    struct object **result
+) __attribute__((warn_unused_result));
+
+// Snapshot of all attributes, later updates to type do not show up in it.
+// Release it with simple_hamt_release.
+struct simple_error *type_get_attributes(
+    const struct type *type,
+    struct simple_hamt **result
+) __attribute__((warn_unused_result));
+
 struct simple_error *type_new(
     const char *type_name,
     enum object_kind instance_kind,